@@ -5,6 +5,7 @@
 #include "Foundation/Reflect/Version.h"
 #include "Foundation/Reflect/Visitor.h"
 #include "Foundation/Reflect/Serializers.h"
+#include "Foundation/Reflect/ArchiveBinary.h"
 #include "Foundation/Component/Component.h"
 
 #include "Core/Asset/Classes/Entity.h"
@@ -78,6 +79,12 @@ void AssetClass::GatherSearchableProperties( Helium::SearchableProperties* prope
 {
     properties->Insert( TXT( "AssetDescription" ), m_Description );
 
+    // a big tag set can be left in the file by a lazy read, and we read it directly instead of through a serializer
+    if ( Reflect::g_LazyElementCount )
+    {
+        Reflect::ArchiveBinary::LoadLazyFields( const_cast< AssetClass* >( this ) );
+    }
+
     for ( std::set< tstring >::const_iterator itr = m_Tags.begin(), end = m_Tags.end(); itr != end; ++itr )
     {
         properties->Insert( TXT( "AssetTag" ), (*itr) );
@@ -3,11 +3,13 @@
 
 #include "Foundation/InitializerStack.h"
 #include "Foundation/Reflect/Registry.h"
+#include "Foundation/Reflect/ArchiveBinary.h"
 #include "Foundation/Component/ComponentInit.h"
 
 #include "Core/Asset/AssetInit.h"
 
 #include "Core/SceneGraph/SceneSettings.h"
+#include "Core/SceneGraph/SceneNode.h"
 #include "Core/SceneGraph/Tool.h"
 #include "Core/SceneGraph/CreateTool.h"
 #include "Core/SceneGraph/DuplicateTool.h"
@@ -48,6 +50,19 @@ using namespace Helium::SceneGraph;
 static i32 g_InitCount = 0;
 static Helium::InitializerStack g_InitializerStack;
 
+// incremental scene saves refer to nodes by their id
+static bool GetSceneNodeID( const Reflect::Element* element, tuid& id )
+{
+    const SceneNode* node = Reflect::ConstObjectCast< SceneNode >( element );
+    if ( node )
+    {
+        id = node->GetID();
+        return true;
+    }
+
+    return false;
+}
+
 void SceneGraph::Initialize()
 {
     if ( ++g_InitCount == 1 )
@@ -119,6 +134,8 @@ void SceneGraph::Initialize()
         g_InitializerStack.Push( Reflect::RegisterClassType< SceneGraph::ViewportSettings >() ); 
         g_InitializerStack.Push( Reflect::RegisterClassType< SceneGraph::GridSettings >() );
         g_InitializerStack.Push( Reflect::RegisterClassType< SceneGraph::SceneSettings >() );
+
+        Reflect::ArchiveBinary::SetElementIDFunc( &GetSceneNodeID );
     }
 }
 
@@ -126,6 +143,8 @@ void SceneGraph::Cleanup()
 {
     if ( --g_InitCount == 0 )
     {
+        Reflect::ArchiveBinary::SetElementIDFunc( NULL );
+
         g_InitializerStack.Cleanup();
     }
 }
@@ -10,6 +10,7 @@
 #include "Foundation/Startup.h"
 #include "Foundation/Exception.h"
 #include "Foundation/InitializerStack.h"
+#include "Foundation/Checksum/FileHash.h"
 #include "Foundation/Math/Utils.h"
 #include "Foundation/CommandLine/Option.h"
 #include "Foundation/CommandLine/Command.h"
@@ -299,6 +300,10 @@ void App::SaveSettings()
 {
     Helium::Path path;
     Helium::GetPreferencesDirectory( path );
+
+    // keep the file hashes for next time so unchanged assets aren't read again
+    Helium::GetFileHashCache().Save( ( path + TXT("FileHashCache.dat") ).Get() );
+
     path += TXT("EditorSettings.xml");
 
     tstring error;
@@ -328,6 +333,10 @@ void App::LoadSettings()
 {
     Helium::Path path;
     Helium::GetPreferencesDirectory( path );
+
+    // a missing or stale cache just means files get hashed again
+    Helium::GetFileHashCache().Load( ( path + TXT("FileHashCache.dat") ).Get() );
+
     path += TXT("EditorSettings.xml");
 
 	if ( !path.Exists() )
@@ -442,6 +451,9 @@ int Main ( int argc, const tchar** argv )
     bool memoryFlag = false;
     success &= processor.AddOption( new FlagOption( &memoryFlag, StartupArgs::Memory, TXT( "profile and report memory usage to the console" ) ), error );
 
+    bool traceFlag = false;
+    success &= processor.AddOption( new FlagOption( &traceFlag, StartupArgs::Trace, TXT( "record profiled scopes to a trace file (use with -profile)" ) ), error );
+
     bool vreboseFlag = false;
     success &= processor.AddOption( new FlagOption( &vreboseFlag, StartupArgs::Verbose, TXT( "output a verbose level of console output" ) ), error );
 
@@ -451,6 +463,9 @@ int Main ( int argc, const tchar** argv )
     bool debugFlag = false;
     success &= processor.AddOption( new FlagOption( &debugFlag, StartupArgs::Debug, TXT( "output debug console output" ) ), error );
 
+    bool syncLogFlag = false;
+    success &= processor.AddOption( new FlagOption( &syncLogFlag, StartupArgs::SyncLog, TXT( "write console and trace file output from the printing thread instead of the log thread" ) ), error );
+
     int nice = 0;
     success &= processor.AddOption( new SimpleOption<int>( &nice , TXT( "nice" ), TXT( "<NUM>" ), TXT( "number of processors to nice (for other processes)" ) ), error );
 
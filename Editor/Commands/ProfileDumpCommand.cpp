@@ -5,141 +5,101 @@
 #include "Foundation/Profile.h"
 #include "Foundation/File/Path.h"
 
-#include <stdio.h>
-#include <stdlib.h>
-
 using namespace Helium;
 using namespace Helium::Profile;
 using namespace Helium::Editor;
 
-static u32 g_Indent = 0; 
-
 ProfileDumpCommand::ProfileDumpCommand()
-: Command( TXT( "profile-dump" ), TXT( "[<INPUT>]" ), TXT( "Dump text information about a profile data file" ) )
+: Command( TXT( "profile-dump" ), TXT( "<INPUT> [<OUTPUT>]" ), TXT( "Dump text information about a profile trace file, or convert it to a chrome trace (chrome://tracing)" ) )
 {
 
 }
 
-static void PrintIndent()
-{
-    for(u32 i = 0; i < g_Indent; ++i)
-    {
-        Log::Print( TXT( " " ) ); 
-    }
-}
-
-static void ParseAndPrintBlock(char* buffer)
+static void PrintThread( const TraceData& data, u32 thread, const std::vector< TraceEvent >& events )
 {
-    char* currentByte = buffer; 
+    Log::Print( TXT( "Thread %d%s, %d events\n" ), thread, thread == data.m_MainThread ? TXT( " (main)" ) : TXT( "" ), (u32)events.size() ); 
 
-    while(currentByte < buffer + PROFILE_PACKET_BLOCK_SIZE)
-    {
-        UberPacket* uberPacket = (UberPacket*) currentByte; 
+    f32 millisPerTick = data.m_Conversion / (f32)PROFILE_CYCLES_FOR_CONVERSION; 
 
-        u16 cmd = uberPacket->m_Header.m_Command; 
-        u16 size = uberPacket->m_Header.m_Size; 
+    std::vector< u64 > starts; 
 
-        const char* packet_names[] = { "INIT       ", 
-            "SCOPE_ENTER", 
-            "SCOPE_EXIT ", 
-            "BLOCK_END  " }; 
+    for ( size_t i = 0; i < events.size(); ++i )
+    {
+        const TraceEvent& event = events[ i ]; 
 
-        if(cmd <= PROFILE_CMD_BLOCK_END)
+        for ( u32 indent = 0; indent <= event.m_Depth; ++indent )
         {
-            Log::Print( TXT( "%s:" ), packet_names[cmd]); 
+            Log::Print( TXT( " " ) ); 
         }
-        else
+
+        if ( event.m_Type == TraceEventTypes::Enter )
         {
-            Log::Error( TXT( "UNKNOWN PROFILE TAG: 0x%.2x\n" ), cmd); 
-            exit(1); 
-        }
+            Log::Print( TXT( "%s\n" ), data.GetString( event.m_ID ) ); 
 
-        switch(cmd)
+            starts.resize( event.m_Depth + 1 ); 
+            starts[ event.m_Depth ] = event.m_Ticks; 
+        }
+        else
         {
-        case PROFILE_CMD_SCOPE_ENTER: 
-            g_Indent++; 
-            PrintIndent(); 
-            Log::Print( TXT( "%s %d\n" ), 
-                uberPacket->m_ScopeEnter.m_Function, 
-                uberPacket->m_ScopeEnter.m_Line); 
-
-            break; 
-        case PROFILE_CMD_SCOPE_EXIT:
-            PrintIndent(); 
-            Log::Print( TXT( "%lld\n" ), uberPacket->m_ScopeExitPacket.m_Duration); 
-            g_Indent--; 
-            break; 
-
-        default:
-            Log::Print( TXT( "\n" ) );
+            f32 millis = event.m_Depth < starts.size() ? (f32)( event.m_Ticks - starts[ event.m_Depth ] ) * millisPerTick : 0.f; 
+            Log::Print( TXT( "%s [%.3f ms]\n" ), data.GetString( event.m_ID ), millis ); 
         }
-
-        if(cmd == PROFILE_CMD_BLOCK_END)
-            break; 
-
-        currentByte += size; 
     }
 }
 
 bool ProfileDumpCommand::Process( std::vector< tstring >::const_iterator& argsBegin, const std::vector< tstring >::const_iterator& argsEnd, tstring& error )
 {
-    tstring fileArg;
+    tstring inputArg;
+    tstring outputArg;
 
     if ( argsBegin != argsEnd )
     {
-        const tstring& arg = (*argsBegin);
+        inputArg = *argsBegin;
+        Helium::Path::Normalize( inputArg );
         ++argsBegin;
-
-        if ( arg.length() )
-        {
-            fileArg = arg;
-            Helium::Path::Normalize( fileArg );
-        }
     }
 
-    const tchar* filename = fileArg.c_str(); 
+    if ( argsBegin != argsEnd )
+    {
+        outputArg = *argsBegin;
+        Helium::Path::Normalize( outputArg );
+        ++argsBegin;
+    }
 
-    FILE* file = _tfopen(filename, TXT( "rb" ) );
-    if(!file)
+    if ( inputArg.empty() )
     {
-        Log::Print( TXT( "Unable to open %s for reading!\n" ), filename); 
+        error = TXT( "No input profile trace specified" );
         return false;
     }
 
-    fseek(file, 0, SEEK_END); 
-    long filesize = ftell(file); 
-    fseek(file, 0, SEEK_SET); 
-
-    u32 blockCount = filesize / PROFILE_PACKET_BLOCK_SIZE; 
-
-    if( filesize % PROFILE_PACKET_BLOCK_SIZE != 0)
+    TraceData data;
+    if ( !ReadTrace( inputArg.c_str(), data, error ) )
     {
-        Log::Print( TXT( "File %s is of the wrong size (not a multiple of PROFILE_PACKET_BLOCK_SIZE %d)\n" ), 
-            filename, PROFILE_PACKET_BLOCK_SIZE); 
+        return false;
     }
-    else
+
+    if ( data.m_Dropped )
     {
-        Log::Print( TXT( "File %s has %d blocks\n" ), filename, blockCount); 
+        Log::Warning( TXT( "%d events were dropped while recording %s\n" ), data.m_Dropped, inputArg.c_str() );
     }
 
-    char* buffer = new char[PROFILE_PACKET_BLOCK_SIZE]; 
-
-    for(u32 i = 0; i < blockCount; ++i)
+    if ( !outputArg.empty() )
     {
-        size_t bytesRead = fread(buffer, 1, PROFILE_PACKET_BLOCK_SIZE, file); 
-
-        if(bytesRead != PROFILE_PACKET_BLOCK_SIZE)
+        if ( !WriteChromeTrace( data, outputArg.c_str(), error ) )
         {
-            Log::Print( TXT( "Error reading block %d from file\n" ), i); 
-            exit(1); 
+            return false;
         }
 
-        Log::Print( TXT( "Block %d\n" ), i); 
-        ParseAndPrintBlock(buffer); 
+        Log::Print( TXT( "Wrote %d threads to %s\n" ), (u32)data.m_Events.size(), outputArg.c_str() );
+        return true;
     }
 
-    delete[] buffer; 
+    Log::Print( TXT( "File %s has %d threads and %d strings\n" ), inputArg.c_str(), (u32)data.m_Events.size(), (u32)data.m_Strings.size() );
+
+    for ( TraceData::M_ThreadEvents::const_iterator itr = data.m_Events.begin(), end = data.m_Events.end(); itr != end; ++itr )
+    {
+        PrintThread( data, itr->first, itr->second );
+    }
 
-    fclose(file); 
     return true;
 }
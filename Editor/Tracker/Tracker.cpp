@@ -2,6 +2,8 @@
 #include "Tracker.h"
 
 #include "Core/Asset/AssetClass.h"
+#include "Foundation/Reflect/ArchiveBinary.h"
+#include "Foundation/Checksum/FileHash.h"
 #include "Foundation/File/Path.h"
 #include "Foundation/Component/SearchableProperties.h"
 
@@ -27,6 +29,26 @@ inline void SleepBetweenTracking( bool* cancel = NULL, const u32 minutes = 1 )
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// A file that is new or has a newer timestamp than when we indexed it
+struct ChangedFile
+{
+    Helium::Path    m_Path;
+    bool            m_Tracked;      // it's in the database, and these are the size and time we indexed it at
+    i64             m_Size;
+    u64             m_ModifiedTime;
+    bool            m_Touched;      // its contents are the same as when we indexed it
+
+    ChangedFile()
+        : m_Tracked( false )
+        , m_Size( 0 )
+        , m_ModifiedTime( 0 )
+        , m_Touched( false )
+    {
+
+    }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 int Tracker::s_InitCount = 0;
 Helium::InitializerStack Tracker::s_InitializerStack;
@@ -125,7 +147,7 @@ void Tracker::TrackEverything()
         m_TrackerDB.upgrade();
     }
 
-    std::set< Helium::Path > assetFiles;
+    std::vector< Helium::Path > assetFiles;
     while ( !m_StopTracking )
     {
         Log::Print( m_InitialIndexingCompleted ? Log::Levels::Verbose : Log::Levels::Default,
@@ -134,7 +156,8 @@ void Tracker::TrackEverything()
         // find all the files in the project
         {
             Timer timer;
-            m_Directory.GetFiles( assetFiles, TXT("*.*"), true );
+            assetFiles.clear();
+            m_Directory.GetFiles( assetFiles, TXT("*.*"), true, true );
             Log::Print( m_InitialIndexingCompleted ? Log::Levels::Verbose : Log::Levels::Default, TXT("Tracker: File reslover database lookup took %.2fms\n"), timer.Elapsed() );
         }
 
@@ -145,8 +168,83 @@ void Tracker::TrackEverything()
         Timer timer;
         Log::Print( m_InitialIndexingCompleted ? Log::Levels::Verbose : Log::Levels::Default, TXT("Tracker: Scanning %d asset file(s) for changes...\n"), (u32)assetFiles.size() );
 
-        for( std::set< Helium::Path >::const_iterator assetFileItr = assetFiles.begin(), assetFileItrEnd = assetFiles.end();
+        // see which files are new or have changed since we indexed them
+        std::vector< ChangedFile > changedFiles;
+        for( std::vector< Helium::Path >::const_iterator assetFileItr = assetFiles.begin(), assetFileItrEnd = assetFiles.end();
             !m_StopTracking && assetFileItr != assetFileItrEnd; ++assetFileItr )
+        {
+            ChangedFile changedFile;
+            changedFile.m_Path = (*assetFileItr);
+
+            try
+            {
+                TrackedFile assetTrackedFile = litesql::select<TrackedFile>( m_TrackerDB, TrackedFile::MPath == assetFileItr->Get() ).one();
+                if ( !assetFileItr->ChangedSince( assetTrackedFile.mLastModified.value().timeStamp() ) )
+                {
+                    ++m_CurrentProgress;
+                    continue;
+                }
+
+                changedFile.m_Tracked = true;
+                changedFile.m_Size = assetTrackedFile.mSize.value();
+                changedFile.m_ModifiedTime = (u64)assetTrackedFile.mLastModified.value().timeStamp();
+            }
+            catch( const litesql::NotFound& )
+            {
+                Log::Debug( TXT("Caught litesql::NotFound excption when selecting file from DB" ));
+            }
+
+            changedFiles.push_back( changedFile );
+        }
+
+        // hash the changed assets across the pool, one with the same contents as when we indexed it was only touched
+        {
+            Timer timer;
+            std::vector< tstring > changedPaths;
+            std::vector< tstring > previousHashes;
+            std::vector< u32 > changedIndices;
+            for ( u32 i = 0; !m_StopTracking && i < changedFiles.size(); ++i )
+            {
+                const ChangedFile& changedFile = changedFiles[ i ];
+                if ( changedFile.m_Path.FullExtension() != TXT( "nrb" ) )
+                {
+                    continue;
+                }
+
+                // the cache remembers the size and time of the file it last hashed, that has to be the version we indexed
+                tstring previousHash;
+                i64 size = 0;
+                u64 modifiedTime = 0;
+                if ( !changedFile.m_Tracked
+                    || !Helium::GetFileHashCache().Lookup( changedFile.m_Path.Get(), FileHashTypes::Hash64, previousHash, size, modifiedTime )
+                    || size != changedFile.m_Size
+                    || modifiedTime != changedFile.m_ModifiedTime )
+                {
+                    previousHash.clear();
+                }
+
+                changedPaths.push_back( changedFile.m_Path.Get() );
+                previousHashes.push_back( previousHash );
+                changedIndices.push_back( i );
+            }
+
+            std::vector< tstring > hashes;
+            Helium::GetFileHashCache().Hash( changedPaths, FileHashTypes::Hash64, hashes );
+
+            for ( u32 i = 0; i < changedIndices.size(); ++i )
+            {
+                changedFiles[ changedIndices[ i ] ].m_Touched = !hashes[ i ].empty() && hashes[ i ] == previousHashes[ i ];
+            }
+
+            Log::Print( m_InitialIndexingCompleted ? Log::Levels::Verbose : Log::Levels::Default, TXT("Tracker: Hashing %d changed asset file(s) took %.2fms\n"), (u32)changedPaths.size(), timer.Elapsed() );
+        }
+
+        // a fresh table each pass, values interned alongside the names would otherwise pile up for as long as we run
+        m_StringTable = new Reflect::StringTable;
+        Reflect::ArchiveBinary::SetStringTable( m_StringTable );
+
+        for( std::vector< ChangedFile >::const_iterator changedFileItr = changedFiles.begin(), changedFileItrEnd = changedFiles.end();
+            !m_StopTracking && changedFileItr != changedFileItrEnd; ++changedFileItr )
         {
             Log::Listener listener ( ~Log::Streams::Error );
             ++m_CurrentProgress;
@@ -155,29 +253,29 @@ void Tracker::TrackEverything()
             m_TrackerDB.begin();
             try
             {
-                // see if the file has changed
                 // insert/update the file: path, timestamp, etc...
-                const Helium::Path& assetFilePath = (*assetFileItr);
+                const Helium::Path& assetFilePath = changedFileItr->m_Path;
                 TrackedFile assetTrackedFile( m_TrackerDB );
-                try
+                if ( changedFileItr->m_Tracked )
                 {
-                    assetTrackedFile = litesql::select<TrackedFile>( m_TrackerDB, TrackedFile::MPath == assetFilePath.Get() ).one();
-                    if ( assetFilePath.ChangedSince( assetTrackedFile.mLastModified.value().timeStamp() ) )
+                    try
                     {
-                        assetTrackedFile.properties().del();
-                        assetTrackedFile.fileReferences().del();
+                        assetTrackedFile = litesql::select<TrackedFile>( m_TrackerDB, TrackedFile::MPath == assetFilePath.Get() ).one();
+
+                        // a file that was only touched keeps what we found in it, just the timestamp catches up
+                        if ( !changedFileItr->m_Touched )
+                        {
+                            assetTrackedFile.properties().del();
+                            assetTrackedFile.fileReferences().del();
+                        }
                     }
-                    else
+                    catch( const litesql::NotFound& )
                     {
-                        continue;
+                        Log::Debug( TXT("Caught litesql::NotFound excption when selecting file from DB" ));
                     }
                 }
-                catch( const litesql::NotFound& )
-                {
-                    Log::Debug( TXT("Caught litesql::NotFound excption when selecting file from DB" ));
-                }
 
-                if ( assetFilePath.FullExtension() == TXT( "nrb" ) )
+                if ( !changedFileItr->m_Touched && assetFilePath.FullExtension() == TXT( "nrb" ) )
                 {
                     const Asset::AssetClassPtr assetClass = Asset::AssetClass::LoadAssetClass( assetFilePath );
                     if ( assetClass.ReferencesObject() )
@@ -233,6 +331,11 @@ void Tracker::TrackEverything()
             m_TrackerDB.commit();
         }
 
+        Reflect::ArchiveBinary::SetStringTable( NULL );
+
+        // anything still holding strings from this pass keeps the table alive on its own
+        m_StringTable = NULL;
+
         if ( m_StopTracking )
         {
             u32 percentComplete = (u32)(((f32)m_CurrentProgress/(f32)m_Total) * 100);
@@ -6,6 +6,7 @@
 
 #include "Foundation/InitializerStack.h"
 #include "Foundation/File/Directory.h"
+#include "Foundation/Reflect/StringPool.h"
 #include "Platform/Thread.h"
 
 namespace Helium
@@ -40,6 +41,9 @@ namespace Helium
             TrackerDBGenerated m_TrackerDB;
             Helium::Directory m_Directory;
 
+            // Field and type names repeat across every file we index, so intern them once per pass
+            Reflect::StringTablePtr m_StringTable;
+
             // Status update
             bool m_InitialIndexingCompleted;
             bool m_IndexingFailed;
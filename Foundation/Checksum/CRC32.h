@@ -2,6 +2,7 @@
 
 #include "Platform/Types.h"
 #include "Platform/Exception.h"
+#include "Platform/MappedFile.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -116,26 +117,42 @@ namespace Helium
       return Crc32(str, (u32)(_tcslen(str) * sizeof(tchar)));
     }
 
-    inline u32 FileCrc32(const tstring& filePath, u32 packetSize = 4096)
+    inline u32 FileCrc32(const tstring& filePath, u32 packetSize = 1024 * 1024)
     {
+        u32 crc = 0xffffffff;
+
+        MappedFile file;
+        if ( file.Open( filePath.c_str() ) )
+        {
+            const u8* data = file.GetData();
+            u64 size = file.GetSize();
+
+            while ( size )
+            {
+                u32 count = size < packetSize ? (u32)size : packetSize;
+                crc = Crc32(crc, data, count);
+                data += count;
+                size -= count;
+            }
+
+            return crc;
+        }
+
+        // couldn't map it, read it in packets instead
         FILE* f = _tfopen(filePath.c_str(), TXT( "rb" ) );
         if (f==0)
         {
             throw Helium::Exception( TXT( "Unable to open %s for read" ), filePath.c_str());
         }
 
-        fseek(f,0,SEEK_END);
-        size_t size = ftell(f);
-        fseek(f,0,SEEK_SET);
-
-        u32 crc = 0xffffffff;
         u8* data = new u8[ packetSize ];
-        while ( size )
+
+        size_t read = 0;
+        while ( ( read = fread(data,1,packetSize,f) ) > 0 )
         {
-            size_t read = fread(data,1,packetSize,f);
-            Crc32(crc, data, (int)read);
-            size -= read;
+            crc = Crc32(crc, data, (u32)read);
         }
+
         fclose(f);
         delete[] data;
 
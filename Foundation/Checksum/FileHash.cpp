@@ -0,0 +1,408 @@
+#include "FileHash.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/MappedFile.h"
+#include "Platform/Platform.h"
+#include "Platform/Stat.h"
+
+#include "Foundation/ThreadPool.h"
+#include "Foundation/Checksum/MD5.h"
+#include "Foundation/Checksum/MurmurHash2.h"
+
+#include <stdio.h>
+
+using namespace Helium;
+
+// saved caches start with these, a cache from another version or character width is ignored
+#define FILE_HASH_CACHE_SIGNATURE   ( 'F' | ( 'H' << 8 ) | ( 'C' << 16 ) | ( 'H' << 24 ) )
+#define FILE_HASH_CACHE_VERSION     ( 1 )
+
+// no path or hash we write is anywhere near this long, anything that claims to be is a corrupt cache
+#define FILE_HASH_CACHE_STRING_MAX  ( 32 * 1024 )
+
+namespace
+{
+    //
+    // FileHasher accumulates a hash a block at a time, every block but the last is FileHashBlockSize
+    //
+
+    class FileHasher
+    {
+    private:
+        FileHashType    m_Type;
+        md5_state_t     m_MD5;
+        u64             m_Hash64;
+        u64             m_Size;
+
+    public:
+        FileHasher( FileHashType type )
+            : m_Type( type )
+            , m_Hash64( 0 )
+            , m_Size( 0 )
+        {
+            md5_init( &m_MD5 );
+        }
+
+        void Append( const u8* data, u32 size )
+        {
+            if ( m_Type == FileHashTypes::MD5 )
+            {
+                md5_append( &m_MD5, (const md5_byte_t*)data, (int)size );
+            }
+            else
+            {
+                // fold each block in, the blocks hash independently so it doesn't matter how the file was read
+                m_Hash64 ^= MurmurHash64A( data, size, 42 );
+                m_Hash64 *= 0xc6a4a7935bd1e995;
+                m_Hash64 ^= m_Hash64 >> 47;
+            }
+
+            m_Size += size;
+        }
+
+        void Finish( tstring& hash )
+        {
+            tchar hex_output[16*2 + 1];
+
+            if ( m_Type == FileHashTypes::MD5 )
+            {
+                md5_byte_t digest[16];
+                md5_finish(&m_MD5, digest);
+
+                for (int di = 0; di < 16; ++di)
+                {
+                    _stprintf(hex_output + di * 2, TXT( "%02X" ), digest[di]);
+                }
+            }
+            else
+            {
+                u64 result = MurmurHash64A( &m_Size, sizeof( m_Size ), (unsigned int)m_Hash64 ) ^ m_Hash64;
+                _stprintf( hex_output, TXT( "%08X%08X" ), (u32)( result >> 32 ), (u32)result );
+            }
+
+            hash = hex_output;
+        }
+    };
+
+    struct HashTaskArgs
+    {
+        FileHashCache*  m_Cache;
+        const tstring*  m_Path;
+        FileHashType    m_Type;
+        tstring*        m_Hash;
+    };
+
+    bool WriteString( FILE* f, const tstring& string )
+    {
+        u32 length = (u32)string.length();
+        return fwrite( &length, sizeof( length ), 1, f ) == 1
+            && ( length == 0 || fwrite( string.data(), sizeof( tchar ), length, f ) == length );
+    }
+
+    bool ReadString( FILE* f, tstring& string )
+    {
+        u32 length = 0;
+        if ( fread( &length, sizeof( length ), 1, f ) != 1 || length > FILE_HASH_CACHE_STRING_MAX )
+        {
+            return false;
+        }
+
+        string.resize( length );
+        return length == 0 || fread( &string[0], sizeof( tchar ), length, f ) == length;
+    }
+
+    FileHashCache g_FileHashCache;
+}
+
+bool Helium::HashFile( const tchar* path, FileHashType type, tstring& hash )
+{
+    FileHasher hasher ( type );
+
+    MappedFile file;
+    if ( file.Open( path ) )
+    {
+        const u8* data = file.GetData();
+        u64 remaining = file.GetSize();
+
+        while ( remaining )
+        {
+            u32 size = remaining < FileHashBlockSize ? (u32)remaining : FileHashBlockSize;
+            hasher.Append( data, size );
+
+            data += size;
+            remaining -= size;
+        }
+    }
+    else
+    {
+        // too big to fit in our address space, or it just can't be mapped, read it instead
+        FILE* f = _tfopen( path, TXT( "rb" ) );
+        if ( f == NULL )
+        {
+            return false;
+        }
+
+        std::vector< u8 > block ( FileHashBlockSize );
+
+        size_t read = 0;
+        while ( ( read = fread( &block.front(), 1, FileHashBlockSize, f ) ) > 0 )
+        {
+            hasher.Append( &block.front(), (u32)read );
+        }
+
+        bool failed = ferror( f ) != 0;
+        fclose( f );
+
+        if ( failed )
+        {
+            return false;
+        }
+    }
+
+    hasher.Finish( hash );
+    return true;
+}
+
+FileHashCache::FileHashCache()
+: m_Dirty (false)
+, m_Hits (0)
+, m_Misses (0)
+{
+
+}
+
+FileHashCache::~FileHashCache()
+{
+
+}
+
+bool FileHashCache::Load( const tstring& file )
+{
+    FILE* f = _tfopen( file.c_str(), TXT( "rb" ) );
+    if ( f == NULL )
+    {
+        return false;
+    }
+
+    u32 header[ 4 ] = { 0, 0, 0, 0 };
+    bool result = fread( header, sizeof( header ), 1, f ) == 1
+        && header[ 0 ] == FILE_HASH_CACHE_SIGNATURE
+        && header[ 1 ] == FILE_HASH_CACHE_VERSION
+        && header[ 2 ] == sizeof( tchar );
+
+    M_Entry entries;
+
+    for ( u32 i = 0; result && i < header[ 3 ]; ++i )
+    {
+        tstring path;
+        Entry entry;
+
+        result = fread( &entry.m_Size, sizeof( entry.m_Size ), 1, f ) == 1
+            && fread( &entry.m_ModifiedTime, sizeof( entry.m_ModifiedTime ), 1, f ) == 1
+            && ReadString( f, path );
+
+        for ( u32 type = 0; result && type < FileHashTypes::Count; ++type )
+        {
+            result = ReadString( f, entry.m_Hashes[ type ] );
+        }
+
+        if ( result )
+        {
+            entries[ path ] = entry;
+        }
+    }
+
+    fclose( f );
+
+    if ( !result )
+    {
+        return false;
+    }
+
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    // anything we've hashed already is at least as fresh as what was saved
+    m_Entries.insert( entries.begin(), entries.end() );
+
+    return true;
+}
+
+bool FileHashCache::Save( const tstring& file )
+{
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    if ( !m_Dirty )
+    {
+        return true;
+    }
+
+    FILE* f = _tfopen( file.c_str(), TXT( "wb" ) );
+    if ( f == NULL )
+    {
+        return false;
+    }
+
+    u32 header[ 4 ] = { FILE_HASH_CACHE_SIGNATURE, FILE_HASH_CACHE_VERSION, sizeof( tchar ), (u32)m_Entries.size() };
+    bool result = fwrite( header, sizeof( header ), 1, f ) == 1;
+
+    M_Entry::const_iterator itr = m_Entries.begin();
+    M_Entry::const_iterator end = m_Entries.end();
+    for ( ; result && itr != end; ++itr )
+    {
+        const Entry& entry = itr->second;
+
+        result = fwrite( &entry.m_Size, sizeof( entry.m_Size ), 1, f ) == 1
+            && fwrite( &entry.m_ModifiedTime, sizeof( entry.m_ModifiedTime ), 1, f ) == 1
+            && WriteString( f, itr->first );
+
+        for ( u32 type = 0; result && type < FileHashTypes::Count; ++type )
+        {
+            result = WriteString( f, entry.m_Hashes[ type ] );
+        }
+    }
+
+    result &= fclose( f ) == 0;
+
+    if ( result )
+    {
+        m_Dirty = false;
+    }
+
+    return result;
+}
+
+void FileHashCache::Clear()
+{
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    m_Entries.clear();
+    m_Dirty = true;
+
+    Helium::AtomicExchange( &m_Hits, 0 );
+    Helium::AtomicExchange( &m_Misses, 0 );
+}
+
+bool FileHashCache::Hash( const tstring& path, FileHashType type, tstring& hash )
+{
+    HELIUM_ASSERT( type < FileHashTypes::Count );
+
+    Helium::Stat stat;
+    if ( !Helium::StatPath( path.c_str(), stat ) )
+    {
+        return false;
+    }
+
+    {
+        Helium::TakeMutex mutex ( m_Mutex );
+
+        M_Entry::const_iterator found = m_Entries.find( path );
+        if ( found != m_Entries.end()
+            && found->second.m_Size == stat.m_Size
+            && found->second.m_ModifiedTime == stat.m_ModifiedTime
+            && !found->second.m_Hashes[ type ].empty() )
+        {
+            hash = found->second.m_Hashes[ type ];
+            Helium::AtomicIncrement( &m_Hits );
+            return true;
+        }
+    }
+
+    Helium::AtomicIncrement( &m_Misses );
+
+    // hash without the lock, this is where all the time goes
+    if ( !HashFile( path.c_str(), type, hash ) )
+    {
+        return false;
+    }
+
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    // if the file changes while we read it the stat we keep won't match next time, and we'll read it again
+    Entry& entry = m_Entries[ path ];
+    if ( entry.m_Size != stat.m_Size || entry.m_ModifiedTime != stat.m_ModifiedTime )
+    {
+        entry = Entry ();
+        entry.m_Size = stat.m_Size;
+        entry.m_ModifiedTime = stat.m_ModifiedTime;
+    }
+
+    entry.m_Hashes[ type ] = hash;
+    m_Dirty = true;
+
+    return true;
+}
+
+void FileHashCache::Hash( const std::vector< tstring >& paths, FileHashType type, std::vector< tstring >& hashes, u32 threadCount )
+{
+    hashes.clear();
+    hashes.resize( paths.size() );
+
+    if ( threadCount == 0 )
+    {
+        threadCount = Helium::GetProcessorCount();
+    }
+
+    if ( threadCount > paths.size() )
+    {
+        threadCount = (u32)paths.size();
+    }
+
+    if ( threadCount <= 1 )
+    {
+        for ( u32 i = 0; i < paths.size(); ++i )
+        {
+            Hash( paths[ i ], type, hashes[ i ] );
+        }
+
+        return;
+    }
+
+    std::vector< HashTaskArgs > args ( paths.size() );
+
+    ThreadPool pool ( threadCount, "File Hash" );
+
+    for ( u32 i = 0; i < paths.size(); ++i )
+    {
+        args[ i ].m_Cache = this;
+        args[ i ].m_Path = &paths[ i ];
+        args[ i ].m_Type = type;
+        args[ i ].m_Hash = &hashes[ i ];
+
+        pool.Queue( &FileHashCache::HashTask, &args[ i ] );
+    }
+
+    pool.Wait();
+}
+
+bool FileHashCache::Lookup( const tstring& path, FileHashType type, tstring& hash, i64& size, u64& modifiedTime )
+{
+    HELIUM_ASSERT( type < FileHashTypes::Count );
+
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    M_Entry::const_iterator found = m_Entries.find( path );
+    if ( found == m_Entries.end() || found->second.m_Hashes[ type ].empty() )
+    {
+        return false;
+    }
+
+    hash = found->second.m_Hashes[ type ];
+    size = found->second.m_Size;
+    modifiedTime = found->second.m_ModifiedTime;
+
+    return true;
+}
+
+void FileHashCache::HashTask( void* param )
+{
+    HashTaskArgs* args = (HashTaskArgs*)param;
+
+    // a file that can't be read is left with an empty hash
+    args->m_Cache->Hash( *args->m_Path, args->m_Type, *args->m_Hash );
+}
+
+FileHashCache& Helium::GetFileHashCache()
+{
+    return g_FileHashCache;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "Platform/Types.h"
+#include "Platform/Mutex.h"
+
+#include "Foundation/API.h"
+
+namespace Helium
+{
+    // files are hashed in blocks this big, the 64-bit hash is defined in terms of them
+    const static u32 FileHashBlockSize = 1024 * 1024;
+
+    namespace FileHashTypes
+    {
+        enum FileHashType
+        {
+            MD5,        // 32 hex digits, the same as Helium::FileMD5
+            Hash64,     // 16 hex digits, MurmurHash64A of each block folded together, much cheaper than MD5
+
+            Count,
+        };
+    }
+    typedef FileHashTypes::FileHashType FileHashType;
+
+    // hash a file on the calling thread, reading it through a mapping where possible, returns false if the file can't be read
+    FOUNDATION_API bool HashFile( const tchar* path, FileHashType type, tstring& hash );
+
+    //
+    // FileHashCache remembers the hash of every file it has seen along with the file's size and modified time,
+    //  a file that still has the same size and modified time is taken to be unchanged and is never read again.
+    //  Batches of files are hashed across a pool of threads, and the cache can be saved and loaded so it
+    //  carries over from one run to the next.
+    //
+
+    class FOUNDATION_API FileHashCache
+    {
+    private:
+        struct Entry
+        {
+            i64         m_Size;
+            u64         m_ModifiedTime;
+            tstring     m_Hashes[ FileHashTypes::Count ];   // empty until asked for
+
+            Entry()
+                : m_Size( 0 )
+                , m_ModifiedTime( 0 )
+            {
+
+            }
+        };
+
+        typedef std::map< tstring, Entry > M_Entry;
+
+        Helium::Mutex   m_Mutex;
+        M_Entry         m_Entries;
+        bool            m_Dirty;
+
+        volatile i32    m_Hits;
+        volatile i32    m_Misses;
+
+    public:
+        FileHashCache();
+        ~FileHashCache();
+
+    private:
+        FileHashCache( const FileHashCache& rhs )
+        {
+
+        }
+
+    public:
+        // read a cache saved by a previous run, merging it with what we have
+        bool Load( const tstring& file );
+
+        // write the cache out, does nothing if nothing has changed since it was loaded or saved
+        bool Save( const tstring& file );
+
+        void Clear();
+
+        // hash a single file, from the cache if it hasn't changed
+        bool Hash( const tstring& path, FileHashType type, tstring& hash );
+
+        // hash many files at once, files that can't be read get an empty hash
+        void Hash( const std::vector< tstring >& paths, FileHashType type, std::vector< tstring >& hashes, u32 threadCount = 0 );
+
+        // the last hash taken of a file and the size and modified time it had then, without looking at the file as it is now
+        bool Lookup( const tstring& path, FileHashType type, tstring& hash, i64& size, u64& modifiedTime );
+
+        // files answered from the cache and files that had to be read
+        u32 GetHits() const
+        {
+            return (u32)m_Hits;
+        }
+
+        u32 GetMisses() const
+        {
+            return (u32)m_Misses;
+        }
+
+    private:
+        static void HashTask( void* param );
+    };
+
+    // the cache Path::FileMD5 goes through, the application decides if and where it is saved
+    FOUNDATION_API FileHashCache& GetFileHashCache();
+}
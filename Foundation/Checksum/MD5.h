@@ -487,6 +487,7 @@ inline void md5_finish(md5_state_t *pms, md5_byte_t digest[16])
 /* End Copyright (C) 1999, 2002 Aladdin Enterprises, begin Helium open source */
 
 #include "Platform/Exception.h"
+#include "Foundation/Checksum/FileHash.h"
 
 namespace Helium
 {
@@ -514,40 +515,14 @@ namespace Helium
         return MD5( data.data(), (u32)data.length() );
     }
 
-    inline tstring FileMD5(const tstring& filePath, u32 packetSize = 4096)
+    inline tstring FileMD5(const tstring& filePath)
     {
-        FILE* f = _tfopen(filePath.c_str(), TXT( "rb" ) );
-        if (f==0)
+        tstring hash;
+        if ( !HashFile( filePath.c_str(), FileHashTypes::MD5, hash ) )
         {
             throw Helium::Exception( TXT( "Unable to open %s for read" ), filePath.c_str());
         }
 
-        fseek(f,0,SEEK_END);
-        size_t size = ftell(f);
-        fseek(f,0,SEEK_SET);
-
-        md5_state_t state;
-        md5_init(&state);
-
-        u8* data = new u8[ packetSize ];
-        while ( size )
-        {
-            size_t read = fread(data,1,packetSize,f);
-            md5_append(&state, data, (int)read);
-            size -= read;
-        }
-        fclose(f);
-        delete[] data;
-
-        md5_byte_t digest[16];
-        md5_finish(&state, digest);
-
-        tchar hex_output[16*2 + 1];
-        for (int di = 0; di < 16; ++di)
-        {
-            _stprintf(hex_output + di * 2, TXT( "%02X" ), digest[di]);
-        }
-
-        return hex_output;
+        return hash;
     }
 }
@@ -82,7 +82,7 @@ namespace Helium
 					tstringstream str ( arg );
 					str >> *m_Data;
 
-					return str.fail();
+					return !str.fail();
 				}
 				
 				error = tstring( TXT("Missing parameter for option: ") ) + m_Token;
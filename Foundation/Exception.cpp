@@ -73,6 +73,9 @@ void Debug::ProcessException(const Helium::Exception& exception, bool print, boo
 
     if ( fatal )
     {
+        // statements still queued for the log thread would die with us
+        Log::FlushOnCrash();
+
         if ( g_Terminating.Count() )
         {
             g_Terminating.Raise( TerminateArgs () );
@@ -122,6 +125,9 @@ void Debug::ProcessException(const std::exception& exception, bool print, bool f
 
     if ( fatal )
     {
+        // statements still queued for the log thread would die with us
+        Log::FlushOnCrash();
+
         if ( g_Terminating.Count() )
         {
             g_Terminating.Raise( TerminateArgs () );
@@ -170,6 +176,9 @@ u32 Debug::ProcessException(LPEXCEPTION_POINTERS info, bool print, bool fatal)
 
         if ( fatal )
         {
+            // statements still queued for the log thread would die with us
+            Log::FlushOnCrash();
+
             if ( g_Terminating.Count() )
             {
                 g_Terminating.Raise( TerminateArgs () );
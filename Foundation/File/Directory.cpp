@@ -1,12 +1,397 @@
-#include "Platform/Windows/Windows.h"
+#ifdef WIN32
+# include "Platform/Windows/Windows.h"
+#else
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <dirent.h>
+# include <fcntl.h>
+# include <string.h>
+# include <unistd.h>
+#endif
+
 #include "Platform/Exception.h"
 
 #include "Directory.h"
 
 #include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Mutex.h"
+#include "Platform/String.h"
+
+#include "Foundation/ThreadPool.h"
+#include "Foundation/String/Wildcard.h"
+
+#include <algorithm>
 
 using namespace Helium;
 
+namespace
+{
+    //
+    // List a directory in as few calls as the platform allows, every item is a name relative to the
+    //  directory with directories flagged and given a trailing slash, times and sizes are only filled
+    //  in where the listing comes with them
+    //
+
+#ifdef WIN32
+
+    // only windows 7 knows about these, anything older fails the call and we ask again the old way
+# ifndef FIND_FIRST_EX_LARGE_FETCH
+#  define FIND_FIRST_EX_LARGE_FETCH 2
+# endif
+# define FIND_EX_INFO_BASIC ( (FINDEX_INFO_LEVELS)1 )
+
+    void ReadDirectory( const tstring& directory, std::vector< DirectoryItem >& items )
+    {
+        tstring query = directory + TXT( "*" );
+
+        WIN32_FIND_DATA foundFile;
+        HANDLE handle = ::FindFirstFileEx( query.c_str(), FIND_EX_INFO_BASIC, &foundFile, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH );
+        if ( handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_INVALID_PARAMETER )
+        {
+            handle = ::FindFirstFile( query.c_str(), &foundFile );
+        }
+
+        if ( handle == INVALID_HANDLE_VALUE )
+        {
+            DWORD error = GetLastError();
+            if ( error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND )
+            {
+                throw Exception( TXT( "Error calling FindFirstFile (%s)" ), Helium::GetErrorString(error).c_str() );
+            }
+
+            return;
+        }
+
+        do
+        {
+            // skip relative path directories if fileName is "." or ".."
+            if ( ( _tcscmp( foundFile.cFileName , TXT( "." ) ) == 0 ) || ( _tcscmp( foundFile.cFileName , TXT( ".." ) ) == 0 ) )
+            {
+                continue;
+            }
+
+            // skip hidden/system directories, so we don't try to access "System Volume Information"
+            if ( foundFile.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY
+                && foundFile.dwFileAttributes & ( FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM ) )
+            {
+                continue;
+            }
+
+            items.push_back( DirectoryItem () );
+            DirectoryItem& item = items.back();
+
+            item.m_Path = foundFile.cFileName;
+            item.m_CreateTime = ( (u64)foundFile.ftCreationTime.dwHighDateTime << 32 ) | foundFile.ftCreationTime.dwLowDateTime;
+            item.m_ModTime = ( (u64)foundFile.ftLastWriteTime.dwHighDateTime << 32 ) | foundFile.ftLastWriteTime.dwLowDateTime;
+            item.m_Size = ( (u64)foundFile.nFileSizeHigh << 32 ) | foundFile.nFileSizeLow;
+
+            if ( foundFile.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+            {
+                item.m_Flags |= DirectoryItemFlags::Directory;
+                item.m_Path += TXT( "/" );
+            }
+
+            // junctions and directory links can point back up the tree
+            if ( foundFile.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT )
+            {
+                item.m_Flags |= DirectoryItemFlags::Link;
+            }
+        }
+        while ( ::FindNextFile( handle, &foundFile ) );
+
+        DWORD error = GetLastError();
+
+        ::FindClose( handle );
+
+        if ( error != ERROR_NO_MORE_FILES )
+        {
+            throw Exception( TXT( "Error calling FindNextFile (%s)" ), Helium::GetErrorString(error).c_str() );
+        }
+    }
+
+#else
+
+    struct LinuxDirent64
+    {
+        u64             d_ino;
+        i64             d_off;
+        unsigned short  d_reclen;
+        unsigned char   d_type;
+        char            d_name[ 1 ];
+    };
+
+    void ReadDirectory( const tstring& directory, std::vector< DirectoryItem >& items )
+    {
+        int fd = open( directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        if ( fd == -1 )
+        {
+            return;
+        }
+
+        // getdents64 hands back a buffer full of entries per call, with their types, so files never need a stat
+        char buffer[ 32 * 1024 ];
+
+        for ( long size = syscall( SYS_getdents64, fd, buffer, sizeof( buffer ) ); size > 0; size = syscall( SYS_getdents64, fd, buffer, sizeof( buffer ) ) )
+        {
+            for ( long offset = 0; offset < size; )
+            {
+                const LinuxDirent64* entry = (const LinuxDirent64*)( buffer + offset );
+                offset += entry->d_reclen;
+
+                if ( strcmp( entry->d_name, "." ) == 0 || strcmp( entry->d_name, ".." ) == 0 )
+                {
+                    continue;
+                }
+
+                bool isDirectory = entry->d_type == DT_DIR;
+                bool isLink = entry->d_type == DT_LNK;
+
+                // some file systems don't fill in the type
+                if ( entry->d_type == DT_UNKNOWN )
+                {
+                    struct stat st;
+                    if ( fstatat( fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW ) == 0 )
+                    {
+                        isDirectory = S_ISDIR( st.st_mode );
+                        isLink = S_ISLNK( st.st_mode );
+                    }
+                }
+
+                // links have to be followed to know what they are
+                if ( isLink )
+                {
+                    struct stat st;
+                    isDirectory = fstatat( fd, entry->d_name, &st, 0 ) == 0 && S_ISDIR( st.st_mode );
+                }
+
+                // hidden directories are skipped, the same as on windows
+                if ( isDirectory && entry->d_name[ 0 ] == '.' )
+                {
+                    continue;
+                }
+
+                items.push_back( DirectoryItem () );
+                DirectoryItem& item = items.back();
+
+                item.m_Path = entry->d_name;
+
+                if ( isDirectory )
+                {
+                    item.m_Flags |= DirectoryItemFlags::Directory;
+                    item.m_Path += TXT( "/" );
+                }
+
+                if ( isLink )
+                {
+                    item.m_Flags |= DirectoryItemFlags::Link;
+                }
+            }
+        }
+
+        close( fd );
+    }
+
+#endif
+
+    // match the way FindFirstFile does, where *.* matches names without an extension too
+    bool MatchSpec( const tstring& spec, const tstring& name )
+    {
+        if ( spec.empty() || spec == TXT( "*" ) || spec == TXT( "*.*" ) )
+        {
+            return true;
+        }
+
+        return WildcardMatch( spec.c_str(), name.c_str() );
+    }
+
+    struct Walk
+    {
+        ThreadPool*                                 m_Pool;         // NULL to walk on the calling thread
+        tstring                                     m_Root;
+        tstring                                     m_Spec;
+        u32                                         m_Flags;
+        bool                                        m_Recursive;
+
+        const DirectoryItemSignature::Delegate*     m_Delegate;     // items go to the delegate...
+        std::vector< Helium::Path >*                m_Paths;        // ...or are collected here
+        Helium::Mutex                               m_Mutex;        // one directory's items go out at a time
+
+        volatile i32                                m_Failed;       // once set no more directories are read
+        tstring                                     m_Error;        // the first exception a pooled walk hit, rethrown on the calling thread
+
+        Walk()
+            : m_Pool( NULL )
+            , m_Flags( DirectoryFlags::Default )
+            , m_Recursive( true )
+            , m_Delegate( NULL )
+            , m_Paths( NULL )
+            , m_Failed( 0 )
+        {
+
+        }
+    };
+
+    struct WalkTaskArgs
+    {
+        Walk*   m_Walk;
+        tstring m_Directory;
+    };
+
+    void WalkDirectory( Walk& walk, const tstring& directory );
+
+    void WalkFailed( Walk& walk, const tstring& error )
+    {
+        // the first one wins, anything after it is most likely fallout from the same problem
+        if ( Helium::AtomicCompareExchange( &walk.m_Failed, 1, 0 ) == 0 )
+        {
+            walk.m_Error = error;
+        }
+    }
+
+    void WalkTask( void* param )
+    {
+        WalkTaskArgs* args = (WalkTaskArgs*)param;
+        Walk& walk = *args->m_Walk;
+
+        // pool tasks can't throw, so whatever stops the walk is held for RunWalk to throw once the pool is done
+        if ( !walk.m_Failed )
+        {
+            try
+            {
+                WalkDirectory( walk, args->m_Directory );
+            }
+            catch ( const Helium::Exception& ex )
+            {
+                WalkFailed( walk, ex.What() );
+            }
+            catch ( const std::exception& ex )
+            {
+                tstring error;
+                Helium::ConvertString( ex.what(), error );
+                WalkFailed( walk, error );
+            }
+            catch ( ... )
+            {
+                WalkFailed( walk, TXT( "Unknown exception" ) );
+            }
+        }
+
+        delete args;
+    }
+
+    void WalkDirectory( Walk& walk, const tstring& directory )
+    {
+        std::vector< DirectoryItem > items;
+        ReadDirectory( directory, items );
+
+        std::vector< tstring > subdirectories;
+
+        std::vector< DirectoryItem >::iterator keep = items.begin();
+        for ( std::vector< DirectoryItem >::iterator itr = items.begin(), end = items.end(); itr != end; ++itr )
+        {
+            bool isDirectory = ( itr->m_Flags & DirectoryItemFlags::Directory ) != 0;
+
+            tstring path = directory + itr->m_Path;
+
+            // links aren't walked through, a link to a parent would have us walking forever
+            if ( isDirectory && walk.m_Recursive && !( itr->m_Flags & DirectoryItemFlags::Link ) )
+            {
+                if ( walk.m_Pool )
+                {
+                    // hand it out now so another thread can start on it while we finish up here
+                    WalkTaskArgs* args = new WalkTaskArgs;
+                    args->m_Walk = &walk;
+                    args->m_Directory = path;
+                    walk.m_Pool->Queue( &WalkTask, args );
+                }
+                else
+                {
+                    subdirectories.push_back( path );
+                }
+            }
+
+            if ( walk.m_Flags & ( isDirectory ? DirectoryFlags::SkipDirectories : DirectoryFlags::SkipFiles ) )
+            {
+                continue;
+            }
+
+            // match against the name without the slash we added
+            if ( !MatchSpec( walk.m_Spec, isDirectory ? itr->m_Path.substr( 0, itr->m_Path.length() - 1 ) : itr->m_Path ) )
+            {
+                continue;
+            }
+
+            itr->m_Path = walk.m_Flags & DirectoryFlags::RelativePath ? path.substr( walk.m_Root.length() ) : path;
+
+            if ( keep != itr )
+            {
+                *keep = *itr;
+            }
+
+            ++keep;
+        }
+
+        items.erase( keep, items.end() );
+
+        if ( !items.empty() )
+        {
+            Helium::TakeMutex mutex ( walk.m_Mutex );
+
+            for ( std::vector< DirectoryItem >::const_iterator itr = items.begin(), end = items.end(); itr != end; ++itr )
+            {
+                if ( walk.m_Delegate )
+                {
+                    walk.m_Delegate->Invoke( *itr );
+                }
+                else
+                {
+                    walk.m_Paths->push_back( Helium::Path( itr->m_Path ) );
+                }
+            }
+        }
+
+        for ( std::vector< tstring >::const_iterator itr = subdirectories.begin(), end = subdirectories.end(); itr != end; ++itr )
+        {
+            WalkDirectory( walk, *itr );
+        }
+    }
+
+    void RunWalk( Walk& walk, const tstring& path, u32 threadCount )
+    {
+        walk.m_Root = path;
+
+        // everything we read is appended to the directory it's in
+        if ( !walk.m_Root.empty() && *walk.m_Root.rbegin() != TXT( '/' ) && *walk.m_Root.rbegin() != TXT( '\\' ) )
+        {
+            walk.m_Root += TXT( "/" );
+        }
+
+        if ( !walk.m_Recursive || threadCount == 1 )
+        {
+            WalkDirectory( walk, walk.m_Root );
+            return;
+        }
+
+        ThreadPool pool ( threadCount, "Directory Walk" );
+        walk.m_Pool = &pool;
+
+        WalkTaskArgs* args = new WalkTaskArgs;
+        args->m_Walk = &walk;
+        args->m_Directory = walk.m_Root;
+        pool.Queue( &WalkTask, args );
+
+        pool.Wait();
+
+        if ( walk.m_Failed )
+        {
+            throw Helium::Exception( TXT( "%s" ), walk.m_Error.c_str() );
+        }
+    }
+}
+
+#ifdef WIN32
+
 Directory::Directory()
 : m_Done( true )
 , m_Handle ( INVALID_HANDLE_VALUE )
@@ -78,28 +463,6 @@ bool Directory::Open(const tstring &path, const tstring &spec /* = TXT( "" ) */,
     return Find(query);
 }
 
-void Directory::GetFiles( const tstring& path, std::set< Helium::Path >& paths, const tstring& spec, bool recursive )
-{
-    for ( Directory dir( path, spec, DirectoryFlags::SkipDirectories ); !dir.IsDone(); dir.Next() )
-    {
-        const DirectoryItem& item = dir.GetItem();
-        paths.insert( Helium::Path( item.m_Path ) );
-    }
-
-    if ( recursive )
-    {
-        for ( Directory dir ( path, TXT( "*" ), DirectoryFlags::SkipFiles ); !dir.IsDone(); dir.Next() )
-        {
-            GetFiles( dir.GetItem().m_Path, paths, spec, recursive );
-        }
-    }
-}
-
-void Directory::GetFiles( std::set< Helium::Path >& paths, const tstring& spec, bool recursive )
-{
-    GetFiles( m_Path, paths, spec, recursive );
-}
-
 bool Directory::Find(const tstring& query)
 {
     DWORD error = 0x0;
@@ -252,4 +615,52 @@ void Helium::RecurseDirectories( DirectoryItemSignature::Delegate delegate, cons
             RecurseDirectories( delegate, dir.GetItem().m_Path, spec, flags );
         }
     }
-}
\ No newline at end of file
+}
+
+#endif
+
+void Directory::GetFiles( const tstring& path, std::set< Helium::Path >& paths, const tstring& spec, bool recursive )
+{
+    std::vector< Helium::Path > found;
+    GetFiles( path, found, spec, recursive );
+
+    paths.insert( found.begin(), found.end() );
+}
+
+void Directory::GetFiles( std::set< Helium::Path >& paths, const tstring& spec, bool recursive )
+{
+    GetFiles( m_Path, paths, spec, recursive );
+}
+
+void Directory::GetFiles( const tstring& path, std::vector< Helium::Path >& paths, const tstring& spec, bool recursive, bool sorted )
+{
+    size_t start = paths.size();
+
+    Walk walk;
+    walk.m_Spec = spec;
+    walk.m_Flags = DirectoryFlags::SkipDirectories;
+    walk.m_Recursive = recursive;
+    walk.m_Paths = &paths;
+
+    RunWalk( walk, path, 0 );
+
+    if ( sorted )
+    {
+        std::sort( paths.begin() + start, paths.end() );
+    }
+}
+
+void Directory::GetFiles( std::vector< Helium::Path >& paths, const tstring& spec, bool recursive, bool sorted )
+{
+    GetFiles( m_Path, paths, spec, recursive, sorted );
+}
+
+void Helium::WalkDirectories( DirectoryItemSignature::Delegate delegate, const tstring &path, const tstring &spec, u32 flags, u32 threadCount )
+{
+    Walk walk;
+    walk.m_Spec = spec;
+    walk.m_Flags = flags;
+    walk.m_Delegate = &delegate;
+
+    RunWalk( walk, path, threadCount );
+}
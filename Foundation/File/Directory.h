@@ -1,5 +1,8 @@
 #pragma once
 
+#include <set>
+#include <vector>
+
 #include "Platform/Types.h"
 
 #include "Foundation/API.h"
@@ -27,6 +30,7 @@ namespace Helium
         enum Flags
         {
             Directory   = 1 << 1,                 // It's actually a directory
+            Link        = 1 << 2,                 // It's a link or reparse point, recursive walks don't go through it
         };
 
         const u32 Default = 0;
@@ -75,6 +79,10 @@ namespace Helium
         static void GetFiles( const tstring& path, std::set< Helium::Path >& paths, const tstring& spec = TXT( "*.*" ), bool recursive = false );
         void GetFiles( std::set< Helium::Path >& paths, const tstring& spec = TXT( "*.*" ), bool recursive = false );
 
+        // recursive searches read subdirectories in parallel, the paths come back in no particular order unless they're sorted
+        static void GetFiles( const tstring& path, std::vector< Helium::Path >& paths, const tstring& spec = TXT( "*.*" ), bool recursive = false, bool sorted = false );
+        void GetFiles( std::vector< Helium::Path >& paths, const tstring& spec = TXT( "*.*" ), bool recursive = false, bool sorted = false );
+
     private:
         bool Find(const tstring& query = TXT( "" ));
         void Close();
@@ -90,4 +98,14 @@ namespace Helium
     typedef Helium::Signature< const DirectoryItem&> DirectoryItemSignature;
 
     FOUNDATION_API void RecurseDirectories( DirectoryItemSignature::Delegate delegate, const tstring &path, const tstring &spec = TXT( "*.*" ), u32 flags = DirectoryFlags::Default);
+
+    //
+    // WalkDirectories is RecurseDirectories spread across a pool of threads, each directory is read by whichever
+    //  thread gets to it first and its subdirectories are handed out to the rest.  The delegate is only ever
+    //  called from one thread at a time, with a directory's items together but directories in no particular order.
+    //  RelativePath items are relative to the path the walk started at.  A thread count of zero is one per processor.
+    //  Links aren't walked through.  The first exception any thread hits stops the walk and is thrown from here.
+    //
+
+    FOUNDATION_API void WalkDirectories( DirectoryItemSignature::Delegate delegate, const tstring &path, const tstring &spec = TXT( "*.*" ), u32 flags = DirectoryFlags::Default, u32 threadCount = 0 );
 }
\ No newline at end of file
@@ -2,17 +2,63 @@
 
 #include "Foundation/Log.h"
 
-#include "Platform/Windows/Windows.h"
+#include "Platform/Profile.h"
+
+#ifdef WIN32
+# include "Platform/Windows/Windows.h"
+#else
+# include <sys/inotify.h>
+# include <sys/stat.h>
+# include <dirent.h>
+# include <errno.h>
+# include <poll.h>
+# include <string.h>
+# include <unistd.h>
+#endif
+
 #include "Path.h"
 
 using namespace Helium;
 
+namespace
+{
+    // true if path is the watched path or directly inside it, or anywhere under it for a subtree watch
+    bool IsUnder( const tstring& path, const tstring& root, bool subtree )
+    {
+        if ( path == root )
+        {
+            return true;
+        }
+
+        if ( path.length() <= root.length() + 1 || path.compare( 0, root.length(), root ) != 0 || path[ root.length() ] != TXT( '/' ) )
+        {
+            return false;
+        }
+
+        return subtree || path.find( TXT( '/' ), root.length() + 1 ) == tstring::npos;
+    }
+
+    tstring TrimSeparator( const tstring& path )
+    {
+        tstring result = path;
+
+        while ( result.length() > 1 && *result.rbegin() == TXT( '/' ) )
+        {
+            result.erase( result.length() - 1 );
+        }
+
+        return result;
+    }
+}
+
+#ifdef WIN32
+
 void EmitLastError()
 {
     DWORD error = GetLastError();
     LPVOID lpMsgBuf;
     FormatMessage(
-        FORMAT_MESSAGE_ALLOCATE_BUFFER | 
+        FORMAT_MESSAGE_ALLOCATE_BUFFER |
         FORMAT_MESSAGE_FROM_SYSTEM |
         FORMAT_MESSAGE_IGNORE_INSERTS,
         NULL,
@@ -27,58 +73,59 @@ void EmitLastError()
 }
 
 FileWatcher::FileWatcher()
+: m_Debounce( DefaultFileWatchDebounce )
+, m_MaxDelay( DefaultFileWatchMaxDelay )
 {
 }
 
 FileWatcher::~FileWatcher()
 {
+    while ( !m_Watches.empty() )
+    {
+        Close( m_Watches.begin()->first );
+    }
 }
 
-bool FileWatcher::Add( const tstring& path, FileChangedSignature::Delegate& listener, bool watchSubtree )
+FileWatch* FileWatcher::Open( const tstring& path, bool watchSubtree )
 {
-    M_PathToFileWatch::const_iterator itr = m_Watches.find( path );
-
-    if ( itr == m_Watches.end() )
+    M_PathToFileWatch::iterator itr = m_Watches.find( path );
+    if ( itr != m_Watches.end() )
     {
+        return &itr->second;
+    }
 
-        m_Watches[ path ].m_Path.Set( path );
-        m_Watches[ path ].m_ChangeHandle = FindFirstChangeNotification( 
-            m_Watches[ path ].m_Path.c_str(),
-            watchSubtree,
-            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE ); // watch for writes
-
+    FileWatch& watch = m_Watches[ path ];
+    watch.m_Path.Set( path );
+    watch.m_WatchSubtree = watchSubtree;
+    watch.m_ChangeHandle = FindFirstChangeNotification(
+        watch.m_Path.c_str(),
+        watchSubtree,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE ); // watch for writes
 
-        if ( m_Watches[ path ].m_ChangeHandle == NULL || m_Watches[ path ].m_ChangeHandle == INVALID_HANDLE_VALUE )
-        {
-            EmitLastError();
+    if ( watch.m_ChangeHandle == NULL || watch.m_ChangeHandle == INVALID_HANDLE_VALUE )
+    {
+        EmitLastError();
 
-            m_Watches.erase( path );
-            return false;
-        }
+        m_Watches.erase( path );
+        return NULL;
     }
 
-    m_Watches[ path ].m_Event.Add( listener );
-
-    return true;
+    return &watch;
 }
 
-bool FileWatcher::Remove( const tstring& path, FileChangedSignature::Delegate& listener )
+void FileWatcher::Close( const tstring& path )
 {
-    m_Watches[ path ].m_Event.Remove( listener );
-
-    if ( m_Watches[ path ].m_Event.Count() == 0 )
+    M_PathToFileWatch::iterator itr = m_Watches.find( path );
+    if ( itr != m_Watches.end() )
     {
-        FindCloseChangeNotification( m_Watches[ path ].m_ChangeHandle );
-        m_Watches.erase( path );
+        FindCloseChangeNotification( itr->second.m_ChangeHandle );
+        m_Watches.erase( itr );
     }
-
-    return true;
 }
 
 bool FileWatcher::Watch( int timeout )
 {
     HANDLE changeHandles[ MAXIMUM_WAIT_OBJECTS ];
-    //    FILE_NOTIFY_INFORMATION notificationInformation[1024];
     FileWatch* watches[ MAXIMUM_WAIT_OBJECTS ];
 
     for ( u32 i = 0; i < MAXIMUM_WAIT_OBJECTS; ++i )
@@ -88,7 +135,7 @@ bool FileWatcher::Watch( int timeout )
     }
 
     u32 handleIndex = 0;
-    for ( M_PathToFileWatch::iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end; ++itr )
+    for ( M_PathToFileWatch::iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end && handleIndex < MAXIMUM_WAIT_OBJECTS; ++itr )
     {
         changeHandles[ handleIndex ] = (*itr).second.m_ChangeHandle;
         watches[ handleIndex ] = &( (*itr).second );
@@ -113,20 +160,723 @@ bool FileWatcher::Watch( int timeout )
         return false;
     }
 
-    FileWatch* watch = watches[ changedObject ];
+    std::vector< bool > changed ( handleIndex, false );
+    changed[ changedObject ] = true;
 
-    //memset( notificationInformation, 0, sizeof( notificationInformation ) );
-    //LPDWORD bytesReturned = 0;
-    //ReadDirectoryChangesW( handleIndex, &notificationInformation, sizeof(notificationInformation), watch->m_WatchSubtree, FILE_NOTIFY_ALL, &bytesReturned, NULL, NULL );  
+    // change notifications don't say what changed, so all we can coalesce is how often we say something did
+    u64 start = Helium::TimerGetClock();
+    while ( true )
+    {
+        for ( u32 i = 0; i < handleIndex; ++i )
+        {
+            if ( changed[ i ] && WaitForSingleObject( changeHandles[ i ], 0 ) == WAIT_OBJECT_0 && FindNextChangeNotification( changeHandles[ i ] ) == FALSE )
+            {
+                EmitLastError();
+                return false;
+            }
+        }
 
-    FileChangedArgs changeEvent( watch->m_Path.c_str(), FileOperations::Unknown );
-    watch->m_Event.Raise( changeEvent );
+        u32 elapsed = (u32)Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+        if ( elapsed >= m_MaxDelay )
+        {
+            break;
+        }
 
-    if ( FindNextChangeNotification( changeHandles[ changedObject ] ) == FALSE )
+        DWORD wait = m_Debounce < m_MaxDelay - elapsed ? m_Debounce : m_MaxDelay - elapsed;
+        DWORD result = WaitForMultipleObjects( handleIndex, changeHandles, FALSE, wait );
+        if ( result == WAIT_TIMEOUT )
+        {
+            break;
+        }
+
+        if ( result >= MAXIMUM_WAIT_OBJECTS )
+        {
+            EmitLastError();
+            return false;
+        }
+
+        changed[ result ] = true;
+    }
+
+    std::vector< FileChangedArgs > changes;
+    for ( u32 i = 0; i < handleIndex; ++i )
     {
-        EmitLastError();
+        if ( changed[ i ] )
+        {
+            changes.push_back( FileChangedArgs( watches[ i ]->m_Path.Get(), FileOperations::Unknown ) );
+        }
+    }
+
+    Deliver( changes );
+
+    return true;
+}
+
+#else
+
+#define FILE_WATCH_EVENTS ( IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF )
+
+//
+// Changes coalesces inotify events, keyed on path so each path is reported once
+//
+
+struct FileWatcher::Changes
+{
+    struct Change
+    {
+        u32     m_Operation;
+        tstring m_OldPath;
+
+        Change()
+            : m_Operation( 0 )
+        {
+        }
+    };
+
+    std::map< tstring, Change > m_Changes;
+    std::map< u32, tstring >    m_Moves;        // cookie to where something moved from, waiting for where it moved to
+    std::map< u32, bool >       m_MoveIsDir;
+    bool                        m_Overflowed;   // the kernel dropped events, only a rescan can say what changed
+
+    Changes()
+        : m_Overflowed( false )
+    {
+    }
+
+    void Add( const tstring& path )
+    {
+        std::map< tstring, Change >::iterator itr = m_Changes.find( path );
+        if ( itr == m_Changes.end() )
+        {
+            m_Changes[ path ].m_Operation = FileOperations::Added;
+        }
+        else if ( itr->second.m_Operation == FileOperations::Removed )
+        {
+            // replaced, as far as anyone who saw the old one is concerned it was modified
+            itr->second.m_Operation = FileOperations::Modified;
+        }
+    }
+
+    void Remove( const tstring& path )
+    {
+        std::map< tstring, Change >::iterator itr = m_Changes.find( path );
+        if ( itr == m_Changes.end() )
+        {
+            m_Changes[ path ].m_Operation = FileOperations::Removed;
+        }
+        else if ( itr->second.m_Operation == FileOperations::Added )
+        {
+            // came and went without anybody seeing it
+            m_Changes.erase( itr );
+        }
+        else if ( itr->second.m_Operation & FileOperations::Renamed )
+        {
+            // what went away is the file under its old name
+            tstring oldPath = itr->second.m_OldPath;
+            m_Changes.erase( itr );
+            Remove( oldPath );
+        }
+        else
+        {
+            itr->second.m_Operation = FileOperations::Removed;
+            itr->second.m_OldPath.clear();
+        }
+    }
+
+    void Modify( const tstring& path )
+    {
+        std::map< tstring, Change >::iterator itr = m_Changes.find( path );
+        if ( itr == m_Changes.end() )
+        {
+            m_Changes[ path ].m_Operation = FileOperations::Modified;
+        }
+        else if ( itr->second.m_Operation == FileOperations::Removed )
+        {
+            itr->second.m_Operation = FileOperations::Modified;
+        }
+        else if ( itr->second.m_Operation & FileOperations::Renamed )
+        {
+            itr->second.m_Operation |= FileOperations::Modified;
+        }
+    }
+
+    void Rename( const tstring& oldPath, const tstring& newPath )
+    {
+        Change change;
+        change.m_Operation = FileOperations::Renamed;
+        change.m_OldPath = oldPath;
+
+        std::map< tstring, Change >::iterator itr = m_Changes.find( oldPath );
+        if ( itr != m_Changes.end() )
+        {
+            if ( itr->second.m_Operation == FileOperations::Added )
+            {
+                change.m_Operation = FileOperations::Added;
+                change.m_OldPath.clear();
+            }
+            else if ( itr->second.m_Operation & FileOperations::Renamed )
+            {
+                change.m_Operation = itr->second.m_Operation;
+                change.m_OldPath = itr->second.m_OldPath;
+            }
+            else if ( itr->second.m_Operation == FileOperations::Modified )
+            {
+                change.m_Operation |= FileOperations::Modified;
+            }
+
+            m_Changes.erase( itr );
+        }
+
+        if ( change.m_OldPath == newPath )
+        {
+            // renamed back where it started
+            change.m_Operation = ( change.m_Operation & FileOperations::Modified ) ? FileOperations::Modified : 0;
+            change.m_OldPath.clear();
+
+            if ( change.m_Operation == 0 )
+            {
+                m_Changes.erase( newPath );
+                return;
+            }
+        }
+
+        // whatever was at the new path is gone, overwritten by what moved there
+        m_Changes[ newPath ] = change;
+    }
+};
+
+FileWatcher::FileWatcher()
+: m_Debounce( DefaultFileWatchDebounce )
+, m_MaxDelay( DefaultFileWatchMaxDelay )
+, m_Notify( -1 )
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_Watches.clear();
+    m_Directories.clear();
+
+    if ( m_Notify != -1 )
+    {
+        close( m_Notify );
+    }
+}
+
+FileWatch* FileWatcher::Open( const tstring& path, bool watchSubtree )
+{
+    M_PathToFileWatch::iterator itr = m_Watches.find( path );
+    if ( itr != m_Watches.end() )
+    {
+        return &itr->second;
+    }
+
+    if ( m_Notify == -1 )
+    {
+        m_Notify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+        if ( m_Notify == -1 )
+        {
+            Log::Error( TXT( "Unable to create file watch: %s\n" ), strerror( errno ) );
+            return NULL;
+        }
+    }
+
+    FileWatch& watch = m_Watches[ path ];
+    watch.m_Path.Set( TrimSeparator( path ) );
+    watch.m_WatchSubtree = watchSubtree;
+
+    // a subtree we can only partly watch would miss changes without anyone knowing, so it's not watched at all
+    tstring error;
+    if ( !AddDirectory( watch.m_Path.Get(), watchSubtree, NULL, error ) )
+    {
+        Log::Error( TXT( "%s\n" ), error.c_str() );
+
+        m_Watches.erase( path );
+        Prune();
+        return NULL;
+    }
+
+    return &watch;
+}
+
+void FileWatcher::Close( const tstring& path )
+{
+    m_Watches.erase( path );
+    Prune();
+}
+
+bool FileWatcher::IsWatched( const tstring& directory ) const
+{
+    for ( M_PathToFileWatch::const_iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end; ++itr )
+    {
+        const tstring& root = itr->second.m_Path.Get();
+
+        if ( directory == root || ( itr->second.m_WatchSubtree && IsUnder( directory, root, true ) ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FileWatcher::AddDirectory( const tstring& directory, bool recurse, Changes* changes, tstring& error, bool nested )
+{
+    int wd = inotify_add_watch( m_Notify, directory.c_str(), FILE_WATCH_EVENTS );
+    if ( wd == -1 )
+    {
+        // something removed before we got to it has nothing left to watch, it's only a failure if it's what we were asked for
+        if ( errno == ENOENT && ( nested || changes ) )
+        {
+            return true;
+        }
+
+        // running out of watches (ENOSPC) fails every directory after this one too, so stop at the first
+        error = TXT( "Unable to watch " ) + directory + TXT( ": " ) + strerror( errno );
+        return false;
+    }
+
+    m_Directories[ wd ] = directory;
+
+    if ( !recurse )
+    {
+        return true;
+    }
+
+    DIR* dir = opendir( directory.c_str() );
+    if ( dir == NULL )
+    {
+        // a file, or a directory we can't list, either way there's nothing under it
+        return true;
+    }
+
+    for ( struct dirent* entry = readdir( dir ); entry; entry = readdir( dir ) )
+    {
+        if ( strcmp( entry->d_name, TXT( "." ) ) == 0 || strcmp( entry->d_name, TXT( ".." ) ) == 0 )
+        {
+            continue;
+        }
+
+        tstring path = directory + TXT( '/' ) + entry->d_name;
+
+        // links aren't followed, a link to a parent would have us watching forever
+        bool isDirectory = entry->d_type == DT_DIR;
+        if ( entry->d_type == DT_UNKNOWN )
+        {
+            struct stat st;
+            isDirectory = lstat( path.c_str(), &st ) == 0 && S_ISDIR( st.st_mode );
+        }
+
+        // a directory that showed up after we were watching might have been filled before we could watch it
+        if ( changes )
+        {
+            changes->Add( path );
+        }
+
+        if ( isDirectory && !AddDirectory( path, true, changes, error, true ) )
+        {
+            closedir( dir );
+            return false;
+        }
+    }
+
+    closedir( dir );
+
+    return true;
+}
+
+void FileWatcher::WatchFailed( const tstring& directory, const tstring& error )
+{
+    // every directory made after the watch limit is hit fails the same way, each watch only says so once
+    for ( M_PathToFileWatch::iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end; ++itr )
+    {
+        FileWatch& watch = itr->second;
+        const tstring& root = watch.m_Path.Get();
+
+        if ( !watch.m_Incomplete && ( directory == root || ( watch.m_WatchSubtree && IsUnder( directory, root, true ) ) ) )
+        {
+            watch.m_Incomplete = true;
+            Log::Warning( TXT( "%s, changes under %s will be missed\n" ), error.c_str(), root.c_str() );
+        }
+    }
+}
+
+void FileWatcher::Resync()
+{
+    // renames and deletes we never heard about left our names stale, so walk every watch again from the top,
+    //  directories still there get their existing watch back and anything not seen again is let go
+    std::map< int, tstring > previous;
+    previous.swap( m_Directories );
+
+    for ( M_PathToFileWatch::const_iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end; ++itr )
+    {
+        tstring error;
+        if ( !AddDirectory( itr->second.m_Path.Get(), itr->second.m_WatchSubtree, NULL, error, true ) )
+        {
+            WatchFailed( itr->second.m_Path.Get(), error );
+        }
+    }
+
+    for ( std::map< int, tstring >::const_iterator itr = previous.begin(), end = previous.end(); itr != end; ++itr )
+    {
+        if ( m_Directories.find( itr->first ) == m_Directories.end() )
+        {
+            inotify_rm_watch( m_Notify, itr->first );
+        }
+    }
+}
+
+void FileWatcher::RemoveDirectories( const tstring& directory )
+{
+    for ( std::map< int, tstring >::iterator itr = m_Directories.begin(); itr != m_Directories.end(); )
+    {
+        if ( IsUnder( itr->second, directory, true ) )
+        {
+            inotify_rm_watch( m_Notify, itr->first );
+            m_Directories.erase( itr++ );
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+}
+
+void FileWatcher::RenameDirectories( const tstring& oldDirectory, const tstring& newDirectory )
+{
+    // the watches follow the directory, it's only our names for them that are stale
+    for ( std::map< int, tstring >::iterator itr = m_Directories.begin(), end = m_Directories.end(); itr != end; ++itr )
+    {
+        if ( IsUnder( itr->second, oldDirectory, true ) )
+        {
+            itr->second = newDirectory + itr->second.substr( oldDirectory.length() );
+        }
+    }
+}
+
+void FileWatcher::Prune()
+{
+    for ( std::map< int, tstring >::iterator itr = m_Directories.begin(); itr != m_Directories.end(); )
+    {
+        if ( IsWatched( itr->second ) )
+        {
+            ++itr;
+        }
+        else
+        {
+            inotify_rm_watch( m_Notify, itr->first );
+            m_Directories.erase( itr++ );
+        }
+    }
+}
+
+bool FileWatcher::ReadChanges( Changes& changes )
+{
+    u8 buffer[ 64 * 1024 ] __attribute__ (( aligned( __alignof__( struct inotify_event ) ) ));
+
+    while ( true )
+    {
+        ssize_t size = read( m_Notify, buffer, sizeof( buffer ) );
+        if ( size == -1 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            if ( errno == EAGAIN )
+            {
+                return true;
+            }
+
+            Log::Error( TXT( "Unable to read file changes: %s\n" ), strerror( errno ) );
+            return false;
+        }
+
+        for ( u8* next = buffer; next < buffer + size; )
+        {
+            const struct inotify_event* event = (const struct inotify_event*)next;
+            next += sizeof( struct inotify_event ) + event->len;
+
+            if ( event->mask & IN_Q_OVERFLOW )
+            {
+                changes.m_Overflowed = true;
+                continue;
+            }
+
+            std::map< int, tstring >::iterator found = m_Directories.find( event->wd );
+            if ( found == m_Directories.end() )
+            {
+                // a watch we've already let go of, its last few events can still be in the queue
+                continue;
+            }
+
+            if ( event->mask & IN_IGNORED )
+            {
+                m_Directories.erase( found );
+                continue;
+            }
+
+            tstring path = found->second;
+            if ( event->len && event->name[ 0 ] )
+            {
+                path += TXT( '/' );
+                path += event->name;
+            }
+
+            bool isDirectory = ( event->mask & IN_ISDIR ) != 0;
+
+            if ( event->mask & ( IN_CREATE | IN_MOVED_TO ) )
+            {
+                std::map< u32, tstring >::iterator move = event->mask & IN_MOVED_TO ? changes.m_Moves.find( event->cookie ) : changes.m_Moves.end();
+                if ( move != changes.m_Moves.end() )
+                {
+                    changes.Rename( move->second, path );
+
+                    if ( isDirectory )
+                    {
+                        RenameDirectories( move->second, path );
+                    }
+
+                    changes.m_Moves.erase( move );
+                    changes.m_MoveIsDir.erase( event->cookie );
+                }
+                else
+                {
+                    changes.Add( path );
+
+                    tstring error;
+                    if ( isDirectory && IsWatched( path ) && !AddDirectory( path, true, &changes, error ) )
+                    {
+                        WatchFailed( path, error );
+                    }
+                }
+            }
+            else if ( event->mask & IN_MOVED_FROM )
+            {
+                // hold on to it until we see where it went
+                changes.m_Moves[ event->cookie ] = path;
+                changes.m_MoveIsDir[ event->cookie ] = isDirectory;
+            }
+            else if ( event->mask & ( IN_DELETE | IN_DELETE_SELF ) )
+            {
+                // a deleted directory's own watch reports it too, we only need to hear it once
+                if ( !( event->mask & IN_DELETE_SELF ) || !IsWatched( path.substr( 0, path.rfind( TXT( '/' ) ) ) ) )
+                {
+                    changes.Remove( path );
+                }
+            }
+            else if ( event->mask & ( IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB ) )
+            {
+                if ( !isDirectory )
+                {
+                    changes.Modify( path );
+                }
+            }
+        }
+    }
+}
+
+bool FileWatcher::Watch( int timeout )
+{
+    if ( m_Watches.empty() || m_Notify == -1 )
+    {
+        // nothing to watch
+        return true;
+    }
+
+    struct pollfd fd;
+    fd.fd = m_Notify;
+    fd.events = POLLIN;
+    fd.revents = 0;
+
+    int result = poll( &fd, 1, timeout );
+    if ( result == 0 || ( result == -1 && errno == EINTR ) )
+    {
+        return true;
+    }
+
+    if ( result == -1 )
+    {
+        Log::Error( TXT( "Unable to wait for file changes: %s\n" ), strerror( errno ) );
         return false;
     }
 
+    Changes changes;
+
+    // a sync touches thousands of files in a burst, keep reading until it settles down so it's handed out all at once
+    u64 start = Helium::TimerGetClock();
+    while ( true )
+    {
+        if ( !ReadChanges( changes ) )
+        {
+            return false;
+        }
+
+        u32 elapsed = (u32)Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+        if ( elapsed >= m_MaxDelay )
+        {
+            break;
+        }
+
+        u32 wait = m_Debounce < m_MaxDelay - elapsed ? m_Debounce : m_MaxDelay - elapsed;
+        result = poll( &fd, 1, (int)wait );
+        if ( result == 0 )
+        {
+            break;
+        }
+
+        if ( result == -1 && errno != EINTR )
+        {
+            Log::Error( TXT( "Unable to wait for file changes: %s\n" ), strerror( errno ) );
+            return false;
+        }
+    }
+
+    // anything that moved away and never showed up again left the watched tree
+    for ( std::map< u32, tstring >::const_iterator itr = changes.m_Moves.begin(), end = changes.m_Moves.end(); itr != end; ++itr )
+    {
+        changes.Remove( itr->second );
+
+        if ( changes.m_MoveIsDir[ itr->first ] )
+        {
+            RemoveDirectories( itr->second );
+        }
+    }
+
+    std::vector< FileChangedArgs > changed;
+
+    if ( changes.m_Overflowed )
+    {
+        // the kernel ran out of room, all we can say is that something changed somewhere
+        Log::Warning( TXT( "File change queue overflowed, changes were lost\n" ) );
+
+        Resync();
+
+        for ( M_PathToFileWatch::const_iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end; ++itr )
+        {
+            changed.push_back( FileChangedArgs( itr->second.m_Path.Get(), FileOperations::Unknown ) );
+        }
+    }
+
+    for ( std::map< tstring, Changes::Change >::const_iterator itr = changes.m_Changes.begin(), end = changes.m_Changes.end(); itr != end; ++itr )
+    {
+        changed.push_back( FileChangedArgs( itr->first, (FileOperation)itr->second.m_Operation, itr->second.m_OldPath ) );
+    }
+
+    Deliver( changed );
+
+    return true;
+}
+
+#endif
+
+bool FileWatcher::Add( const tstring& path, FileChangedSignature::Delegate& listener, bool watchSubtree )
+{
+    FileWatch* watch = Open( path, watchSubtree );
+    if ( watch == NULL )
+    {
+        return false;
+    }
+
+    watch->m_Event.Add( listener );
+
+    return true;
+}
+
+bool FileWatcher::Add( const tstring& path, FileChangeBatchSignature::Delegate& listener, bool watchSubtree )
+{
+    FileWatch* watch = Open( path, watchSubtree );
+    if ( watch == NULL )
+    {
+        return false;
+    }
+
+    watch->m_BatchEvent.Add( listener );
+
+    return true;
+}
+
+bool FileWatcher::Remove( const tstring& path, FileChangedSignature::Delegate& listener )
+{
+    M_PathToFileWatch::iterator itr = m_Watches.find( path );
+    if ( itr == m_Watches.end() )
+    {
+        return false;
+    }
+
+    itr->second.m_Event.Remove( listener );
+
+    if ( itr->second.m_Event.Count() == 0 && itr->second.m_BatchEvent.Count() == 0 )
+    {
+        Close( path );
+    }
+
+    return true;
+}
+
+bool FileWatcher::Remove( const tstring& path, FileChangeBatchSignature::Delegate& listener )
+{
+    M_PathToFileWatch::iterator itr = m_Watches.find( path );
+    if ( itr == m_Watches.end() )
+    {
+        return false;
+    }
+
+    itr->second.m_BatchEvent.Remove( listener );
+
+    if ( itr->second.m_Event.Count() == 0 && itr->second.m_BatchEvent.Count() == 0 )
+    {
+        Close( path );
+    }
+
     return true;
 }
+
+void FileWatcher::Deliver( const std::vector< FileChangedArgs >& changes )
+{
+    if ( changes.empty() )
+    {
+        return;
+    }
+
+    // listeners are free to add and remove watches, so look each one up again before raising its events
+    std::vector< tstring > keys;
+    for ( M_PathToFileWatch::const_iterator itr = m_Watches.begin(), end = m_Watches.end(); itr != end; ++itr )
+    {
+        keys.push_back( itr->first );
+    }
+
+    for ( std::vector< tstring >::const_iterator key = keys.begin(), keyEnd = keys.end(); key != keyEnd; ++key )
+    {
+        M_PathToFileWatch::iterator found = m_Watches.find( *key );
+        if ( found == m_Watches.end() )
+        {
+            continue;
+        }
+
+        // copy the watch so our events and path outlive anything the listeners do
+        FileWatch watch = found->second;
+        FileChangeBatchArgs batch ( watch.m_Path );
+
+        for ( std::vector< FileChangedArgs >::const_iterator itr = changes.begin(), end = changes.end(); itr != end; ++itr )
+        {
+            if ( IsUnder( itr->m_Path, watch.m_Path.Get(), watch.m_WatchSubtree ) || ( !itr->m_OldPath.empty() && IsUnder( itr->m_OldPath, watch.m_Path.Get(), watch.m_WatchSubtree ) ) )
+            {
+                batch.m_Changes.push_back( *itr );
+            }
+        }
+
+        if ( batch.m_Changes.empty() )
+        {
+            continue;
+        }
+
+        watch.m_BatchEvent.Raise( batch );
+
+        for ( std::vector< FileChangedArgs >::const_iterator itr = batch.m_Changes.begin(), end = batch.m_Changes.end(); itr != end; ++itr )
+        {
+            watch.m_Event.Raise( *itr );
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 
 #include "Foundation/API.h"
 #include "Foundation/Automation/Event.h"
@@ -39,18 +40,43 @@ namespace Helium
     };
     typedef Helium::Signature< const FileChangedArgs& > FileChangedSignature;
 
+    //
+    // Every change seen under a watched path in one go, coalesced so each path shows up once
+    //  A file written many times is Modified once, one added and then removed doesn't show up at all,
+    //  and a rename carries the path the file had before the batch started
+    //
+
+    struct FOUNDATION_API FileChangeBatchArgs
+    {
+        const Path&                     m_Path;
+        std::vector< FileChangedArgs >  m_Changes;
+
+        FileChangeBatchArgs( const Path& path )
+            : m_Path( path )
+        {
+        }
+    };
+    typedef Helium::Signature< const FileChangeBatchArgs& > FileChangeBatchSignature;
+
+    // a batch is delivered once nothing has changed for this long, or once it's been collecting for the max delay
+    const static u32 DefaultFileWatchDebounce = 100;
+    const static u32 DefaultFileWatchMaxDelay = 1000;
+
     typedef void* HANDLE;
     struct FOUNDATION_API FileWatch
     {
-        HANDLE                      m_ChangeHandle;
-        FileChangedSignature::Event m_Event;
-        Path                        m_Path;
-        bool                        m_WatchSubtree;
+        HANDLE                              m_ChangeHandle;
+        FileChangedSignature::Event         m_Event;
+        FileChangeBatchSignature::Event     m_BatchEvent;
+        Path                                m_Path;
+        bool                                m_WatchSubtree;
+        bool                                m_Incomplete;       // part of the subtree couldn't be watched, already reported
 
 
         FileWatch()
             : m_ChangeHandle( NULL )
             , m_WatchSubtree( false )
+            , m_Incomplete( false )
         {
         }
     };
@@ -63,13 +89,51 @@ namespace Helium
     {
     private:
         M_PathToFileWatch m_Watches;
+        u32 m_Debounce;
+        u32 m_MaxDelay;
+
+#ifndef WIN32
+        struct Changes;
+
+        int m_Notify;                               // inotify instance, opened with the first watch
+        std::map< int, tstring > m_Directories;     // inotify watch descriptor to the path it watches
+#endif
 
     public:
         FileWatcher();
         ~FileWatcher();
 
         bool Add( const tstring& path, FileChangedSignature::Delegate& listener, bool watchSubtree = false  );
+        bool Add( const tstring& path, FileChangeBatchSignature::Delegate& listener, bool watchSubtree = false  );
         bool Remove( const tstring& path, FileChangedSignature::Delegate& listener );
+        bool Remove( const tstring& path, FileChangeBatchSignature::Delegate& listener );
+
+        // how long to wait for things to settle down before handing out what changed
+        void SetDebounce( u32 debounce, u32 maxDelay = DefaultFileWatchMaxDelay )
+        {
+            m_Debounce = debounce;
+            m_MaxDelay = maxDelay;
+        }
+
+        // wait for changes and deliver them, returns true on a timeout with nothing changed
         bool Watch( int timeout = 0xFFFFFFFF );
+
+    private:
+        FileWatch* Open( const tstring& path, bool watchSubtree );
+        void Close( const tstring& path );
+
+        // deliver a batch to the listeners of every watch it falls under
+        void Deliver( const std::vector< FileChangedArgs >& changes );
+
+#ifndef WIN32
+        bool IsWatched( const tstring& directory ) const;
+        bool AddDirectory( const tstring& directory, bool recurse, Changes* changes, tstring& error, bool nested = false );
+        void WatchFailed( const tstring& directory, const tstring& error );
+        void Resync();
+        void RemoveDirectories( const tstring& directory );
+        void RenameDirectories( const tstring& oldDirectory, const tstring& newDirectory );
+        void Prune();
+        bool ReadChanges( Changes& changes );
+#endif
     };
 }
\ No newline at end of file
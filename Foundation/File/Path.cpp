@@ -6,6 +6,7 @@
 
 #include "Platform/Exception.h"
 #include "Foundation/Checksum/Crc32.h"
+#include "Foundation/Checksum/FileHash.h"
 #include "Foundation/Checksum/MD5.h"
 #include "Foundation/Checksum/MurmurHash2.h"
 
@@ -588,7 +589,14 @@ bool Path::VerifyFileCRC( const tstring& hash ) const
 
 tstring Path::FileMD5() const
 {
-    return Helium::FileMD5( m_Path.c_str() );
+    // unchanged files are answered from the cache without being read
+    tstring hash;
+    if ( !Helium::GetFileHashCache().Hash( m_Path, FileHashTypes::MD5, hash ) )
+    {
+        throw Helium::Exception( TXT( "Unable to open %s for read" ), m_Path.c_str() );
+    }
+
+    return hash;
 }
 
 bool Path::VerifyFileMD5( const tstring& hash ) const
@@ -169,7 +169,7 @@ Message* Connection::CreateMessage(u32 id, u32 size, i32 trans, u32 type)
         }
     }
 
-    IPC::Message* msg = new Message (id, trans, size, type);
+    IPC::Message* msg = Message::Create(id, trans, size, type);
 
     if (!msg)
     {
@@ -197,9 +197,9 @@ bool Connection::CreatedMessage(i32 transaction)
     }
 }
 
-void Connection::Wait()
+bool Connection::Wait(u32 timeout)
 {
-    m_ReadQueue.Wait();
+    return m_ReadQueue.Wait(timeout);
 }
 
 ConnectionState Connection::Send(Message* message)
@@ -283,18 +283,43 @@ bool Connection::WritePump()
 {
     bool result = false;
 
+    Message* msgs[ IPC_WRITE_BATCH_COUNT ];
+    u32 count = 0;
+
+    // block for the first message, then take whatever else is already waiting so it goes out together
     Message* msg = m_WriteQueue.Remove();
-    if (msg)
+    while (msg)
+    {
+        msgs[ count++ ] = msg;
+
+        if (count == IPC_WRITE_BATCH_COUNT || m_WriteQueue.Count() == 0)
+        {
+            break;
+        }
+
+        msg = m_WriteQueue.Remove();
+    }
+
+    if (count)
     {
         // the result will be true unless there was heinous breakage
-        result = WriteMessage(msg);
+        result = WriteMessages(msgs, count);
 
+        for (u32 i = 0; i < count; ++i)
+        {
 #ifdef IPC_CONNECTION_DEBUG
-        Helium::Print("%s: Put message %d, id '%d', transaction '%d', size '%d'\n", m_Name, msg->GetNumber(), msg->GetID(), msg->GetTransaction(), msg->GetSize());
+            Helium::Print("%s: Put message %d, id '%d', transaction '%d', size '%d'\n", m_Name, msgs[i]->GetNumber(), msgs[i]->GetID(), msgs[i]->GetTransaction(), msgs[i]->GetSize());
 #endif
 
-        // free the memory
-        delete msg;
+            // free the memory
+            delete msgs[i];
+        }
+
+        // a null in the middle of the batch was a wakeup to shut down, let the write thread see it
+        if (msg == NULL)
+        {
+            result = false;
+        }
     }
 
     // there was a failure
@@ -307,6 +332,19 @@ bool Connection::WritePump()
     return result;
 }
 
+bool Connection::WriteMessages(Message** msgs, u32 count)
+{
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (!WriteMessage(msgs[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void Connection::ReadThread()
 {
     while (1)
@@ -8,6 +8,9 @@
 
 #include "Foundation/Localization.h"
 
+// most messages the write thread drains from the queue in one go
+const static u32 IPC_WRITE_BATCH_COUNT = 32;
+
 namespace Helium
 {
     namespace IPC
@@ -115,8 +118,8 @@ namespace Helium
             // did this endpoint create the specified transaction
             bool CreatedMessage(i32 transaction);
 
-            // wait in the calling thread for a message
-            void Wait();
+            // wait in the calling thread for a message, false if the timeout (in millis) passed first
+            bool Wait(u32 timeout = 0xffffffff);
 
 
             //
@@ -155,6 +158,9 @@ namespace Helium
             virtual bool ReadMessage(Message** msg) = 0;
             virtual bool WriteMessage(Message* msg) = 0;
 
+            // Writes a batch of messages drained from the write queue, by default one at a time
+            virtual bool WriteMessages(Message** msgs, u32 count);
+
             // These synchronously read or write data through the connection
             virtual bool Read(void* buffer, u32 bytes) = 0;
             virtual bool Write(void* buffer, u32 bytes) = 0;
@@ -1,9 +1,250 @@
 #include "Platform/API.h"
 #include "Message.h"
 #include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Platform.h"
+
+#include <string.h>
 
 using namespace Helium::IPC;
 
+namespace
+{
+    // blocks run from 128 bytes up to 128k, bigger messages aren't worth keeping around
+    const u32 MESSAGE_POOL_CLASS_COUNT = 11;
+    const u32 MESSAGE_POOL_MIN_SIZE = 128;
+
+    // how much free storage each class holds on to before it starts giving blocks back to the heap
+    const u32 MESSAGE_POOL_CLASS_LIMIT = 2 * 1024 * 1024;
+
+    // every block starts with its class, padded out so what follows stays 16 byte aligned
+    const u32 MESSAGE_BLOCK_HEADER_SIZE = 16;
+
+    // the payload follows the message, on a 16 byte boundary
+    const u32 MESSAGE_DATA_OFFSET = ( sizeof( Message ) + 15 ) & ~15;
+
+    // the most blocks any one class will hold on to
+    const u32 MESSAGE_POOL_MAX_SLOTS = 4096;
+
+    //
+    // FreeRing is a bounded multiple producer, multiple consumer ring of free blocks
+    //  Each slot carries a sequence number that says which lap of the ring it is ready for, so a
+    //  thread that loses the race for a slot just moves on to the next one instead of waiting on a lock.
+    //
+
+    struct FreeSlot
+    {
+        volatile i32    m_Sequence;
+        void*           m_Block;
+    };
+
+    class FreeRing
+    {
+    private:
+        FreeSlot*       m_Slots;
+        u32             m_Mask;
+        u8              m_Pad0[ 64 ];
+        volatile i32    m_PushPosition;
+        u8              m_Pad1[ 64 ];
+        volatile i32    m_PopPosition;
+        u8              m_Pad2[ 64 ];
+
+    public:
+        FreeRing()
+            : m_Slots (NULL)
+            , m_Mask (0)
+            , m_PushPosition (0)
+            , m_PopPosition (0)
+        {
+        }
+
+        ~FreeRing()
+        {
+            // messages freed during shutdown after this go straight back to the heap
+            delete [] m_Slots;
+            m_Slots = NULL;
+        }
+
+        // count must be a power of two
+        void Initialize(u32 count)
+        {
+            m_Slots = new FreeSlot[ count ];
+            m_Mask = count - 1;
+
+            for (u32 i = 0; i < count; ++i)
+            {
+                m_Slots[ i ].m_Sequence = i;
+                m_Slots[ i ].m_Block = NULL;
+            }
+        }
+
+        // returns false if the ring is full
+        bool Push(void* block)
+        {
+            if (m_Slots == NULL)
+            {
+                return false;
+            }
+
+            i32 position = m_PushPosition;
+            while (true)
+            {
+                FreeSlot& slot = m_Slots[ position & m_Mask ];
+                i32 difference = (i32)( (u32)slot.m_Sequence - (u32)position );
+
+                if (difference == 0)
+                {
+                    i32 previous = Helium::AtomicCompareExchange( &m_PushPosition, (i32)( (u32)position + 1 ), position );
+                    if (previous == position)
+                    {
+                        slot.m_Block = block;
+                        Helium::AtomicExchange( &slot.m_Sequence, (i32)( (u32)position + 1 ) );
+                        return true;
+                    }
+
+                    position = previous;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_PushPosition;
+                }
+            }
+        }
+
+        // returns NULL if the ring is empty
+        void* Pop()
+        {
+            if (m_Slots == NULL)
+            {
+                return NULL;
+            }
+
+            i32 position = m_PopPosition;
+            while (true)
+            {
+                FreeSlot& slot = m_Slots[ position & m_Mask ];
+                i32 difference = (i32)( (u32)slot.m_Sequence - (u32)( position + 1 ) );
+
+                if (difference == 0)
+                {
+                    i32 previous = Helium::AtomicCompareExchange( &m_PopPosition, (i32)( (u32)position + 1 ), position );
+                    if (previous == position)
+                    {
+                        void* block = slot.m_Block;
+                        Helium::AtomicExchange( &slot.m_Sequence, (i32)( (u32)position + m_Mask + 1 ) );
+                        return block;
+                    }
+
+                    position = previous;
+                }
+                else if (difference < 0)
+                {
+                    return NULL;
+                }
+                else
+                {
+                    position = m_PopPosition;
+                }
+            }
+        }
+    };
+
+    u32 GetClassSize(u32 size_class)
+    {
+        return MESSAGE_POOL_MIN_SIZE << size_class;
+    }
+
+    // returns MESSAGE_POOL_CLASS_COUNT if the size is bigger than any class
+    u32 GetSizeClass(u32 size)
+    {
+        u32 size_class = 0;
+        while (size_class < MESSAGE_POOL_CLASS_COUNT && GetClassSize(size_class) < size)
+        {
+            ++size_class;
+        }
+
+        return size_class;
+    }
+
+    struct FreeRings
+    {
+        FreeRing m_Rings[ MESSAGE_POOL_CLASS_COUNT ];
+
+        FreeRings()
+        {
+            for (u32 size_class = 0; size_class < MESSAGE_POOL_CLASS_COUNT; ++size_class)
+            {
+                u32 count = MESSAGE_POOL_CLASS_LIMIT / GetClassSize(size_class);
+                m_Rings[ size_class ].Initialize( count < MESSAGE_POOL_MAX_SLOTS ? count : MESSAGE_POOL_MAX_SLOTS );
+            }
+        }
+
+        ~FreeRings()
+        {
+            MessagePool::Trim();
+        }
+    };
+
+    FreeRings g_FreeRings;
+}
+
+void* MessagePool::Allocate(u32 size)
+{
+    u32 size_class = GetSizeClass(size + MESSAGE_BLOCK_HEADER_SIZE);
+
+    u8* block = NULL;
+    if (size_class == MESSAGE_POOL_CLASS_COUNT)
+    {
+        block = new u8[ size + MESSAGE_BLOCK_HEADER_SIZE ];
+    }
+    else
+    {
+        block = (u8*)g_FreeRings.m_Rings[ size_class ].Pop();
+        if (block == NULL)
+        {
+            block = new u8[ GetClassSize(size_class) ];
+        }
+    }
+
+    *(u32*)block = size_class;
+    return block + MESSAGE_BLOCK_HEADER_SIZE;
+}
+
+void MessagePool::Free(void* ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    u8* block = (u8*)ptr - MESSAGE_BLOCK_HEADER_SIZE;
+    u32 size_class = *(u32*)block;
+
+    if (size_class < MESSAGE_POOL_CLASS_COUNT && g_FreeRings.m_Rings[ size_class ].Push(block))
+    {
+        return;
+    }
+
+    delete [] block;
+}
+
+void MessagePool::Trim()
+{
+    for (u32 size_class = 0; size_class < MESSAGE_POOL_CLASS_COUNT; ++size_class)
+    {
+        FreeRing& ring = g_FreeRings.m_Rings[ size_class ];
+
+        for (void* block = ring.Pop(); block; block = ring.Pop())
+        {
+            delete [] (u8*)block;
+        }
+    }
+}
+
 Message::Message(u32 id, i32 trn, u32 size, u32 type)
 : MessageHeader( id, trn, size, type )
 , m_Next (NULL)
@@ -11,7 +252,8 @@ Message::Message(u32 id, i32 trn, u32 size, u32 type)
 {
     if (size)
     {
-        m_Data = new u8[size];
+        // operator new made room for the payload behind us
+        m_Data = (u8*)this + MESSAGE_DATA_OFFSET;
     }
     else
     {
@@ -21,18 +263,53 @@ Message::Message(u32 id, i32 trn, u32 size, u32 type)
 
 Message::~Message()
 {
-    if (m_Data)
+    // the payload goes back to the pool with the message
+    m_Data = 0;
+}
+
+void* Message::operator new(size_t size, u32 data_size)
+{
+    HELIUM_ASSERT(size == sizeof(Message));
+    return MessagePool::Allocate( MESSAGE_DATA_OFFSET + data_size );
+}
+
+void Message::operator delete(void* ptr, u32 data_size)
+{
+    MessagePool::Free(ptr);
+}
+
+void Message::operator delete(void* ptr)
+{
+    MessagePool::Free(ptr);
+}
+
+Message* Message::Create(u32 id, i32 trans, u32 size, u32 type)
+{
+    return new (size) Message (id, trans, size, type);
+}
+
+u8* Message::TakeData()
+{
+    if (m_Data == NULL)
     {
-        delete [] m_Data;
-        m_Data = 0;
+        return NULL;
     }
+
+    u8* data = new u8[m_Size];
+    memcpy(data, m_Data, m_Size);
+    m_Data = NULL;
+
+    return data;
 }
 
 MessageQueue::MessageQueue()
-: m_Head (0)
-, m_Tail (0)
+: m_Head (&m_Stub)
+, m_Tail (&m_Stub)
+, m_Stub (0, 0, 0, 0)
 , m_Count (0)
 , m_Total (0)
+, m_Wakeups (0)
+, m_Sleeping (0)
 {
 
 }
@@ -42,79 +319,156 @@ MessageQueue::~MessageQueue()
     Clear();
 }
 
-void MessageQueue::Add(Message* msg)
+void MessageQueue::Push(Message* msg)
 {
-    IPC_SCOPE_TIMER("");
+    msg->m_Next = NULL;
 
-    if (msg)
-    {
-        Helium::TakeMutex mutex (m_Mutex);
+    // claim the tail, after this the queue runs through us even though nothing links to us yet
+    Message* prev = (Message*)Helium::AtomicExchangePointer( (void* volatile*)&m_Tail, msg );
 
-        if (m_Tail == 0)
-        {
-            // header must also be zero and count must be zero
-            if(m_Count !=0)
-            {
-                HELIUM_BREAK();
-            }
-            if (m_Head != 0)
-            {
-                HELIUM_BREAK();
-            }
+    // link the old tail to us, the consumer waits on this if it catches up in between
+    *(Message* volatile*)&prev->m_Next = msg;
+}
 
-            msg->m_Next = 0;
-            m_Head = msg;
-            m_Tail = msg;
-        }
-        else
+Message* MessageQueue::Pop()
+{
+    Message* head = m_Head;
+    Message* next = *(Message* volatile*)&head->m_Next;
+
+    // step over the stub if it is at the front
+    if (head == &m_Stub)
+    {
+        if (next == NULL)
         {
-            Message* end = m_Tail;
+            return NULL;
+        }
 
-            // tail points to new message
-            m_Tail = msg;
+        m_Head = next;
+        head = next;
+        next = *(Message* volatile*)&head->m_Next;
+    }
 
-            // old end message points to us
-            end->m_Next = msg;
+    if (next)
+    {
+        m_Head = next;
+        return head;
+    }
 
-            // we point to null
-            msg->m_Next = 0;       
+    // a producer has swapped the tail but hasn't linked to it yet
+    if (head != m_Tail)
+    {
+        return NULL;
+    }
+
+    // head is the last message, put the stub behind it so we can take it without emptying the list
+    Push(&m_Stub);
+
+    next = *(Message* volatile*)&head->m_Next;
+    if (next)
+    {
+        m_Head = next;
+        return head;
+    }
+
+    return NULL;
+}
+
+bool MessageQueue::WaitForWork(u32 timeout)
+{
+    // full barrier, after this any producer that adds work will see us sleeping
+    Helium::AtomicExchange( &m_Sleeping, 1 );
+
+    if (m_Count > 0 || m_Wakeups > 0)
+    {
+        // work arrived while we were getting ready to sleep
+        if (Helium::AtomicExchange( &m_Sleeping, 0 ) == 0)
+        {
+            // a producer beat us to it and has signaled (or is about to), consume that signal
+            m_Append.Decrement();
         }
 
-        m_Count++;
-        m_Total++;
-        msg->SetNumber( m_Total );
+        return true;
     }
 
-    m_Append.Increment();
+    if (m_Append.Decrement(timeout))
+    {
+        return true;
+    }
+
+    // timed out, but a producer may have claimed the wakeup just now and be about to signal it
+    if (Helium::AtomicExchange( &m_Sleeping, 0 ) == 0)
+    {
+        m_Append.Decrement();
+        return true;
+    }
+
+    return false;
 }
 
-Message* MessageQueue::Remove()
+void MessageQueue::WakeConsumer()
+{
+    // the plain read keeps the common case, a consumer that is busy, free of interlocked operations
+    if (m_Sleeping && Helium::AtomicExchange( &m_Sleeping, 0 ))
+    {
+        m_Append.Increment();
+    }
+}
+
+void MessageQueue::Add(Message* msg)
 {
     IPC_SCOPE_TIMER("");
 
-    m_Append.Decrement();
+    if (msg)
+    {
+        msg->SetNumber( Helium::AtomicIncrement( &m_Total ) );
+
+        // count it before it is linked so the consumer can never pop it and decrement first
+        Helium::AtomicIncrement( &m_Count );
 
-    Helium::TakeMutex mutex (m_Mutex);
+        Push(msg);
+    }
+    else
+    {
+        // a null message just wakes up the consumer, Remove will return null for it
+        Helium::AtomicIncrement( &m_Wakeups );
+    }
+
+    WakeConsumer();
+}
+
+Message* MessageQueue::Remove()
+{
+    IPC_SCOPE_TIMER("");
 
-    Message* result = 0;
-    if (m_Head != 0)
+    while (true)
     {
-        m_Count--;
+        {
+            Helium::TakeMutex mutex (m_Mutex);
 
-        // take the head of the queue
-        result = m_Head;
+            Message* result = Pop();
+            if (result)
+            {
+                Helium::AtomicDecrement( &m_Count );
+                return result;
+            }
 
-        // move the the head dow
-        m_Head = m_Head->m_Next;
+            if (m_Wakeups > 0)
+            {
+                Helium::AtomicDecrement( &m_Wakeups );
+                return NULL;
+            }
+        }
 
-        // if the head points to null, set the tail to null because we have popped the last entry
-        if (m_Head == 0)
+        if (m_Count > 0)
         {
-            m_Tail = 0;
+            // a producer is between claiming the tail and linking it, it will be done momentarily
+            Helium::Sleep(0);
+        }
+        else
+        {
+            WaitForWork();
         }
     }
-
-    return result;
 }
 
 void MessageQueue::Clear()
@@ -123,26 +477,31 @@ void MessageQueue::Clear()
 
     Helium::TakeMutex mutex (m_Mutex);
 
-    Message* msg = m_Head;
+    Message* msg = Pop();
     while (msg)
     {
-        Message* next = msg->m_Next;
+        Helium::AtomicDecrement( &m_Count );
         delete msg;
-        msg = next;
+        msg = Pop();
     }
 
-    m_Head = 0;
-    m_Tail = 0;
-    m_Count = 0;
-    m_Total = 0;
+    Helium::AtomicExchange( &m_Total, 0 );
 
-    m_Append.Increment();
-    m_Append.Reset();
+    // pending wakeups are left alone, a consumer that hasn't gone to sleep yet still needs them
+
+    // anyone asleep in Remove comes back with null
+    if (m_Sleeping)
+    {
+        Helium::AtomicIncrement( &m_Wakeups );
+        WakeConsumer();
+    }
 }
 
 u32 MessageQueue::Count()
 {
-    return m_Count;
+    // messages still being linked are counted, but never report less than nothing
+    i32 count = m_Count;
+    return count > 0 ? count : 0;
 }
 
 u32 MessageQueue::Total()
@@ -150,15 +509,16 @@ u32 MessageQueue::Total()
     return m_Total;
 }
 
-void MessageQueue::Wait()
+bool MessageQueue::Wait(u32 timeout)
 {
-    // this will send the calling thread to sleep, and when it returns the semaphore value will be decremented for *this* thread
-    m_Append.Decrement();
-
-    // this will be zero if the queue was reset by another thread
-    if ( m_Total )
+    // this will send the calling thread to sleep until there is a message (or a wakeup) to remove
+    while (m_Count == 0 && m_Wakeups == 0)
     {
-        // do an increment to preserve the semaphore's value over the call to this function
-        m_Append.Increment();
+        if (!WaitForWork(timeout))
+        {
+            return false;
+        }
     }
+
+    return true;
 }
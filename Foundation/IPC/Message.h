@@ -40,6 +40,25 @@ namespace Helium
             }
         };
 
+        //
+        // MessagePool recycles the storage of messages
+        //  Each message lives in a single block with its payload right behind it, blocks are pooled in
+        //  power of two classes up to 128k, and larger ones come straight from the heap.
+        //
+
+        class FOUNDATION_API MessagePool
+        {
+        public:
+            // allocates a block of at least size bytes
+            static void* Allocate(u32 size);
+
+            // returns a block to the pool
+            static void Free(void* block);
+
+            // releases all the cached blocks back to the heap
+            static void Trim();
+        };
+
         class FOUNDATION_API Message : private MessageHeader
         {
             friend class Connection;
@@ -53,9 +72,18 @@ namespace Helium
         private:
             Message(u32 id, i32 trans, u32 size, u32 type);
 
+            // the payload is allocated along with the message
+            static void* operator new(size_t size, u32 data_size);
+            static void operator delete(void* ptr, u32 data_size);
+
         public:
             ~Message();
 
+            static void operator delete(void* ptr);
+
+            // connections should use Connection::CreateMessage, which assigns the transaction number
+            static Message* Create(u32 id, i32 trans, u32 size, u32 type);
+
             u32 GetNumber() const
             {
                 return m_Number;
@@ -91,24 +119,38 @@ namespace Helium
                 return m_Data;
             }
 
-            u8* TakeData()
-            {
-                u8* data = m_Data;
-                m_Data = NULL;
-                return data;
-            }
+            // returns a copy of the payload allocated with new[], the caller owns it
+            u8* TakeData();
         };
 
+        //
+        // MessageQueue is a multiple producer, single consumer queue
+        //  Add never takes a lock: producers swap themselves onto the tail and link the previous tail to them.
+        //  Only one thread may Remove or Wait at a time, and the semaphore is only signaled when that thread
+        //  has actually gone to sleep, so a busy consumer costs producers no kernel calls at all.
+        //
+
         class FOUNDATION_API MessageQueue
         {
         private:
-            Message* m_Head;    // pointer to head message 
-            Message* m_Tail;    // pointer to tail message 
-            u32 m_Count;        // number of messages in queue
-            u32 m_Total;        // number of messages that have passed through the queue since clear
+            Message* m_Head;            // consumer end, always points at the message before the next one out
+            Message* volatile m_Tail;   // producer end, swapped by each Add
+            Message m_Stub;             // placeholder link so the queue is never truly empty
 
-            Helium::Mutex m_Mutex;      // mutex to control access to the queue
-            Helium::Semaphore m_Append; // semaphore that increments on add, decrements on remove
+            volatile i32 m_Count;       // number of messages in queue
+            volatile i32 m_Total;       // number of messages that have passed through the queue since clear
+            volatile i32 m_Wakeups;     // number of Add(NULL) wakeups not yet returned by Remove
+            volatile i32 m_Sleeping;    // set while the consumer is (about to be) asleep on the semaphore
+
+            Helium::Mutex m_Mutex;      // serializes Remove against Clear, producers never touch it
+            Helium::Semaphore m_Append; // signaled by producers that find the consumer sleeping
+
+            void Push(Message* msg);
+            Message* Pop();
+
+            // puts the consumer to sleep until a producer has something for it, false if the timeout passed first
+            bool WaitForWork(u32 timeout = 0xffffffff);
+            void WakeConsumer();
 
         public:
             MessageQueue();
@@ -119,7 +161,9 @@ namespace Helium
             void Clear();
             u32 Count();
             u32 Total();
-            void Wait();
+
+            // sleep until there is a message or wakeup to remove, false if the timeout (in millis) passed first
+            bool Wait(u32 timeout = 0xffffffff);
         };
     }
 }
@@ -0,0 +1,534 @@
+#include "SharedMemory.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Process.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace Helium;
+using namespace Helium::IPC;
+
+// Debug printing
+//#define IPC_SHARED_MEMORY_DEBUG
+
+HELIUM_COMPILE_ASSERT( ( IPC_SHARED_MEMORY_RING_SIZE & ( IPC_SHARED_MEMORY_RING_SIZE - 1 ) ) == 0 );
+
+namespace
+{
+    const u32 IPC_SHARED_MEMORY_MAGIC = 0x4d534849; // 'IHSM'
+    const u32 IPC_SHARED_MEMORY_CACHE_LINE = 64;
+
+    // how many times we look at the ring before going to sleep on the signal
+    const u32 IPC_SHARED_MEMORY_SPIN_COUNT = 4000;
+
+    // how long we sleep before checking the other side is still alive (millis)
+    const u32 IPC_SHARED_MEMORY_POLL_TIME = 100;
+}
+
+namespace Helium
+{
+    namespace IPC
+    {
+        //
+        // Positions count bytes since the rings were reset and wrap, only the writer moves m_Written
+        //  and only the reader moves m_Read, each on their own cache line
+        //
+
+        struct SharedMemoryRing
+        {
+            volatile i32    m_Written;
+            u8              m_WrittenPad[ IPC_SHARED_MEMORY_CACHE_LINE - sizeof( i32 ) ];
+
+            volatile i32    m_Read;
+            u8              m_ReadPad[ IPC_SHARED_MEMORY_CACHE_LINE - sizeof( i32 ) ];
+
+            volatile i32    m_ReaderWaiting;    // set by the reader before it sleeps on the data signal
+            volatile i32    m_WriterWaiting;    // set by the writer before it sleeps on the space signal
+            u8              m_WaitingPad[ IPC_SHARED_MEMORY_CACHE_LINE - sizeof( i32 ) * 2 ];
+        };
+
+        struct SharedMemoryHeader
+        {
+            u32             m_Magic;
+            u32             m_RingSize;
+            volatile i32    m_Ready;            // set by the server once the rings are reset, cleared when a client attaches
+            volatile i32    m_ServerProcess;    // process id of each side while it's attached, else 0
+            volatile i32    m_ClientProcess;
+            u8              m_Pad[ IPC_SHARED_MEMORY_CACHE_LINE - sizeof( u32 ) * 2 - sizeof( i32 ) * 3 ];
+
+            SharedMemoryRing m_Rings[ 2 ];      // client to server, then server to client
+        };
+    }
+}
+
+static const u32 IPC_SHARED_MEMORY_SIZE = sizeof( SharedMemoryHeader ) + IPC_SHARED_MEMORY_RING_SIZE * 2;
+
+SharedMemoryConnection::SharedMemoryConnection()
+: m_Header (NULL)
+, m_ReadRing (NULL)
+, m_ReadBuffer (NULL)
+, m_WriteRing (NULL)
+, m_WriteBuffer (NULL)
+{
+    m_SharedName[0] = '\0';
+}
+
+SharedMemoryConnection::~SharedMemoryConnection()
+{
+    // other threads still need our object's virtual functions, so call this in the derived destructor
+    Cleanup();
+}
+
+bool SharedMemoryConnection::Initialize(bool server, const tchar* name, const tchar* shared_name)
+{
+    if (!Connection::Initialize(server, name))
+    {
+        return false;
+    }
+
+    if (shared_name && shared_name[0] != '\0')
+    {
+        _tcscpy(m_SharedName, shared_name);
+    }
+
+    SetState(ConnectionStates::Waiting);
+
+    Helium::Thread::Entry serverEntry = Helium::Thread::EntryHelper<SharedMemoryConnection, &SharedMemoryConnection::ServerThread>;
+    Helium::Thread::Entry clientEntry = Helium::Thread::EntryHelper<SharedMemoryConnection, &SharedMemoryConnection::ClientThread>;
+    if (!m_ConnectThread.Create(server ? serverEntry : clientEntry, this, "IPC Connection Thread" ))
+    {
+        Helium::Print( TXT( "%s: Failed to create connect thread\n" ), m_Name);
+        SetState(ConnectionStates::Failed);
+        return false;
+    }
+
+    return true;
+}
+
+void SharedMemoryConnection::ServerThread()
+{
+    Helium::Print( TXT( "%s: Starting shared memory server '%s'\n" ), m_Name, m_SharedName);
+
+    if ( !OpenShared() )
+    {
+        Helium::Print( TXT( "%s: Failed to create shared memory '%s'\n" ), m_Name, m_SharedName);
+        SetState(ConnectionStates::Failed);
+        return;
+    }
+
+    AtomicExchange( &m_Header->m_ServerProcess, (i32)Helium::GetProcessID() );
+
+    // while the server is still running, cycle through connections
+    while (!m_Terminating)
+    {
+        // the last client has let go, so start the rings over and let the next one in
+        memset( m_Header->m_Rings, 0, sizeof( m_Header->m_Rings ) );
+        AtomicExchange( &m_Header->m_Ready, 1 );
+
+        Helium::Print( TXT( "%s: Ready for client\n" ), m_Name);
+
+        // wait for the connection, the client signals our read data when it attaches
+        while (!m_Terminating && m_Header->m_ClientProcess == 0)
+        {
+            m_ReadData.Wait( IPC_SHARED_MEMORY_POLL_TIME );
+        }
+
+        AtomicExchange( &m_Header->m_Ready, 0 );
+
+        if (!m_Terminating)
+        {
+            // do connection
+            ConnectThread();
+        }
+
+        // wait for the client to detach before we reset the rings under it
+        while (!m_Terminating && PeerAttached( true ))
+        {
+            m_ReadData.Wait( IPC_SHARED_MEMORY_POLL_TIME );
+        }
+
+        AtomicExchange( &m_Header->m_ClientProcess, 0 );
+
+        if (!m_Terminating)
+        {
+            // reset back to waiting for connections
+            SetState(ConnectionStates::Waiting);
+        }
+    }
+
+    AtomicExchange( &m_Header->m_ServerProcess, 0 );
+    m_WriteData.Signal();
+
+    CloseShared();
+
+    Helium::Print( TXT( "%s: Stopping shared memory server '%s'\n" ), m_Name, m_SharedName);
+}
+
+void SharedMemoryConnection::ClientThread()
+{
+    Helium::Print( TXT( "%s: Starting shared memory client '%s'\n" ), m_Name, m_SharedName);
+
+    while (!m_Terminating)
+    {
+        Helium::Print( TXT( "%s: Ready for server\n" ), m_Name);
+
+        // wait for the server to create the block and reset the rings
+        while (!m_Terminating)
+        {
+            if ( m_Header || OpenShared() )
+            {
+                if ( m_Header->m_Ready && m_Header->m_ClientProcess == 0 && PeerAttached( true ) )
+                {
+                    break;
+                }
+
+                // a server that went away won't come back under the same block
+                if ( !PeerAttached( true ) )
+                {
+                    CloseShared();
+                }
+            }
+
+            Helium::Sleep(100);
+        }
+
+        if (!m_Terminating)
+        {
+            // attach, and wake the server up
+            AtomicExchange( &m_Header->m_ClientProcess, (i32)Helium::GetProcessID() );
+            m_WriteData.Signal();
+
+            // do connection
+            ConnectThread();
+
+            // detach, so the server can reset the rings
+            AtomicExchange( &m_Header->m_ClientProcess, 0 );
+            m_WriteData.Signal();
+        }
+
+        if (!m_Terminating)
+        {
+            // return to waiting
+            SetState(ConnectionStates::Waiting);
+        }
+    }
+
+    CloseShared();
+
+    Helium::Print( TXT( "%s: Stopping shared memory client '%s'\n" ), m_Name, m_SharedName);
+}
+
+bool SharedMemoryConnection::OpenShared()
+{
+    tchar name[512];
+
+    _stprintf( name, TXT( "%s_memory" ), m_SharedName );
+    if ( m_Server ? !m_Memory.Create( name, IPC_SHARED_MEMORY_SIZE ) : !m_Memory.Open( name, IPC_SHARED_MEMORY_SIZE ) )
+    {
+        return false;
+    }
+
+    m_Header = (SharedMemoryHeader*)m_Memory.GetData();
+
+    if ( m_Server )
+    {
+        m_Header->m_Magic = IPC_SHARED_MEMORY_MAGIC;
+        m_Header->m_RingSize = IPC_SHARED_MEMORY_RING_SIZE;
+    }
+    else if ( m_Header->m_Magic != IPC_SHARED_MEMORY_MAGIC || m_Header->m_RingSize != IPC_SHARED_MEMORY_RING_SIZE )
+    {
+        CloseShared();
+        return false;
+    }
+
+    // the client writes the first ring and reads the second, the server the other way around
+    u8* rings = (u8*)m_Header + sizeof( SharedMemoryHeader );
+    u32 read_index = m_Server ? 0 : 1;
+    u32 write_index = m_Server ? 1 : 0;
+
+    m_ReadRing = &m_Header->m_Rings[ read_index ];
+    m_ReadBuffer = rings + read_index * IPC_SHARED_MEMORY_RING_SIZE;
+
+    m_WriteRing = &m_Header->m_Rings[ write_index ];
+    m_WriteBuffer = rings + write_index * IPC_SHARED_MEMORY_RING_SIZE;
+
+    const tchar* read_prefix = m_Server ? TXT( "client" ) : TXT( "server" );
+    const tchar* write_prefix = m_Server ? TXT( "server" ) : TXT( "client" );
+
+    Helium::SharedSignal* signals[] = { &m_ReadData, &m_ReadSpace, &m_WriteData, &m_WriteSpace };
+    const tchar* prefixes[] = { read_prefix, read_prefix, write_prefix, write_prefix };
+    const tchar* suffixes[] = { TXT( "data" ), TXT( "space" ), TXT( "data" ), TXT( "space" ) };
+
+    for ( u32 i = 0; i < sizeof( signals ) / sizeof( signals[0] ); ++i )
+    {
+        _stprintf( name, TXT( "%s_%s_%s" ), m_SharedName, prefixes[ i ], suffixes[ i ] );
+        if ( m_Server ? !signals[ i ]->Create( name ) : !signals[ i ]->Open( name ) )
+        {
+            CloseShared();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SharedMemoryConnection::CloseShared()
+{
+    m_ReadData.Close();
+    m_ReadSpace.Close();
+    m_WriteData.Close();
+    m_WriteSpace.Close();
+
+    m_Header = NULL;
+    m_ReadRing = NULL;
+    m_ReadBuffer = NULL;
+    m_WriteRing = NULL;
+    m_WriteBuffer = NULL;
+
+    m_Memory.Close();
+}
+
+bool SharedMemoryConnection::PeerAttached(bool check_process)
+{
+    i32 peer = m_Server ? m_Header->m_ClientProcess : m_Header->m_ServerProcess;
+    if ( peer == 0 )
+    {
+        return false;
+    }
+
+    // a peer that crashed never detaches, so look for the process itself
+    return !check_process || Helium::IsProcessRunning( (u32)peer );
+}
+
+bool SharedMemoryConnection::WaitForRing(volatile i32* waiting, volatile i32* position, i32 value, Helium::SharedSignal& signal)
+{
+    // a short spin catches the other side in the middle of a copy without paying for a wakeup
+    for ( u32 spin = 0; spin < IPC_SHARED_MEMORY_SPIN_COUNT; ++spin )
+    {
+        if ( *position != value )
+        {
+            return true;
+        }
+    }
+
+    // announce we are going to sleep, then look again so a wakeup sent in between isn't missed
+    AtomicExchange( waiting, 1 );
+
+    bool result = true;
+    while ( *position == value )
+    {
+        if ( m_Terminating || !PeerAttached( false ) )
+        {
+            result = false;
+            break;
+        }
+
+        if ( !signal.Wait( IPC_SHARED_MEMORY_POLL_TIME ) && !PeerAttached( true ) )
+        {
+            result = false;
+            break;
+        }
+    }
+
+    AtomicExchange( waiting, 0 );
+
+    return result;
+}
+
+bool SharedMemoryConnection::ReadMessage(Message** msg)
+{
+    IPC_SCOPE_TIMER("");
+
+    {
+        IPC_SCOPE_TIMER("Read Message Header");
+
+        // both sides are on this machine, so the header never needs swapping
+        if ( !Read(&m_ReadHeader,sizeof(m_ReadHeader)) )
+        {
+            return false;
+        }
+    }
+
+    // make a message with the received m_ReadHeader and fill it
+    Message* message = CreateMessage(m_ReadHeader.m_ID,m_ReadHeader.m_Size,m_ReadHeader.m_TRN, m_ReadHeader.m_Type);
+
+    // out of memory condition
+    if ( message == NULL )
+    {
+        return true;
+    }
+
+    u8* data = message->GetData();
+
+    // out of memory condition #2
+    if ( m_ReadHeader.m_Size > 0 && data == NULL )
+    {
+        delete message;
+        message = NULL;
+        return true;
+    }
+
+    {
+        IPC_SCOPE_TIMER("Read Message Data");
+
+        if ( !Read(data, m_ReadHeader.m_Size) )
+        {
+            delete message;
+            message = NULL;
+            return false;
+        }
+    }
+
+#ifdef IPC_SHARED_MEMORY_DEBUG
+    Helium::Print( TXT( "%s: Read message id '%d', transaction '%d', size '%d'\n" ), m_Name, m_ReadHeader.m_ID, m_ReadHeader.m_TRN, m_ReadHeader.m_Size);
+#endif
+
+    *msg = message;
+
+    return true;
+}
+
+bool SharedMemoryConnection::WriteMessage(Message* msg)
+{
+    IPC_SCOPE_TIMER("");
+
+    {
+        IPC_SCOPE_TIMER("Write Message Header");
+
+        m_WriteHeader.m_ID = msg->GetID();
+        m_WriteHeader.m_TRN = msg->GetTransaction();
+        m_WriteHeader.m_Size = msg->GetSize();
+        m_WriteHeader.m_Type = msg->GetType();
+
+        // write the m_WriteHeader
+        if ( !Write(&m_WriteHeader, sizeof(m_WriteHeader)) )
+        {
+            return false;
+        }
+    }
+
+    {
+        IPC_SCOPE_TIMER("Write Message Data");
+
+        // write the data
+        if ( !Write(msg->GetData(), msg->GetSize()) )
+        {
+            return false;
+        }
+    }
+
+#ifdef IPC_SHARED_MEMORY_DEBUG
+    Helium::Print( TXT( "%s: Wrote message id '%d', transaction '%d', size '%d'\n" ), m_Name, m_WriteHeader.m_ID, m_WriteHeader.m_TRN, m_WriteHeader.m_Size);
+#endif
+
+    return true;
+}
+
+bool SharedMemoryConnection::Read(void* buffer, u32 bytes)
+{
+    if ( m_ReadRing == NULL )
+    {
+        return false;
+    }
+
+    u8* destination = (u8*)buffer;
+
+    while (bytes > 0)
+    {
+        if (m_Terminating)
+        {
+            return false;
+        }
+
+        // only we move the read position, the writer only ever moves the written position forward
+        u32 read = (u32)m_ReadRing->m_Read;
+        u32 written = (u32)m_ReadRing->m_Written;
+        u32 available = written - read;
+
+        if ( available == 0 )
+        {
+            if ( !WaitForRing( &m_ReadRing->m_ReaderWaiting, &m_ReadRing->m_Written, (i32)written, m_ReadData ) )
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        u32 count = std::min( available, bytes );
+        u32 offset = read & ( IPC_SHARED_MEMORY_RING_SIZE - 1 );
+        u32 first = std::min( count, IPC_SHARED_MEMORY_RING_SIZE - offset );
+
+        memcpy( destination, m_ReadBuffer + offset, first );
+        memcpy( destination + first, m_ReadBuffer, count - first );
+
+        // hand the space back to the writer, the exchange is a full barrier so our copy is done first
+        AtomicExchange( &m_ReadRing->m_Read, (i32)( read + count ) );
+
+        if ( m_ReadRing->m_WriterWaiting )
+        {
+            m_ReadSpace.Signal();
+        }
+
+        destination += count;
+        bytes -= count;
+    }
+
+    return true;
+}
+
+bool SharedMemoryConnection::Write(void* buffer, u32 bytes)
+{
+    if ( m_WriteRing == NULL )
+    {
+        return false;
+    }
+
+    const u8* source = (const u8*)buffer;
+
+    while (bytes > 0)
+    {
+        if (m_Terminating)
+        {
+            return false;
+        }
+
+        // only we move the written position, the reader only ever moves the read position forward
+        u32 written = (u32)m_WriteRing->m_Written;
+        u32 read = (u32)m_WriteRing->m_Read;
+        u32 space = IPC_SHARED_MEMORY_RING_SIZE - ( written - read );
+
+        if ( space == 0 )
+        {
+            if ( !WaitForRing( &m_WriteRing->m_WriterWaiting, &m_WriteRing->m_Read, (i32)read, m_WriteSpace ) )
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        u32 count = std::min( space, bytes );
+        u32 offset = written & ( IPC_SHARED_MEMORY_RING_SIZE - 1 );
+        u32 first = std::min( count, IPC_SHARED_MEMORY_RING_SIZE - offset );
+
+        memcpy( m_WriteBuffer + offset, source, first );
+        memcpy( m_WriteBuffer, source + first, count - first );
+
+        // publish the data, the exchange is a full barrier so the reader can't see the position before the bytes
+        AtomicExchange( &m_WriteRing->m_Written, (i32)( written + count ) );
+
+        if ( m_WriteRing->m_ReaderWaiting )
+        {
+            m_WriteData.Signal();
+        }
+
+        source += count;
+        bytes -= count;
+    }
+
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Platform/SharedMemory.h"
+
+#include "IPC.h"
+#include "Connection.h"
+
+// size of the ring each direction of the connection writes into, must be a power of two
+const static u32 IPC_SHARED_MEMORY_RING_SIZE = 1024 * 1024;
+
+namespace Helium
+{
+    namespace IPC
+    {
+        struct SharedMemoryHeader;
+        struct SharedMemoryRing;
+
+        //
+        // SharedMemoryConnection connects two processes on the same machine through a block of shared memory
+        //  Each direction is a single producer, single consumer ring, so sending a message is a copy into the ring
+        //  (and a wakeup if the other side has gone to sleep) instead of a trip through the kernel
+        //
+
+        class FOUNDATION_API SharedMemoryConnection : public Connection
+        {
+        private:
+            tchar                   m_SharedName[256];  // name of the connection passed in by the user
+
+            Helium::SharedMemory    m_Memory;           // the shared block holding the header and both rings
+            SharedMemoryHeader*     m_Header;
+
+            SharedMemoryRing*       m_ReadRing;         // ring the other side writes to us
+            u8*                     m_ReadBuffer;
+            Helium::SharedSignal    m_ReadData;         // signaled when data is written to our read ring
+            Helium::SharedSignal    m_ReadSpace;        // signaled when we have freed space in our read ring
+
+            SharedMemoryRing*       m_WriteRing;        // ring we write to the other side
+            u8*                     m_WriteBuffer;
+            Helium::SharedSignal    m_WriteData;
+            Helium::SharedSignal    m_WriteSpace;
+
+        public:
+            SharedMemoryConnection();
+            virtual ~SharedMemoryConnection();
+
+        public:
+            bool Initialize(bool server, const tchar* name, const tchar* shared_name);
+
+        protected:
+            void ServerThread();
+            void ClientThread();
+
+            // create (server) or open (client) the shared block and the signals
+            bool OpenShared();
+            void CloseShared();
+
+            // is the other side still attached to the rings
+            bool PeerAttached(bool check_process);
+
+            // block until the position moves on from value, returns false if the connection is going away
+            bool WaitForRing(volatile i32* waiting, volatile i32* position, i32 value, Helium::SharedSignal& signal);
+
+            virtual bool ReadMessage(Message** msg);
+            virtual bool WriteMessage(Message* msg);
+            virtual bool Read(void* buffer, u32 bytes);
+            virtual bool Write(void* buffer, u32 bytes);
+        };
+    }
+}
@@ -20,6 +20,9 @@ TCPConnection::TCPConnection()
 , m_ReadSocket (0)
 , m_WritePort (0)
 , m_WriteSocket (0)
+, m_ReadBuffer (new u8[ IPC_TCP_BUFFER_SIZE ])
+, m_ReadBufferStart (0)
+, m_ReadBufferEnd (0)
 {
     m_IP[0] = '\0';
 }
@@ -28,6 +31,8 @@ TCPConnection::~TCPConnection()
 {
     // other threads still need our object's virtual functions, so call this in the derived destructor
     Cleanup();
+
+    delete [] m_ReadBuffer;
 }
 
 bool TCPConnection::Initialize(bool server, const tchar* name, const tchar* server_ip, const u16 server_port)
@@ -167,6 +172,10 @@ void TCPConnection::ServerThread()
             result = setsockopt(m_WriteSocket, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(int));
 #endif
 
+            // nothing left over from the last session
+            m_ReadBufferStart = 0;
+            m_ReadBufferEnd = 0;
+
             // do connection
             ConnectThread();
         }
@@ -270,6 +279,10 @@ void TCPConnection::ClientThread()
             result = setsockopt(m_WriteSocket, IPPROTO_TCP, TCP_NODELAY, (const char*) &flag, sizeof(int));
 #endif
 
+            // nothing left over from the last session
+            m_ReadBufferStart = 0;
+            m_ReadBufferEnd = 0;
+
             // do connection
             ConnectThread();
         }
@@ -364,46 +377,97 @@ bool TCPConnection::ReadMessage(Message** msg)
 }
 
 bool TCPConnection::WriteMessage(Message* msg)
+{
+    return WriteMessages(&msg, 1);
+}
+
+bool TCPConnection::WriteMessages(Message** msgs, u32 count)
 {
     IPC_SCOPE_TIMER("");
 
-    m_WriteHeader.m_ID = msg->GetID();
-    m_WriteHeader.m_TRN = msg->GetTransaction();
-    m_WriteHeader.m_Size = msg->GetSize();
-    m_WriteHeader.m_Type = msg->GetType();
+    HELIUM_ASSERT(count <= IPC_WRITE_BATCH_COUNT);
 
-#ifdef WIN32
-    if ( m_RemotePlatform != (Helium::Platform::Type)-1 )
-    {
-        m_WriteHeader.m_ID = ConvertEndian(m_WriteHeader.m_ID, m_RemotePlatform != Helium::Platform::Types::Windows);
-        m_WriteHeader.m_TRN = ConvertEndian(m_WriteHeader.m_TRN, m_RemotePlatform != Helium::Platform::Types::Windows);
-        m_WriteHeader.m_Size = ConvertEndian(m_WriteHeader.m_Size, m_RemotePlatform != Helium::Platform::Types::Windows);
-        m_WriteHeader.m_Type = ConvertEndian(m_WriteHeader.m_Type, m_RemotePlatform != Helium::Platform::Types::Windows);
-    }
-#endif
+    // every header and payload in the batch goes out in a single send, instead of two per message
+    Helium::SocketBuffer buffers[ IPC_WRITE_BATCH_COUNT * 2 ];
+    u32 buffer_count = 0;
 
+    for (u32 i = 0; i < count; ++i)
     {
-        IPC_SCOPE_TIMER("Write Message Header");
-        if (!Write( &m_WriteHeader, sizeof( m_WriteHeader ) ))
+        Message* msg = msgs[i];
+        MessageHeader& header = m_WriteHeaders[i];
+
+        header.m_ID = msg->GetID();
+        header.m_TRN = msg->GetTransaction();
+        header.m_Size = msg->GetSize();
+        header.m_Type = msg->GetType();
+
+#ifdef WIN32
+        if ( m_RemotePlatform != (Helium::Platform::Type)-1 )
         {
-#ifdef IPC_TCP_DEBUG_SOCKETS
-            Helium::Print("%s: Failed to write message header\n", m_Name);
+            header.m_ID = ConvertEndian(header.m_ID, m_RemotePlatform != Helium::Platform::Types::Windows);
+            header.m_TRN = ConvertEndian(header.m_TRN, m_RemotePlatform != Helium::Platform::Types::Windows);
+            header.m_Size = ConvertEndian(header.m_Size, m_RemotePlatform != Helium::Platform::Types::Windows);
+            header.m_Type = ConvertEndian(header.m_Type, m_RemotePlatform != Helium::Platform::Types::Windows);
+        }
 #endif
 
-            return false;
+        buffers[ buffer_count ].m_Data = &header;
+        buffers[ buffer_count ].m_Size = sizeof( header );
+        ++buffer_count;
+
+        if (msg->GetSize())
+        {
+            buffers[ buffer_count ].m_Data = msg->GetData();
+            buffers[ buffer_count ].m_Size = msg->GetSize();
+            ++buffer_count;
         }
     }
 
+    if (!WriteGather( buffers, buffer_count ))
     {
-        IPC_SCOPE_TIMER("Write Message Data");
-        if (!Write( msg->GetData(), msg->GetSize() ))
-        {
 #ifdef IPC_TCP_DEBUG_SOCKETS
-            Helium::Print("%s::Failed to write message data\n", m_Name);
+        Helium::Print("%s: Failed to write %d messages\n", m_Name, count);
 #endif
 
+        return false;
+    }
+
+    return true;
+}
+
+bool TCPConnection::WriteGather(Helium::SocketBuffer* buffers, u32 count)
+{
+    while (count > 0)
+    {
+        u32 bytes_put = 0;
+
+        if (!Helium::WriteSocketGather( m_WriteSocket, buffers, count, bytes_put, m_Terminate ))
+        {
             return false;
         }
+
+        if (m_Terminating)
+        {
+            return false;
+        }
+
+#ifdef IPC_TCP_DEBUG_SOCKETS_CHUNKS
+        Helium::Print(" %s: Put %d bytes from %d buffers\n", m_Name, bytes_put, count);
+#endif
+
+        // skip past what went out, a short send leaves us part way through a buffer
+        while (count > 0 && bytes_put >= buffers->m_Size)
+        {
+            bytes_put -= buffers->m_Size;
+            ++buffers;
+            --count;
+        }
+
+        if (count > 0)
+        {
+            buffers->m_Data = (u8*)buffers->m_Data + bytes_put;
+            buffers->m_Size -= bytes_put;
+        }
     }
 
     return true;
@@ -420,13 +484,30 @@ bool TCPConnection::Read(void* buffer, u32 bytes)
 
     while (bytes_left > 0)
     {
-        u32 count = std::min<u32>(bytes_left, IPC_TCP_BUFFER_SIZE);
+        // hand out what an earlier receive already brought in
+        u32 buffered = m_ReadBufferEnd - m_ReadBufferStart;
+        if (buffered > 0)
+        {
+            u32 count = std::min<u32>(bytes_left, buffered);
+            memcpy(buffer, m_ReadBuffer + m_ReadBufferStart, count);
+
+            m_ReadBufferStart += count;
+            bytes_left -= count;
+            buffer = ((u8*)buffer) + count;
+            continue;
+        }
+
+        // big reads go straight to their destination, small ones fill the whole buffer
+        //  so that the messages queued up behind them come in with the same receive
+        bool direct = bytes_left >= IPC_TCP_BUFFER_SIZE;
+        void* target = direct ? buffer : m_ReadBuffer;
+        u32 count = direct ? std::min<u32>(bytes_left, IPC_TCP_BUFFER_SIZE) : IPC_TCP_BUFFER_SIZE;
 
 #ifdef IPC_TCP_DEBUG_SOCKETS_CHUNKS
         Helium::Print(" %s: Receiving %d bytes...\n", m_Name, count);
 #endif
 
-        if (!Helium::ReadSocket( m_ReadSocket, buffer, count, bytes_got, m_Terminate ))
+        if (!Helium::ReadSocket( m_ReadSocket, target, count, bytes_got, m_Terminate ))
         {
 #ifdef IPC_TCP_DEBUG_SOCKETS
             Helium::Print( "%s: ReadSocket failed\n", m_Name );
@@ -442,8 +523,16 @@ bool TCPConnection::Read(void* buffer, u32 bytes)
             return false;
         }
 
-        bytes_left -= bytes_got;
-        buffer = ((u8*)buffer) + bytes_got;
+        if (direct)
+        {
+            bytes_left -= bytes_got;
+            buffer = ((u8*)buffer) + bytes_got;
+        }
+        else
+        {
+            m_ReadBufferStart = 0;
+            m_ReadBufferEnd = bytes_got;
+        }
 
 #ifdef IPC_TCP_DEBUG_SOCKETS_CHUNKS
         Helium::Print(" %s: Got %d bytes, %d bytes to go\n", m_Name, bytes_got, bytes_left);
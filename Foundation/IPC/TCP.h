@@ -26,6 +26,12 @@ namespace Helium
             u16               m_WritePort;                    // port number for write operations
             Helium::Socket  m_WriteSocket;                  // socket used for write operations
 
+            u8*               m_ReadBuffer;                   // incoming bytes not yet handed to a message
+            u32               m_ReadBufferStart;
+            u32               m_ReadBufferEnd;
+
+            MessageHeader     m_WriteHeaders[ IPC_WRITE_BATCH_COUNT ];  // headers of the batch being written
+
         public:
             TCPConnection();
             virtual ~TCPConnection();
@@ -40,8 +46,12 @@ namespace Helium
             virtual void CleanupThread();
             virtual bool ReadMessage(Message** msg);
             virtual bool WriteMessage(Message* msg);
+            virtual bool WriteMessages(Message** msgs, u32 count);
             virtual bool Read(void* buffer, u32 bytes);
             virtual bool Write(void* buffer, u32 bytes);
+
+            // writes all of the buffers, as few sends as the socket allows
+            bool WriteGather(Helium::SocketBuffer* buffers, u32 count);
         };
     }
 }
\ No newline at end of file
@@ -1,11 +1,15 @@
 #include "Log.h"
 
 #include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Condition.h"
 #include "Platform/Mutex.h"
+#include "Platform/Platform.h"
 #include "Platform/Thread.h"
 #include "Platform/Windows/Windows.h"
 #include "Platform/Windows/Console.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
@@ -21,6 +25,18 @@ using namespace Helium::Log;
 
 #define NTFS_PATH_MAX (0x7FFF)
 
+// the most whitespace a statement gets in front of each line
+#define LOG_INDENT_MAX (63)
+
+// each printing thread gets a buffer this big for statements the output thread hasn't written yet, must be a power of two
+#define LOG_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// longest the output thread lets statements sit before it writes them
+#define LOG_OUTPUT_FLUSH_MILLIS (10)
+
+// how long a crashing thread waits on another thread that is writing output before it writes anyway
+#define LOG_CRASH_FLUSH_MILLIS (1000)
+
 u32 g_LogFileCount = 20;
 
 Helium::Mutex g_Mutex;
@@ -90,11 +106,14 @@ struct OutputFile
     Stream      m_StreamType;
     int         m_RefCount;
     u32         m_ThreadId;
+    bool        m_StampNewLine; // the last thing written to the file ended a line
+    tstring     m_Pending;      // written to the file at the end of each batch
 
     OutputFile()
         : m_StreamType( Streams::Normal )
         , m_RefCount( 0 )
         , m_ThreadId( -1 )
+        , m_StampNewLine( true )
     {
 
     }
@@ -103,30 +122,129 @@ struct OutputFile
 typedef std::map< tstring, OutputFile > M_OutputFile;
 M_OutputFile g_TraceFiles;
 
+// every stream some trace file wants, so printing threads can tell if anyone will see a statement without the lock
+volatile u32 g_TraceFileStreams = 0;
+
 u32 g_Streams = Streams::Normal | Streams::Warning | Streams::Error;
 Level g_Level = Levels::Default;
-int g_WarningCount = 0;
-int g_ErrorCount = 0;
+volatile i32 g_WarningCount = 0;
+volatile i32 g_ErrorCount = 0;
 int g_Indent = 0;
 
 PrintingSignature::Event g_PrintingEvent;
 PrintedSignature::Event g_PrintedEvent;
 
-void Log::Statement::ApplyIndent( const tchar* string, tstring& output )
+//
+// OutputRecord is a statement waiting in a thread's buffer, the string follows it
+//
+
+struct OutputRecord
+{
+    u32         m_Size;         // bytes from the start of this record to the next
+    u32         m_Sequence;     // print order across all threads
+    u32         m_Thread;
+    Stream      m_Stream;       // zero for the padding that fills out the end of the buffer
+    Level       m_Level;
+    Color       m_Color;
+    int         m_Indent;
+    u32         m_Display;      // goes to the console and the printed listeners
+    u32         m_Length;       // characters in the string, not counting the terminator
+    _timeb      m_Time;
+
+    const tchar* GetString() const
+    {
+        return (const tchar*)( this + 1 );
+    }
+};
+
+//
+// ThreadOutput is a printing thread's format buffers and the ring of statements it has printed
+//  Only the owning thread writes records and moves m_Write, only the drain reads them and moves m_Read,
+//  so printing never waits on another thread unless the ring is full.  When the thread exits its entry is
+//  written out, unlinked while the drain isn't walking the list, and freed.
+//
+
+struct ThreadOutput
+{
+    u8*             m_Buffer;
+    volatile i32    m_Write;
+    volatile i32    m_Read;
+    u32             m_Thread;
+    ThreadOutput*   m_Next;
+
+    tchar           m_Format[ MAX_PRINT_SIZE ];
+    tchar           m_String[ MAX_PRINT_SIZE ];
+    tstring         m_Indented;
+
+    ThreadOutput()
+        : m_Buffer( NULL )
+        , m_Write( 0 )
+        , m_Read( 0 )
+        , m_Thread( GetCurrentThreadID() )
+        , m_Next( NULL )
+    {
+        m_Format[0] = '\0';
+        m_String[0] = '\0';
+    }
+
+    ~ThreadOutput()
+    {
+        delete [] m_Buffer;
+    }
+
+    static ThreadOutput* Get();
+    static void Release( void* output );
+};
+
+ThreadOutput* volatile      g_ThreadOutputs = NULL;
+Helium::Mutex               g_ThreadOutputsMutex;
+
+volatile i32                g_Sequence = 0;
+volatile i32                g_AsyncOutput = 0;
+volatile i32                g_Dropped = 0;
+OverflowPolicy              g_OverflowPolicy = OverflowPolicies::Block;
+
+volatile i32                g_Draining = 0;
+volatile u32                g_DrainThread = 0;  // the thread writing output, so it doesn't wait on itself
+
+Helium::Thread              g_OutputThread;
+Helium::Condition           g_OutputSignal;
+
+// after everything Release uses, so it is torn down first
+Helium::ThreadLocalPointer  g_ThreadOutput ( &ThreadOutput::Release );
+
+ThreadOutput* ThreadOutput::Get()
+{
+    ThreadOutput* output = (ThreadOutput*)g_ThreadOutput.GetPointer();
+    if ( output == NULL )
+    {
+        output = new ThreadOutput;
+        g_ThreadOutput.SetPointer( output );
+
+        // the drain walks the list without the lock, so the new entry is complete before it is linked in
+        Helium::TakeMutex mutex (g_ThreadOutputsMutex);
+        output->m_Next = g_ThreadOutputs;
+        g_ThreadOutputs = output;
+    }
+
+    return output;
+}
+
+static void IndentString( const tchar* string, int indent, tstring& output )
 {
-    if ( m_Indent > 0 )
+    if ( indent > 0 )
     {
-        tchar m_IndentString[64] = TXT( "" );
-        if(m_Indent >= sizeof(m_IndentString))
+        tchar m_IndentString[ LOG_INDENT_MAX + 1 ] = TXT( "" );
+        if ( indent > LOG_INDENT_MAX )
         {
-            m_Indent = sizeof(m_IndentString)-1;
+            indent = LOG_INDENT_MAX;
         }
 
-        for (int i=0; i<m_Indent; i++)
+        for (int i=0; i<indent; i++)
         {
             m_IndentString[i] = ' ';
         }
-        m_IndentString[m_Indent] = '\0';
+        m_IndentString[indent] = '\0';
 
         // insert the indtent string after newlines and before non-newlines
         const tchar* pos = string;
@@ -140,7 +258,7 @@ void Log::Statement::ApplyIndent( const tchar* string, tstring& output )
 
             if ( previous == '\n' && *pos != '\n' )
             {
-                // start of a new line, apply m_Indent
+                // start of a new line, apply indent
                 output += m_IndentString;
             }
 
@@ -154,6 +272,16 @@ void Log::Statement::ApplyIndent( const tchar* string, tstring& output )
     }
 }
 
+void Log::Statement::ApplyIndent( const tchar* string, tstring& output )
+{
+    if ( m_Indent > LOG_INDENT_MAX )
+    {
+        m_Indent = LOG_INDENT_MAX;
+    }
+
+    IndentString( string, m_Indent, output );
+}
+
 void Log::AddPrintingListener(const PrintingSignature::Delegate& listener)
 {
     Helium::TakeMutex mutex (g_Mutex);
@@ -182,36 +310,425 @@ void Log::RemovePrintedListener(const PrintedSignature::Delegate& listener)
     g_PrintedEvent.Remove(listener);
 }
 
-void Redirect(const tstring& fileName, const tchar* str, bool stampNewLine = true )
+static void InitializeRecord( OutputRecord& record, Stream stream, Level level, Color color, int indent, bool display )
+{
+    record.m_Size = 0;
+    record.m_Sequence = (u32)Helium::AtomicIncrement( &g_Sequence );
+    record.m_Thread = GetCurrentThreadID();
+    record.m_Stream = stream;
+    record.m_Level = level;
+    record.m_Color = color;
+    record.m_Indent = indent;
+    record.m_Display = display;
+    record.m_Length = 0;
+    _ftime( &record.m_Time );
+}
+
+static void AppendTrace( OutputFile& file, const OutputRecord& record, const tchar* string )
+{
+    if ( file.m_StampNewLine )
+    {
+        u32 time = (u32) record.m_Time.time;
+        u32 milli = record.m_Time.millitm;
+        u32 sec = time % 60; time /= 60;
+        u32 min = time % 60; time -= record.m_Time.timezone; time /= 60;
+        time += record.m_Time.dstflag ? 1 : 0;
+        u32 hour = time % 24;
+
+        tchar stamp[ 64 ];
+        _stprintf( stamp, TXT( "[%02d:%02d:%02d.%03d TID:%d] " ), hour, min, sec, milli, record.m_Thread );
+        file.m_Pending += stamp;
+    }
+
+    file.m_Pending += string;
+
+    if ( record.m_Length )
+    {
+        file.m_StampNewLine = string[ record.m_Length - 1 ] == '\n';
+    }
+}
+
+// write the text collected for each trace file, one write and one flush per file per batch
+static void CommitTraceFiles()
 {
-    FILE* f = g_FileManager.Find(fileName);
-    if (f)
+    M_OutputFile::iterator itr = g_TraceFiles.begin();
+    M_OutputFile::iterator end = g_TraceFiles.end();
+    for( ; itr != end; ++itr )
     {
-        if ( stampNewLine )
+        if ( !(*itr).second.m_Pending.empty() )
+        {
+            FILE* f = g_FileManager.Find( (*itr).first );
+            if ( f )
+            {
+                _fputts( (*itr).second.m_Pending.c_str(), f );
+                fflush( f );
+            }
+
+            (*itr).second.m_Pending.clear();
+        }
+    }
+}
+
+// send a statement to the console, the printed listeners, the debugger, and the trace files
+static void WriteRecord( const OutputRecord& record, const tchar* string, bool listeners )
+{
+    // output to screen window
+    if ( record.m_Display )
+    {
+        Statement statement ( string, record.m_Stream, record.m_Level, record.m_Indent );
+
+        // deduce the color if we were told to do so
+        Color color = record.m_Color;
+        if ( color == Colors::Auto )
+        {
+            color = GetStreamColor( record.m_Stream );
+        }
+
+        // print the statement to the window
+        Helium::PrintString((Helium::ConsoleColor)color, record.m_Stream == Streams::Error ? stderr : stdout, statement.m_String);
+
+        // raise the printed event
+        if ( listeners )
         {
-            _timeb currentTime;
-            _ftime( &currentTime );
+            PrintedArgs args ( statement );
+            g_PrintedEvent.Raise( args );
+        }
+    }
 
-            u32 time = (u32) currentTime.time;
-            u32 milli = currentTime.millitm;
-            u32 sec = time % 60; time /= 60;
-            u32 min = time % 60; time -= currentTime.timezone; time /= 60;
-            time += currentTime.dstflag ? 1 : 0;
-            u32 hour = time % 24;
+    // send the text to the debugger, if no debugger nothing happens
+    OutputDebugString( string );
 
-            fprintf( f, "[%02d:%02d:%02d.%03d TID:%d] %s", hour, min, sec, milli, GetCurrentThreadId(), str );
+    // output to trace file(s), filtering by the thread that printed it
+    M_OutputFile::iterator itr = g_TraceFiles.begin();
+    M_OutputFile::iterator end = g_TraceFiles.end();
+    for( ; itr != end; ++itr )
+    {
+        if ( ( (*itr).second.m_StreamType & record.m_Stream ) == record.m_Stream
+            && ( (*itr).second.m_ThreadId == -1 || (*itr).second.m_ThreadId == record.m_Thread ) )
+        {
+            AppendTrace( (*itr).second, record, string );
+        }
+    }
+}
+
+static void WriteDropped( i32 dropped, bool listeners )
+{
+    tchar string[ 64 ];
+    _stprintf( string, TXT( "%d log statements were dropped, the output thread fell behind\n" ), dropped );
+
+    OutputRecord record;
+    InitializeRecord( record, Streams::Warning, Levels::Default, Colors::Auto, 0, true );
+    record.m_Length = (u32)_tcslen( string );
+
+    WriteRecord( record, string, listeners );
+}
+
+static bool CompareSequence( const OutputRecord* lhs, const OutputRecord* rhs )
+{
+    return (i32)( lhs->m_Sequence - rhs->m_Sequence ) < 0;
+}
+
+// write everything the printing threads have queued, in the order it was printed
+static void DrainOutput( bool crash )
+{
+    u32 thread = GetCurrentThreadID();
+
+    bool locked = false;
+    for ( u32 waited = 0; !locked; ++waited )
+    {
+        locked = Helium::AtomicCompareExchange( &g_Draining, 1, 0 ) == 0;
+        if ( !locked )
+        {
+            // a listener flushing from inside the drain, it will be written when we get back out
+            if ( g_DrainThread == thread && !crash )
+            {
+                return;
+            }
+
+            // whoever is writing may be the thread that's going down, write what we can anyway
+            if ( crash && ( g_DrainThread == thread || waited >= LOG_CRASH_FLUSH_MILLIS ) )
+            {
+                break;
+            }
+
+            Helium::Sleep( 1 );
+        }
+    }
+
+    if ( locked )
+    {
+        g_DrainThread = thread;
+    }
+
+    std::vector< const OutputRecord* > records;
+    std::vector< std::pair< ThreadOutput*, i32 > > drained;
+
+    for ( ThreadOutput* output = g_ThreadOutputs; output; output = output->m_Next )
+    {
+        u32 read = (u32)output->m_Read;
+        u32 write = (u32)output->m_Write;
+        if ( read == write )
+        {
+            continue;
+        }
+
+        drained.push_back( std::make_pair( output, (i32)write ) );
+
+        while ( read != write )
+        {
+            const OutputRecord* record = (const OutputRecord*)( output->m_Buffer + ( read & ( LOG_OUTPUT_BUFFER_SIZE - 1 ) ) );
+            if ( record->m_Stream )
+            {
+                records.push_back( record );
+            }
+
+            read += record->m_Size;
+        }
+    }
+
+    std::sort( records.begin(), records.end(), &CompareSequence );
+
+    // the listeners and trace files change under the lock, a dying process doesn't risk waiting on whoever has it
+    if ( !crash )
+    {
+        g_Mutex.Lock();
+    }
+
+    std::vector< const OutputRecord* >::const_iterator itr = records.begin();
+    std::vector< const OutputRecord* >::const_iterator end = records.end();
+    for ( ; itr != end; ++itr )
+    {
+        WriteRecord( **itr, (*itr)->GetString(), !crash );
+    }
+
+    i32 dropped = Helium::AtomicExchange( &g_Dropped, 0 );
+    if ( dropped )
+    {
+        WriteDropped( dropped, !crash );
+    }
+
+    CommitTraceFiles();
+
+    if ( !crash )
+    {
+        g_Mutex.Unlock();
+    }
+
+    // hand the space back to the printing threads
+    for ( u32 i = 0; i < drained.size(); ++i )
+    {
+        Helium::AtomicExchange( &drained[ i ].first->m_Read, drained[ i ].second );
+    }
+
+    if ( locked )
+    {
+        g_DrainThread = 0;
+        Helium::AtomicExchange( &g_Draining, 0 );
+    }
+}
+
+void ThreadOutput::Release( void* pointer )
+{
+    ThreadOutput* output = (ThreadOutput*)pointer;
+
+    // the thread is going away, so nothing more will be added behind what it has left
+    if ( output->m_Read != output->m_Write )
+    {
+        DrainOutput( false );
+    }
+
+    // the drain walks the list without the lock, so wait until nobody is draining to take it out
+    while ( Helium::AtomicCompareExchange( &g_Draining, 1, 0 ) != 0 )
+    {
+        Helium::Sleep( 1 );
+    }
+
+    {
+        Helium::TakeMutex mutex (g_ThreadOutputsMutex);
+
+        ThreadOutput* volatile* link = &g_ThreadOutputs;
+        while ( *link != output )
+        {
+            link = &(*link)->m_Next;
+        }
+
+        *link = output->m_Next;
+    }
+
+    Helium::AtomicExchange( &g_Draining, 0 );
+
+    delete output;
+}
+
+static void QueueRecord( ThreadOutput* output, OutputRecord& record, const tchar* string )
+{
+    if ( output->m_Buffer == NULL )
+    {
+        output->m_Buffer = new u8[ LOG_OUTPUT_BUFFER_SIZE ];
+    }
+
+    // a record can't take more than half the ring, there has to be room for padding at the end
+    const u32 maxLength = ( LOG_OUTPUT_BUFFER_SIZE / 2 - sizeof( OutputRecord ) ) / sizeof( tchar ) - 1;
+    if ( record.m_Length > maxLength )
+    {
+        record.m_Length = maxLength;
+    }
+
+    record.m_Size = ( sizeof( OutputRecord ) + ( record.m_Length + 1 ) * sizeof( tchar ) + 7 ) & ~7;
+
+    u32 write = 0;
+    u32 offset = 0;
+    u32 padding = 0;
+
+    while ( true )
+    {
+        write = (u32)output->m_Write;
+        offset = write & ( LOG_OUTPUT_BUFFER_SIZE - 1 );
+        padding = offset + record.m_Size > LOG_OUTPUT_BUFFER_SIZE ? LOG_OUTPUT_BUFFER_SIZE - offset : 0;
+
+        if ( LOG_OUTPUT_BUFFER_SIZE - ( write - (u32)output->m_Read ) >= padding + record.m_Size )
+        {
+            break;
+        }
+
+        // the output thread can't make room while it's waiting on us (a listener that prints)
+        if ( g_DrainThread == output->m_Thread
+            || ( g_OverflowPolicy == OverflowPolicies::Drop && record.m_Stream != Streams::Warning && record.m_Stream != Streams::Error ) )
+        {
+            Helium::AtomicIncrement( &g_Dropped );
+            return;
+        }
+
+        if ( g_AsyncOutput )
+        {
+            g_OutputSignal.Signal();
+            Helium::Sleep( 1 );
         }
         else
         {
-            fprintf( f, "%s", str );
+            // the output thread went away while we were waiting on it
+            DrainOutput( false );
         }
+    }
+
+    bool wasEmpty = write == (u32)output->m_Read;
+
+    if ( padding )
+    {
+        OutputRecord* pad = (OutputRecord*)( output->m_Buffer + offset );
+        pad->m_Size = padding;
+        pad->m_Stream = 0;
+
+        write += padding;
+        offset = 0;
+    }
 
-        fflush( f );
+    OutputRecord* dest = (OutputRecord*)( output->m_Buffer + offset );
+    memcpy( dest, &record, sizeof( OutputRecord ) );
+
+    tchar* text = (tchar*)( dest + 1 );
+    memcpy( text, string, record.m_Length * sizeof( tchar ) );
+    text[ record.m_Length ] = '\0';
+
+    // moving the write position is what hands the record over, the exchange keeps the copies above from moving past it
+    Helium::AtomicExchange( &output->m_Write, (i32)( write + record.m_Size ) );
+
+    // the output thread gets to a busy ring on its next pass, only wake it up for the first statement or a ring filling up
+    if ( wasEmpty || write + record.m_Size - (u32)output->m_Read > LOG_OUTPUT_BUFFER_SIZE / 2 )
+    {
+        g_OutputSignal.Signal();
+    }
+}
+
+static Thread::Return OutputThread( Thread::Param )
+{
+    while ( g_AsyncOutput )
+    {
+        g_OutputSignal.Wait( LOG_OUTPUT_FLUSH_MILLIS );
+        g_OutputSignal.Reset();
+
+        DrainOutput( false );
+    }
+
+    return Thread::Exit();
+}
+
+void Log::InitializeAsyncOutput()
+{
+    if ( g_AsyncOutput )
+    {
+        return;
+    }
+
+    Helium::AtomicExchange( &g_AsyncOutput, 1 );
+
+    if ( !g_OutputThread.Create( &OutputThread, NULL, "Log Output Thread" ) )
+    {
+        Helium::AtomicExchange( &g_AsyncOutput, 0 );
+    }
+}
+
+void Log::CleanupAsyncOutput()
+{
+    if ( !g_AsyncOutput )
+    {
+        return;
+    }
+
+    Helium::AtomicExchange( &g_AsyncOutput, 0 );
+    g_OutputSignal.Signal();
+
+    g_OutputThread.Wait();
+    g_OutputThread.Close();
+
+    // pick up whatever came in after the thread's last pass
+    DrainOutput( false );
+}
+
+bool Log::IsAsyncOutput()
+{
+    return g_AsyncOutput != 0;
+}
+
+OverflowPolicy Log::GetOverflowPolicy()
+{
+    return g_OverflowPolicy;
+}
+
+void Log::SetOverflowPolicy( OverflowPolicy policy )
+{
+    g_OverflowPolicy = policy;
+}
+
+void Log::Flush()
+{
+    DrainOutput( false );
+}
+
+void Log::FlushOnCrash()
+{
+    DrainOutput( true );
+}
+
+static void UpdateTraceFileStreams( const M_OutputFile& files )
+{
+    u32 streams = 0;
+
+    M_OutputFile::const_iterator itr = files.begin();
+    M_OutputFile::const_iterator end = files.end();
+    for( ; itr != end; ++itr )
+    {
+        streams |= (*itr).second.m_StreamType;
     }
+
+    g_TraceFileStreams = streams;
 }
 
 bool AddFile( M_OutputFile& files, const tstring& fileName, Stream stream, u32 threadId, bool append )
 {
+    // what was printed before the file was added doesn't go in it
+    Log::Flush();
+
     Helium::TakeMutex mutex (g_Mutex);
 
     M_OutputFile::iterator found = files.find( fileName );
@@ -248,6 +765,7 @@ bool AddFile( M_OutputFile& files, const tstring& fileName, Stream stream, u32 t
             info.m_RefCount = 1;
             info.m_ThreadId = threadId;
             files[ fileName ] = info;
+            UpdateTraceFileStreams( files );
             return true;
         }
     }
@@ -257,6 +775,9 @@ bool AddFile( M_OutputFile& files, const tstring& fileName, Stream stream, u32 t
 
 void RemoveFile( M_OutputFile& files, const tstring& fileName )
 {
+    // what was printed while the file was around still goes in it
+    Log::Flush();
+
     Helium::TakeMutex mutex (g_Mutex);
 
     M_OutputFile::iterator found = files.find( fileName );
@@ -268,6 +789,7 @@ void RemoveFile( M_OutputFile& files, const tstring& fileName )
         {
             g_FileManager.Close( fileName );
             files.erase( found );
+            UpdateTraceFileStreams( files );
         }
     }
 }
@@ -358,22 +880,22 @@ Log::Color Log::GetStreamColor( Log::Stream stream )
 
 int Log::GetErrorCount()
 {
-    return g_ErrorCount;
+    return (int)g_ErrorCount;
 }
 
 int Log::GetWarningCount()
 {
-    return g_WarningCount;
+    return (int)g_WarningCount;
 }
 
 void Log::ResetErrorCount()
 {
-    g_ErrorCount = 0;
+    Helium::AtomicExchange( &g_ErrorCount, 0 );
 }
 
 void Log::ResetWarningCount()
 {
-    g_WarningCount = 0;
+    Helium::AtomicExchange( &g_WarningCount, 0 );
 }
 
 void Log::LockMutex()
@@ -388,31 +910,32 @@ void Log::UnlockMutex()
 
 void Log::PrintString(const tchar* string, Stream stream, Level level, Color color, int indent, tchar* output, u32 outputSize)
 {
-    Helium::TakeMutex mutex (g_Mutex);
+    // determine if we should be displayed
+    bool display = ( g_Streams & stream ) == stream && level <= g_Level;
 
-    // check trace files
-    bool trace = false;
-    M_OutputFile::iterator itr = g_TraceFiles.begin();
-    M_OutputFile::iterator end = g_TraceFiles.end();
-    for( ; itr != end; ++itr )
+    // check trace files, the ones that only take a single thread get sorted out when the statement is written
+    bool trace = ( g_TraceFileStreams & stream ) == stream;
+
+    // check for nothing to do
+    if ( !trace && !display && !output )
     {
-        if ( ( (*itr).second.m_StreamType & stream ) == stream
-            && ( (*itr).second.m_ThreadId == -1 || (*itr).second.m_ThreadId == GetCurrentThreadID() ) )
-        {
-            trace = true;
-        }
+        return;
     }
 
-    // determine if we should be displayed
-    bool display = ( g_Streams & stream ) == stream && level <= g_Level;
+    if ( indent < 0 )
+    {
+        indent = g_Indent;
+    }
 
-    // check for nothing to do
-    if ( trace || display || output )
+    if ( indent > LOG_INDENT_MAX )
     {
-        if ( indent < 0 )
-        {
-            indent = g_Indent;
-        }
+        indent = LOG_INDENT_MAX;
+    }
+
+    // printing listeners can skip the statement, so they run here on the printing thread, it's rare to have any
+    if ( display && g_PrintingEvent.Valid() )
+    {
+        Helium::TakeMutex mutex (g_Mutex);
 
         // the statement
         Statement statement ( string, stream, level, indent );
@@ -420,79 +943,65 @@ void Log::PrintString(const tchar* string, Stream stream, Level level, Color col
         // construct the print statement
         PrintingArgs args ( statement );
 
-        // is this statement to be output via normal channels
-        if ( display )
-        {
-            // raise the printing event
-            g_PrintingEvent.Raise( args );
-        }
+        // raise the printing event
+        g_PrintingEvent.Raise( args );
 
         // only process this string if it was not handled by a handler
-        if ( !args.m_Skip )
+        if ( args.m_Skip )
         {
-            // apply indentation
-            statement.m_String.clear();
-            statement.ApplyIndent( string, statement.m_String );
+            return;
+        }
+    }
 
-            // output to screen window
-            if ( display )
-            {
-                // deduce the color if we were told to do so
-                if ( color == Colors::Auto )
-                {
-                    color = GetStreamColor( stream );
-                }
+    ThreadOutput* thread = ThreadOutput::Get();
 
-                // print the statement to the window
-                Helium::PrintString((Helium::ConsoleColor)color, stream == Streams::Error ? stderr : stdout, statement.m_String);
+    // apply indentation
+    tstring& indented = thread->m_Indented;
+    indented.clear();
+    IndentString( string, indent, indented );
 
-                // raise the printed event
-                g_PrintedEvent.Raise( PrintedArgs (statement) );
-            }
+    // output to buffer
+    if (output && outputSize > 0)
+    {
+        _tcsncpy( output, indented.c_str(), outputSize - 1 );
+    }
 
-            // send the text to the debugger, if no debugger nothing happens
-            OutputDebugString(statement.m_String.c_str());
+    OutputRecord record;
+    InitializeRecord( record, stream, level, color, indent, display );
+    record.m_Length = (u32)indented.length();
 
-            // output to trace file(s)
-            static bool stampNewLine = true;
+    if ( g_AsyncOutput )
+    {
+        QueueRecord( thread, record, indented.c_str() );
+    }
+    else
+    {
+        Helium::TakeMutex mutex (g_Mutex);
 
-            itr = g_TraceFiles.begin();
-            end = g_TraceFiles.end();
-            for( ; itr != end; ++itr )
-            {
-                if ( ( (*itr).second.m_StreamType & stream ) == stream
-                    && ( (*itr).second.m_ThreadId == -1 || (*itr).second.m_ThreadId == GetCurrentThreadID() ) )
-                {
-                    Redirect( (*itr).first, statement.m_String.c_str(), stampNewLine );
-                }
-            }
+        WriteRecord( record, indented.c_str(), true );
+        CommitTraceFiles();
+    }
+}
 
-            // update stampNewLine
-            if ( !statement.m_String.empty() )
-            {
-                stampNewLine = ( *statement.m_String.rbegin() == '\n' ) ? true : false ;
-            }
+// format into the calling thread's buffer and print it
+static void PrintFormatted(const tchar* fmt, va_list args, Stream stream, Level level, Color color, int indent = -1)
+{
+    ThreadOutput* output = ThreadOutput::Get();
 
-            // output to buffer
-            if (output && outputSize > 0)
-            {
-                _tcsncpy( output, statement.m_String.c_str(), outputSize - 1 );
-            }
-        }
-    }
+    int size = _vsntprintf(output->m_String, MAX_PRINT_SIZE, fmt, args);
+    output->m_String[ MAX_PRINT_SIZE - 1] = 0; 
+    HELIUM_ASSERT(size >= 0);
+
+    PrintString(output->m_String, stream, level, color, indent);
 }
 
 void Log::PrintStatement(const Statement& statement)
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     PrintString( statement.m_String.c_str(), statement.m_Stream, statement.m_Level, GetStreamColor( statement.m_Stream ), statement.m_Indent );
 }
 
 void Log::PrintStatements(const V_Statement& statements, u32 streamFilter)
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     V_Statement::const_iterator itr = statements.begin();
     V_Statement::const_iterator end = statements.end();
     for ( ; itr != end; ++itr )
@@ -506,135 +1015,78 @@ void Log::PrintStatements(const V_Statement& statements, u32 streamFilter)
 
 void Log::PrintColor(Log::Color color, const tchar* fmt, ...)
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-    PrintString(string, Streams::Normal, Levels::Default, color); 
+    PrintFormatted(fmt, args, Streams::Normal, Levels::Default, color); 
     va_end(args); 
 }
 
 void Log::Print(const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Normal, Levels::Default, Log::GetStreamColor( Streams::Normal ));
+    PrintFormatted(fmt, args, Streams::Normal, Levels::Default, Log::GetStreamColor( Streams::Normal ));
     va_end(args);      
 }
 
 void Log::Print(Level level, const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Normal, level, Log::GetStreamColor( Streams::Normal ));
+    PrintFormatted(fmt, args, Streams::Normal, level, Log::GetStreamColor( Streams::Normal ));
     va_end(args);       
 }
 
 void Log::Debug(const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Debug, Levels::Default, Log::GetStreamColor( Streams::Debug ), 0);
+    PrintFormatted(fmt, args, Streams::Debug, Levels::Default, Log::GetStreamColor( Streams::Debug ), 0);
     va_end(args);
 }
 
 void Log::Debug(Level level, const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Debug, level, Log::GetStreamColor( Streams::Debug ), 0);
+    PrintFormatted(fmt, args, Streams::Debug, level, Log::GetStreamColor( Streams::Debug ), 0);
     va_end(args);
 }
 
 void Log::Profile(const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Profile, Levels::Default, Log::GetStreamColor( Streams::Profile ), 0);
+    PrintFormatted(fmt, args, Streams::Profile, Levels::Default, Log::GetStreamColor( Streams::Profile ), 0);
     va_end(args);
 }
 
 void Log::Profile(Level level, const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Profile, level, Log::GetStreamColor( Streams::Profile ), 0);
+    PrintFormatted(fmt, args, Streams::Profile, level, Log::GetStreamColor( Streams::Profile ), 0);
     va_end(args);
 }
 
 void Log::Warning(const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
-    static tchar format[MAX_PRINT_SIZE];
-    _stprintf(format, TXT( "Warning (%d): " ), ++g_WarningCount);
+    tchar* format = ThreadOutput::Get()->m_Format;
+    _stprintf(format, TXT( "Warning (%d): " ), Helium::AtomicIncrement( &g_WarningCount ));
     _tcscat(format, fmt);
 
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), format, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Warning, Levels::Default, Log::GetStreamColor( Streams::Warning ), 0);
+    PrintFormatted(format, args, Streams::Warning, Levels::Default, Log::GetStreamColor( Streams::Warning ), 0);
     va_end(args);      
 }
 
 void Log::Warning(Level level, const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
-    static tchar format[MAX_PRINT_SIZE];
+    tchar* format = ThreadOutput::Get()->m_Format;
     if (level == Levels::Default)
     {
-        _stprintf(format, TXT( "Warning (%d): " ), ++g_WarningCount);
+        _stprintf(format, TXT( "Warning (%d): " ), Helium::AtomicIncrement( &g_WarningCount ));
     }
     else
     {
@@ -644,42 +1096,28 @@ void Log::Warning(Level level, const tchar *fmt,...)
 
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), format, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Warning, level, Log::GetStreamColor( Streams::Warning ), 0);
+    PrintFormatted(format, args, Streams::Warning, level, Log::GetStreamColor( Streams::Warning ), 0);
     va_end(args);      
 }
 
 void Log::Error(const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
-    static tchar format[MAX_PRINT_SIZE];
-    _stprintf(format, TXT( "Error (%d): " ), ++g_ErrorCount);
+    tchar* format = ThreadOutput::Get()->m_Format;
+    _stprintf(format, TXT( "Error (%d): " ), Helium::AtomicIncrement( &g_ErrorCount ));
     _tcscat(format, fmt);
 
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), format, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Error, Levels::Default, Log::GetStreamColor( Streams::Error ), 0);
+    PrintFormatted(format, args, Streams::Error, Levels::Default, Log::GetStreamColor( Streams::Error ), 0);
     va_end(args);
 }
 
 void Log::Error(Level level, const tchar *fmt,...) 
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
-    static tchar format[MAX_PRINT_SIZE];
+    tchar* format = ThreadOutput::Get()->m_Format;
     if (level == Levels::Default)
     {
-        _stprintf(format, TXT( "Error (%d): " ), ++g_ErrorCount);
+        _stprintf(format, TXT( "Error (%d): " ), Helium::AtomicIncrement( &g_ErrorCount ));
     }
     else
     {
@@ -689,28 +1127,16 @@ void Log::Error(Level level, const tchar *fmt,...)
 
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), format, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Error, level, Log::GetStreamColor( Streams::Error ), 0);
+    PrintFormatted(format, args, Streams::Error, level, Log::GetStreamColor( Streams::Error ), 0);
     va_end(args);
 }
 
 Log::Heading::Heading(const tchar *fmt, ...)
 {
-    Helium::TakeMutex mutex (g_Mutex);
-
     // do a basic print
     va_list args;
     va_start(args, fmt); 
-    static tchar string[MAX_PRINT_SIZE];
-    int size = _vsntprintf(string, sizeof(string), fmt, args);
-    string[ sizeof(string) - 1] = 0; 
-    HELIUM_ASSERT(size >= 0);
-
-    PrintString(string, Streams::Normal, Levels::Default, Log::GetStreamColor( Streams::Normal ));
+    PrintFormatted(fmt, args, Streams::Normal, Levels::Default, Log::GetStreamColor( Streams::Normal ));
     va_end(args);      
 
     // now indent
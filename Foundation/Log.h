@@ -240,6 +240,38 @@ namespace Helium
         FOUNDATION_API void UnlockMutex();
 
 
+        //
+        // Asynchronous output hands statements off to a background thread that writes them to the console,
+        //  the trace files, and the printed listeners, so printing threads only format and copy their text
+        //
+
+        namespace OverflowPolicies
+        {
+            enum OverflowPolicy
+            {
+                Block,  // wait for the output thread to make room
+                Drop,   // throw the statement away and count it, warnings and errors still wait
+            };
+        }
+        typedef OverflowPolicies::OverflowPolicy OverflowPolicy;
+
+        // start and stop the output thread, while it isn't running statements are written by the thread that prints them
+        FOUNDATION_API void InitializeAsyncOutput();
+        FOUNDATION_API void CleanupAsyncOutput();
+        FOUNDATION_API bool IsAsyncOutput();
+
+        // what a printing thread does when its buffer is full of statements the output thread hasn't gotten to yet
+        FOUNDATION_API OverflowPolicy GetOverflowPolicy();
+        FOUNDATION_API void SetOverflowPolicy( OverflowPolicy policy );
+
+        // write out everything printed so far before returning
+        FOUNDATION_API void Flush();
+
+        // like Flush, but for a dying process, only the trace files and the debugger get the output and
+        //  it doesn't wait long on other threads
+        FOUNDATION_API void FlushOnCrash();
+
+
         //
         // Printing APIs are the heart of Console
         //
@@ -0,0 +1,97 @@
+#include "Endian.h"
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE2__ )
+# define HELIUM_ENDIAN_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace Helium;
+
+#ifdef HELIUM_ENDIAN_SSE2
+
+// swaps the bytes of each 16 bit lane
+static inline __m128i SwapBytes16( __m128i value )
+{
+    return _mm_or_si128( _mm_slli_epi16( value, 8 ), _mm_srli_epi16( value, 8 ) );
+}
+
+#endif
+
+void Helium::ConvertEndianArray(u16* values, size_t count, bool endian)
+{
+    if (!endian)
+    {
+        return;
+    }
+
+    size_t index = 0;
+
+#ifdef HELIUM_ENDIAN_SSE2
+    for ( ; index + 8 <= count; index += 8 )
+    {
+        __m128i value = _mm_loadu_si128( (const __m128i*)( values + index ) );
+        _mm_storeu_si128( (__m128i*)( values + index ), SwapBytes16( value ) );
+    }
+#endif
+
+    for ( ; index < count; ++index )
+    {
+        values[ index ] = ConvertEndian( values[ index ], true );
+    }
+}
+
+void Helium::ConvertEndianArray(u32* values, size_t count, bool endian)
+{
+    if (!endian)
+    {
+        return;
+    }
+
+    size_t index = 0;
+
+#ifdef HELIUM_ENDIAN_SSE2
+    for ( ; index + 4 <= count; index += 4 )
+    {
+        __m128i value = _mm_loadu_si128( (const __m128i*)( values + index ) );
+
+        // swap the 16 bit halves of each value, then the bytes of each half
+        value = _mm_shufflelo_epi16( value, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        value = _mm_shufflehi_epi16( value, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+
+        _mm_storeu_si128( (__m128i*)( values + index ), SwapBytes16( value ) );
+    }
+#endif
+
+    for ( ; index < count; ++index )
+    {
+        values[ index ] = ConvertEndian( values[ index ], true );
+    }
+}
+
+void Helium::ConvertEndianArray(u64* values, size_t count, bool endian)
+{
+    if (!endian)
+    {
+        return;
+    }
+
+    size_t index = 0;
+
+#ifdef HELIUM_ENDIAN_SSE2
+    for ( ; index + 2 <= count; index += 2 )
+    {
+        __m128i value = _mm_loadu_si128( (const __m128i*)( values + index ) );
+
+        // reverse the 16 bit quarters of each value, then the bytes of each quarter
+        value = _mm_shufflelo_epi16( value, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+        value = _mm_shufflehi_epi16( value, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+
+        _mm_storeu_si128( (__m128i*)( values + index ), SwapBytes16( value ) );
+    }
+#endif
+
+    for ( ; index < count; ++index )
+    {
+        values[ index ] = ConvertEndian( values[ index ], true );
+    }
+}
@@ -3,6 +3,12 @@
 #include "Platform/Types.h"
 #include "Platform/Assert.h"
 
+#include "Foundation/API.h"
+
+#ifdef _MSC_VER
+# include <stdlib.h>
+#endif
+
 namespace Helium
 {
 
@@ -24,13 +30,10 @@ namespace Helium
     {
         if (endian)
         {
-#if defined( WIN32 ) && defined ( _M_IX86 )
-            _asm mov eax,DWORD PTR [val];
-            _asm mov ebx,DWORD PTR [val+4];
-            _asm bswap eax;
-            _asm bswap ebx;
-            _asm mov DWORD PTR [val+4],eax;
-            _asm mov DWORD PTR [val],ebx;
+#if defined( _MSC_VER )
+            val = _byteswap_uint64(val);
+#elif defined( __GNUC__ )
+            val = __builtin_bswap64(val);
 #else
             HELIUM_BREAK();
 #endif
@@ -78,10 +81,10 @@ namespace Helium
     {
         if (endian)
         {
-#if defined( WIN32 ) && defined ( _M_IX86 )
-            _asm mov eax,val;
-            _asm bswap eax;
-            _asm mov val,eax;
+#if defined( _MSC_VER )
+            val = _byteswap_ulong(val);
+#elif defined( __GNUC__ )
+            val = __builtin_bswap32(val);
 #else
             HELIUM_BREAK();
 #endif
@@ -129,12 +132,10 @@ namespace Helium
     {
         if (endian)
         {
-#if defined( WIN32 ) && defined ( _M_IX86 )
-            _asm mov ax,val;
-            _asm xchg al,ah;
-            _asm mov val,ax;
+#if defined( _MSC_VER )
+            val = _byteswap_ushort(val);
 #else
-            HELIUM_BREAK();
+            val = (u16)( ( val << 8 ) | ( val >> 8 ) );
 #endif
         }
 
@@ -159,6 +160,40 @@ namespace Helium
         return val;
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Swaps whole arrays in place, using SSE2 where it's available
+    //
+
+    FOUNDATION_API void ConvertEndianArray(u16* values, size_t count, bool endian = true);
+    FOUNDATION_API void ConvertEndianArray(u32* values, size_t count, bool endian = true);
+    FOUNDATION_API void ConvertEndianArray(u64* values, size_t count, bool endian = true);
+
+    inline void ConvertEndianArray(i16* values, size_t count, bool endian = true)
+    {
+        ConvertEndianArray((u16*)values, count, endian);
+    }
+
+    inline void ConvertEndianArray(i32* values, size_t count, bool endian = true)
+    {
+        ConvertEndianArray((u32*)values, count, endian);
+    }
+
+    inline void ConvertEndianArray(f32* values, size_t count, bool endian = true)
+    {
+        ConvertEndianArray((u32*)values, count, endian);
+    }
+
+    inline void ConvertEndianArray(i64* values, size_t count, bool endian = true)
+    {
+        ConvertEndianArray((u64*)values, count, endian);
+    }
+
+    inline void ConvertEndianArray(f64* values, size_t count, bool endian = true)
+    {
+        ConvertEndianArray((u64*)values, count, endian);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
     template<class T>
@@ -2,10 +2,15 @@
 #include "Log.h"
 
 #include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Condition.h"
+#include "Platform/Mutex.h"
 #include "Platform/Thread.h"
 #include "Platform/Platform.h"
 #include "Platform/Types.h"
 
+#include <algorithm>
+
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
@@ -21,12 +26,6 @@
 using namespace Helium;
 using namespace Helium::Profile;
 
-static u32           g_AccumulatorCount = 0;
-static Accumulator*  g_Accumulators[ PROFILE_ACCUMULATOR_MAX ];
-
-static u32           g_ContextCount = 0; 
-static Context*      g_Contexts[ PROFILE_CONTEXTS_MAX ];
-
 static bool          g_Enabled = false;
 
 bool Profile::Settings::Enabled()
@@ -41,36 +40,193 @@ void Profile::Initialize()
 
 void Profile::Cleanup()
 {
-    for(u32 i = 0; i < g_ContextCount; ++i)
+    StopTrace(); 
+    g_Enabled = false;
+}
+
+namespace
+{
+    //
+    // Histogram buckets are log-linear, small values get a bucket each and above that every power of two
+    //  is split into PROFILE_HISTOGRAM_SUB_BUCKETS, so a bucket is never more than 1/16th off from its samples
+    //
+
+    const u32 PROFILE_HISTOGRAM_SUB_BITS    = 4;
+    const u32 PROFILE_HISTOGRAM_SUB_BUCKETS = 1 << PROFILE_HISTOGRAM_SUB_BITS;
+    const u32 PROFILE_HISTOGRAM_LINEAR      = PROFILE_HISTOGRAM_SUB_BUCKETS * 2;
+    const u32 PROFILE_HISTOGRAM_BUCKETS     = PROFILE_HISTOGRAM_LINEAR + ( 64 - PROFILE_HISTOGRAM_SUB_BITS - 1 ) * PROFILE_HISTOGRAM_SUB_BUCKETS;
+
+    u32 HighestBit(u64 value)
+    {
+        u32 bit = 0;
+        for (u32 shift = 32; shift; shift >>= 1)
+        {
+            if (value >> shift)
+            {
+                value >>= shift;
+                bit += shift;
+            }
+        }
+        return bit;
+    }
+
+    u32 GetBucket(u64 cycles)
     {
-        g_Contexts[i]->FlushFile(); 
-        delete(g_Contexts[i]); 
+        if (cycles < PROFILE_HISTOGRAM_LINEAR)
+        {
+            return (u32)cycles;
+        }
+
+        u32 bit = HighestBit(cycles);
+        u32 sub = (u32)( cycles >> ( bit - PROFILE_HISTOGRAM_SUB_BITS ) ) & ( PROFILE_HISTOGRAM_SUB_BUCKETS - 1 );
+        return PROFILE_HISTOGRAM_LINEAR + ( bit - PROFILE_HISTOGRAM_SUB_BITS - 1 ) * PROFILE_HISTOGRAM_SUB_BUCKETS + sub;
+    }
+
+    // the middle of the range of cycle counts that land in the bucket
+    u64 GetBucketValue(u32 bucket)
+    {
+        if (bucket < PROFILE_HISTOGRAM_LINEAR)
+        {
+            return bucket;
+        }
+
+        u32 bit = ( bucket - PROFILE_HISTOGRAM_LINEAR ) / PROFILE_HISTOGRAM_SUB_BUCKETS + PROFILE_HISTOGRAM_SUB_BITS + 1;
+        u64 sub = ( bucket - PROFILE_HISTOGRAM_LINEAR ) % PROFILE_HISTOGRAM_SUB_BUCKETS;
+        u64 width = (u64)1 << ( bit - PROFILE_HISTOGRAM_SUB_BITS );
+        return ( (u64)1 << bit ) + sub * width + width / 2;
+    }
+
+    //
+    // One thread's samples for one accumulator, only the owning thread writes to it
+    //
+
+    struct AccumulatorShard
+    {
+        u64 m_Hits;
+        u64 m_TotalCycles;
+        u64 m_MinCycles;
+        u64 m_MaxCycles;
+        u32 m_Histogram[ PROFILE_HISTOGRAM_BUCKETS ];
+
+        AccumulatorShard()
+        {
+            Reset();
+        }
+
+        void Reset()
+        {
+            m_Hits = 0;
+            m_TotalCycles = 0;
+            m_MinCycles = ~(u64)0;
+            m_MaxCycles = 0;
+            memset( m_Histogram, 0, sizeof( m_Histogram ) );
+        }
+
+        void Add(u64 cycles)
+        {
+            m_Hits++;
+            m_TotalCycles += cycles;
+            m_MinCycles = MIN( m_MinCycles, cycles );
+            m_MaxCycles = MAX( m_MaxCycles, cycles );
+            m_Histogram[ GetBucket( cycles ) ]++;
+        }
+    };
+
+    //
+    // Every thread that hits an accumulator gets a set of shards, the sets are chained together
+    //  for reporting by swapping in a new tail and linking the old one to it, so registering
+    //  never takes a lock (the reporter may just miss a thread that is in the middle of it)
+    //
+    // Sets are never unlinked, the reporter walks them without locking, instead a thread hands its
+    //  set back when it exits and the next new thread picks it up, samples and all, so there are
+    //  only ever as many sets as there have been threads running at once
+    //
+
+    struct AccumulatorShards
+    {
+        AccumulatorShard* volatile  m_Shards[ PROFILE_ACCUMULATOR_MAX ];
+        AccumulatorShards* volatile m_Next;
+        volatile i32                m_Owned;
+
+        AccumulatorShards()
+            : m_Next (NULL)
+            , m_Owned (0)
+        {
+            memset( (void*)m_Shards, 0, sizeof( m_Shards ) );
+        }
+    };
+
+    AccumulatorShards           g_ShardsHead;
+    AccumulatorShards* volatile g_ShardsTail = &g_ShardsHead;
+
+    void ReleaseShards(void* shards)
+    {
+        Helium::AtomicExchange( &((AccumulatorShards*)shards)->m_Owned, 0 );
+    }
+
+    Helium::ThreadLocalPointer  g_ThreadShards ( &ReleaseShards );
+
+    AccumulatorShards* ClaimShards()
+    {
+        for (AccumulatorShards* shards = &g_ShardsHead; shards; shards = shards->m_Next)
+        {
+            if (shards->m_Owned == 0 && Helium::AtomicCompareExchange( &shards->m_Owned, 1, 0 ) == 0)
+            {
+                return shards;
+            }
+        }
+
+        AccumulatorShards* shards = new AccumulatorShards;
+        shards->m_Owned = 1;
+
+        AccumulatorShards* prev = (AccumulatorShards*)Helium::AtomicExchangePointer( (void* volatile*)&g_ShardsTail, shards );
+        prev->m_Next = shards;
+
+        return shards;
+    }
+
+    AccumulatorShard* GetShard(i32 index)
+    {
+        AccumulatorShards* shards = (AccumulatorShards*)g_ThreadShards.GetPointer();
+
+        if (shards == NULL)
+        {
+            shards = ClaimShards();
+            g_ThreadShards.SetPointer( shards );
+        }
+
+        AccumulatorShard* shard = shards->m_Shards[ index ];
+
+        if (shard == NULL)
+        {
+            shard = new AccumulatorShard;
+
+            // publish it filled out
+            Helium::AtomicExchangePointer( (void* volatile*)&shards->m_Shards[ index ], shard );
+        }
+
+        return shard;
     }
-    g_ContextCount = 0; 
-    g_Enabled = false;
 }
 
+static volatile i32  g_AccumulatorCount = 0;
+static Accumulator*  g_Accumulators[ PROFILE_ACCUMULATOR_MAX ];
+
 Accumulator::Accumulator()
-: m_Hits (0)
-, m_TotalMillis (0.0f)
-, m_Index (-1)
+: m_Index (-1)
 {
 
 
 }
 
 Accumulator::Accumulator(const char* name)
-: m_Hits (0)
-, m_TotalMillis (0.0f)
-, m_Index (-1)
+: m_Index (-1)
 {
     Init(name); 
 }
 
 Accumulator::Accumulator(const char* function, const char* name)
-: m_Hits (0)
-, m_TotalMillis (0.0f)
-, m_Index (-1)
+: m_Index (-1)
 {
     size_t temp = MIN( strlen( function ), sizeof(m_Name)-1 );
     memcpy( m_Name, function, temp );
@@ -95,10 +251,15 @@ void Accumulator::Init(const char* name)
         HELIUM_ASSERT(m_Name[0] != '\0');
     }
 
+    // function level statics can be constructed from several threads at once
     if (m_Index < 0 && g_AccumulatorCount < PROFILE_ACCUMULATOR_MAX)
     {
-        g_Accumulators[ g_AccumulatorCount ] = this;
-        m_Index = g_AccumulatorCount++;
+        i32 index = Helium::AtomicIncrement( &g_AccumulatorCount ) - 1;
+        if (index < PROFILE_ACCUMULATOR_MAX)
+        {
+            g_Accumulators[ index ] = this;
+            m_Index = index;
+        }
     }
 }
 
@@ -110,227 +271,797 @@ Accumulator::~Accumulator()
     }
 }
 
-void Accumulator::Report()
+void Accumulator::Add(u64 cycles)
 {
-    Log::Profile( TXT( "[%12.3f] [%8d] %s\n" ), m_TotalMillis, m_Hits, m_Name);
+    if (m_Index >= 0)
+    {
+        GetShard( m_Index )->Add( cycles );
+    }
 }
 
-int CompareAccumulatorPtr( const void* ptr1, const void* ptr2 )
+void Accumulator::Collect(AccumulatorStats& stats)
 {
-    const Accumulator* left = *(const Accumulator**)ptr1;
-    const Accumulator* right = *(const Accumulator**)ptr2;
+    memset( &stats, 0, sizeof( stats ) );
+
+    if (m_Index < 0)
+    {
+        return;
+    }
+
+    u64 totalCycles = 0;
+    u64 minCycles = ~(u64)0;
+    u64 maxCycles = 0;
+    std::vector< u64 > histogram ( PROFILE_HISTOGRAM_BUCKETS );
 
-    if (left && !right)
+    // the owning threads keep going while we read, so this is a close snapshot rather than an exact one
+    for (AccumulatorShards* shards = &g_ShardsHead; shards; shards = shards->m_Next)
     {
-        return -1;
+        AccumulatorShard* shard = shards->m_Shards[ m_Index ];
+        if (shard == NULL || shard->m_Hits == 0)
+        {
+            continue;
+        }
+
+        stats.m_Hits += shard->m_Hits;
+        totalCycles += shard->m_TotalCycles;
+        minCycles = MIN( minCycles, shard->m_MinCycles );
+        maxCycles = MAX( maxCycles, shard->m_MaxCycles );
+
+        for (u32 i = 0; i < PROFILE_HISTOGRAM_BUCKETS; ++i)
+        {
+            histogram[ i ] += shard->m_Histogram[ i ];
+        }
     }
 
-    if (!left && right)
+    if (stats.m_Hits == 0)
     {
-        return 1;
+        return;
     }
 
-    if (left && right)
+    stats.m_TotalMillis = Helium::CyclesToMillis( totalCycles );
+    stats.m_AverageMillis = stats.m_TotalMillis / (f32)stats.m_Hits;
+    stats.m_MinMillis = Helium::CyclesToMillis( minCycles );
+    stats.m_MaxMillis = Helium::CyclesToMillis( maxCycles );
+
+    const f64 percentiles[] = { 0.50, 0.99, 0.999 };
+    f32* results[] = { &stats.m_P50Millis, &stats.m_P99Millis, &stats.m_P999Millis };
+
+    u64 seen = 0;
+    u32 bucket = 0;
+    for (u32 p = 0; p < sizeof(percentiles) / sizeof(percentiles[0]); ++p)
     {
-        if ((left)->m_TotalMillis > (right)->m_TotalMillis)
+        u64 rank = (u64)( percentiles[ p ] * (f64)stats.m_Hits );
+        if (rank >= stats.m_Hits)
         {
-            return -1;
+            rank = stats.m_Hits - 1;
         }
-        else if ((left)->m_TotalMillis < (right)->m_TotalMillis)
+
+        while (bucket < PROFILE_HISTOGRAM_BUCKETS && seen + histogram[ bucket ] <= rank)
         {
-            return 1;
+            seen += histogram[ bucket++ ];
         }
-    }
 
-    return 0;
+        // the bucket's middle can land outside what was actually seen
+        u64 cycles = bucket < PROFILE_HISTOGRAM_BUCKETS ? GetBucketValue( bucket ) : maxCycles;
+        cycles = MAX( minCycles, MIN( maxCycles, cycles ) );
+        *results[ p ] = Helium::CyclesToMillis( cycles );
+    }
 }
 
-void Accumulator::ReportAll()
+void Accumulator::Reset()
 {
-    float totalTime = 0.f;
-    for ( u32 i = 0; i < g_AccumulatorCount; i++ )
+    if (m_Index < 0)
+    {
+        return;
+    }
+
+    for (AccumulatorShards* shards = &g_ShardsHead; shards; shards = shards->m_Next)
     {
-        if (g_Accumulators[i])
+        AccumulatorShard* shard = shards->m_Shards[ m_Index ];
+        if (shard)
         {
-            totalTime += g_Accumulators[i]->m_TotalMillis;
+            shard->Reset();
         }
     }
+}
+
+void Accumulator::Report()
+{
+    AccumulatorStats stats;
+    Collect( stats );
+    Report( stats );
+}
+
+void Accumulator::Report(const AccumulatorStats& stats)
+{
+    Log::Profile( TXT( "[%12.3f] [%8d] [%10.3f %10.3f %10.3f %10.3f %10.3f %10.3f] %s\n" ), 
+        stats.m_TotalMillis, (u32)stats.m_Hits, stats.m_AverageMillis, stats.m_MinMillis, stats.m_P50Millis, stats.m_P99Millis, stats.m_P999Millis, stats.m_MaxMillis, m_Name);
+}
+
+struct AccumulatorReport
+{
+    Accumulator*        m_Accumulator;
+    AccumulatorStats    m_Stats;
 
-    if (totalTime > 0.f)
+    bool operator<(const AccumulatorReport& rhs) const
     {
-        Log::Profile( TXT( "\nProfile Report:\n" ) );
+        return m_Stats.m_TotalMillis > rhs.m_Stats.m_TotalMillis;
+    }
+};
+
+void Accumulator::ReportAll()
+{
+    std::vector< AccumulatorReport > reports;
 
-        qsort( g_Accumulators, g_AccumulatorCount, sizeof(Accumulator*), &CompareAccumulatorPtr );
+    u32 count = MIN( (u32)g_AccumulatorCount, (u32)PROFILE_ACCUMULATOR_MAX );
+    for ( u32 i = 0; i < count; i++ )
+    {
+        AccumulatorReport report;
+        report.m_Accumulator = g_Accumulators[i];
 
-        for ( u32 i = 0; i < g_AccumulatorCount; i++ )
+        if (report.m_Accumulator)
         {
-            if (g_Accumulators[i] && g_Accumulators[i]->m_TotalMillis > 0.f)
+            report.m_Accumulator->Collect( report.m_Stats );
+
+            if (report.m_Stats.m_TotalMillis > 0.f)
             {
-                g_Accumulators[i]->Report();
+                reports.push_back( report );
             }
         }
     }
+
+    if (!reports.empty())
+    {
+        std::sort( reports.begin(), reports.end() );
+
+        Log::Profile( TXT( "\nProfile Report:\n" ) );
+        Log::Profile( TXT( "[  total (ms)] [    hits] [  avg (ms)   min (ms)   p50 (ms)   p99 (ms)  p999 (ms)   max (ms)] name\n" ) );
+
+        for ( u32 i = 0; i < reports.size(); i++ )
+        {
+            reports[i].m_Accumulator->Report( reports[i].m_Stats );
+        }
+    }
 }
 
-Helium::ThreadLocalPointer g_ProfileContext;
+static volatile i32  g_Tracing = 0;
+static bool          g_TraceOpen = false;   // the file is open, retired rings wait for their events to be written
+static TraceRing*    g_TraceRings = NULL;
+static Mutex         g_TraceRingsMutex;
+
+// ids only mean something within one trace file, so each trace starts a new table
+static Mutex                     g_TraceStringsMutex;
+static std::map< std::string, u32 > g_TraceStringLookup;
+static std::vector< const char* >   g_TraceStrings;         // interned copies
+static std::vector< const char* >   g_TraceStringsRetired;  // the previous trace's, a straggling thread may still be comparing against them
+static u32                       g_TraceStringsWritten = 0;
+static volatile i32              g_TraceStringsTable = 0;
+
+static Helium::TraceFile         g_TraceFile;
+static Helium::Thread            g_TraceThread;
+static Helium::Condition         g_TraceFlush;
+
+// after everything Release uses, so it is torn down first
+static Helium::ThreadLocalPointer g_TraceRing ( &TraceRing::Release );
 
 ScopeTimer::ScopeTimer(Accumulator* accum, const char* func, u32 line, const char* desc)
+: m_Description (desc)
+, m_StartTicks (Helium::TimerGetClock())
+, m_Accum (accum)
+, m_Trace (NULL)
+, m_TraceID (0)
+, m_Print (desc != NULL)
 {
     HELIUM_ASSERT(func); 
-    m_Description[0] = '\0'; 
-    if(desc)
+
+    if (g_Tracing)
     {
-        strncpy(m_Description, desc, sizeof(m_Description)); 
-        m_Description[ sizeof(m_Description)-1 ] = '\0'; 
+        // descriptions are often formatted per call, the accumulator's name is the same every time
+        const char* name = func; 
+        if (accum && accum->m_Name[0] != '\0')
+        {
+            name = accum->m_Name; 
+        }
+        else if (desc && desc[0] != '\0')
+        {
+            name = desc; 
+        }
+
+        m_Trace = TraceRing::Get(); 
+        m_TraceID = m_Trace->Intern(name); 
+        m_Trace->Record(m_TraceID, TraceEventTypes::Enter, m_StartTicks); 
     }
+}
 
-    m_Accum       = accum; 
-    m_StartTicks  = Helium::TimerGetClock(); 
-    m_Print       = desc != NULL; 
+ScopeTimer::~ScopeTimer()
+{
+    u64 stopTicks = Helium::TimerGetClock();  
 
-#if defined(PROFILE_INSTRUMENTATION)
+    if (m_Trace)
+    {
+        m_Trace->Record(m_TraceID, TraceEventTypes::Exit, stopTicks); 
+    }
 
-    Context* context = (Context*)g_ProfileContext.GetPointer(); 
+    u64 taken = stopTicks - m_StartTicks; 
 
-    if(context == NULL)
+    if ( m_Print && m_Description[0] != '\0' )
     {
-        context = new Context; 
-        g_ProfileContext.SetPointer( context ); 
+        Log::Profile( TXT( "[%12.3f] %s\n" ), Helium::CyclesToMillis(taken), m_Description);
+    }
+
+#if defined(PROFILE_ACCUMULATION)
+
+    if(m_Accum)
+    {
+        m_Accum->Add(taken); 
+    }
+
+#endif
+}
+
+TraceRing::TraceRing()
+: m_Write (0)
+, m_Read (0)
+, m_Dropped (0)
+, m_Thread (Helium::GetCurrentThreadID())
+, m_Depth (0)
+, m_Next (NULL)
+, m_Retired (false)
+, m_Strings (g_TraceStringsTable)
+{
+    memset(m_Cache, 0, sizeof(m_Cache)); 
+}
 
-        // save it off. this should probably be locked
-        g_Contexts[ g_ContextCount ] = context; 
-        g_ContextCount++; 
+TraceRing* TraceRing::Get()
+{
+    TraceRing* ring = (TraceRing*)g_TraceRing.GetPointer(); 
 
-        InitPacket* init = context->AllocPacket<InitPacket>(PROFILE_CMD_INIT); 
+    if (ring == NULL)
+    {
+        ring = new TraceRing; 
+        g_TraceRing.SetPointer( ring ); 
 
-        init->m_Version    = PROFILE_PROTOCOL_VERSION;
-        init->m_Signature  = PROFILE_SIGNATURE; 
-        init->m_Conversion = Helium::CyclesToMillis(PROFILE_CYCLES_FOR_CONVERSION); 
+        // rings stay until their thread exits, threads may still be unwinding scopes when a trace stops
+        Helium::TakeMutex mutex (g_TraceRingsMutex); 
+        ring->m_Next = g_TraceRings; 
+        g_TraceRings = ring; 
     }
 
-    ScopeEnterPacket* enter = context->AllocPacket<ScopeEnterPacket>(PROFILE_CMD_SCOPE_ENTER); 
+    return ring; 
+}
 
-    enter->m_UniqueID   = context->m_UniqueID++; 
-    enter->m_StackDepth = context->m_StackDepth; 
-    enter->m_Line       = line; 
-    enter->m_StartTicks = m_StartTicks; 
+void TraceRing::Release(void* pointer)
+{
+    TraceRing* ring = (TraceRing*)pointer; 
 
-    strncpy(enter->m_Description, m_Description, sizeof(enter->m_Description)); 
-    enter->m_Description[ sizeof(enter->m_Description)-1] = 0; 
+    Helium::TakeMutex mutex (g_TraceRingsMutex); 
 
-    strncpy(enter->m_Function, func, sizeof(enter->m_Function)); 
-    enter->m_Function[ sizeof(enter->m_Function)-1] = 0; 
+    // the flush writes out what's left and frees it, otherwise nobody wants the events
+    if (g_TraceOpen)
+    {
+        ring->m_Retired = true; 
+        return; 
+    }
 
-    context->m_StackDepth++; 
-    if(m_Accum && m_Accum->m_Index != -1)
+    TraceRing** link = &g_TraceRings; 
+    while (*link != ring)
     {
-        context->m_AccumStack[ m_Accum->m_Index ]++; 
+        link = &(*link)->m_Next; 
     }
 
-#endif
+    *link = ring->m_Next; 
+    delete ring; 
 }
 
-ScopeTimer::~ScopeTimer()
+// the caller holds g_TraceStringsMutex
+static u32 InternTraceStringLocked(const char* string)
 {
-    u64 stopTicks = Helium::TimerGetClock();  
+    std::map< std::string, u32 >::const_iterator found = g_TraceStringLookup.find( string ); 
+    if (found != g_TraceStringLookup.end())
+    {
+        return found->second; 
+    }
 
-    u64   taken  = stopTicks - m_StartTicks; 
-    float millis = Helium::CyclesToMillis(taken); 
+    size_t length = strlen(string); 
+    char* copy = new char[ length + 1 ]; 
+    memcpy(copy, string, length + 1); 
 
-    if ( m_Print && m_Description[0] != '\0' )
+    u32 id = (u32)g_TraceStrings.size(); 
+    g_TraceStrings.push_back( copy ); 
+    g_TraceStringLookup[ string ] = id; 
+
+    return id; 
+}
+
+u32 TraceRing::Intern(const char* string)
+{
+    // a new trace started a new string table
+    if (m_Strings != g_TraceStringsTable)
+    {
+        memset(m_Cache, 0, sizeof(m_Cache)); 
+        m_Strings = g_TraceStringsTable; 
+    }
+
+    // callers almost always pass the same literal or accumulator name, so hash the pointer
+    CacheEntry& entry = m_Cache[ ( (size_t)string >> 2 ) & (PROFILE_TRACE_RING_CACHE - 1) ]; 
+
+    // the contents are checked too, some callers format into the same buffer every time
+    if (entry.m_Key == string && strcmp(entry.m_String, string) == 0)
+    {
+        return entry.m_ID; 
+    }
+
+    // the lock is held across both so the table can't be replaced in between
+    Helium::TakeMutex mutex (g_TraceStringsMutex); 
+
+    u32 id = InternTraceStringLocked(string); 
+
+    entry.m_Key = string; 
+    entry.m_String = g_TraceStrings[ id ]; 
+    entry.m_ID = id; 
+
+    return id; 
+}
+
+void TraceRing::Publish(i32 write)
+{
+    // the exchange is a full barrier, so the event is written before the flush thread can see it
+    Helium::AtomicExchange(&m_Write, write); 
+
+    if ( (u32)(write - m_Read) == PROFILE_TRACE_RING_SIZE / 2 )
     {
-        Log::Profile( TXT( "[%12.3f] %s\n" ), millis, m_Description);
+        g_TraceFlush.Signal(); 
     }
+}
+
+void TraceRing::Drop()
+{
+    Helium::AtomicIncrement(&m_Dropped); 
+}
 
-#if defined(PROFILE_INSTRUMENTATION)
+u32 Profile::InternTraceString(const char* string)
+{
+    Helium::TakeMutex mutex (g_TraceStringsMutex); 
 
-    Context* context = (Context*)g_ProfileContext.GetPointer(); 
-    HELIUM_ASSERT(context); 
+    return InternTraceStringLocked(string); 
+}
 
-    ScopeExitPacket* packet = context->AllocPacket<ScopeExitPacket>(PROFILE_CMD_SCOPE_EXIT); 
+static void WriteTraceStrings()
+{
+    std::vector< const char* > strings; 
+    u32 first = 0; 
 
-    packet->m_UniqueID   = context->m_UniqueID++; 
-    packet->m_StackDepth = --context->m_StackDepth;
-    packet->m_Duration   = taken; 
+    {
+        Helium::TakeMutex mutex (g_TraceStringsMutex); 
 
-    if(m_Accum && m_Accum->m_Index != -1)
+        first = g_TraceStringsWritten; 
+        strings.assign( g_TraceStrings.begin() + first, g_TraceStrings.end() ); 
+        g_TraceStringsWritten = (u32)g_TraceStrings.size(); 
+    }
+
+    if (strings.empty())
     {
-        int stack = --context->m_AccumStack[ m_Accum->m_Index ]; 
+        return; 
+    }
 
-        if(stack == 0)
+    TraceChunkHeader chunk; 
+    chunk.m_Type    = PROFILE_TRACE_CHUNK_STRINGS; 
+    chunk.m_Thread  = 0; 
+    chunk.m_Count   = (u32)strings.size(); 
+    chunk.m_Dropped = 0; 
+    g_TraceFile.Write(&chunk, sizeof(chunk)); 
+
+    for (u32 i = 0; i < strings.size(); ++i)
+    {
+        TraceString string; 
+        string.m_ID     = first + i; 
+        string.m_Length = (u32)strlen(strings[i]); 
+        g_TraceFile.Write(&string, sizeof(string)); 
+        g_TraceFile.Write(strings[i], string.m_Length); 
+    }
+}
+
+static void WriteTraceEvents(TraceRing* ring)
+{
+    i32 read = ring->m_Read; 
+    i32 write = ring->m_Write; 
+    i32 dropped = Helium::AtomicExchange(&ring->m_Dropped, 0); 
+
+    if (read == write && dropped == 0)
+    {
+        return; 
+    }
+
+    TraceChunkHeader chunk; 
+    chunk.m_Type    = PROFILE_TRACE_CHUNK_EVENTS; 
+    chunk.m_Thread  = ring->m_Thread; 
+    chunk.m_Count   = (u32)(write - read); 
+    chunk.m_Dropped = (u32)dropped; 
+    g_TraceFile.Write(&chunk, sizeof(chunk)); 
+
+    // the events might wrap around the end of the ring
+    u32 start = read & (PROFILE_TRACE_RING_SIZE - 1); 
+    u32 first = MIN( chunk.m_Count, PROFILE_TRACE_RING_SIZE - start ); 
+    g_TraceFile.Write(&ring->m_Events[ start ], first * sizeof(TraceEvent)); 
+    g_TraceFile.Write(&ring->m_Events[ 0 ], (chunk.m_Count - first) * sizeof(TraceEvent)); 
+
+    // hand the space back to the thread
+    Helium::AtomicExchange(&ring->m_Read, write); 
+}
+
+static void FlushTrace()
+{
+    // strings go first so the events never refer to an id the file hasn't seen
+    WriteTraceStrings(); 
+
+    // held throughout, exiting threads take their rings out of the list under it
+    Helium::TakeMutex mutex (g_TraceRingsMutex); 
+
+    TraceRing** link = &g_TraceRings; 
+    while (*link)
+    {
+        TraceRing* ring = *link; 
+
+        WriteTraceEvents(ring); 
+
+        if (ring->m_Retired)
         {
-            m_Accum->m_TotalMillis += millis; 
+            *link = ring->m_Next; 
+            delete ring; 
         }
+        else
+        {
+            link = &ring->m_Next; 
+        }
+    }
+}
 
-        m_Accum->m_Hits++; 
+static void CloseTrace()
+{
+    {
+        // threads that exit from here on free their rings themselves, and nobody will write out the ones already waiting
+        Helium::TakeMutex mutex (g_TraceRingsMutex); 
+        g_TraceOpen = false; 
+
+        TraceRing** link = &g_TraceRings; 
+        while (*link)
+        {
+            TraceRing* ring = *link; 
+
+            if (ring->m_Retired)
+            {
+                *link = ring->m_Next; 
+                delete ring; 
+            }
+            else
+            {
+                link = &ring->m_Next; 
+            }
+        }
     }
 
-#elif defined(PROFILE_ACCUMULATION)
+    g_TraceFile.Close(); 
+}
 
-    if(m_Accum && m_Accum->m_Index != -1)
+static Thread::Return TraceThread(Thread::Param)
+{
+    while (g_Tracing)
     {
-        m_Accum->m_TotalMillis += millis; 
-        m_Accum->m_Hits++; 
+        g_TraceFlush.Wait(PROFILE_TRACE_FLUSH_MILLIS); 
+        g_TraceFlush.Reset(); 
+
+        FlushTrace(); 
     }
 
-#endif
+    return Thread::Exit(); 
+}
+
+bool Profile::IsTracing()
+{
+    return g_Tracing != 0; 
+}
+
+bool Profile::StartTrace(const tchar* file)
+{
+    if (g_Tracing)
+    {
+        return true; 
+    }
+
+    if (file == NULL)
+    {
+        file = Helium::TraceFile::GetFilePath(); 
+    }
+
+    if (file == NULL || !g_TraceFile.Open(file))
+    {
+        return false; 
+    }
+
+    TraceFileHeader header; 
+    header.m_Signature  = PROFILE_TRACE_SIGNATURE; 
+    header.m_Version    = PROFILE_TRACE_VERSION; 
+    header.m_Conversion = Helium::CyclesToMillis(PROFILE_CYCLES_FOR_CONVERSION); 
+    header.m_MainThread = Helium::GetMainThreadID(); 
+    g_TraceFile.Write(&header, sizeof(header)); 
+
+    {
+        Helium::TakeMutex mutex (g_TraceStringsMutex); 
+
+        // strings only the previous trace used don't carry over, a whole trace later nobody is still looking at them
+        for (u32 i = 0; i < g_TraceStringsRetired.size(); ++i)
+        {
+            delete [] g_TraceStringsRetired[i]; 
+        }
+
+        g_TraceStringsRetired.swap( g_TraceStrings ); 
+        g_TraceStrings.clear(); 
+        g_TraceStringLookup.clear(); 
+        g_TraceStringsWritten = 0; 
+
+        Helium::AtomicIncrement(&g_TraceStringsTable); 
+    }
+
+    // anything left over from a previous trace belongs to that trace
+    {
+        Helium::TakeMutex mutex (g_TraceRingsMutex); 
+        for (TraceRing* ring = g_TraceRings; ring; ring = ring->m_Next)
+        {
+            Helium::AtomicExchange(&ring->m_Read, ring->m_Write); 
+            Helium::AtomicExchange(&ring->m_Dropped, 0); 
+        }
+
+        g_TraceOpen = true; 
+    }
+
+    Helium::AtomicExchange(&g_Tracing, 1); 
+
+    if (!g_TraceThread.Create(&TraceThread, NULL, "Profile Trace Thread"))
+    {
+        Helium::AtomicExchange(&g_Tracing, 0); 
+        CloseTrace(); 
+        return false; 
+    }
+
+    return true; 
 }
 
+void Profile::StopTrace()
+{
+    if (!g_Tracing)
+    {
+        return; 
+    }
+
+    Helium::AtomicExchange(&g_Tracing, 0); 
+    g_TraceFlush.Signal(); 
+
+    g_TraceThread.Wait(); 
+    g_TraceThread.Close(); 
+
+    // pick up whatever came in after the thread's last pass
+    FlushTrace(); 
 
-Context::Context()
-: m_UniqueID(0)
-, m_StackDepth(0)
-, m_PacketBufferOffset(0)
+    CloseTrace(); 
+}
+
+const char* TraceData::GetString(u32 id) const
 {
-    m_TraceFile.Open( Helium::TraceFile::GetFilePath() ); 
-    memset(m_AccumStack, 0, sizeof(m_AccumStack)); 
+    return id < m_Strings.size() ? m_Strings[ id ].c_str() : "<unknown>"; 
 }
 
-Context::~Context()
+bool Profile::ReadTrace(const tchar* filename, TraceData& data, tstring& error)
 {
-    m_TraceFile.Close(); 
+    FILE* file = _tfopen(filename, TXT( "rb" ) ); 
+    if (!file)
+    {
+        error = tstring( TXT( "Unable to open " ) ) + filename + TXT( " for reading" ); 
+        return false; 
+    }
+
+    TraceFileHeader header; 
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.m_Signature != PROFILE_TRACE_SIGNATURE)
+    {
+        error = tstring( filename ) + TXT( " is not a profile trace" ); 
+        fclose(file); 
+        return false; 
+    }
+
+    if (header.m_Version != PROFILE_TRACE_VERSION)
+    {
+        error = tstring( filename ) + TXT( " is from a different version of the trace recorder" ); 
+        fclose(file); 
+        return false; 
+    }
+
+    data.m_Conversion = header.m_Conversion; 
+    data.m_MainThread = header.m_MainThread; 
+    data.m_Dropped = 0; 
+    data.m_Strings.clear(); 
+    data.m_Events.clear(); 
+
+    bool result = true; 
+
+    TraceChunkHeader chunk; 
+    while (result && fread(&chunk, sizeof(chunk), 1, file) == 1)
+    {
+        switch (chunk.m_Type)
+        {
+        case PROFILE_TRACE_CHUNK_STRINGS:
+            {
+                for (u32 i = 0; result && i < chunk.m_Count; ++i)
+                {
+                    TraceString string; 
+                    if (fread(&string, sizeof(string), 1, file) != 1)
+                    {
+                        result = false; 
+                        break; 
+                    }
+
+                    if (data.m_Strings.size() <= string.m_ID)
+                    {
+                        data.m_Strings.resize( string.m_ID + 1 ); 
+                    }
+
+                    std::string& str = data.m_Strings[ string.m_ID ]; 
+                    str.resize( string.m_Length ); 
+                    if (string.m_Length && fread(&str[0], string.m_Length, 1, file) != 1)
+                    {
+                        result = false; 
+                    }
+                }
+                break; 
+            }
+
+        case PROFILE_TRACE_CHUNK_EVENTS:
+            {
+                std::vector< TraceEvent >& events = data.m_Events[ chunk.m_Thread ]; 
+                size_t offset = events.size(); 
+                events.resize( offset + chunk.m_Count ); 
+
+                if (chunk.m_Count && fread(&events[ offset ], sizeof(TraceEvent), chunk.m_Count, file) != chunk.m_Count)
+                {
+                    result = false; 
+                }
+
+                data.m_Dropped += chunk.m_Dropped; 
+                break; 
+            }
+
+        default:
+            {
+                result = false; 
+                break; 
+            }
+        }
+    }
+
+    fclose(file); 
+
+    if (!result)
+    {
+        error = tstring( filename ) + TXT( " is truncated or corrupt" ); 
+    }
+
+    return result; 
 }
 
-void Context::FlushFile()
+// a scope we've seen enter but not exit while converting a thread's events
+struct OpenScope
 {
-    u64 startTicks = Helium::TimerGetClock(); 
+    u32 m_ID; 
+    u32 m_Depth; 
+    u64 m_Ticks; 
+};
 
-    // make a scope enter packet for flushing the file
-    ScopeEnterPacket* enter = (ScopeEnterPacket*) (m_PacketBuffer + m_PacketBufferOffset); 
-    m_PacketBufferOffset += sizeof(ScopeEnterPacket); 
+static void WriteJSONString(FILE* file, const char* string)
+{
+    fputc('"', file); 
+
+    for (const char* c = string; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file); 
+            fputc(*c, file); 
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            fprintf(file, "\\u%04x", (unsigned char)*c); 
+        }
+        else
+        {
+            fputc(*c, file); 
+        }
+    }
+
+    fputc('"', file); 
+}
+
+bool Profile::WriteChromeTrace(const TraceData& data, const tchar* filename, tstring& error)
+{
+    FILE* file = _tfopen(filename, TXT( "w" ) ); 
+    if (!file)
+    {
+        error = tstring( TXT( "Unable to open " ) ) + filename + TXT( " for writing" ); 
+        return false; 
+    }
+
+    // chrome wants microseconds, measured from the start of the trace
+    f64 microsPerTick = (f64)data.m_Conversion * 1000.0 / (f64)PROFILE_CYCLES_FOR_CONVERSION; 
+
+    u64 base = 0; 
+    bool first = true; 
+    for (TraceData::M_ThreadEvents::const_iterator itr = data.m_Events.begin(), end = data.m_Events.end(); itr != end; ++itr)
+    {
+        if (!itr->second.empty() && (first || itr->second.front().m_Ticks < base))
+        {
+            base = itr->second.front().m_Ticks; 
+            first = false; 
+        }
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"); 
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Main Thread\"}}", data.m_MainThread); 
 
-    enter->m_Header.m_Command = PROFILE_CMD_SCOPE_ENTER; 
-    enter->m_Header.m_Size    = sizeof(ScopeEnterPacket); 
-    enter->m_UniqueID         = 0; 
-    enter->m_StackDepth       = 0; 
-    enter->m_Line             = __LINE__;
-    enter->m_StartTicks       = startTicks; 
-    strcpy( enter->m_Function, "Context::FlushFile" ); 
-    enter->m_Description[0]   = 0; 
+    for (TraceData::M_ThreadEvents::const_iterator itr = data.m_Events.begin(), end = data.m_Events.end(); itr != end; ++itr)
+    {
+        u32 thread = itr->first; 
+        const std::vector< TraceEvent >& events = itr->second; 
 
-    // make a block end packet for end of packet
-    BlockEndPacket* blockEnd = (BlockEndPacket*) (m_PacketBuffer + m_PacketBufferOffset); 
-    m_PacketBufferOffset += sizeof(BlockEndPacket); 
+        std::vector< OpenScope > stack; 
 
-    blockEnd->m_Header.m_Command = PROFILE_CMD_BLOCK_END; 
-    blockEnd->m_Header.m_Size    = sizeof(BlockEndPacket); 
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            const TraceEvent& event = events[ i ]; 
 
-    // we write the whole buffer, in large blocks
-    m_TraceFile.Write( (const tchar*) m_PacketBuffer, PROFILE_PACKET_BLOCK_SIZE); 
+            if (event.m_Type == TraceEventTypes::Enter)
+            {
+                OpenScope scope = { event.m_ID, event.m_Depth, event.m_Ticks }; 
+                stack.push_back( scope ); 
+                continue; 
+            }
 
-    // reset the packet buffer
-    m_PacketBufferOffset = 0; 
+            // scopes deeper than this exit lost their own exit to a full ring
+            while (!stack.empty() && stack.back().m_Depth > event.m_Depth)
+            {
+                stack.pop_back(); 
+            }
+
+            // and this exit might have lost its enter
+            if (stack.empty() || stack.back().m_Depth != event.m_Depth || stack.back().m_ID != event.m_ID)
+            {
+                continue; 
+            }
 
-    // make a scope exit packet for being done flushing the file
-    ScopeExitPacket* exit = (ScopeExitPacket*) (m_PacketBuffer + m_PacketBufferOffset); 
-    m_PacketBufferOffset += sizeof(ScopeExitPacket); 
+            const OpenScope& scope = stack.back(); 
 
-    exit->m_Header.m_Command = PROFILE_CMD_SCOPE_EXIT; 
-    exit->m_Header.m_Size    = sizeof(ScopeExitPacket); 
+            fprintf(file, ",\n{\"name\":"); 
+            WriteJSONString(file, data.GetString(scope.m_ID)); 
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", 
+                thread, (f64)(scope.m_Ticks - base) * microsPerTick, (f64)(event.m_Ticks - scope.m_Ticks) * microsPerTick); 
 
-    exit->m_UniqueID   = 0; 
-    exit->m_StackDepth = 0; 
-    exit->m_Duration   = Helium::TimerGetClock() - startTicks; 
+            stack.pop_back(); 
+        }
+
+        // scopes still open when the trace stopped, these are usually the interesting ones
+        for (size_t i = 0; i < stack.size(); ++i)
+        {
+            fprintf(file, ",\n{\"name\":"); 
+            WriteJSONString(file, data.GetString(stack[ i ].m_ID)); 
+            fprintf(file, ",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", thread, (f64)(stack[ i ].m_Ticks - base) * microsPerTick); 
+        }
+    }
+
+    fprintf(file, "\n]}\n"); 
+
+    bool result = ferror(file) == 0; 
+    fclose(file); 
+
+    if (!result)
+    {
+        error = tstring( TXT( "Failed writing " ) ) + filename; 
+    }
 
-    // return to filling out the packet buffer
+    return result; 
 }
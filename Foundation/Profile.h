@@ -1,5 +1,9 @@
 #pragma once 
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "Timer.h"
 #include "Memory.h"
 #include "Platform/Types.h"
@@ -7,22 +11,20 @@
 #include "Foundation/API.h"
 
 #define PROFILE_ACCUMULATOR_MAX   (2048)
-#define PROFILE_CONTEXTS_MAX      (128)
 
 #define PROFILE_STRINGIFY(x) #x
 #define PROFILE_TOSTRING(x) PROFILE_STRINGIFY(x)
 
-#define PROFILE_PROTOCOL_VERSION        (0x00)
-#define PROFILE_SIGNATURE               (0x12345678)
+#define PROFILE_TRACE_VERSION           (0x01)
+#define PROFILE_TRACE_SIGNATURE         (0x48545243)
 
-#define PROFILE_CMD_INIT                (0x00)
-#define PROFILE_CMD_SCOPE_ENTER         (0x01)
-#define PROFILE_CMD_SCOPE_EXIT          (0x02)
-#define PROFILE_CMD_BLOCK_END           (0x03)
+#define PROFILE_TRACE_CHUNK_STRINGS     (0x00)
+#define PROFILE_TRACE_CHUNK_EVENTS      (0x01)
 
-#define PROFILE_PACKET_STRING_BUFSIZE   (64)
 #define PROFILE_CYCLES_FOR_CONVERSION   (100000)
-#define PROFILE_PACKET_BLOCK_SIZE       (16 * 1024)
+#define PROFILE_TRACE_RING_SIZE         (64 * 1024)     // events per thread (16 bytes each), must be a power of two
+#define PROFILE_TRACE_RING_CACHE        (256)           // interned strings each thread remembers, must be a power of two
+#define PROFILE_TRACE_FLUSH_MILLIS      (100)
 
 //
 // Profile code API, for the most part almost all of this code always gets compiled in
@@ -45,15 +47,29 @@ namespace Helium
         FOUNDATION_API void Cleanup(); 
 
         //
-        // Accumulates information over multiple calls
+        // Accumulated timings for an accumulator, merged from every thread that hit it
+        //
+
+        struct AccumulatorStats
+        {
+            u64   m_Hits; 
+            f32   m_TotalMillis; 
+            f32   m_AverageMillis; 
+            f32   m_MinMillis; 
+            f32   m_MaxMillis; 
+            f32   m_P50Millis; 
+            f32   m_P99Millis; 
+            f32   m_P999Millis; 
+        };
+
+        //
+        // Accumulates information over multiple calls, each thread adds to its own shard
+        //  so scopes never contend, and the shards are merged when they are reported
         //
 
         class FOUNDATION_API Accumulator
         {
         public:
-            u32   m_Hits; 
-            float m_TotalMillis; 
-
             i32   m_Index;
             char  m_Name[MAX_DESCRIPTION];
 
@@ -63,27 +79,40 @@ namespace Helium
             ~Accumulator();
 
             void Init(const char* name);
+
+            // record one timing from the calling thread
+            void Add(u64 cycles);
+
+            // merge every thread's timings
+            void Collect(AccumulatorStats& stats);
+            void Reset();
+
             void Report();
+            void Report(const AccumulatorStats& stats);
 
             static void ReportAll();
 
         private: 
         };
 
+        class TraceRing; 
+
         //
-        // Scope timer prints or logs information
+        // Scope timer prints or logs information, and records the scope to the trace if one is running
         //
 
         class FOUNDATION_API ScopeTimer
         {
         public: 
+            // desc is not copied, it must outlive the timer
             ScopeTimer(Accumulator* accum, const char* func, u32 line, const char* desc = NULL); 
             ~ScopeTimer(); 
 
-            char         m_Description[MAX_DESCRIPTION]; 
+            const char*  m_Description; 
             u64          m_StartTicks; 
             Accumulator* m_Accum; 
-            u32          m_UniqueID; 
+            TraceRing*   m_Trace; 
+            u32          m_TraceID; 
             bool         m_Print; 
 
         private: 
@@ -91,88 +120,143 @@ namespace Helium
 
         };
 
-        struct Header
-        {
-            u16 m_Command; 
-            u16 m_Size; 
-        }; 
+        //
+        // Trace recording, every thread writes compact scope events into its own ring and a
+        //  background thread drains the rings into a binary trace file, strings are interned
+        //  once and written to the file the first time they are seen
+        //
 
-        struct InitPacket 
+        namespace TraceEventTypes
         {
-            Header m_Header; 
-            u32    m_Version; 
-            u32    m_Signature; 
-            f32    m_Conversion; // PROFILE_CYCLES_FOR_CONVERSION cycles -> how many millis?
-        }; 
+            enum TraceEventType
+            {
+                Enter,
+                Exit,
+            };
+        }
+        typedef TraceEventTypes::TraceEventType TraceEventType;
 
-        struct ScopeEnterPacket
+        struct TraceEvent
         {
-            Header m_Header; 
-            u32    m_UniqueID; 
-            u32    m_StackDepth; 
-            u32    m_Line; 
-            u64    m_StartTicks; 
-            char   m_Description[PROFILE_PACKET_STRING_BUFSIZE]; 
-            char   m_Function[PROFILE_PACKET_STRING_BUFSIZE]; 
-        }; 
-
-        struct ScopeExitPacket 
+            u64 m_Ticks; 
+            u32 m_ID;       // interned name
+            u16 m_Depth;    // scope depth on the thread, the same for an enter and its exit
+            u16 m_Type; 
+        };
+
+        struct TraceFileHeader
         {
-            Header m_Header;
-            u32    m_UniqueID;   
-            u32    m_StackDepth; 
-            u64    m_Duration; 
-        }; 
+            u32 m_Signature; 
+            u32 m_Version; 
+            f32 m_Conversion;   // PROFILE_CYCLES_FOR_CONVERSION cycles -> how many millis?
+            u32 m_MainThread; 
+        };
 
-        struct BlockEndPacket
+        struct TraceChunkHeader
         {
-            Header m_Header; 
+            u32 m_Type; 
+            u32 m_Thread;   // thread the events came from
+            u32 m_Count;    // strings or events that follow
+            u32 m_Dropped;  // events the thread dropped since its last chunk because the ring was full
         };
 
-        union UberPacket
+        // each string in a strings chunk is its id and length followed by its characters
+        struct TraceString
         {
-            Header           m_Header; 
-            InitPacket       m_Init; 
-            ScopeEnterPacket m_ScopeEnter; 
-            ScopeExitPacket  m_ScopeExitPacket; 
+            u32 m_ID; 
+            u32 m_Length; 
         };
 
-        class FOUNDATION_API Context
+        class FOUNDATION_API TraceRing
         {
+        private:
+            struct CacheEntry
+            {
+                const char* m_Key; 
+                const char* m_String; 
+                u32         m_ID; 
+            };
+
         public:
-            Helium::TraceFile m_TraceFile; 
-            u32               m_UniqueID; 
-            u32               m_StackDepth; 
-            u32               m_PacketBufferOffset; 
-            u8                m_PacketBuffer[PROFILE_PACKET_BLOCK_SIZE]; 
-            u32               m_AccumStack[PROFILE_ACCUMULATOR_MAX]; 
+            TraceEvent      m_Events[PROFILE_TRACE_RING_SIZE]; 
+            volatile i32    m_Write;    // only the owning thread moves this
+            volatile i32    m_Read;     // only the flush thread moves this
+            volatile i32    m_Dropped; 
+            u32             m_Thread; 
+            u32             m_Depth; 
+            TraceRing*      m_Next; 
+            bool            m_Retired;  // the thread is gone, free the ring once its events are written
+            i32             m_Strings;  // the string table the cache refers to
+            CacheEntry      m_Cache[PROFILE_TRACE_RING_CACHE]; 
+
+            TraceRing(); 
+
+            // the calling thread's ring, created the first time through
+            static TraceRing* Get(); 
 
-            Context(); 
-            ~Context(); 
+            // called as the owning thread exits
+            static void Release(void* ring); 
 
-            void FlushFile(); 
+            // the id for a string, without locking if this thread has seen the string before
+            u32 Intern(const char* string); 
 
-            template <class T>
-            T* AllocPacket(u32 cmd)
+            void Record(u32 id, TraceEventType type, u64 ticks)
             {
-                u32 spaceNeeded = sizeof(T) + sizeof(BlockEndPacket) + sizeof(ScopeEnterPacket); 
+                u32 depth = type == TraceEventTypes::Enter ? m_Depth++ : --m_Depth; 
 
-                if (m_PacketBufferOffset + spaceNeeded >= PROFILE_PACKET_BLOCK_SIZE)
+                i32 write = m_Write; 
+                if ( (u32)(write - m_Read) >= PROFILE_TRACE_RING_SIZE )
                 {
-                    FlushFile(); 
+                    // never stall the thread being traced, the reader copes with the missing events
+                    Drop(); 
+                    return;
                 }
 
-                T* packet = (T*) (m_PacketBuffer + m_PacketBufferOffset); 
-                m_PacketBufferOffset += sizeof(T); 
+                TraceEvent& event = m_Events[ write & (PROFILE_TRACE_RING_SIZE - 1) ]; 
+                event.m_Ticks = ticks; 
+                event.m_ID    = id; 
+                event.m_Depth = (u16)depth; 
+                event.m_Type  = (u16)type; 
 
-                //Log::Print("CMD %d OFFSET %d\n", cmd, m_PacketBufferOffset); 
+                Publish( write + 1 ); 
+            }
+
+        private:
+            // make the event visible to the flush thread, and wake it if we're filling up
+            void Publish(i32 write); 
+            void Drop(); 
+        };
 
-                packet->m_Header.m_Command = cmd; 
-                packet->m_Header.m_Size    = sizeof(T); 
+        // is a trace being recorded
+        FOUNDATION_API bool IsTracing(); 
 
-                return packet; 
-            }
-        }; 
+        // start recording to the given file (or the default trace file path if NULL)
+        FOUNDATION_API bool StartTrace(const tchar* file = NULL); 
+
+        // flush everything recorded so far and close the file
+        FOUNDATION_API void StopTrace(); 
+
+        // get the id for a string, the same string always gets the same id
+        FOUNDATION_API u32 InternTraceString(const char* string); 
+
+        struct FOUNDATION_API TraceData
+        {
+            typedef std::map< u32, std::vector< TraceEvent > > M_ThreadEvents; 
+
+            f32                         m_Conversion; 
+            u32                         m_MainThread; 
+            u32                         m_Dropped; 
+            std::vector< std::string >  m_Strings;  // indexed by id
+            M_ThreadEvents              m_Events;   // per thread, in the order they were recorded
+
+            const char* GetString(u32 id) const; 
+        };
+
+        // load a trace file written by the recorder
+        FOUNDATION_API bool ReadTrace(const tchar* file, TraceData& data, tstring& error); 
+
+        // write the trace in chrome's trace event format, for viewing in chrome://tracing
+        FOUNDATION_API bool WriteChromeTrace(const TraceData& data, const tchar* file, tstring& error); 
     }
 }
 
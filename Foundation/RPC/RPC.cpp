@@ -4,6 +4,7 @@
 
 #include "Platform/Assert.h"
 #include "Foundation/IPC/Connection.h"
+#include "Foundation/Checksum/CRC32.h"
 
 #include "RPC.h"
 
@@ -16,33 +17,57 @@ using namespace Helium::RPC;
 //#define RPC_DEBUG
 //#define RPC_DEBUG_MSG
 
+u32 RPC::GetInterfaceID(const char* interfaceName)
+{
+    return Crc32(interfaceName, (u32)strlen(interfaceName));
+}
+
+u32 RPC::GetInvokerID(const char* interfaceName, const char* invokerName)
+{
+    // "Interface.Invoker", so the same invoker name in two interfaces gets two ids
+    u32 crc = Crc32(0xffffffff, interfaceName, (u32)strlen(interfaceName));
+    crc = Crc32(crc, ".", 1);
+    return Crc32(crc, invokerName, (u32)strlen(invokerName));
+}
+
 Interface::Interface(const char* name)
 : m_Name (name)
+, m_ID (GetInterfaceID(name))
 , m_Host (NULL)
-, m_InvokerCount (0)
 {
 
 }
 
 void Interface::AddInvoker(InvokerPtr invoker)
 {
-    if (m_InvokerCount >= MAX_INVOKERS)
+    std::pair< H_Invoker::iterator, bool > result = m_InvokerLookup.insert( H_Invoker::value_type( invoker->GetID(), invoker.Ptr() ) );
+    if (!result.second)
     {
+        // two names hashed to the same id, rename one of them
+        printf("RPC::Invoker '%s' in interface '%s' collides with '%s'\n", invoker->GetName(), m_Name, result.first->second->GetName());
         HELIUM_BREAK();
         return;
     }
 
-    m_Invokers[m_InvokerCount++] = invoker;
+    m_Invokers.push_back(invoker);
+
+    if (m_Host)
+    {
+        m_Host->AddInvoker(invoker);
+    }
 }
 
 Invoker* Interface::GetInvoker(const char* name)
 {
-    for ( u32 i=0; i<m_InvokerCount; i++ )
+    return GetInvoker( GetInvokerID(m_Name, name) );
+}
+
+Invoker* Interface::GetInvoker(u32 id)
+{
+    H_Invoker::const_iterator found = m_InvokerLookup.find(id);
+    if (found != m_InvokerLookup.end())
     {
-        if ( !strcmp( m_Invokers[i]->GetName(), name ) )
-        {
-            return m_Invokers[i];
-        }
+        return found->second;
     }
 
     return NULL;
@@ -103,30 +128,58 @@ void Host::Reset()
     m_ConnectionCount = 0;
     m_Timeout = TIMEOUT_DEFAULT;
 
-    memset(m_Interfaces, 0, sizeof(Interface*) * MAX_INTERFACES);
+    m_Interfaces.clear();
+    m_Calls.clear();
+    m_Invokers.clear();
+    m_Waiting = NULL;
 }
 
 void Host::AddInterface(Interface* interface)
 {
-    if (m_InterfaceCount >= MAX_INTERFACES)
+    std::pair< H_Interface::iterator, bool > result = m_Interfaces.insert( H_Interface::value_type( interface->GetID(), interface ) );
+    if (!result.second)
     {
+        printf("RPC::Interface '%s' collides with '%s'\n", interface->GetName(), result.first->second->GetName());
         HELIUM_BREAK();
         return;
     }
 
-    m_Interfaces[m_InterfaceCount++] = interface;
-
     interface->SetHost( this );
+
+    const std::vector< InvokerPtr >& invokers = interface->GetInvokers();
+    for ( std::vector< InvokerPtr >::const_iterator itr = invokers.begin(), end = invokers.end(); itr != end; ++itr )
+    {
+        AddInvoker( *itr );
+    }
 }
 
 Interface* Host::GetInterface(const char* name)
 {
-    for ( u32 i=0; i<m_InterfaceCount; i++ )
+    H_Interface::const_iterator found = m_Interfaces.find( GetInterfaceID(name) );
+    if (found != m_Interfaces.end())
     {
-        if ( !strcmp( m_Interfaces[i]->GetName(), name ) )
-        {
-            return m_Interfaces[i];
-        }
+        return found->second;
+    }
+
+    return NULL;
+}
+
+void Host::AddInvoker(Invoker* invoker)
+{
+    std::pair< H_Invoker::iterator, bool > result = m_Invokers.insert( H_Invoker::value_type( invoker->GetID(), invoker ) );
+    if (!result.second && result.first->second != invoker)
+    {
+        printf("RPC::Invoker '%s.%s' collides with '%s.%s'\n", invoker->GetInterface()->GetName(), invoker->GetName(), result.first->second->GetInterface()->GetName(), result.first->second->GetName());
+        HELIUM_BREAK();
+    }
+}
+
+Invoker* Host::GetInvoker(u32 id)
+{
+    H_Invoker::const_iterator found = m_Invokers.find(id);
+    if (found != m_Invokers.end())
+    {
+        return found->second;
     }
 
     return NULL;
@@ -145,65 +198,54 @@ void Host::SetTimeout(i32 timeout)
 
 IPC::Message* Host::Create(Invoker* invoker, u32 size, i32 transaction)
 {
-#pragma TODO("Pack the invoker and interface name into the message data")
-    invoker->GetName();
-    invoker->GetInterface()->GetName();
-
+    // the message id is the invoker id, the other side dispatches on it without looking at any names
     if (transaction != 0)
     {
-        return m_Connection->CreateMessage(0, size, transaction);
+        return m_Connection->CreateMessage(invoker->GetID(), size, transaction);
     }
     else
     {
-        return m_Connection->CreateMessage(0, size);
+        return m_Connection->CreateMessage(invoker->GetID(), size);
     }
 }
 
-void Host::Emit(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
+IPC::Message* Host::Pack(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
 {
-    if (Connected())
-    {
-        if (m_ConnectionCount != m_Connection->GetConnectCount())
-        {
-#ifdef RPC_DEBUG
-            printf("RPC::Connection cycled, resetting stack\n");
-#endif
-            m_ConnectionCount = m_Connection->GetConnectCount();
-            m_Stack.Reset();
-        }
-
-        u32 size = 0;
+    u32 total = 0;
 
-        if (args != NULL)
-        {
-            HELIUM_ASSERT(size > 0);
-            size += size;
-        }
+    if (args != NULL)
+    {
+        HELIUM_ASSERT(size > 0);
+        total += size;
 
         if (args->m_Payload != NULL)
         {
             HELIUM_ASSERT(args->m_PayloadSize > 0);
-            size += args->m_PayloadSize;
+            total += args->m_PayloadSize;
         }
+    }
 
-        IPC::Message* message = Create(invoker, size);
+    IPC::Message* message = Create(invoker, total);
+    if (message == NULL)
+    {
+        return NULL;
+    }
 
-        u8* ptr = message->GetData();
+    u8* ptr = message->GetData();
 
-        if (args != NULL)
+    if (args != NULL)
+    {
+        if (Swizzle())
         {
-            if (Swizzle())
-            {
-                swizzler(args);
-            }
+            swizzler(args);
+        }
 
-            memcpy(ptr, args, size);
-            ptr += size;
+        memcpy(ptr, args, size);
+        ptr += size;
 
-            if (Swizzle())
-            {
-                swizzler(args);
-            }
+        if (Swizzle())
+        {
+            swizzler(args);
         }
 
         if (args->m_Payload != NULL)
@@ -211,8 +253,46 @@ void Host::Emit(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
             memcpy(ptr, args->m_Payload, args->m_PayloadSize);
             ptr += args->m_PayloadSize;
         }
+    }
+
+    HELIUM_ASSERT((u32)(ptr - message->GetData()) == total);
+
+    return message;
+}
 
-        HELIUM_ASSERT((u32)(ptr - message->GetData()) == size);
+void Host::ResetCalls()
+{
+#ifdef RPC_DEBUG
+    printf("RPC::Connection cycled, resetting stack\n");
+#endif
+
+    m_ConnectionCount = m_Connection->GetConnectCount();
+    m_Stack.Reset();
+
+    // their replies went with the old connection
+    for ( H_Call::iterator itr = m_Calls.begin(), end = m_Calls.end(); itr != end; ++itr )
+    {
+        itr->second->m_Failed = true;
+        itr->second->m_Complete = true;
+    }
+
+    m_Calls.clear();
+}
+
+void Host::Emit(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
+{
+    if (Connected())
+    {
+        if (m_ConnectionCount != m_Connection->GetConnectCount())
+        {
+            ResetCalls();
+        }
+
+        IPC::Message* message = Pack(invoker, args, size, swizzler);
+        if (message == NULL)
+        {
+            return;
+        }
 
 #ifdef RPC_DEBUG_MSG
         u32 msg_id = message->GetID();
@@ -232,7 +312,7 @@ void Host::Emit(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
 
         message = NULL; // assume its GONE
 
-        if (args->m_Flags & RPC::Flags::NonBlocking)
+        if (args == NULL || args->m_Flags & RPC::Flags::NonBlocking)
         {
 #ifdef RPC_DEBUG
             printf("RPC::Emitting async transaction %d\n", msg_transaction);
@@ -275,31 +355,20 @@ void Host::Emit(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
                 printf("RPC::Emit success for transaction %d, stack size %d\n", msg_transaction, m_Stack.Size());
 #endif
 
-                size = 0;
-                ptr = frame->m_ReplyData;
-
-                if (args != NULL)
-                {
-                    HELIUM_ASSERT(size > 0);
-                    size += size;
-                }
-
-                if (args->m_Payload != NULL)
-                {
-                    HELIUM_ASSERT(args->m_PayloadSize > 0);
-                    size += args->m_PayloadSize;
-                }
+                u8* ptr = frame->m_ReplyData;
 
                 // do ref args processing here
-                if (args->m_Flags & RPC::Flags::ReplyWithArgs && args != NULL)
+                if (args->m_Flags & RPC::Flags::ReplyWithArgs)
                 {
                     if (Swizzle())
                     {
                         swizzler(ptr);
                     }
 
-                    // copy our data BACK
+                    // copy our data BACK, but keep our own payload pointer
+                    void* payload = args->m_Payload;
                     memcpy(args, ptr, size);
+                    args->m_Payload = payload;
 
                     ptr += size;
                 }
@@ -322,26 +391,111 @@ void Host::Emit(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
     }
 }
 
-bool Host::Invoke(IPC::Message* msg)
+CallPtr Host::EmitAsync(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler)
 {
-#pragma TODO("Unpack the invoker and interface name from the message data")
-    const char* invokerName = NULL;
-    const char* interfaceName = NULL;
+    u32 flags = args ? args->m_Flags : 0;
+
+    // a non blocking call never gets a reply, so there would be nothing to wait for
+    HELIUM_ASSERT( !(flags & RPC::Flags::NonBlocking) );
 
-    // find the interface
-    Interface* interface = GetInterface(interfaceName);
-    if (interface == NULL)
+    if (!Connected())
     {
-        printf("RPC::Unable to find interface '%s'\n", interfaceName);
-        delete msg;
-        return true;
+        CallPtr call = new Call (0, flags, swizzler);
+        call->m_Failed = true;
+        call->m_Complete = true;
+        return call;
+    }
+
+    if (m_ConnectionCount != m_Connection->GetConnectCount())
+    {
+        ResetCalls();
+    }
+
+    IPC::Message* message = Pack(invoker, args, size, swizzler);
+
+    CallPtr call = new Call (message ? message->GetTransaction() : 0, flags, swizzler);
+
+    if (message == NULL || m_Connection->Send(message) != IPC::ConnectionStates::Active)
+    {
+        delete message;
+        call->m_Failed = true;
+        call->m_Complete = true;
+        return call;
+    }
+
+#ifdef RPC_DEBUG
+    printf("RPC::Emitting async call transaction %d, %d calls in flight\n", call->GetTransaction(), (u32)m_Calls.size() + 1);
+#endif
+
+    m_Calls[ call->GetTransaction() ] = call;
+
+    return call;
+}
+
+bool Host::Wait(Call* call)
+{
+    // invocations dispatched while we wait can wait on calls of their own
+    Call* waiting = m_Waiting;
+    m_Waiting = call;
+
+    while (!call->IsComplete())
+    {
+        if (!Process(true) && !call->IsComplete())
+        {
+            // the connection is gone, and the reply with it
+            m_Calls.erase( call->GetTransaction() );
+            call->m_Failed = true;
+            call->m_Complete = true;
+        }
+    }
+
+    m_Waiting = waiting;
+
+    return call->Succeeded();
+}
+
+u32 Host::GetPendingCallCount()
+{
+    return (u32)m_Calls.size();
+}
+
+bool Host::CompleteCall(IPC::Message* msg)
+{
+    H_Call::iterator found = m_Calls.find( msg->GetTransaction() );
+    if (found == m_Calls.end())
+    {
+        return false;
+    }
+
+    Call* call = found->second;
+
+#ifdef RPC_DEBUG
+    printf("RPC::Got reply to async call transaction %d, %d calls in flight\n", msg->GetTransaction(), (u32)m_Calls.size() - 1);
+#endif
+
+    call->m_ReplySize = msg->GetSize();
+    call->m_ReplyData = msg->TakeData();
+
+    // the args come back in the sender's byte order
+    if (call->m_ReplyData && call->m_Flags & RPC::Flags::ReplyWithArgs && call->m_Swizzler && Swizzle())
+    {
+        call->m_Swizzler(call->m_ReplyData);
     }
 
+    call->m_Complete = true;
+
+    m_Calls.erase(found);
+
+    return true;
+}
+
+bool Host::Invoke(IPC::Message* msg)
+{
     // find the invoker
-    Invoker* invoker = interface->GetInvoker(invokerName);
+    Invoker* invoker = GetInvoker(msg->GetID());
     if (invoker == NULL)
     {
-        printf("RPC::Unable to find invoker '%s' in interface '%s'\n", invokerName, interfaceName);
+        printf("RPC::Unable to find invoker 0x%08x\n", msg->GetID());
         delete msg;
         return true;
     }
@@ -499,11 +653,7 @@ bool Host::Process(bool wait)
     {
         if (m_ConnectionCount != m_Connection->GetConnectCount())
         {
-#ifdef RPC_DEBUG
-            printf("RPC::Connection cycled, resetting stack\n");
-#endif
-            m_ConnectionCount = m_Connection->GetConnectCount();
-            m_Stack.Reset();
+            ResetCalls();
         }
 
         if (m_Connection->GetState() != IPC::ConnectionStates::Active)
@@ -527,6 +677,21 @@ bool Host::Process(bool wait)
 #endif
 
             bool is_reply = m_Connection->CreatedMessage(msg->GetTransaction());
+
+            // replies to asynchronous calls can come back in any order, and in the middle of a blocking call
+            if (is_reply && CompleteCall(msg))
+            {
+                delete msg;
+
+                // hand control back once the call being waited on is done, otherwise keep draining
+                if (m_Waiting && m_Waiting->IsComplete())
+                {
+                    break;
+                }
+
+                continue;
+            }
+
             if (is_reply && m_Stack.Size() > 0)
             {
                 Frame* top = m_Stack.Top();
@@ -8,6 +8,9 @@
 #include "Foundation/Memory/Endian.h"
 #include "Foundation/Automation/Event.h"
 
+#include <vector>
+#include <hash_map>
+
 namespace Helium
 {
     namespace IPC
@@ -23,8 +26,6 @@ namespace Helium
         class Host;
 
         const u32 MAX_STACK = 64;
-        const u32 MAX_INVOKERS = 32;
-        const u32 MAX_INTERFACES = 32;
         const i32 TIMEOUT_DEFAULT = 1000;
         const i32 TIMEOUT_FOREVER = -1;
 
@@ -54,6 +55,14 @@ namespace Helium
         typedef Helium::Signature< RPC::Args&>::Delegate ArgsDelegate;
 
 
+        //
+        // Names are hashed to stable ids when they are registered, and only the ids go over the wire
+        //
+
+        FOUNDATION_API u32 GetInterfaceID(const char* interfaceName);
+        FOUNDATION_API u32 GetInvokerID(const char* interfaceName, const char* invokerName);
+
+
         //
         // Invoker:
         //  - packages an invocation for dispatch to a remote implementation
@@ -63,12 +72,7 @@ namespace Helium
         class Invoker : public Helium::RefCountBase< Invoker >
         {
         public:
-            Invoker (Interface* interface, SwizzleFunc swizzler)
-                : m_Interface (interface)
-                , m_Swizzler (swizzler)
-            {
-                HELIUM_ASSERT( interface && swizzler );
-            }
+            Invoker (Interface* interface, const char* name, SwizzleFunc swizzler);
 
             virtual ~Invoker()
             {
@@ -87,6 +91,11 @@ namespace Helium
                 return m_Name;
             }
 
+            u32 GetID()
+            {
+                return m_ID;
+            }
+
             Interface* GetInterface()
             {
                 return m_Interface;
@@ -99,6 +108,7 @@ namespace Helium
 
         protected:
             const char*   m_Name;
+            u32           m_ID;
             Interface*    m_Interface;
             SwizzleFunc   m_Swizzler;
         };
@@ -106,6 +116,74 @@ namespace Helium
         typedef Helium::SmartPtr< Invoker > InvokerPtr;
 
 
+        //
+        // Call tracks an asynchronous invocation until its reply comes back
+        //  Replies are matched by transaction, so any number of calls can be in flight at once and
+        //  they can complete in any order.  Nothing completes unless the host is dispatching.
+        //
+
+        class Call : public Helium::RefCountBase< Call >
+        {
+        public:
+            Call(i32 transaction, u32 flags, SwizzleFunc swizzler)
+                : m_Transaction (transaction)
+                , m_Flags (flags)
+                , m_Swizzler (swizzler)
+                , m_Complete (false)
+                , m_Failed (false)
+                , m_ReplyData (NULL)
+                , m_ReplySize (0)
+            {
+
+            }
+
+            ~Call()
+            {
+                delete[] m_ReplyData;
+            }
+
+            i32 GetTransaction() const
+            {
+                return m_Transaction;
+            }
+
+            // the reply arrived, or the connection went away first
+            bool IsComplete() const
+            {
+                return m_Complete;
+            }
+
+            bool Succeeded() const
+            {
+                return m_Complete && !m_Failed;
+            }
+
+            // the args (if ReplyWithArgs) followed by the payload (if ReplyWithPayload) the other side sent back
+            const u8* GetReplyData() const
+            {
+                return m_ReplyData;
+            }
+
+            u32 GetReplySize() const
+            {
+                return m_ReplySize;
+            }
+
+        private:
+            friend class Host;
+
+            i32           m_Transaction;
+            u32           m_Flags;
+            SwizzleFunc   m_Swizzler;
+            bool          m_Complete;
+            bool          m_Failed;
+            u8*           m_ReplyData;
+            u32           m_ReplySize;
+        };
+
+        typedef Helium::SmartPtr< Call > CallPtr;
+
+
         //
         // Interface is a named group of invokers
         //
@@ -129,16 +207,41 @@ namespace Helium
                 return m_Name;
             }
 
+            u32 GetID()
+            {
+                return m_ID;
+            }
+
+            const std::vector< InvokerPtr >& GetInvokers()
+            {
+                return m_Invokers;
+            }
+
             void AddInvoker(InvokerPtr invoker);
             Invoker* GetInvoker(const char* name);
+            Invoker* GetInvoker(u32 id);
 
         protected:
-            const char*   m_Name;
-            Host*         m_Host;
-            InvokerPtr    m_Invokers[MAX_INVOKERS];
-            u32           m_InvokerCount;
+            typedef stdext::hash_map< u32, Invoker* > H_Invoker;
+
+            const char*                 m_Name;
+            u32                         m_ID;
+            Host*                       m_Host;
+            std::vector< InvokerPtr >   m_Invokers;
+            H_Invoker                   m_InvokerLookup;
         };
 
+        inline Invoker::Invoker(Interface* interface, const char* name, SwizzleFunc swizzler)
+            : m_Name (name)
+            , m_ID (0)
+            , m_Interface (interface)
+            , m_Swizzler (swizzler)
+        {
+            HELIUM_ASSERT( interface && name && swizzler );
+
+            m_ID = GetInvokerID( interface->GetName(), name );
+        }
+
 
         //
         // Host is the endpoint for communication and local store of interfaces
@@ -160,6 +263,10 @@ namespace Helium
             void AddInterface(RPC::Interface* interface);
             Interface* GetInterface(const char* name);
 
+            // register an invoker of one of our interfaces for dispatch, AddInterface does this for you
+            void AddInvoker(RPC::Invoker* invoker);
+            Invoker* GetInvoker(u32 id);
+
             //
             // IPC connection settings
             //
@@ -180,6 +287,15 @@ namespace Helium
             // helper function to send a single data block
             void Emit(Invoker* invoker, Args* args = NULL, u32 size = 0, SwizzleFunc swizzler = NULL);
 
+            // send a single data block and return right away, the call completes when its reply is dispatched
+            CallPtr EmitAsync(Invoker* invoker, Args* args = NULL, u32 size = 0, SwizzleFunc swizzler = NULL);
+
+            // dispatch until the call completes, returns false if it failed
+            bool Wait(Call* call);
+
+            // number of asynchronous calls still waiting on a reply
+            u32 GetPendingCallCount();
+
             // process data from the other side
             bool Invoke(IPC::Message* msg);
 
@@ -199,6 +315,15 @@ namespace Helium
             // Call this to process all messages in the calling thread, pass true to sleep until the connection breaks
             bool Process(bool wait);
 
+            // allocate a message for the args and payload
+            IPC::Message* Pack(Invoker* invoker, Args* args, u32 size, SwizzleFunc swizzler);
+
+            // the connection cycled, drop the blocking stack and fail any calls in flight
+            void ResetCalls();
+
+            // match a reply against the asynchronous calls in flight, returns false if it isn't one of ours
+            bool CompleteCall(IPC::Message* msg);
+
         private:
             struct Frame
             {
@@ -227,12 +352,18 @@ namespace Helium
                 u32               m_Size;
             };
 
+            typedef stdext::hash_map< u32, Interface* > H_Interface;
+            typedef stdext::hash_map< u32, Invoker* > H_Invoker;
+            typedef stdext::hash_map< i32, CallPtr > H_Call;
+
             IPC::Connection*    m_Connection;
             u32                 m_ConnectionCount;
             i32                 m_Timeout;
             Stack               m_Stack;
-            Interface*          m_Interfaces[MAX_INTERFACES];
-            u32                 m_InterfaceCount;
+            H_Interface         m_Interfaces;
+            H_Invoker           m_Invokers;         // every invoker of every interface, by id, for dispatch
+            H_Call              m_Calls;            // asynchronous calls waiting on a reply, by transaction
+            Call*               m_Waiting;          // the call Wait() is dispatching for, if any
         };
 
         template<class ArgsType>
@@ -242,8 +373,8 @@ namespace Helium
             typedef Helium::Signature< ArgsType&> InvokerSignature;
             typedef typename InvokerSignature::Delegate InvokerDelegate;
 
-            InvokerTemplate(Interface* interface, InvokerDelegate delegate)
-                : Invoker (interface, GetSwizzleFunc<ArgsType>())
+            InvokerTemplate(Interface* interface, const char* name, InvokerDelegate delegate)
+                : Invoker (interface, name, GetSwizzleFunc<ArgsType>())
                 , m_Delegate (delegate)
             {
 
@@ -279,7 +410,14 @@ namespace Helium
             {
                 args->m_Payload = payload;
                 args->m_PayloadSize = size;
-                m_Interface->m_Host->Emit(this, args, sizeof(ArgsType), m_Swizzler);
+                m_Interface->GetHost()->Emit(this, args, sizeof(ArgsType), m_Swizzler);
+            }
+
+            CallPtr EmitAsync(ArgsType* args, void* payload = NULL, u32 size = 0)
+            {
+                args->m_Payload = payload;
+                args->m_PayloadSize = size;
+                return m_Interface->GetHost()->EmitAsync(this, args, sizeof(ArgsType), m_Swizzler);
             }
 
         private:
@@ -11,7 +11,7 @@ TestInterface::TestInterface()
 {
     Helium::Signature< TestArgs&>::Delegate delegate ( this, &TestInterface::Test );
 
-    AddInvoker( new InvokerTemplate<TestArgs> ( this, delegate ) );
+    AddInvoker( new InvokerTemplate<TestArgs> ( this, "Test", delegate ) );
 }
 
 void TestInterface::Test( TestArgs& args )
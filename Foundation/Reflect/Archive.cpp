@@ -164,7 +164,7 @@ bool Archive::GetFileType( const tstring& file, ArchiveType& type )
 
 void Archive::Warning(const tchar* fmt, ...)
 {
-    static tchar buff[512];
+    tchar buff[512];
 
     va_list args;
     va_start(args, fmt); 
@@ -184,7 +184,7 @@ void Archive::Warning(const tchar* fmt, ...)
 
 void Archive::Debug(const tchar* fmt, ...)
 {
-    static tchar buff[512];
+    tchar buff[512];
 
     va_list args;
     va_start(args, fmt); 
@@ -1,25 +1,39 @@
+#include <fstream>
+#include <sstream>
+
 #include "ArchiveBinary.h"
 #include "Element.h"
 #include "Registry.h"
 #include "Serializers.h"
 
 #include "Platform/Compiler.h"
+#include "Platform/Condition.h"
+#include "Platform/Mutex.h"
+#include "Platform/Path.h"
+#include "Platform/String.h"
+#include "Platform/Thread.h"
+#include "Foundation/ThreadPool.h"
 #include "Foundation/SmartBuffer/SmartBuffer.h"
 #include "Foundation/Container/Insert.h" 
 #include "Foundation/Checksum/CRC32.h"
 
 using Helium::Insert;
+using namespace Helium;
 using namespace Helium::Reflect; 
 
 //#define REFLECT_DEBUG_BINARY_CRC
 //#define REFLECT_DISABLE_BINARY_CRC
+//#define REFLECT_DISABLE_PARALLEL_READ
 
 // version / feature management 
-const u32 ArchiveBinary::CURRENT_VERSION                            = 6;
+const u32 ArchiveBinary::CURRENT_VERSION                            = 9;
 const u32 ArchiveBinary::FIRST_VERSION_WITH_ARRAY_COMPRESSION       = 3; 
 const u32 ArchiveBinary::FIRST_VERSION_WITH_STRINGPOOL_COMPRESSION  = 4; 
 const u32 ArchiveBinary::FIRST_VERSION_WITH_POINTER_SERIALIZER      = 5; 
 const u32 ArchiveBinary::FIRST_VERSION_WITH_UNICODE_SUPPORT         = 6; 
+const u32 ArchiveBinary::FIRST_VERSION_WITH_ELEMENT_TABLE           = 7; 
+const u32 ArchiveBinary::FIRST_VERSION_WITH_BLOCK_COMPRESSION       = 8; 
+const u32 ArchiveBinary::FIRST_VERSION_WITH_DELTA_LOG               = 9; 
 
 // our ORIGINAL version id was '!', don't ever re-use that byte
 HELIUM_COMPILE_ASSERT( (ArchiveBinary::CURRENT_VERSION & 0xff) != 33 );
@@ -34,6 +48,20 @@ const u32 CRC_BLOCK_SIZE = 4;
 const u32 CRC_BLOCK_SIZE = 4096;
 #endif
 
+// Parallel reads, below this many elements it isn't worth spinning up threads
+const i32 PARALLEL_READ_MIN_ELEMENTS = 256;
+const i32 PARALLEL_READ_BATCH_SIZE = 16;
+
+// Delta log, the header field holding its offset and the size of a record's fixed part
+const u32 DELTA_OFFSET_LOCATION = sizeof(u32) + sizeof(u8) + sizeof(u8) + sizeof(u32) + 3 * sizeof(u32);
+const u32 DELTA_RECORD_HEADER_SIZE = sizeof(u32) + sizeof(tuid);
+
+// Compact once the delta log is bigger than this fraction of the base archive
+const u32 DELTA_COMPACTION_DIVISOR = 2;
+
+// Lazy reads, the smallest threshold honored (plain data fields are always read in place)
+const u32 LAZY_THRESHOLD_MIN = 256;
+
 // this is sneaky, but in general people shouldn't use this
 namespace Helium
 {
@@ -47,11 +75,110 @@ namespace Helium
 // Binary Archive implements our own custom serialization technique
 //
 
+ElementIDFunc ArchiveBinary::s_ElementIDFunc = NULL;
+
+//
+// Lazy reads
+//  Big field payloads are left in the file, recorded against the element they belong to, and read
+//  back in by their own archive when a serializer connects to them (see Serializer::ConnectField)
+//
+
+namespace Helium
+{
+    namespace Reflect
+    {
+        class LazySource : public Helium::AtomicRefCountBase
+        {
+        public:
+            // the file, and its header when we read it so we notice if it gets rewritten
+            tstring         m_File;
+            u8              m_Header[ DELTA_OFFSET_LOCATION ];
+
+            // the latent data needed to make sense of the field payloads
+            u32             m_Version;
+            StringPool      m_Strings;
+            M_IDToClass     m_ClassesByID;
+            M_StrToClass    m_ClassesByShortName;
+        };
+
+        FOUNDATION_API volatile i32 g_LazyElementCount = 0;
+
+        void LoadLazyField(Element* element, const Field* field)
+        {
+            ArchiveBinary::LoadLazyFields( element, field );
+        }
+    }
+}
+
+namespace
+{
+    struct LazyField
+    {
+        LazySourcePtr   m_Source;
+        const Field*    m_Field;        // the current field, what serializers get connected to
+        const Field*    m_LatentField;  // the field as described by the file
+        u32             m_Offset;       // offset into the file of the field's serializer
+    };
+
+    typedef std::vector< LazyField > V_LazyField;
+    typedef std::map< const Element*, V_LazyField > M_ElementToLazyFields;
+
+    // the thresholds are per thread so a background indexer can read lazily while everyone else doesn't
+    ThreadLocalPointer      g_LazyThreshold;
+
+    // so is the intern table, one thread sharing strings across its archives shouldn't hand them to everyone else
+    ThreadLocalPointer      g_StringTable;
+
+    Mutex                   g_LazyMutex;
+    M_ElementToLazyFields   g_LazyFields;
+
+    // loads take turns, and the thread loading is remembered since the fields it reads connect back into LoadLazyFields
+    Mutex                   g_LazyLoadMutex;
+    volatile u32            g_LazyLoadThread = 0;
+
+    // drop fields that have been read, call with g_LazyMutex held
+    void ForgetLazyFields( const Element* element, const V_LazyField& fields )
+    {
+        M_ElementToLazyFields::iterator found = g_LazyFields.find( element );
+        if ( found == g_LazyFields.end() )
+        {
+            return;
+        }
+
+        V_LazyField& pending = found->second;
+        for ( V_LazyField::const_iterator field = fields.begin(); field != fields.end(); ++field )
+        {
+            for ( V_LazyField::iterator itr = pending.begin(); itr != pending.end(); ++itr )
+            {
+                if ( itr->m_Field == field->m_Field && itr->m_Offset == field->m_Offset )
+                {
+                    pending.erase( itr );
+                    break;
+                }
+            }
+        }
+
+        if ( pending.empty() )
+        {
+            g_LazyFields.erase( found );
+            --g_LazyElementCount;
+        }
+    }
+}
+
 ArchiveBinary::ArchiveBinary (StatusHandler* status)
 : Archive (status)
+, m_Strings ((StringTable*)g_StringTable.GetPointer())
 , m_Version (CURRENT_VERSION)
 , m_Size (0)
 , m_Skip (false)
+, m_ElementOffsets (NULL)
+, m_LazyThreshold ((u32)(uintptr)g_LazyThreshold.GetPointer())
+{
+
+}
+
+ArchiveBinary::~ArchiveBinary()
 {
 
 }
@@ -64,7 +191,17 @@ void ArchiveBinary::OpenFile( const tstring& file, bool write )
     Debug(TXT("Opening file '%s'\n"), file.c_str());
 #endif
 
-    Reflect::CharStreamPtr stream = new FileStream<char>(file, write); 
+    // reads are serviced straight out of a mapping of the file, writes need a real file stream
+    Reflect::CharStreamPtr stream;
+    if ( write )
+    {
+        stream = new FileStream<char>(file, write); 
+    }
+    else
+    {
+        stream = new MappedFileStream<char>(file); 
+    }
+
     OpenStream( stream, write );
 }
 
@@ -117,6 +254,10 @@ void ArchiveBinary::Read()
     m_Size = (long) m_Stream->TellRead();
     m_Stream->SeekRead(0, std::ios_base::beg);
 
+    // if the whole stream is in memory, worker threads can read it directly
+    u32 file_size = (u32)m_Size;
+    const char* file_data = m_Stream->PeekBuffer(m_Size);
+
     // fail on an empty input stream
     if ( m_Size == 0 )
     {
@@ -170,6 +311,21 @@ void ArchiveBinary::Read()
     u32 current_crc = crc;
     m_Stream->Read(&crc); 
 
+    // the delta log is appended after the fact, so the CRC stops where it begins
+    u32 delta_offset = (u32)m_Size;
+    if (m_Version >= FIRST_VERSION_WITH_DELTA_LOG)
+    {
+        u32 start = (u32)m_Stream->TellRead();
+        m_Stream->SeekRead(DELTA_OFFSET_LOCATION, std::ios_base::beg);
+        m_Stream->Read(&delta_offset);
+        m_Stream->SeekRead(start, std::ios_base::beg);
+
+        if (delta_offset < start || delta_offset > (u32)m_Size)
+        {
+            throw Reflect::DataFormatException( TXT( "Delta log offset is outside of the file" ) );
+        }
+    }
+
 #ifdef REFLECT_DISABLE_BINARY_CRC
     crc = CRC_DEFAULT;
 #endif
@@ -189,14 +345,23 @@ void ArchiveBinary::Read()
         // snapshot our starting location
         u32 start = (u32)m_Stream->TellRead();
 
+        // if the file is mapped, check the whole thing in place
+        const char* mapped = m_Stream->PeekBuffer(delta_offset - start);
+        if (mapped)
+        {
+            current_crc = Helium::Crc32(current_crc, mapped, delta_offset - start);
+        }
+
         // roll through file
-        while (!m_Stream->Done())
+        u32 remaining = delta_offset - start;
+        while (!mapped && remaining > 0 && !m_Stream->Done())
         {
             // read block
-            m_Stream->ReadBuffer(block, CRC_BLOCK_SIZE);
+            m_Stream->ReadBuffer(block, remaining < CRC_BLOCK_SIZE ? remaining : CRC_BLOCK_SIZE);
 
             // how much we got
             u32 got = (u32) m_Stream->ElementsRead();
+            remaining -= got;
 
             // crc block
             current_crc = Helium::Crc32(current_crc, block, got);
@@ -231,6 +396,15 @@ void ArchiveBinary::Read()
     m_Stream->Read(&type_offset); 
     u32 string_offset;
     m_Stream->Read(&string_offset);
+    u32 table_offset = 0;
+    if (m_Version >= FIRST_VERSION_WITH_ELEMENT_TABLE)
+    {
+        m_Stream->Read(&table_offset);
+    }
+    if (m_Version >= FIRST_VERSION_WITH_DELTA_LOG)
+    {
+        m_Stream->Read(&delta_offset);
+    }
     u32 element_offset = (u32)m_Stream->TellRead();
 
     // deserialize string pool
@@ -279,6 +453,20 @@ void ArchiveBinary::Read()
         }
     }
 
+    // lazy reads need to find their way back into the file later on, and visitors need to see every field
+    if ( m_LazyThreshold && !m_Path.empty() && m_Version >= FIRST_VERSION_WITH_ELEMENT_TABLE && m_Visitors.empty() )
+    {
+        m_LazySource = new LazySource;
+        m_LazySource->m_File = m_Path.Get();
+        m_LazySource->m_Version = m_Version;
+        m_LazySource->m_Strings = m_Strings;
+        m_LazySource->m_ClassesByID = m_ClassesByID;
+        m_LazySource->m_ClassesByShortName = m_ClassesByShortName;
+
+        m_Stream->SeekRead(0, std::ios_base::beg);
+        m_Stream->ReadBuffer(m_LazySource->m_Header, sizeof(m_LazySource->m_Header));
+    }
+
     // seek back to start of element stream
     m_Stream->SeekRead(element_offset, std::ios_base::beg);
 
@@ -289,7 +477,10 @@ void ArchiveBinary::Read()
     {
         REFLECT_SCOPE_TIMER( ("Main Spool Read") );
 
-        Deserialize(m_Spool, ArchiveFlags::Status);
+        if (!DeserializeParallel(file_data, file_size, table_offset))
+        {
+            Deserialize(m_Spool, ArchiveFlags::Status);
+        }
     }
 
     // invalidate the search type and abort flags so we process the append block
@@ -312,6 +503,14 @@ void ArchiveBinary::Read()
     // restore state, just in case someone wants to consume this after the fact
     m_SearchType = searchType;
 
+    // replay incremental saves over the main spool
+    if (delta_offset < file_size)
+    {
+        REFLECT_SCOPE_TIMER( ("Delta Log Read") );
+
+        DeserializeDeltas(delta_offset, file_size);
+    }
+
     // tell visitors to process append
     PostDeserialize(append);
 
@@ -370,14 +569,24 @@ void ArchiveBinary::Write()
     m_Stream->Write(&type_offset); 
     u32 string_offset = (u32)m_Stream->TellWrite();
     m_Stream->Write(&string_offset);
-
-    // serialize main file elements
+    u32 table_offset = (u32)m_Stream->TellWrite();
+    m_Stream->Write(&table_offset);
+    u32 delta_offset = (u32)m_Stream->TellWrite();
+    m_Stream->Write(&delta_offset);
+    HELIUM_ASSERT(delta_offset == DELTA_OFFSET_LOCATION);
+
+    // serialize main file elements, recording where each one starts
+    std::vector< u32 > element_offsets;
     {
         REFLECT_SCOPE_TIMER( ("Main Spool Write") );
 
+        m_ElementOffsets = &element_offsets;
         Serialize(m_Spool, ArchiveFlags::Status);
+        m_ElementOffsets = NULL;
     }
 
+    u32 append_offset = (u32)m_Stream->TellWrite();
+
     // tell visitors to generate append
     V_Element append;
     PostSerialize(append);
@@ -437,6 +646,37 @@ void ArchiveBinary::Write()
         m_Strings.Serialize(this); 
     }
 
+    // serialize element table
+    {
+        REFLECT_SCOPE_TIMER( ("Element Table Write") );
+
+        // write our current location back at our offset
+        u32 table_location = (u32)m_Stream->TellWrite();
+        m_Stream->SeekWrite(table_offset, std::ios_base::beg);
+        m_Stream->Write(&table_location); 
+        m_Stream->SeekWrite(0, std::ios_base::end);
+
+        i32 count = (i32)element_offsets.size();
+        m_Stream->Write(&count); 
+        if (count > 0)
+        {
+            m_Stream->WriteBuffer(&element_offsets.front(), count * sizeof(u32)); 
+        }
+
+        m_Stream->Write(&append_offset); 
+
+        const static i32 terminator = -1;
+        m_Stream->Write(&terminator); 
+    }
+
+    // the delta log starts out empty, at the end of the file
+    {
+        u32 delta_location = (u32)m_Stream->TellWrite();
+        m_Stream->SeekWrite(delta_offset, std::ios_base::beg);
+        m_Stream->Write(&delta_location); 
+        m_Stream->SeekWrite(0, std::ios_base::end);
+    }
+
     // CRC
     {
         REFLECT_SCOPE_TIMER( ("CRC Build") );
@@ -603,7 +843,11 @@ void ArchiveBinary::Serialize(const V_Element& elements, u32 flags)
 {
     REFLECT_SCOPE_TIMER_INST( "" )
 
-        i32 size = (i32)elements.size();
+    // only the top-level array records element offsets, nested arrays don't
+    std::vector< u32 >* offsets = m_ElementOffsets;
+    m_ElementOffsets = NULL;
+
+    i32 size = (i32)elements.size();
     m_Stream->Write(&size); 
 
 #ifdef REFLECT_ARCHIVE_VERBOSE
@@ -616,6 +860,11 @@ void ArchiveBinary::Serialize(const V_Element& elements, u32 flags)
     V_Element::const_iterator end = elements.end();
     for (int index = 0; itr != end; ++itr, ++index )
     {
+        if (offsets)
+        {
+            offsets->push_back( (u32)m_Stream->TellWrite() );
+        }
+
         Serialize(*itr);
 
         if (flags & ArchiveFlags::Status && m_Status != NULL)
@@ -639,6 +888,8 @@ void ArchiveBinary::Serialize(const V_Element& elements, u32 flags)
 
     const static i32 terminator = -1;
     m_Stream->Write(&terminator); 
+
+    m_ElementOffsets = offsets;
 }
 
 void ArchiveBinary::SerializeFields(const ElementPtr& element)
@@ -673,6 +924,13 @@ void ArchiveBinary::SerializeField(const ElementPtr& element, const Field* field
         return;
     }
 
+    // plain data skips the serializer entirely (visitors need one to look at, though)
+    if ( field->m_PlainData && field->m_Default.ReferencesObject() && m_Visitors.empty() )
+    {
+        SerializePlainDataField(element, field);
+        return;
+    }
+
     // construct serialization object
     ElementPtr e;
     m_Cache.Create( field->m_SerializerID, e );
@@ -752,7 +1010,7 @@ ElementPtr ArchiveBinary::Allocate()
     // read type string
     i32 index = -1;
     m_Stream->Read(&index); 
-    const tstring& str = m_Strings.Get(index);
+    const tchar* str = m_Strings.Get(index);
 
     // read length info if we have it
     u32 length = 0;
@@ -776,7 +1034,7 @@ ElementPtr ArchiveBinary::Allocate()
     {
         // we failed to find a type in the latent RTTI data, that is bad
         HELIUM_BREAK();
-        throw Reflect::TypeInformationException( TXT( "Unable to locate type '%s'" ), str.c_str());
+        throw Reflect::TypeInformationException( TXT( "Unable to locate type '%s'" ), str);
     }
 
     // this is guaranteed to be our legacy short name name
@@ -806,12 +1064,12 @@ ElementPtr ArchiveBinary::Allocate()
             // if you see this, then data is being lost because:
             //  1 - a type was completely removed from the codebase
             //  2 - a type was not found because its type library is not registered
-            Debug( TXT( "Unable to create object of type '%s', size %d, skipping...\n" ), str.c_str(), length);
+            Debug( TXT( "Unable to create object of type '%s', size %d, skipping...\n" ), str, length);
         }
         else
         {
             HELIUM_BREAK();
-            throw Reflect::DataFormatException( TXT( "Unable to create object, unknown type '%s'" ), str.c_str());
+            throw Reflect::DataFormatException( TXT( "Unable to create object, unknown type '%s'" ), str);
         }
     }
 
@@ -951,142 +1209,789 @@ void ArchiveBinary::Deserialize(V_Element& elements, u32 flags)
     }
 }
 
-void ArchiveBinary::DeserializeFields(const ElementPtr& element)
+//
+// Parallel reading
+//  Each worker gets its own archive over the in-memory file that shares the string pool
+//  and RTTI data of the main archive, and pulls batches of elements from the element table
+//
+
+namespace
 {
-    i32 field_count = -1;
-    m_Stream->Read(&field_count); 
+    // forwards worker archive notifications to the real handler one thread at a time
+    class LockedStatusHandler : public StatusHandler
+    {
+    public:
+        LockedStatusHandler( StatusHandler* handler, Mutex& mutex )
+            : m_Handler( handler )
+            , m_Mutex( mutex )
+        {
 
-    REFLECT_SCOPE_TIMER_INST( "" )
+        }
 
-        if (field_count > 0)
+        virtual void ArchiveStatus( StatusInfo& info ) HELIUM_OVERRIDE
         {
-            const Class* type = NULL;
+            // progress is reported by the main thread
+        }
 
-            // find the type of this object
-            M_StrToClass::iterator type_found = m_ClassesByShortName.find(element->GetClass()->m_ShortName);
+        virtual void ArchiveException( ExceptionInfo& info ) HELIUM_OVERRIDE
+        {
+            TakeMutex mutex ( m_Mutex );
+            m_Handler->ArchiveException( info );
+        }
 
-            // get Element's type info
-            if ( type_found != m_ClassesByShortName.end() )
-            {
-                type = type_found->second;
-            }
-            else
-            {
-                // our short name has changed so look up the legacy short name name given the short name of the current object
-                std::map< tstring, tstring >::const_iterator shortName_found = m_ShortNameMapping.find( element->GetClass()->m_ShortName );
+        virtual void ArchiveWarning( const tstring& warning ) HELIUM_OVERRIDE
+        {
+            TakeMutex mutex ( m_Mutex );
+            m_Handler->ArchiveWarning( warning );
+        }
 
-                // we should always find it, else its a bug/internal error
-                if ( shortName_found == m_ShortNameMapping.end() )
-                {
-                    throw Reflect::TypeInformationException( TXT( "Unable to remap short name '%s'" ), element->GetClass()->m_ShortName.c_str());
-                }
+        virtual void ArchiveDebug( const tstring& debug ) HELIUM_OVERRIDE
+        {
+            TakeMutex mutex ( m_Mutex );
+            m_Handler->ArchiveDebug( debug );
+        }
 
-                // we throw if there is an internal error, so just dereference the result
-                type = m_ClassesByShortName.find( shortName_found->second )->second;
-            }
+    private:
+        StatusHandler*  m_Handler;
+        Mutex&          m_Mutex;
+    };
 
-            if (type == NULL)
-            {
-                Debug( TXT( "Unable to resolve type from short name '%s'\n" ), element->GetClass()->m_ShortName.c_str());
-            }
+    // throws a failure from a worker on the calling thread, as the type it was caught as
+    template< class T >
+    void RethrowAs( const tstring& error )
+    {
+        throw T( TXT( "%s" ), error.c_str() );
+    }
 
-            // while we haven't hit the terminator
-            for (int i=0; i<field_count; i++)
-            {
-                i32 field_id = -1;
-                m_Stream->Read(&field_id); 
+    // shared by the calling thread and any pool threads that help out, the last one out deletes it
+    struct ParallelRead
+    {
+        ArchiveBinary*          m_Archive;      // only touched by whoever claims a batch, the caller waits for those
+        StatusHandler*          m_Status;
+        const char*             m_Data;
+        u32                     m_Size;
+        std::vector< u32 >      m_Offsets;
+        V_Element               m_Elements;
+
+        Mutex                   m_Mutex;
+        Mutex                   m_StatusMutex;
+        Condition               m_Done;
+        i32                     m_Next;         // next element to hand out
+        u32                     m_Batches;
+        u32                     m_Remaining;    // batches that haven't been finished or given up on
+        u32                     m_References;
+        bool                    m_Stopped;      // failed or aborted, nothing more gets handed out
+        tstring                 m_Error;
+        void                  (*m_Rethrow)( const tstring& error );
+    };
+
+    void ReleaseParallelRead( ParallelRead* read )
+    {
+        bool last = false;
 
-                if (type != NULL)
-                {
-                    M_FieldIDToInfo::const_iterator field_found = type->m_FieldIDToInfo.find(field_id);
-                    HELIUM_ASSERT(field_found != type->m_FieldIDToInfo.end());
+        {
+            TakeMutex mutex ( read->m_Mutex );
+            last = --read->m_References == 0;
+        }
 
-#ifdef REFLECT_ARCHIVE_VERBOSE
-                    m_Indent.Get(stdout);
-                    Debug(TXT("Deserializing field %s (field id %d)\n"), field_found->second->m_Name.c_str(), field_id);
-                    m_Indent.Push();
-#endif
+        if ( last )
+        {
+            delete read;
+        }
+    }
 
-                    // process
-                    DeserializeField(element, field_found->second);
+    // gives up on the batches nobody has claimed yet, call with the mutex held
+    void StopParallelRead( ParallelRead* read )
+    {
+        if ( read->m_Stopped )
+        {
+            return;
+        }
 
-#ifdef REFLECT_ARCHIVE_VERBOSE
-                    m_Indent.Pop();
-#endif
-                }
+        read->m_Stopped = true;
+
+        i32 count = (i32)read->m_Offsets.size();
+        if ( read->m_Next < count )
+        {
+            read->m_Remaining -= ( count - read->m_Next + PARALLEL_READ_BATCH_SIZE - 1 ) / PARALLEL_READ_BATCH_SIZE;
+            read->m_Next = count;
+
+            if ( read->m_Remaining == 0 )
+            {
+                read->m_Done.Signal();
             }
         }
+    }
 
-        i32 terminator = -1;
-        m_Stream->Read(&terminator); 
+    void FailParallelRead( ParallelRead* read, void (*rethrow)( const tstring& error ), const tstring& error )
+    {
+        TakeMutex mutex ( read->m_Mutex );
 
-        if (terminator != -1)
+        if ( read->m_Rethrow == NULL )
         {
-            throw Reflect::DataFormatException( TXT( "Unterminated field array block" ) );
+            read->m_Rethrow = rethrow;
+            read->m_Error = error;
         }
-}
-
-void ArchiveBinary::DeserializeField(const ElementPtr& element, const Field* latent_field)
-{
-    REFLECT_SCOPE_TIMER_INST( ("Deserialize %s", latent_field->m_Name.c_str()) );
 
-    // get the type info for the instance we are writing too
-    const Class* type = element->GetClass();
+        StopParallelRead( read );
+    }
 
-    // lookup the current field info by latent field name
-    M_FieldNameToInfo::const_iterator found = type->m_FieldNameToInfo.find(latent_field->m_Name);
+    Mutex                   g_ReadPoolMutex;
+    ThreadPool*             g_ReadPool = NULL;
 
-    // our missing component
-    ElementPtr component;
+    ThreadPool* GetReadPool()
+    {
+        TakeMutex mutex ( g_ReadPoolMutex );
 
-    // the field to serialize
-    FieldPtr current_field;
+        if ( g_ReadPool == NULL )
+        {
+            g_ReadPool = new ThreadPool( 0, "Reflect Binary Read" );
+        }
 
-    // sanity check
-    if (found == type->m_FieldNameToInfo.end())
-    {
-        current_field = NULL;
-    }
-    else
-    {
-        current_field = found->second;
+        return g_ReadPool;
     }
+}
 
-    if ( GetVersion() < ArchiveBinary::FIRST_VERSION_WITH_POINTER_SERIALIZER && latent_field->m_SerializerID == Reflect::GetType<PointerSerializer>() )
+namespace
+{
+    // a delta record that passed its crc check, offsets are relative to the start of the delta log
+    struct DeltaRecord
     {
-        // the address of a pointer to an element
-        ElementPtr* elementLocation = &component;
+        tuid    m_ID;
+        u32     m_Offset;
+        u32     m_Size;
+    };
 
-        // if we still have a pointer field, use it
-        if (current_field.ReferencesObject())
+    // serializes appends against compaction, and guards the set of files being compacted
+    Mutex                   g_DeltaMutex;
+    ThreadPool*             g_CompactionPool = NULL;
+    std::set< tstring >     g_Compacting;
+
+    struct CompactionJob
+    {
+        CompactionJob( const tstring& file )
+            : m_File( file )
         {
-            SerializerPtr serializer = current_field->CreateSerializer( element );
-            PointerSerializer* pointerSerializer = ObjectCast<PointerSerializer>( serializer );
-            if ( pointerSerializer )
-            {
-                elementLocation = &pointerSerializer->m_Data.Ref();
-                *elementLocation = NULL;
-            }
+
         }
 
-        // process
-        Deserialize( *elementLocation );
+        tstring m_File;
+    };
 
-        // post process
-        PostDeserialize( element, current_field );
-    }
-    else
+    // validates the header of a file we are about to touch the delta log of, and finds the end of the last
+    //  intact record (a crash mid-append leaves a partial record at the end of the file, it gets overwritten),
+    //  this must stop exactly where DeserializeDeltas does, or new records land behind ones it won't read past
+    u32 FindDeltaLogEnd( std::istream& stream, const tstring& file, u32& delta_offset )
     {
-        if ( current_field.ReferencesObject() )
+        stream.seekg( 0, std::ios_base::end );
+        u32 size = (u32)stream.tellg();
+        stream.seekg( 0, std::ios_base::beg );
+
+        u32 version = 0;
+        stream.read( (char*)&version, sizeof( version ) );
+        if ( stream.fail() || version < ArchiveBinary::FIRST_VERSION_WITH_DELTA_LOG || version > ArchiveBinary::CURRENT_VERSION )
         {
-            // pull and element and downcast to serializer
-            SerializerPtr latent_serializer = ObjectCast<Serializer>( Allocate() );
+            throw Reflect::LogisticException( TXT( "'%s' must be saved in full before it can take incremental saves" ), file.c_str() );
+        }
 
-            if (!latent_serializer.ReferencesObject())
-            {
-                // this should never happen, the type id read from the file is bogus
-                throw Reflect::TypeInformationException( TXT( "Invalid type id for field '%s'" ), latent_field->m_Name.c_str() );
-            }
+        stream.seekg( DELTA_OFFSET_LOCATION, std::ios_base::beg );
+        stream.read( (char*)&delta_offset, sizeof( delta_offset ) );
+        if ( stream.fail() || delta_offset > size )
+        {
+            throw Reflect::DataFormatException( TXT( "Delta log offset is outside of '%s'" ), file.c_str() );
+        }
+
+        std::vector< char > record;
+
+        u32 offset = delta_offset;
+        while ( size - offset >= sizeof( u32 ) + DELTA_RECORD_HEADER_SIZE )
+        {
+            u32 length = 0;
+            stream.seekg( offset, std::ios_base::beg );
+            stream.read( (char*)&length, sizeof( length ) );
+            if ( stream.fail() || length < DELTA_RECORD_HEADER_SIZE || length > size - offset - sizeof( u32 ) )
+            {
+                break;
+            }
+
+            record.resize( length );
+            stream.read( &record.front(), length );
+
+            u32 crc = 0;
+            memcpy( &crc, &record.front(), sizeof( u32 ) );
+            if ( stream.fail() || crc != Helium::Crc32( CRC_DEFAULT, &record.front() + sizeof( u32 ), length - sizeof( u32 ) ) )
+            {
+                break;
+            }
+
+            offset += sizeof( u32 ) + length;
+        }
+
+        stream.clear();
+        return offset;
+    }
+}
+
+bool ArchiveBinary::DeserializeParallel(const char* data, u32 size, u32 table_offset)
+{
+#ifdef REFLECT_DISABLE_PARALLEL_READ
+    return false;
+#else
+    // we need the table, the whole file in memory, and no visitors (they expect to be called from a single thread)
+    if ( data == NULL || table_offset == 0 || !m_Visitors.empty() || m_SearchType != Reflect::ReservedTypes::Invalid )
+    {
+        return false;
+    }
+
+    u32 start = (u32)m_Stream->TellRead();
+
+    m_Stream->SeekRead(table_offset, std::ios_base::beg);
+
+    i32 count = -1;
+    m_Stream->Read(&count); 
+
+    if (count < PARALLEL_READ_MIN_ELEMENTS)
+    {
+        m_Stream->SeekRead(start, std::ios_base::beg);
+        return false;
+    }
+
+    std::vector< u32 > offsets (count);
+    m_Stream->ReadBuffer(&offsets.front(), count * sizeof(u32)); 
+
+    u32 append_offset = 0;
+    m_Stream->Read(&append_offset); 
+
+    i32 terminator = -1;
+    m_Stream->Read(&terminator); 
+
+    if (terminator != -1)
+    {
+        throw Reflect::DataFormatException( TXT( "Unterminated element table" ) );
+    }
+
+#ifdef REFLECT_ARCHIVE_VERBOSE
+    Debug(TXT("Deserializing %d elements in parallel\n"), count);
+#endif
+
+    ParallelRead* job = new ParallelRead;
+    job->m_Archive = this;
+    job->m_Status = m_Status;
+    job->m_Data = data;
+    job->m_Size = size;
+    job->m_Offsets.swap(offsets);
+    job->m_Elements.resize(count);
+    job->m_Next = 0;
+    job->m_Batches = (count + PARALLEL_READ_BATCH_SIZE - 1) / PARALLEL_READ_BATCH_SIZE;
+    job->m_Remaining = job->m_Batches;
+    job->m_References = 1;
+    job->m_Stopped = false;
+    job->m_Rethrow = NULL;
+
+    ThreadPool* pool = GetReadPool();
+
+    // we do our share of the work too (and report progress as we go), so one less helper than there are batches
+    u32 helpers = std::min< u32 >( pool->GetThreadCount(), job->m_Batches - 1 );
+
+    job->m_References += helpers;
+    for ( u32 i=0; i<helpers; ++i )
+    {
+        pool->Queue( &ArchiveBinary::DeserializeParallelTask, job );
+    }
+
+    DeserializeParallelBatches( job, true );
+
+    // helpers that run after all the batches are claimed just drop their reference
+    job->m_Done.Wait();
+
+    if (job->m_Rethrow)
+    {
+        void (*rethrow)( const tstring& error ) = job->m_Rethrow;
+        tstring error = job->m_Error;
+        ReleaseParallelRead( job );
+
+        rethrow( error );
+    }
+
+    // gather the results in file order, the same way the serial read would have (up to where it was aborted)
+    m_Spool.reserve( m_Spool.size() + count );
+
+    V_Element::const_iterator itr = job->m_Elements.begin();
+    V_Element::const_iterator end = job->m_Elements.end();
+    for ( ; itr != end; ++itr )
+    {
+        if ( itr->ReferencesObject() )
+        {
+            m_Spool.push_back( *itr );
+        }
+    }
+
+    ReleaseParallelRead( job );
+
+    if (m_Status != NULL)
+    {
+        StatusInfo info (*this, ArchiveStates::ElementProcessed);
+        info.m_Progress = 100;
+        m_Status->ArchiveStatus(info);
+    }
+
+    // pick up where the serial read would have left off
+    m_Stream->SeekRead(append_offset, std::ios_base::beg);
+
+    return true;
+#endif
+}
+
+void ArchiveBinary::DeserializeParallelTask(void* param)
+{
+    ParallelRead* read = static_cast< ParallelRead* >( param );
+
+    DeserializeParallelBatches( read, false );
+    ReleaseParallelRead( read );
+}
+
+void ArchiveBinary::DeserializeParallelBatches(void* param, bool main)
+{
+    ParallelRead* read = static_cast< ParallelRead* >( param );
+
+    LockedStatusHandler status ( read->m_Status, read->m_StatusMutex );
+
+    // built once we have a batch, a helper that shows up late mustn't touch the archive
+    ArchiveBinary* archive = NULL;
+
+    i32 count = (i32)read->m_Offsets.size();
+
+    while (true)
+    {
+        i32 begin = 0;
+        {
+            TakeMutex mutex ( read->m_Mutex );
+
+            if (read->m_Next >= count)
+            {
+                break;
+            }
+
+            begin = read->m_Next;
+            read->m_Next += PARALLEL_READ_BATCH_SIZE;
+        }
+
+        // tasks can't throw, so anything that goes wrong is held for the calling thread to throw as the same type
+        try
+        {
+            if (archive == NULL)
+            {
+                ArchiveBinary* parent = read->m_Archive;
+
+                archive = new ArchiveBinary ( read->m_Status ? &status : NULL );
+                archive->m_Mode = ArchiveModes::Read;
+                archive->m_Path = parent->m_Path;
+                archive->m_Version = parent->m_Version;
+                archive->m_Strings = parent->m_Strings;
+                archive->m_ClassesByID = parent->m_ClassesByID;
+                archive->m_ClassesByShortName = parent->m_ClassesByShortName;
+                archive->m_LazyThreshold = parent->m_LazyThreshold;
+                archive->m_LazySource = parent->m_LazySource;
+                archive->m_Stream = new MemoryStream<char>( read->m_Data, read->m_Size );
+            }
+
+            i32 end = std::min( begin + PARALLEL_READ_BATCH_SIZE, count );
+            for ( i32 i=begin; i<end; ++i )
+            {
+                archive->m_Stream->SeekRead( read->m_Offsets[i], std::ios_base::beg );
+
+                ElementPtr element;
+                archive->Deserialize( element );
+
+                read->m_Elements[i] = element;
+            }
+        }
+        catch ( Reflect::ChecksumException& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Reflect::ChecksumException >, ex.Get() );
+        }
+        catch ( Reflect::StreamException& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Reflect::StreamException >, ex.Get() );
+        }
+        catch ( Reflect::CastException& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Reflect::CastException >, ex.Get() );
+        }
+        catch ( Reflect::DataFormatException& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Reflect::DataFormatException >, ex.Get() );
+        }
+        catch ( Reflect::TypeInformationException& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Reflect::TypeInformationException >, ex.Get() );
+        }
+        catch ( Reflect::LogisticException& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Reflect::LogisticException >, ex.Get() );
+        }
+        catch ( Helium::Exception& ex )
+        {
+            FailParallelRead( read, &RethrowAs< Helium::Exception >, ex.Get() );
+        }
+        catch ( std::exception& ex )
+        {
+            tstring error;
+            Helium::ConvertString( ex.what(), error );
+            FailParallelRead( read, &RethrowAs< Helium::Exception >, error );
+        }
+        catch ( ... )
+        {
+            FailParallelRead( read, &RethrowAs< Helium::Exception >, TXT( "Unknown exception while reading elements" ) );
+        }
+
+        u32 finished = 0;
+        {
+            TakeMutex mutex ( read->m_Mutex );
+
+            finished = read->m_Batches - --read->m_Remaining;
+
+            if (read->m_Remaining == 0)
+            {
+                read->m_Done.Signal();
+            }
+        }
+
+        // status handlers expect to hear from the thread that called Read(), which is also the only one that can abort
+        if (main && read->m_Status != NULL)
+        {
+            StatusInfo info (*read->m_Archive, ArchiveStates::ElementProcessed);
+            info.m_Progress = (int)(((float)finished / (float)read->m_Batches) * 100.0f);
+
+            {
+                TakeMutex mutex ( read->m_StatusMutex );
+                read->m_Status->ArchiveStatus(info);
+            }
+
+            if (info.m_Abort)
+            {
+                read->m_Archive->m_Abort = true;
+
+                TakeMutex mutex ( read->m_Mutex );
+                StopParallelRead( read );
+            }
+        }
+    }
+
+    delete archive;
+}
+
+void ArchiveBinary::DeserializeDeltas(u32 delta_offset, u32 file_size)
+{
+    u32 size = file_size - delta_offset;
+
+    m_Stream->SeekRead(delta_offset, std::ios_base::beg);
+
+    // the log is small next to the base archive, so just pull it into memory if it isn't already
+    std::vector< char > buffer;
+    const char* data = m_Stream->PeekBuffer(size);
+    if (!data)
+    {
+        buffer.resize(size);
+        m_Stream->ReadBuffer(&buffer.front(), size);
+        data = &buffer.front();
+    }
+
+    // find the intact records, and the newest record for each id
+    std::vector< DeltaRecord > records;
+    std::map< tuid, size_t > newest;
+
+    u32 offset = 0;
+    while (size - offset >= sizeof(u32) + DELTA_RECORD_HEADER_SIZE)
+    {
+        u32 length = 0;
+        memcpy(&length, data + offset, sizeof(u32));
+        if (length < DELTA_RECORD_HEADER_SIZE || length > size - offset - sizeof(u32))
+        {
+            break;
+        }
+
+        const char* record = data + offset + sizeof(u32);
+
+        u32 crc = 0;
+        memcpy(&crc, record, sizeof(u32));
+        if (crc != Helium::Crc32(CRC_DEFAULT, record + sizeof(u32), length - sizeof(u32)))
+        {
+            break;
+        }
+
+        DeltaRecord delta;
+        memcpy(&delta.m_ID, record + sizeof(u32), sizeof(tuid));
+        delta.m_Offset = offset + sizeof(u32) + DELTA_RECORD_HEADER_SIZE;
+        delta.m_Size = length - DELTA_RECORD_HEADER_SIZE;
+
+        newest[ delta.m_ID ] = records.size();
+        records.push_back(delta);
+
+        offset += sizeof(u32) + length;
+    }
+
+    if (offset < size)
+    {
+        Debug( TXT( "Discarding %d bytes of incomplete delta log\n" ), size - offset );
+    }
+
+    if (records.empty())
+    {
+        return;
+    }
+
+    if (s_ElementIDFunc == NULL)
+    {
+        throw Reflect::LogisticException( TXT( "Archive has a delta log, but no element id function is set to replay it" ) );
+    }
+
+    // deserialize the newest record for each id, in log order so new elements keep the order they were saved in
+    M_TUIDToElement elements;
+    std::vector< tuid > order;
+    for ( size_t i=0; i<records.size(); ++i )
+    {
+        const DeltaRecord& delta = records[i];
+        if (newest[ delta.m_ID ] != i)
+        {
+            continue;
+        }
+
+        ElementPtr element;
+        if (delta.m_Size > 0)
+        {
+            ArchiveBinary archive;
+            archive.OpenStream( new MemoryStream<char>( data + delta.m_Offset, delta.m_Size ), false );
+            archive.Read();
+            archive.Close();
+
+            if (!archive.m_Spool.empty())
+            {
+                element = archive.m_Spool.front();
+            }
+        }
+
+        elements[ delta.m_ID ] = element;
+        order.push_back( delta.m_ID );
+    }
+
+    // replace (or remove) the elements that were saved incrementally
+    V_Element spool;
+    spool.reserve( m_Spool.size() );
+
+    V_Element::const_iterator itr = m_Spool.begin();
+    V_Element::const_iterator end = m_Spool.end();
+    for ( ; itr != end; ++itr )
+    {
+        tuid id = 0;
+        if ( itr->ReferencesObject() && s_ElementIDFunc( *itr, id ) )
+        {
+            M_TUIDToElement::iterator found = elements.find( id );
+            if ( found != elements.end() )
+            {
+                if ( found->second.ReferencesObject() )
+                {
+                    spool.push_back( found->second );
+                }
+
+                elements.erase( found );
+                continue;
+            }
+        }
+
+        spool.push_back( *itr );
+    }
+
+    // whatever is left was created after the base archive was written
+    std::vector< tuid >::const_iterator orderItr = order.begin();
+    std::vector< tuid >::const_iterator orderEnd = order.end();
+    for ( ; orderItr != orderEnd; ++orderItr )
+    {
+        M_TUIDToElement::const_iterator found = elements.find( *orderItr );
+        if ( found != elements.end() && found->second.ReferencesObject() )
+        {
+            spool.push_back( found->second );
+        }
+    }
+
+    m_Spool.swap( spool );
+}
+
+void ArchiveBinary::SerializePlainDataField(const ElementPtr& element, const Field* field)
+{
+    bool force = (field->m_Flags & FieldFlags::Force) != 0;
+    if (!force && field->m_Type->HasDefaultPlainData(element, field))
+    {
+        return;
+    }
+
+    PreSerialize(element, field);
+
+    // write our latent field ID to the stream, this will always be valid since we persist ALL of the RTTI data
+    m_Stream->Write(&field->m_FieldID); 
+
+    // write exactly what Serialize() would for the field's SimpleSerializer: type, length, then the raw value
+    const Class* serializerClass = field->m_Default->GetClass();
+    i32 index = m_Strings.Insert(serializerClass->m_ShortName);
+    m_Stream->Write(&index); 
+
+    u32 length = sizeof(u32) + field->m_Size;
+    m_Stream->Write(&length); 
+
+    m_Stream->WriteBuffer(reinterpret_cast<const u8*>(element.Ptr()) + field->m_Offset, field->m_Size);
+
+    m_Types.insert(serializerClass->m_TypeID);
+
+    // we wrote a field, so increment our count
+    HELIUM_ASSERT(m_FieldStack.size() > 0);
+    m_FieldStack.top().m_Count++;
+}
+
+void ArchiveBinary::DeserializeFields(const ElementPtr& element)
+{
+    i32 field_count = -1;
+    m_Stream->Read(&field_count); 
+
+    REFLECT_SCOPE_TIMER_INST( "" )
+
+        if (field_count > 0)
+        {
+            const Class* type = NULL;
+
+            // find the type of this object
+            M_StrToClass::iterator type_found = m_ClassesByShortName.find(element->GetClass()->m_ShortName);
+
+            // get Element's type info
+            if ( type_found != m_ClassesByShortName.end() )
+            {
+                type = type_found->second;
+            }
+            else
+            {
+                // our short name has changed so look up the legacy short name name given the short name of the current object
+                std::map< tstring, tstring >::const_iterator shortName_found = m_ShortNameMapping.find( element->GetClass()->m_ShortName );
+
+                // we should always find it, else its a bug/internal error
+                if ( shortName_found == m_ShortNameMapping.end() )
+                {
+                    throw Reflect::TypeInformationException( TXT( "Unable to remap short name '%s'" ), element->GetClass()->m_ShortName.c_str());
+                }
+
+                // we throw if there is an internal error, so just dereference the result
+                type = m_ClassesByShortName.find( shortName_found->second )->second;
+            }
+
+            if (type == NULL)
+            {
+                Debug( TXT( "Unable to resolve type from short name '%s'\n" ), element->GetClass()->m_ShortName.c_str());
+            }
+
+            // while we haven't hit the terminator
+            for (int i=0; i<field_count; i++)
+            {
+                i32 field_id = -1;
+                m_Stream->Read(&field_id); 
+
+                if (type != NULL)
+                {
+                    M_FieldIDToInfo::const_iterator field_found = type->m_FieldIDToInfo.find(field_id);
+                    HELIUM_ASSERT(field_found != type->m_FieldIDToInfo.end());
+
+#ifdef REFLECT_ARCHIVE_VERBOSE
+                    m_Indent.Get(stdout);
+                    Debug(TXT("Deserializing field %s (field id %d)\n"), field_found->second->m_Name.c_str(), field_id);
+                    m_Indent.Push();
+#endif
+
+                    // process
+                    DeserializeField(element, field_found->second);
+
+#ifdef REFLECT_ARCHIVE_VERBOSE
+                    m_Indent.Pop();
+#endif
+                }
+            }
+        }
+
+        i32 terminator = -1;
+        m_Stream->Read(&terminator); 
+
+        if (terminator != -1)
+        {
+            throw Reflect::DataFormatException( TXT( "Unterminated field array block" ) );
+        }
+}
+
+void ArchiveBinary::DeserializeField(const ElementPtr& element, const Field* latent_field)
+{
+    REFLECT_SCOPE_TIMER_INST( ("Deserialize %s", latent_field->m_Name.c_str()) );
+
+    // get the type info for the instance we are writing too
+    const Class* type = element->GetClass();
+
+    // lookup the current field info by latent field name
+    M_FieldNameToInfo::const_iterator found = type->m_FieldNameToInfo.find(latent_field->m_Name);
+
+    // our missing component
+    ElementPtr component;
+
+    // the field to serialize
+    FieldPtr current_field;
+
+    // sanity check
+    if (found == type->m_FieldNameToInfo.end())
+    {
+        current_field = NULL;
+    }
+    else
+    {
+        current_field = found->second;
+    }
+
+    if ( GetVersion() < ArchiveBinary::FIRST_VERSION_WITH_POINTER_SERIALIZER && latent_field->m_SerializerID == Reflect::GetType<PointerSerializer>() )
+    {
+        // the address of a pointer to an element
+        ElementPtr* elementLocation = &component;
+
+        // if we still have a pointer field, use it
+        if (current_field.ReferencesObject())
+        {
+            SerializerPtr serializer = current_field->CreateSerializer( element );
+            PointerSerializer* pointerSerializer = ObjectCast<PointerSerializer>( serializer );
+            if ( pointerSerializer )
+            {
+                elementLocation = &pointerSerializer->m_Data.Ref();
+                *elementLocation = NULL;
+            }
+        }
+
+        // process
+        Deserialize( *elementLocation );
+
+        // post process
+        PostDeserialize( element, current_field );
+    }
+    else
+    {
+        if ( current_field.ReferencesObject() && current_field->m_PlainData && current_field->m_SerializerID == latent_field->m_SerializerID && DeserializePlainDataField( element, current_field ) )
+        {
+            // post process
+            PostDeserialize( element, current_field );
+        }
+        else if ( current_field.ReferencesObject() && m_LazySource && current_field->m_SerializerID == latent_field->m_SerializerID && DeserializeLazyField( element, current_field, latent_field ) )
+        {
+            // left in the file until someone asks for it
+        }
+        else if ( current_field.ReferencesObject() )
+        {
+            // pull and element and downcast to serializer
+            SerializerPtr latent_serializer = ObjectCast<Serializer>( Allocate() );
+
+            if (!latent_serializer.ReferencesObject())
+            {
+                // this should never happen, the type id read from the file is bogus
+                throw Reflect::TypeInformationException( TXT( "Invalid type id for field '%s'" ), latent_field->m_Name.c_str() );
+            }
 
             // keep in mind that m_SerializerID of latent field is the current type id that matches the latent short name
             if (current_field->m_SerializerID == latent_field->m_SerializerID)
@@ -1165,6 +2070,209 @@ void ArchiveBinary::DeserializeField(const ElementPtr& element, const Field* lat
     }
 }
 
+bool ArchiveBinary::DeserializePlainDataField(const ElementPtr& element, const Field* current_field)
+{
+    // visitors and skipping both need the serializer object
+    if ( m_Version < 2 || m_Skip || !m_Visitors.empty() )
+    {
+        return false;
+    }
+
+    i32 index = -1;
+    m_Stream->Read(&index); 
+
+    u32 length = 0;
+    m_Stream->Read(&length); 
+
+    // the latent serializer must have written just the raw value, else go the long way around
+    if ( length != sizeof(u32) + current_field->m_Size )
+    {
+        m_Stream->SeekRead(-(std::streamoff)(sizeof(i32) + sizeof(u32)), std::ios_base::cur);
+        return false;
+    }
+
+    m_Stream->ReadBuffer(reinterpret_cast<u8*>(element.Ptr()) + current_field->m_Offset, current_field->m_Size);
+
+    return true;
+}
+
+bool ArchiveBinary::DeserializeLazyField(const ElementPtr& element, const Field* current_field, const Field* latent_field)
+{
+    if ( m_Skip )
+    {
+        return false;
+    }
+
+    // only containers of plain values, anything holding elements has callbacks to make while it's read
+    const Class* serializerClass = Registry::GetInstance()->GetClass( current_field->m_SerializerID );
+    if ( serializerClass == NULL
+        || !( serializerClass->HasType( Reflect::GetType<ArraySerializer>() )
+        || serializerClass->HasType( Reflect::GetType<SetSerializer>() )
+        || serializerClass->HasType( Reflect::GetType<MapSerializer>() ) ) )
+    {
+        return false;
+    }
+
+    u32 offset = (u32)m_Stream->TellRead();
+
+    i32 index = -1;
+    m_Stream->Read(&index); 
+
+    u32 length = 0;
+    m_Stream->Read(&length); 
+
+    if ( length < std::max( m_LazyThreshold, LAZY_THRESHOLD_MIN ) )
+    {
+        m_Stream->SeekRead(offset, std::ios_base::beg);
+        return false;
+    }
+
+    // the length includes itself
+    m_Stream->SeekRead(offset + sizeof(i32) + length, std::ios_base::beg);
+
+    LazyField lazy;
+    lazy.m_Field = current_field;
+    lazy.m_LatentField = latent_field;
+    lazy.m_Offset = offset;
+
+    TakeMutex mutex ( g_LazyMutex );
+
+    lazy.m_Source = m_LazySource;
+
+    V_LazyField& fields = g_LazyFields[ element.Ptr() ];
+    if ( fields.empty() )
+    {
+        ++g_LazyElementCount;
+    }
+
+    fields.push_back( lazy );
+
+    return true;
+}
+
+void ArchiveBinary::SetStringTable(StringTable* table)
+{
+    g_StringTable.SetPointer( table );
+}
+
+void ArchiveBinary::SetLazyThreshold(u32 bytes)
+{
+    g_LazyThreshold.SetPointer( (void*)(uintptr)bytes );
+}
+
+void ArchiveBinary::LoadLazyFields(Element* element, const Field* field)
+{
+    u32 thread = Helium::GetCurrentThreadID();
+    if ( g_LazyLoadThread == thread )
+    {
+        return;
+    }
+
+    {
+        TakeMutex mutex ( g_LazyMutex );
+
+        if ( g_LazyFields.find( element ) == g_LazyFields.end() )
+        {
+            return;
+        }
+    }
+
+    // the fields stay pending until they are read, so anyone else after them waits here instead of seeing them empty
+    TakeMutex loading ( g_LazyLoadMutex );
+    g_LazyLoadThread = thread;
+
+    V_LazyField fields;
+
+    {
+        TakeMutex mutex ( g_LazyMutex );
+
+        // another thread may have loaded them while we waited
+        M_ElementToLazyFields::iterator found = g_LazyFields.find( element );
+        if ( found != g_LazyFields.end() )
+        {
+            const V_LazyField& pending = found->second;
+            for ( V_LazyField::const_iterator itr = pending.begin(); itr != pending.end(); ++itr )
+            {
+                if ( field == NULL || itr->m_Field == field )
+                {
+                    fields.push_back( *itr );
+                }
+            }
+        }
+    }
+
+    ElementPtr instance ( element );
+
+    try
+    {
+        V_LazyField::const_iterator itr = fields.begin();
+        V_LazyField::const_iterator end = fields.end();
+        for ( ; itr != end; ++itr )
+        {
+            const LazySource* source = itr->m_Source.Ptr();
+
+            ArchiveBinary archive;
+            archive.m_LazyThreshold = 0;
+            archive.m_Version = source->m_Version;
+            archive.m_Strings = source->m_Strings;
+            archive.m_ClassesByID = source->m_ClassesByID;
+            archive.m_ClassesByShortName = source->m_ClassesByShortName;
+            archive.OpenFile( source->m_File );
+
+            try
+            {
+                // appending deltas leaves the base archive alone, but anything else invalidates our offsets
+                u8 header[ DELTA_OFFSET_LOCATION ];
+                archive.m_Stream->ReadBuffer( header, sizeof( header ) );
+                if ( archive.m_Stream->ElementsRead() != sizeof( header ) || memcmp( header, source->m_Header, sizeof( header ) ) != 0 )
+                {
+                    throw Reflect::StreamException( TXT( "'%s' changed before field '%s' was loaded from it" ), source->m_File.c_str(), itr->m_Field->m_Name.c_str() );
+                }
+
+                archive.m_Stream->SeekRead( itr->m_Offset, std::ios_base::beg );
+                archive.DeserializeField( instance, itr->m_LatentField );
+            }
+            catch (...)
+            {
+                archive.Close();
+                throw;
+            }
+
+            archive.Close();
+        }
+    }
+    catch (...)
+    {
+        // a failed field isn't tried again, it would only fail the same way
+        {
+            TakeMutex mutex ( g_LazyMutex );
+            ForgetLazyFields( element, fields );
+        }
+
+        g_LazyLoadThread = 0;
+        throw;
+    }
+
+    {
+        TakeMutex mutex ( g_LazyMutex );
+        ForgetLazyFields( element, fields );
+    }
+
+    g_LazyLoadThread = 0;
+}
+
+void ArchiveBinary::DiscardLazyFields(const Element* element)
+{
+    TakeMutex mutex ( g_LazyMutex );
+
+    M_ElementToLazyFields::iterator found = g_LazyFields.find( element );
+    if ( found != g_LazyFields.end() )
+    {
+        g_LazyFields.erase( found );
+        --g_LazyElementCount;
+    }
+}
+
 void ArchiveBinary::SerializeComposite(const Composite* composite)
 {
 #ifdef REFLECT_ARCHIVE_VERBOSE
@@ -1193,7 +2301,7 @@ bool ArchiveBinary::DeserializeComposite(Composite* composite)
 {
     i32 string_index = -1;
     m_Stream->Read(&string_index); 
-    composite->m_ShortName = m_Strings.Get(string_index);
+    m_Strings.Get(string_index, composite->m_ShortName);
 
     m_Stream->Read(&composite->m_TypeID); 
 
@@ -1259,7 +2367,7 @@ bool ArchiveBinary::DeserializeField(Field* field)
 
     // field name
     m_Stream->Read(&string_index); 
-    field->m_Name = m_Strings.Get(string_index);
+    m_Strings.Get(string_index, field->m_Name);
 
     if ( GetVersion() < ArchiveBinary::FIRST_VERSION_WITH_POINTER_SERIALIZER )
     {
@@ -1277,7 +2385,7 @@ bool ArchiveBinary::DeserializeField(Field* field)
     m_Stream->Read(&string_index); 
     if (string_index >= 0)
     {
-        const tstring& str (m_Strings.Get(string_index));
+        const tchar* str = m_Strings.Get(string_index);
 
         const Class* c = Registry::GetInstance()->GetClass(str);
 
@@ -1291,7 +2399,7 @@ bool ArchiveBinary::DeserializeField(Field* field)
         }
 
 #ifdef REFLECT_ARCHIVE_VERBOSE
-        Log::Debug(TXT("  Deserializing %s (short name %s)\n"), c->m_FullName.c_str(), str.c_str());
+        Log::Debug(TXT("  Deserializing %s (short name %s)\n"), c->m_FullName.c_str(), str);
 #endif
     }
 
@@ -1368,3 +2476,229 @@ void ArchiveBinary::FromStream(std::iostream& stream, V_Element& elements, Statu
 
     elements = archive.m_Spool;
 }
+
+void ArchiveBinary::AppendDeltas(const tstring& file, const M_TUIDToElement& elements)
+{
+    REFLECT_SCOPE_TIMER(("%s", file.c_str()));
+
+    // build the records up front, so we only hold the file for as long as it takes to write them
+    std::string records;
+
+    M_TUIDToElement::const_iterator itr = elements.begin();
+    M_TUIDToElement::const_iterator end = elements.end();
+    for ( ; itr != end; ++itr )
+    {
+        std::string data;
+        if ( itr->second.ReferencesObject() )
+        {
+            std::stringstream stream;
+            ToStream( itr->second, stream );
+            data = stream.str();
+        }
+
+        tuid id = itr->first;
+        u32 length = DELTA_RECORD_HEADER_SIZE + (u32)data.size();
+        u32 crc = Helium::Crc32( CRC_DEFAULT, &id, sizeof( id ) );
+        crc = Helium::Crc32( crc, data.data(), (u32)data.size() );
+
+        records.append( (const char*)&length, sizeof( length ) );
+        records.append( (const char*)&crc, sizeof( crc ) );
+        records.append( (const char*)&id, sizeof( id ) );
+        records.append( data );
+    }
+
+    TakeMutex mutex ( g_DeltaMutex );
+
+    std::fstream stream ( file.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary );
+    if ( !stream.is_open() )
+    {
+        throw Reflect::StreamException( TXT( "Unable to open '%s' for write" ), file.c_str() );
+    }
+
+    u32 delta_offset = 0;
+    u32 log_end = FindDeltaLogEnd( stream, file, delta_offset );
+
+    stream.seekp( log_end, std::ios_base::beg );
+    stream.write( records.data(), records.size() );
+    stream.flush();
+    if ( stream.fail() )
+    {
+        throw Reflect::StreamException( TXT( "Unable to append to '%s'" ), file.c_str() );
+    }
+
+    // once replaying the log costs more than it saves, fold it into the base archive
+    u32 log_size = log_end + (u32)records.size() - delta_offset;
+    if ( log_size > delta_offset / DELTA_COMPACTION_DIVISOR && g_Compacting.insert( file ).second )
+    {
+        if ( g_CompactionPool == NULL )
+        {
+            g_CompactionPool = new ThreadPool( 1, "Reflect Compaction" );
+        }
+
+        g_CompactionPool->Queue( &ArchiveBinary::CompactTask, new CompactionJob( file ) );
+    }
+}
+
+void ArchiveBinary::Compact(const tstring& file, StatusHandler* status)
+{
+    REFLECT_SCOPE_TIMER(("%s", file.c_str()));
+
+    // snapshot the file, appends can carry on while we build the new base archive from it
+    std::string snapshot;
+    u32 snapshot_end = 0;
+    {
+        TakeMutex mutex ( g_DeltaMutex );
+
+        std::ifstream stream ( file.c_str(), std::ios_base::in | std::ios_base::binary );
+        if ( !stream.is_open() )
+        {
+            throw Reflect::StreamException( TXT( "Unable to open '%s' for read" ), file.c_str() );
+        }
+
+        u32 delta_offset = 0;
+        snapshot_end = FindDeltaLogEnd( stream, file, delta_offset );
+        if ( snapshot_end == delta_offset )
+        {
+            return;
+        }
+
+        snapshot.resize( snapshot_end );
+        stream.seekg( 0, std::ios_base::beg );
+        stream.read( &snapshot[0], snapshot_end );
+        if ( stream.fail() )
+        {
+            throw Reflect::StreamException( TXT( "Unable to read '%s'" ), file.c_str() );
+        }
+    }
+
+    // load the base archive with the deltas replayed over it
+    ArchiveBinary reader ( status );
+    reader.OpenStream( new MemoryStream<char>( snapshot.data(), snapshot.size() ), false );
+    reader.Read();
+    reader.Close();
+
+    // write the new base archive next to the file
+    Helium::Path path ( file );
+    Helium::Path compactPath ( file + TXT( ".compact" ) );
+    try
+    {
+        ArchiveBinary writer ( status );
+        writer.m_Spool = reader.m_Spool;
+        writer.OpenFile( compactPath.Get(), true );
+
+        try
+        {
+            writer.Write();
+        }
+        catch (...)
+        {
+            writer.Close();
+            throw;
+        }
+
+        writer.Close();
+    }
+    catch (...)
+    {
+        compactPath.Delete();
+        throw;
+    }
+
+    // carry over anything appended since the snapshot, and publish
+    TakeMutex mutex ( g_DeltaMutex );
+
+    std::ifstream source ( file.c_str(), std::ios_base::in | std::ios_base::binary );
+    if ( !source.is_open() )
+    {
+        compactPath.Delete();
+        throw Reflect::StreamException( TXT( "Unable to open '%s' for read" ), file.c_str() );
+    }
+
+    // if the header changed the whole file was saved over while we were busy, and that save wins
+    std::string header ( DELTA_OFFSET_LOCATION + sizeof( u32 ), '\0' );
+    source.read( &header[0], header.size() );
+    if ( source.fail() || header != snapshot.substr( 0, header.size() ) )
+    {
+        compactPath.Delete();
+        return;
+    }
+
+    u32 delta_offset = 0;
+    u32 log_end = FindDeltaLogEnd( source, file, delta_offset );
+    if ( log_end > snapshot_end )
+    {
+        std::string tail ( log_end - snapshot_end, '\0' );
+        source.seekg( snapshot_end, std::ios_base::beg );
+        source.read( &tail[0], tail.size() );
+
+        std::ofstream dest ( compactPath.Get().c_str(), std::ios_base::out | std::ios_base::app | std::ios_base::binary );
+        dest.write( tail.data(), tail.size() );
+        dest.close();
+
+        if ( source.fail() || dest.fail() )
+        {
+            compactPath.Delete();
+            throw Reflect::StreamException( TXT( "Unable to carry the delta log of '%s' over" ), file.c_str() );
+        }
+    }
+
+    source.close();
+
+    // replace in one step, there is never a moment where a crash leaves us without the archive
+    if ( !Helium::Replace( compactPath.Native().c_str(), path.Native().c_str() ) )
+    {
+        compactPath.Delete();
+        throw Reflect::StreamException( TXT( "Unable to move '%s' to '%s'" ), compactPath.c_str(), file.c_str() );
+    }
+}
+
+void ArchiveBinary::CompactTask(void* param)
+{
+    CompactionJob* job = static_cast< CompactionJob* >( param );
+
+    try
+    {
+        Compact( job->m_File );
+    }
+    catch ( Helium::Exception& ex )
+    {
+        Log::Warning( TXT( "Unable to compact '%s': %s\n" ), job->m_File.c_str(), ex.What() );
+    }
+    catch ( std::exception& ex )
+    {
+        tstring what;
+        Helium::ConvertString( ex.what(), what );
+        Log::Warning( TXT( "Unable to compact '%s': %s\n" ), job->m_File.c_str(), what.c_str() );
+    }
+    catch ( ... )
+    {
+        // nothing may escape a pool thread, and the file must be free to compact again
+        Log::Warning( TXT( "Unable to compact '%s': Unknown exception\n" ), job->m_File.c_str() );
+    }
+
+    {
+        TakeMutex mutex ( g_DeltaMutex );
+        g_Compacting.erase( job->m_File );
+    }
+
+    delete job;
+}
+
+void ArchiveBinary::CleanupCompaction()
+{
+    if ( g_CompactionPool )
+    {
+        g_CompactionPool->Wait();
+
+        delete g_CompactionPool;
+        g_CompactionPool = NULL;
+    }
+}
+
+void ArchiveBinary::CleanupParallelRead()
+{
+    TakeMutex mutex ( g_ReadPoolMutex );
+
+    delete g_ReadPool;
+    g_ReadPool = NULL;
+}
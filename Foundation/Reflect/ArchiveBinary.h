@@ -3,6 +3,8 @@
 #include "Indent.h"
 #include "Archive.h"
 
+#include "Foundation/TUID.h"
+
 //  
 //    Reflect Binary Format:
 //  
@@ -33,22 +35,44 @@
 //      i32 term;             // -1
 //    };
 //  
+//    struct ElementTable
+//    {
+//      i32 count;            // count of elements in the main spool
+//      u32[] offsets;        // offset into file for the beginning of each element
+//      u32 append_offset;    // offset into file for the beginning of the append array
+//      i32 term;             // -1
+//    };
+//  
+//    struct DeltaRecord
+//    {
+//      u32 length;           // number of bytes following the length
+//      u32 crc;              // crc of the id and data
+//      tuid id;              // id of the element this record replaces
+//      byte[] data;          // single element binary archive, empty if the element was removed
+//    };
+//  
 //    struct File
 //    {
-//      char file_id;         // '!'
+//          char file_id;         // '!'
 //  
-//      u32 crc;              // crc of all bytes following the crc value itself
-//    |-i32 type_offet;       // offset into file for the beginning of the rtti block
-//  |-+-i32 string_offset;    // offset into file for the beginning of the global string pool
-//  | |
-//  | | Array spool;          // spooled data from client
-//  | | Array append;         // appended session data
+//          u32 crc;              // crc of all bytes following the crc value itself, up to the delta log
+//        |-i32 type_offet;       // offset into file for the beginning of the rtti block
+//      |-+-i32 string_offset;    // offset into file for the beginning of the global string pool
+//    |-+-+-i32 table_offset;     // offset into file for the beginning of the element table
+//  |-+-+-+-i32 delta_offset;     // offset into file for the beginning of the delta log
+//  | | | |
+//  | | | | Array spool;          // spooled data from client
+//  | | | | Array append;         // appended session data
+//  | | | |
+//  | | | ->i32 type_count;       // number of types stored
+//  | | |   Structure[] types;    // see Class.h for details
+//  | | |   i32 type_term;        // -1
+//  | | |
+//  | | --->StringPool strings;   // see StringPool.h for details
 //  | |
-//  | ->i32 type_count;       // number of types stored
-//  |   Structure[] types;    // see Class.h for details
-//  |   i32 type_term;        // -1
+//  | ----->ElementTable table;   // lets readers find (and load) each element independently
 //  |
-//  --->StringPool strings;   // see StringPool.h for details
+//  ------->DeltaRecord[] deltas; // incremental saves, replayed over the spool in order (runs to the end of the file)
 //    };
 //  
 
@@ -62,6 +86,14 @@ namespace Helium
 
         typedef std::map< int, Helium::SmartPtr<const Class> > M_IDToClass;
         typedef std::map< tstring, Helium::SmartPtr<const Class> > M_StrToClass;
+        typedef std::map< tuid, ElementPtr > M_TUIDToElement;
+
+        // fetches the id delta records use to refer to an element, returns false if the element has no id
+        typedef bool (*ElementIDFunc)( const Element* element, tuid& id );
+
+        // what a lazy read needs to come back to the file for a field later
+        class LazySource;
+        typedef Helium::SmartPtr< LazySource > LazySourcePtr;
 
         class FOUNDATION_API ArchiveBinary : public Archive
         {
@@ -71,6 +103,9 @@ namespace Helium
             static const u32 FIRST_VERSION_WITH_STRINGPOOL_COMPRESSION; 
             static const u32 FIRST_VERSION_WITH_POINTER_SERIALIZER; 
             static const u32 FIRST_VERSION_WITH_UNICODE_SUPPORT; 
+            static const u32 FIRST_VERSION_WITH_ELEMENT_TABLE; 
+            static const u32 FIRST_VERSION_WITH_BLOCK_COMPRESSION; 
+            static const u32 FIRST_VERSION_WITH_DELTA_LOG; 
 
         private:
             friend class Archive;
@@ -86,6 +121,9 @@ namespace Helium
             // The strings to cache for binary modes
             StringPool m_Strings;
 
+            // Maps elements to the ids used by delta records
+            static ElementIDFunc s_ElementIDFunc;
+
             // Latent types by latent ids
             M_IDToClass m_ClassesByID;
 
@@ -114,8 +152,18 @@ namespace Helium
             // The stack of fields we are writing
             std::stack<WriteFields> m_FieldStack;
 
+            // The offsets of the top-level elements we are writing (NULL when nested)
+            std::vector< u32 >* m_ElementOffsets;
+
+            // Field payloads at least this big are left in the file until first use (0 reads everything)
+            u32 m_LazyThreshold;
+
+            // Where the fields we leave in the file come from
+            LazySourcePtr m_LazySource;
+
         private:
             ArchiveBinary (StatusHandler* status = NULL);
+            ~ArchiveBinary();
 
         public:
             // Stream access
@@ -130,6 +178,21 @@ namespace Helium
                 return m_Strings;
             }
 
+            // Intern table for archives created on the calling thread after this call, NULL gives each archive its own table
+            //  Archives take their own reference, but the caller must keep one until it sets another table (or NULL)
+            static void SetStringTable(StringTable* table);
+
+            // Id lookup for replaying delta records over the elements of the main spool
+            static void SetElementIDFunc(ElementIDFunc func)
+            {
+                s_ElementIDFunc = func;
+            }
+
+            // Field payloads at least this many bytes are left in the file by binary reads on the calling thread, and
+            //  are loaded when a serializer is first connected to them (or by LoadLazyFields), 0 turns this off
+            //  PostDeserialize runs before lazy fields are loaded, so only use this for reads that inspect a few properties
+            static void SetLazyThreshold(u32 bytes);
+
             u32 GetVersion()
             {
                 return m_Version; 
@@ -167,6 +230,7 @@ namespace Helium
             // Helpers
             void SerializeFields(const ElementPtr& element);
             void SerializeField(const ElementPtr& element, const Field* field);
+            void SerializePlainDataField(const ElementPtr& element, const Field* field);
 
         private:
             // pulls an element from the head of the stream
@@ -177,10 +241,30 @@ namespace Helium
             virtual void Deserialize(ElementPtr& element);
             virtual void Deserialize(V_Element& elements, u32 flags = 0);
 
+        private:
+            // leaves a large field in the file to be loaded later, returns false if it must be read now
+            bool DeserializeLazyField(const ElementPtr& element, const Field* current_field, const Field* latent_field);
+
+            // deserializes the main spool using the element table, split across worker threads
+            bool DeserializeParallel(const char* data, u32 size, u32 table_offset);
+
+            // worker thread entry point for parallel deserialization
+            static void DeserializeParallelTask(void* param);
+
+            // reads batches of elements until there are none left to claim, the calling thread reports progress
+            static void DeserializeParallelBatches(void* param, bool main);
+
+            // reads the delta log and applies it to the main spool
+            void DeserializeDeltas(u32 delta_offset, u32 file_size);
+
+            // background compaction entry point
+            static void CompactTask(void* param);
+
         protected:
             // Helpers
             void DeserializeFields(const ElementPtr& element);
             void DeserializeField(const ElementPtr& element, const Field* latent_field);
+            bool DeserializePlainDataField(const ElementPtr& element, const Field* current_field);
 
             // Reflection Helpers
             void SerializeComposite(const Composite* composite);
@@ -196,6 +280,25 @@ namespace Helium
             // Reading and writing multiple elements via binary
             static void       ToStream(const V_Element& elements, std::iostream& stream, StatusHandler* status = NULL);
             static void       FromStream(std::iostream& stream, V_Element& elements, StatusHandler* status = NULL);
+
+            // Incremental saving, appends a delta record per element to an existing file (NULL elements are removed)
+            //  Once the log outgrows half of the base archive a background compaction is queued
+            static void       AppendDeltas(const tstring& file, const M_TUIDToElement& elements);
+
+            // Rewrites the file with its delta log folded into the base archive
+            static void       Compact(const tstring& file, StatusHandler* status = NULL);
+
+            // Blocks until queued background compactions are done, and releases the compaction thread
+            static void       CleanupCompaction();
+
+            // Releases the threads shared by parallel reads
+            static void       CleanupParallelRead();
+
+            // Loads the fields of an element that a lazy read left in the file (just the given one if field is not NULL)
+            static void       LoadLazyFields(Element* element, const Field* field = NULL);
+
+            // Forgets the lazy fields of an element that is going away
+            static void       DiscardLazyFields(const Element* element);
         };
     }
 }
\ No newline at end of file
@@ -23,24 +23,21 @@ const u32 ArchiveXML::FIRST_VERSION_WITH_NAMESPACE_SUPPORT          = 3;
 
 ArchiveXML::ArchiveXML(StatusHandler* status)
 : Archive(status)
+, m_Parser (NULL)
 , m_Version (CURRENT_VERSION)
+, m_SkipDepth (0)
 , m_Target (&m_Spool)
 {
-    m_Parser = XML_ParserCreate( Helium::GetEncoding().c_str() );
 
-    // set the user data used in callbacks
-    XML_SetUserData(m_Parser, (void*)this);
-
-    // attach callbacks, will call back to 'this' via user data pointer
-    XML_SetStartElementHandler(m_Parser, &StartElementHandler);
-    XML_SetEndElementHandler(m_Parser, &EndElementHandler);
-    XML_SetCharacterDataHandler(m_Parser, &CharacterDataHandler);
 }
 
 ArchiveXML::~ArchiveXML()
 {
-    XML_ParserFree( m_Parser );
-    m_Parser = NULL;
+    if ( m_Parser )
+    {
+        XML_ParserFree( m_Parser );
+        m_Parser = NULL;
+    }
 }
 
 void ArchiveXML::OpenFile( const tstring& file, bool write )
@@ -110,12 +107,26 @@ void ArchiveXML::Read()
         throw Reflect::StreamException( TXT( "Input stream is empty" ) );
     }
 
+    // the parser is only created here, archives used to deserialize field text never need one
+    if ( m_Parser == NULL )
+    {
+        m_Parser = XML_ParserCreate( Helium::GetEncoding().c_str() );
+
+        // set the user data used in callbacks
+        XML_SetUserData(m_Parser, (void*)this);
+
+        // attach callbacks, will call back to 'this' via user data pointer
+        XML_SetStartElementHandler(m_Parser, &StartElementHandler);
+        XML_SetEndElementHandler(m_Parser, &EndElementHandler);
+        XML_SetCharacterDataHandler(m_Parser, &CharacterDataHandler);
+    }
+
     // setup visitors
     PreDeserialize();
 
     // while there is data, parse buffer
     long step = 0;
-    const unsigned bufferSizeInBytes = 4096;
+    const unsigned bufferSizeInBytes = 64 * 1024;
     while (!m_Stream->Fail() && !m_Abort)
     {
         m_Progress = (int)(((float)(step++ * bufferSizeInBytes) / (float)size) * 100.0f);
@@ -428,6 +439,27 @@ void ArchiveXML::Deserialize(V_Element& elements, u32 flags)
     }
 }
 
+ArchiveXML::ParsingStatePtr ArchiveXML::AcquireState(const tchar* shortName)
+{
+    if ( m_FreeStates.empty() )
+    {
+        return new ParsingState (shortName);
+    }
+
+    ParsingStatePtr state = m_FreeStates.back();
+    m_FreeStates.pop_back();
+    state->Reset( shortName );
+    return state;
+}
+
+void ArchiveXML::ReleaseState(const ParsingStatePtr& state)
+{
+    // drop references now, the rest is cleared when the state is reused
+    state->m_Element = NULL;
+    state->m_Components.clear();
+    m_FreeStates.push_back( state );
+}
+
 void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszAttrs)
 {
     if (m_Abort)
@@ -435,6 +467,13 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
         return;
     }
 
+    // nested within an element we are skipping, just track the depth
+    if (m_SkipDepth)
+    {
+        ++m_SkipDepth;
+        return;
+    }
+
     if ( !_tcscmp(pszName, TXT( "Reflect" ) ) )
     {
         if ( papszAttrs[0] && papszAttrs[1] && papszAttrs[0] && _tcsicmp(papszAttrs[0], TXT( "FileFormatVersion" ) ) == 0 )
@@ -464,7 +503,8 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
     // Find element type
     //
 
-    tstring elementType;
+    tstring& elementType = m_ElementType;
+    elementType.clear();
 
     if ( m_Version < FIRST_VERSION_WITH_NAMESPACE_SUPPORT )
     {
@@ -494,8 +534,8 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
     // We use a stack to track the state of parsing, this will be the new state
     //
 
-    ParsingStatePtr newState = new ParsingState (elementType.c_str());
-    ParsingStatePtr topState = m_StateStack.empty() ? NULL : m_StateStack.top();
+    ParsingStatePtr newState = AcquireState( elementType.c_str() );
+    ParsingState* topState = m_StateStack.empty() ? NULL : m_StateStack.top().Ptr();
 
     //
     // First pass at creation:
@@ -505,7 +545,7 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
     if ( topState && topState->m_Element )
     {
         // pointer to the parent element below which we are nested
-        ElementPtr parentElement = topState->m_Element;
+        const ElementPtr& parentElement = topState->m_Element;
 
         // retrieve the type information for our parent structure
         const Class* parentTypeDefinition = Registry::GetInstance()->GetClass( parentElement->GetType() );
@@ -570,7 +610,18 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
 
         if (newState->m_Element == NULL)
         {
-            Debug( TXT( "Unable to create element with short name: %s\n" ), elementType);
+            Debug( TXT( "Unable to create element with short name: %s\n" ), elementType.c_str());
+
+            // nothing below an element we can't create is used, so skip the whole subtree without
+            //  building any state for it, the parent still gets a null entry for sparse containers
+            if ( topState )
+            {
+                topState->m_Components.push_back( ElementPtr () );
+            }
+
+            ReleaseState( newState );
+            m_SkipDepth = 1;
+            return;
         }
     }
 
@@ -578,7 +629,6 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
     // Do callbacks
     //
 
-    if (newState->m_Element)
     {
         REFLECT_SCOPE_TIMER_INST( ("PreDeserialize %s", newState->m_Element->GetClass()->m_ShortName.c_str()) );
 
@@ -600,12 +650,12 @@ void ArchiveXML::OnStartElement(const XML_Char *pszName, const XML_Char **papszA
 
 void ArchiveXML::OnCharacterData(const XML_Char *pszData, int nLength)
 {
-    if (m_Abort)
+    if (m_Abort || m_SkipDepth)
     {
         return;
     }
 
-    ParsingStatePtr topState = m_StateStack.empty() ? NULL : m_StateStack.top();
+    ParsingState* topState = m_StateStack.empty() ? NULL : m_StateStack.top().Ptr();
     if ( topState && topState->m_Element )
     {
         topState->m_Buffer.append( pszData, nLength );
@@ -619,6 +669,12 @@ void ArchiveXML::OnEndElement(const XML_Char *pszName)
         return;
     }
 
+    if (m_SkipDepth)
+    {
+        --m_SkipDepth;
+        return;
+    }
+
     if (!_tcscmp(pszName, TXT( "Reflect" ) ))
     {
         return;
@@ -649,12 +705,16 @@ void ArchiveXML::OnEndElement(const XML_Char *pszName)
         {
             Serializer* serializer = DangerousCast<Serializer>(topState->m_Element);
 
-            tstringstream stream (topState->m_Buffer);
+            // simple data is decoded straight out of the buffer, everything else goes through a stream
+            if ( !serializer->DeserializeText( topState->m_Buffer.c_str(), topState->m_Buffer.length() ) )
+            {
+                tstringstream stream (topState->m_Buffer);
 
-            ArchiveXML xml (m_Status);
-            xml.m_Stream = new Reflect::TCharStream (&stream); 
-            xml.m_Components = topState->m_Components;
-            serializer->Deserialize(xml);
+                ArchiveXML xml (m_Status);
+                xml.m_Stream = new Reflect::TCharStream (&stream); 
+                xml.m_Components.swap( topState->m_Components );
+                serializer->Deserialize(xml);
+            }
         }
 
         // do callbacks
@@ -673,7 +733,7 @@ void ArchiveXML::OnEndElement(const XML_Char *pszName)
             PostDeserialize( topState->m_Element );
 
             // are we nested within another element?
-            ParsingStatePtr parentState = m_StateStack.empty() ? NULL : m_StateStack.top();
+            ParsingState* parentState = m_StateStack.empty() ? NULL : m_StateStack.top().Ptr();
 
             // if we are we should see if it's being processed and perhaps be added as a component
             if ( parentState != NULL )
@@ -710,7 +770,7 @@ void ArchiveXML::OnEndElement(const XML_Char *pszName)
     // if this is a top level element push the result into the target (even if its null)
     if ( !m_StateStack.empty() )
     {
-        ParsingStatePtr parentState = m_StateStack.top();
+        ParsingState* parentState = m_StateStack.top().Ptr();
 
         parentState->m_Components.push_back(topState->m_Element);
     }
@@ -728,6 +788,8 @@ void ArchiveXML::OnEndElement(const XML_Char *pszName)
             m_Abort |= info.m_Abort;
         }
     }
+
+    ReleaseState( topState );
 }
 
 void ArchiveXML::ToString(const ElementPtr& element, tstring& xml, StatusHandler* status)
@@ -58,6 +58,17 @@ namespace Helium
 
                 }
 
+                // reinitialize a recycled state, keeping the capacity of its buffers
+                void Reset(const tchar* shortName)
+                {
+                    m_ShortName = shortName;
+                    m_Buffer.clear();
+                    m_Field = NULL;
+                    m_Element = NULL;
+                    m_Components.clear();
+                    m_Flags = 0;
+                }
+
                 void SetFlag( ProcessFlag flag, bool state )
                 {
                     if ( state )
@@ -89,6 +100,15 @@ namespace Helium
             // The nesting stack of parsing state
             std::stack<ParsingStatePtr> m_StateStack;
 
+            // Parsing states recycled from finished elements
+            std::vector<ParsingStatePtr> m_FreeStates;
+
+            // Scratch space for the type of the element being started
+            tstring m_ElementType;
+
+            // Nesting depth within an element we could not create, which is skipped entirely
+            u32 m_SkipDepth;
+
             // The current name of the serializing field
             std::stack<tstring> m_FieldNames;
 
@@ -161,6 +181,11 @@ namespace Helium
             virtual void Deserialize(ElementPtr& element);
             virtual void Deserialize(V_Element& elements, u32 flags = 0);
 
+        private:
+            // Parsing state management
+            ParsingStatePtr AcquireState(const tchar* shortName);
+            void ReleaseState(const ParsingStatePtr& state);
+
         private:
             static void StartElementHandler(void *pUserData, const tchar* pszName, const tchar **papszAttrs)
             {
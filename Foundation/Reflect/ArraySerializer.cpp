@@ -2,6 +2,7 @@
 #include "Compression.h" 
 #include "ArchiveBinary.h"
 #include "ArchiveXML.h"
+#include "TextParse.h"
 
 using namespace Helium;
 using namespace Helium::Reflect;
@@ -261,7 +262,7 @@ void SimpleArraySerializer<T>::Serialize(Archive& archive) const
                 binary.GetStream().Write(&bytesWritten); 
 
                 const T& front = m_Data->front();
-                bytesWritten   = CompressToStream(binary.GetStream(), (const char*) &front, sizeof(T) * count); 
+                bytesWritten   = CompressBlocksToStream(binary.GetStream(), (const char*) &front, sizeof(T) * count); 
 
                 binary.GetStream().SeekWrite(offset, std::ios_base::beg); 
                 binary.GetStream().Write(&bytesWritten); 
@@ -321,7 +322,17 @@ void SimpleArraySerializer<T>::Deserialize(Archive& archive)
                 {
                     i32 inputBytes; 
                     binary.GetStream().Read(&inputBytes); 
-                    i32 bytesInflated = DecompressFromStream(binary.GetStream(), inputBytes, (char*) &(m_Data->front()), sizeof(T) * count); 
+
+                    i32 bytesInflated = 0; 
+                    if(archiveBinary->GetVersion() >= ArchiveBinary::FIRST_VERSION_WITH_BLOCK_COMPRESSION)
+                    {
+                        bytesInflated = DecompressBlocksFromStream(binary.GetStream(), inputBytes, (char*) &(m_Data->front()), sizeof(T) * count); 
+                    }
+                    else
+                    {
+                        bytesInflated = DecompressFromStream(binary.GetStream(), inputBytes, (char*) &(m_Data->front()), sizeof(T) * count); 
+                    }
+
                     if(bytesInflated != sizeof(T) * count)
                     {
                         throw Reflect::StreamException( TXT( "Compressed Array size mismatch" ) ); 
@@ -337,6 +348,32 @@ void SimpleArraySerializer<T>::Deserialize(Archive& archive)
     }
 }
 
+template < class T >
+bool SimpleArraySerializer<T>::DeserializeText(const tchar* text, size_t length)
+{
+    m_Data->clear();
+
+    const tchar* cursor = text;
+    SkipTextSpace( cursor );
+
+    T value;
+    while ( *cursor )
+    {
+        if ( !ParseText( cursor, value ) )
+        {
+            // let the stream path deal with it
+            m_Data->clear();
+            return false;
+        }
+
+        m_Data->push_back( value );
+
+        SkipTextSpace( cursor );
+    }
+
+    return true;
+}
+
 template < class T >
 tostream& SimpleArraySerializer<T>::operator>> (tostream& stream) const
 {
@@ -487,7 +524,7 @@ void StringArraySerializer::Deserialize(Archive& archive)
             {
                 i32 index;
                 binary.GetStream().Read(&index); 
-                m_Data.Ref()[i] = binary.GetStrings().Get(index);
+                binary.GetStrings().Get(index, m_Data.Ref()[i]);
             }
 
             break;
@@ -537,6 +574,19 @@ tistream& SimpleArraySerializer<i8>::operator<< (tistream& stream)
 }
 #endif // UNICODE
 
+// these are written as characters, not numbers
+template <>
+bool SimpleArraySerializer<u8>::DeserializeText(const tchar* text, size_t length)
+{
+    return false;
+}
+
+template <>
+bool SimpleArraySerializer<i8>::DeserializeText(const tchar* text, size_t length)
+{
+    return false;
+}
+
 template SimpleArraySerializer<tstring>;
 template SimpleArraySerializer<bool>;
 template SimpleArraySerializer<u8>;
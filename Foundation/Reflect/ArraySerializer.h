@@ -58,6 +58,7 @@ namespace Helium
 
             virtual void Serialize(Archive& archive) const HELIUM_OVERRIDE;
             virtual void Deserialize(Archive& archive) HELIUM_OVERRIDE;
+            virtual bool DeserializeText(const tchar* text, size_t length) HELIUM_OVERRIDE;
 
             virtual tostream& operator>> (tostream& stream) const HELIUM_OVERRIDE;
             virtual tistream& operator<< (tistream& stream) HELIUM_OVERRIDE;
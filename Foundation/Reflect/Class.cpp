@@ -10,6 +10,7 @@ using namespace Helium::Reflect;
 
 Class::Class()
 : m_Create (NULL)
+, m_Pool (NULL)
 {
 
 }
@@ -10,6 +10,7 @@ namespace Helium
     {
         class Field;
         class Class;
+        class ObjectPool;
 
 
         //
@@ -22,6 +23,7 @@ namespace Helium
             REFLECTION_TYPE( ReflectionTypes::Class );
 
             CreateObjectFunc      m_Create;             // factory function for creating instances of this class
+            ObjectPool*           m_Pool;               // allocator for instances created through the registry
 
         protected:
             Class();
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "Composite.h"
 #include "Element.h"
 #include "Registry.h"
@@ -175,6 +177,45 @@ Reflect::EnumerationField* Composite::AddEnumerationField(Element& instance, con
     return fieldInfo;
 }
 
+void Composite::AddPlainDataField(Element& instance, Reflect::Field* field)
+{
+    field->m_PlainData = true;
+
+    // capture the default value from the instance we are enumerating with
+    u32 offset = (u32)field->m_Offset;
+    if ( m_PlainDataDefaults.size() < offset + field->m_Size )
+    {
+        m_PlainDataDefaults.resize( offset + field->m_Size );
+    }
+    memcpy( &m_PlainDataDefaults[ offset ], reinterpret_cast<const u8*>( &instance ) + offset, field->m_Size );
+
+    // extend the current run if this field directly follows it, there can't be padding inside a run
+    if ( !m_PlainDataRuns.empty() )
+    {
+        PlainDataRun& run = m_PlainDataRuns.back();
+        if ( run.m_LastFieldID + 1 == field->m_FieldID && run.m_Offset + run.m_Size == offset )
+        {
+            run.m_Size += field->m_Size;
+            run.m_LastFieldID = field->m_FieldID;
+            return;
+        }
+    }
+
+    PlainDataRun run;
+    run.m_Offset = offset;
+    run.m_Size = field->m_Size;
+    run.m_FirstFieldID = field->m_FieldID;
+    run.m_LastFieldID = field->m_FieldID;
+    m_PlainDataRuns.push_back( run );
+}
+
+bool Composite::HasDefaultPlainData(const Element* instance, const Reflect::Field* field) const
+{
+    HELIUM_ASSERT( field->m_PlainData && field->m_Type == this );
+
+    return memcmp( reinterpret_cast<const u8*>( instance ) + field->m_Offset, &m_PlainDataDefaults[ field->m_Offset ], field->m_Size ) == 0;
+}
+
 void Composite::Report() const
 {
     static tchar buf[8192];
@@ -285,12 +326,29 @@ bool Composite::Equals(const Element* a, const Element* b)
     }
     else
     {
+        // plain data is compared bitwise, a whole run at a time
+        V_PlainDataRun::const_iterator runItr = type->m_PlainDataRuns.begin();
+        V_PlainDataRun::const_iterator runEnd = type->m_PlainDataRuns.end();
+        for ( ; runItr != runEnd; ++runItr )
+        {
+            if ( memcmp( reinterpret_cast<const u8*>( a ) + runItr->m_Offset, reinterpret_cast<const u8*>( b ) + runItr->m_Offset, runItr->m_Size ) != 0 )
+            {
+                return false;
+            }
+        }
+
         M_FieldIDToInfo::const_iterator itr = type->m_FieldIDToInfo.begin();
         M_FieldIDToInfo::const_iterator end = type->m_FieldIDToInfo.end();
         for ( ; itr != end; ++itr )
         {
             const Field* field = itr->second;
 
+            // already compared above
+            if ( field->m_PlainData )
+            {
+                continue;
+            }
+
             // create serializers
             SerializerPtr aSerializer = field->CreateSerializer();
             SerializerPtr bSerializer = field->CreateSerializer();
@@ -409,12 +467,26 @@ void Composite::Copy( const Element* src, Element* dest )
     }
     else
     {
+        // plain data is copied as raw memory, a whole run at a time
+        V_PlainDataRun::const_iterator runItr = type->m_PlainDataRuns.begin();
+        V_PlainDataRun::const_iterator runEnd = type->m_PlainDataRuns.end();
+        for ( ; runItr != runEnd; ++runItr )
+        {
+            memcpy( reinterpret_cast<u8*>( dest ) + runItr->m_Offset, reinterpret_cast<const u8*>( src ) + runItr->m_Offset, runItr->m_Size );
+        }
+
         M_FieldIDToInfo::const_iterator itr = type->m_FieldIDToInfo.begin();
         M_FieldIDToInfo::const_iterator end = type->m_FieldIDToInfo.end();
         for ( ; itr != end; ++itr )
         {
             const Field* field = itr->second;
 
+            // already copied above
+            if ( field->m_PlainData )
+            {
+                continue;
+            }
+
             // create serializers
             SerializerPtr lhs = field->CreateSerializer();
             SerializerPtr rhs = field->CreateSerializer();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <typeinfo>
+#include <vector>
 
 #include "Type.h"
 #include "Field.h"
@@ -44,6 +45,21 @@ namespace Helium
         typedef void (*CompositeEnumerator)(void* type);
 
 
+        //
+        // PlainDataRun is a span of adjacent plain data fields (in both field id and memory layout),
+        //  the whole span is copied and compared with a single memcpy/memcmp
+        //
+
+        struct PlainDataRun
+        {
+            u32 m_Offset;           // offset of the first field in the run
+            u32 m_Size;             // total size of the run in bytes
+            i32 m_FirstFieldID;     // id of the first field in the run
+            i32 m_LastFieldID;      // id of the last field in the run
+        };
+        typedef std::vector< PlainDataRun > V_PlainDataRun;
+
+
         //
         // Composite (struct or class)
         //
@@ -67,6 +83,9 @@ namespace Helium
             i32                   m_LastFieldID;        // last field id of this class's fields (exclusive of base and derived class's fields)
             i32                   m_NextFieldID;        // id used for the next field (as we are enumerating)
 
+            V_PlainDataRun        m_PlainDataRuns;      // runs of plain data fields, in field id order
+            std::vector< u8 >     m_PlainDataDefaults;  // default values of plain data fields (indexed by field offset)
+
         protected:
             Composite();
             virtual ~Composite();
@@ -146,6 +165,12 @@ namespace Helium
             Reflect::ElementField* AddElementField ( Element& instance, const std::string& name, const u32 offset, u32 size, i32 serializerID, i32 typeID, i32 flags = 0 );
             Reflect::EnumerationField* AddEnumerationField ( Element& instance, const std::string& name, const u32 offset, u32 size, i32 serializerID, const std::string& enumName, i32 flags = 0 );
 
+            // marks a field as plain data, folding it into the run of the previous field when they are adjacent
+            void AddPlainDataField ( Element& instance, Reflect::Field* field );
+
+            // checks to see if a plain data field matches its default value in the passed object
+            bool HasDefaultPlainData ( const Element* instance, const Reflect::Field* field ) const;
+
             //
             // Report information to stdout
             //
@@ -266,13 +291,21 @@ namespace Helium
             template <class FieldT>
             inline Reflect::Field* AddField( FieldT T::* field, const std::string& name, i32 flags = 0, i32 serializerType = -1 )
             {
-                return m_Composite.AddField(
+                Reflect::Field* result = m_Composite.AddField(
                     m_Instance,
                     GetName(name),
                     GetOffset(field),
                     sizeof(FieldT),
                     serializerType < 0 ? Reflect::GetType<FieldT>() : serializerType,
                     flags );
+
+                // custom serializers may not treat the data as raw memory
+                if ( PlainDataTraits<FieldT>::IsPlainData && serializerType < 0 )
+                {
+                    m_Composite.AddPlainDataField( m_Instance, result );
+                }
+
+                return result;
             }
 
             template <class FieldT>
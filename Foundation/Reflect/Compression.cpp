@@ -1,13 +1,21 @@
 #include "Compression.h" 
 #include "Exceptions.h" 
 
+#include "Platform/Mutex.h"
+#include "Platform/Condition.h"
+#include "Foundation/ThreadPool.h"
+
 #include <zlib.h> 
+#include <string.h>
 
 using namespace Helium;
 using namespace Helium::Reflect;
 
 static const u32 ZLIB_BUFFER_SIZE = 16 * 1024; 
 
+// don't bother with threads unless we have at least this many blocks to inflate
+static const u32 PARALLEL_INFLATE_MIN_BLOCKS = 4; 
+
 // helper struct to make zlib deflate initialization exception-safe: 
 //
 struct zlibOutputStream : public z_stream
@@ -113,6 +121,30 @@ int Reflect::DecompressFromStream(CharStream& reflectStream, int inputBytes, cha
     zStream.avail_out = outputBytes; 
     zStream.next_out  = (Bytef*) output; 
 
+    // if the stream is backed by memory, inflate straight out of it in one pass
+    const char* input = reflectStream.PeekBuffer(inputBytes); 
+    if(input)
+    {
+        zStream.avail_in = inputBytes; 
+        zStream.next_in  = (Bytef*) input; 
+
+        int ret = inflate(&zStream, Z_FINISH); 
+
+        if(ret == Z_BUF_ERROR && zStream.avail_out == 0)
+        {
+            throw Helium::Exception( TXT( "zlib decompression overflow" ) ); 
+        }
+
+        if(ret != Z_STREAM_END)
+        {
+            throw Helium::Exception( TXT( "zlib error while decompressing" ) ); 
+        }
+
+        reflectStream.SeekRead(inputBytes, std::ios_base::cur); 
+
+        return outputBytes - zStream.avail_out; 
+    }
+
     int bytesRemaining = inputBytes; 
 
     // again, this is pretty simple case because we know both 
@@ -156,3 +188,422 @@ int Reflect::DecompressFromStream(CharStream& reflectStream, int inputBytes, cha
     int bytesDecompressed = outputBytes - zStream.avail_out; 
     return bytesDecompressed; 
 }
+
+// compresses a single block and writes it to the stream, returns bytes written
+//
+static u32 CompressBlock(CharStream& reflectStream, const char* data, u32 size, std::vector< char >& compressed)
+{
+    uLongf compressedSize = compressBound(size); 
+    if(compressed.size() < compressedSize)
+    {
+        compressed.resize(compressedSize); 
+    }
+
+    int ret = compress2((Bytef*) &compressed[0], &compressedSize, (const Bytef*) data, size, Z_DEFAULT_COMPRESSION); 
+    if( ret != Z_OK )
+    {
+        throw Helium::Exception( TXT( "zlib error while compressing" ) ); 
+    }
+
+    i32 blockSize = (i32)size; 
+    u32 blockCompressedSize = (u32)compressedSize; 
+    reflectStream.Write(&blockSize); 
+    reflectStream.Write(&blockCompressedSize); 
+    reflectStream.WriteBuffer(&compressed[0], blockCompressedSize); 
+
+    return sizeof(blockSize) + sizeof(blockCompressedSize) + blockCompressedSize; 
+}
+
+// terminates a block list, returns bytes written
+//
+static u32 TerminateBlocks(CharStream& reflectStream)
+{
+    i32 term = -1; 
+    reflectStream.Write(&term); 
+    return sizeof(term); 
+}
+
+// inflates a single block, the block must inflate to exactly outputBytes
+//
+static bool InflateBlock(const char* input, u32 inputBytes, char* output, u32 outputBytes)
+{
+    uLongf inflatedSize = outputBytes; 
+    int ret = uncompress((Bytef*) output, &inflatedSize, (const Bytef*) input, inputBytes); 
+    return ret == Z_OK && inflatedSize == outputBytes; 
+}
+
+int Reflect::CompressBlocksToStream(CharStream& reflectStream, const char* data, u32 size)
+{
+    REFLECT_SCOPE_TIMER((""));
+
+    std::vector< char > compressed; 
+
+    u32 totalOut = 0; 
+    for(u32 offset = 0; offset < size; offset += COMPRESSION_BLOCK_SIZE)
+    {
+        totalOut += CompressBlock(reflectStream, data + offset, std::min(size - offset, COMPRESSION_BLOCK_SIZE), compressed); 
+    }
+
+    totalOut += TerminateBlocks(reflectStream); 
+
+    return totalOut; 
+}
+
+namespace
+{
+    struct CompressedBlock
+    {
+        const char* m_Input; 
+        u32         m_InputBytes; 
+        char*       m_Output; 
+        u32         m_OutputBytes; 
+    };
+
+    // shared by the calling thread and any pool threads that help out, the last one out deletes it
+    struct InflateJob
+    {
+        std::vector< CompressedBlock >  m_Blocks; 
+        Helium::Mutex                   m_Mutex; 
+        Helium::Condition               m_Done; 
+        u32                             m_Next; 
+        u32                             m_Remaining; 
+        u32                             m_References; 
+        bool                            m_Failed; 
+    };
+}
+
+static Helium::Mutex        g_InflatePoolMutex; 
+static Helium::ThreadPool*  g_InflatePool = NULL; 
+
+static Helium::ThreadPool* GetInflatePool()
+{
+    Helium::TakeMutex mutex (g_InflatePoolMutex); 
+
+    if(!g_InflatePool)
+    {
+        g_InflatePool = new Helium::ThreadPool (0, "Reflect Inflate Thread"); 
+    }
+
+    return g_InflatePool; 
+}
+
+void Reflect::CleanupCompression()
+{
+    Helium::TakeMutex mutex (g_InflatePoolMutex); 
+
+    delete g_InflatePool; 
+    g_InflatePool = NULL; 
+}
+
+static void ReleaseInflateJob(InflateJob* job)
+{
+    bool last = false; 
+
+    {
+        Helium::TakeMutex mutex (job->m_Mutex); 
+        last = --job->m_References == 0; 
+    }
+
+    if(last)
+    {
+        delete job; 
+    }
+}
+
+// inflates blocks until there are none left to claim
+//
+static void InflateBlocks(InflateJob* job)
+{
+    while(1)
+    {
+        u32 index = 0; 
+
+        {
+            Helium::TakeMutex mutex (job->m_Mutex); 
+
+            if(job->m_Next >= job->m_Blocks.size())
+            {
+                return; 
+            }
+
+            index = job->m_Next++; 
+        }
+
+        const CompressedBlock& block = job->m_Blocks[index]; 
+        bool ok = InflateBlock(block.m_Input, block.m_InputBytes, block.m_Output, block.m_OutputBytes); 
+
+        {
+            Helium::TakeMutex mutex (job->m_Mutex); 
+
+            if(!ok)
+            {
+                job->m_Failed = true; 
+            }
+
+            if(--job->m_Remaining == 0)
+            {
+                job->m_Done.Signal(); 
+            }
+        }
+    }
+}
+
+static void InflateBlocksTask(void* param)
+{
+    InflateJob* job = static_cast< InflateJob* >( param ); 
+
+    InflateBlocks(job); 
+    ReleaseInflateJob(job); 
+}
+
+int Reflect::DecompressBlocksFromStream(CharStream& reflectStream, int inputBytes, char* output, int outputBytes)
+{
+    REFLECT_SCOPE_TIMER((""));
+
+    u32 inflatedSize = 0; 
+
+    // if the stream is backed by memory, index the blocks and inflate them straight out of it
+    const char* input = reflectStream.PeekBuffer(inputBytes); 
+    if(input)
+    {
+        std::vector< CompressedBlock > blocks; 
+
+        const char* cursor = input; 
+        const char* end = input + inputBytes; 
+        while(1)
+        {
+            i32 blockSize = -1; 
+            if(cursor + sizeof(blockSize) > end)
+            {
+                throw Reflect::StreamException( TXT( "Compressed block list is truncated" ) ); 
+            }
+
+            memcpy(&blockSize, cursor, sizeof(blockSize)); 
+            cursor += sizeof(blockSize); 
+
+            if(blockSize < 0)
+            {
+                break; 
+            }
+
+            CompressedBlock block; 
+            if(cursor + sizeof(block.m_InputBytes) > end)
+            {
+                throw Reflect::StreamException( TXT( "Compressed block list is truncated" ) ); 
+            }
+
+            memcpy(&block.m_InputBytes, cursor, sizeof(block.m_InputBytes)); 
+            cursor += sizeof(block.m_InputBytes); 
+
+            if(block.m_InputBytes > (u32)(end - cursor))
+            {
+                throw Reflect::StreamException( TXT( "Compressed block list is truncated" ) ); 
+            }
+
+            if((u32)blockSize > (u32)outputBytes - inflatedSize)
+            {
+                throw Helium::Exception( TXT( "zlib decompression overflow" ) ); 
+            }
+
+            block.m_Input = cursor; 
+            block.m_Output = output + inflatedSize; 
+            block.m_OutputBytes = blockSize; 
+            blocks.push_back(block); 
+
+            cursor += block.m_InputBytes; 
+            inflatedSize += blockSize; 
+        }
+
+        if(blocks.size() < PARALLEL_INFLATE_MIN_BLOCKS)
+        {
+            std::vector< CompressedBlock >::const_iterator itr = blocks.begin(); 
+            std::vector< CompressedBlock >::const_iterator itrEnd = blocks.end(); 
+            for( ; itr != itrEnd; ++itr )
+            {
+                if(!InflateBlock(itr->m_Input, itr->m_InputBytes, itr->m_Output, itr->m_OutputBytes))
+                {
+                    throw Helium::Exception( TXT( "zlib error while decompressing" ) ); 
+                }
+            }
+        }
+        else
+        {
+            InflateJob* job = new InflateJob; 
+            job->m_Blocks.swap(blocks); 
+            job->m_Next = 0; 
+            job->m_Remaining = (u32)job->m_Blocks.size(); 
+            job->m_References = 1; 
+            job->m_Failed = false; 
+
+            Helium::ThreadPool* pool = GetInflatePool(); 
+
+            // we do our share of the work too, so one less helper than there are blocks
+            u32 helpers = std::min< u32 >( pool->GetThreadCount(), (u32)job->m_Blocks.size() - 1 ); 
+
+            job->m_References += helpers; 
+            for(u32 i=0; i<helpers; ++i)
+            {
+                pool->Queue(&InflateBlocksTask, job); 
+            }
+
+            InflateBlocks(job); 
+
+            // helpers that run after all the blocks are claimed just drop their reference
+            job->m_Done.Wait(); 
+            bool failed = job->m_Failed; 
+            ReleaseInflateJob(job); 
+
+            if(failed)
+            {
+                throw Helium::Exception( TXT( "zlib error while decompressing" ) ); 
+            }
+        }
+
+        reflectStream.SeekRead(inputBytes, std::ios_base::cur); 
+
+        return inflatedSize; 
+    }
+
+    // otherwise read and inflate one block at a time
+    std::vector< char > compressed; 
+    while(1)
+    {
+        i32 blockSize = -1; 
+        reflectStream.Read(&blockSize); 
+
+        if(blockSize < 0)
+        {
+            break; 
+        }
+
+        u32 compressedSize = 0; 
+        reflectStream.Read(&compressedSize); 
+
+        if((u32)blockSize > (u32)outputBytes - inflatedSize)
+        {
+            throw Helium::Exception( TXT( "zlib decompression overflow" ) ); 
+        }
+
+        compressed.resize(std::max< u32 >(compressedSize, 1)); 
+        reflectStream.ReadBuffer(&compressed[0], compressedSize); 
+
+        if(!InflateBlock(&compressed[0], compressedSize, output + inflatedSize, blockSize))
+        {
+            throw Helium::Exception( TXT( "zlib error while decompressing" ) ); 
+        }
+
+        inflatedSize += blockSize; 
+    }
+
+    return inflatedSize; 
+}
+
+CompressionStreamBuffer::CompressionStreamBuffer(CharStream& stream)
+: m_Stream (stream)
+, m_Size (0)
+, m_CompressedSize (0)
+{
+    m_Block.resize(COMPRESSION_BLOCK_SIZE); 
+    setp(&m_Block[0], &m_Block[0] + m_Block.size()); 
+}
+
+CompressionStreamBuffer::~CompressionStreamBuffer()
+{
+
+}
+
+u32 CompressionStreamBuffer::Finish()
+{
+    FlushBlock(); 
+    m_CompressedSize += TerminateBlocks(m_Stream); 
+
+    return m_CompressedSize; 
+}
+
+CompressionStreamBuffer::int_type CompressionStreamBuffer::overflow(int_type c)
+{
+    FlushBlock(); 
+
+    if(!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c); 
+        pbump(1); 
+    }
+
+    return traits_type::not_eof(c); 
+}
+
+void CompressionStreamBuffer::FlushBlock()
+{
+    u32 size = (u32)(pptr() - pbase()); 
+    if(size > 0)
+    {
+        m_CompressedSize += CompressBlock(m_Stream, pbase(), size, m_Compressed); 
+        m_Size += size; 
+    }
+
+    setp(&m_Block[0], &m_Block[0] + m_Block.size()); 
+}
+
+DecompressionStreamBuffer::DecompressionStreamBuffer(CharStream& stream)
+: m_Stream (stream)
+, m_Size (0)
+, m_Done (false)
+{
+
+}
+
+DecompressionStreamBuffer::int_type DecompressionStreamBuffer::underflow()
+{
+    if(gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr()); 
+    }
+
+    if(m_Done)
+    {
+        return traits_type::eof(); 
+    }
+
+    i32 blockSize = -1; 
+    m_Stream.Read(&blockSize); 
+
+    if(blockSize < 0)
+    {
+        m_Done = true; 
+        return traits_type::eof(); 
+    }
+
+    u32 compressedSize = 0; 
+    m_Stream.Read(&compressedSize); 
+
+    if(blockSize == 0 || (u32)blockSize > COMPRESSION_BLOCK_SIZE)
+    {
+        throw Helium::Exception( TXT( "zlib decompression overflow" ) ); 
+    }
+
+    m_Block.resize(blockSize); 
+
+    // inflate straight out of memory backed streams
+    const char* input = m_Stream.PeekBuffer(compressedSize); 
+    if(input)
+    {
+        m_Stream.SeekRead(compressedSize, std::ios_base::cur); 
+    }
+    else
+    {
+        m_Compressed.resize(std::max< u32 >(compressedSize, 1)); 
+        m_Stream.ReadBuffer(&m_Compressed[0], compressedSize); 
+        input = &m_Compressed[0]; 
+    }
+
+    if(!InflateBlock(input, compressedSize, &m_Block[0], blockSize))
+    {
+        throw Helium::Exception( TXT( "zlib error while decompressing" ) ); 
+    }
+
+    m_Size += blockSize; 
+    setg(&m_Block[0], &m_Block[0], &m_Block[0] + blockSize); 
+
+    return traits_type::to_int_type(*gptr()); 
+}
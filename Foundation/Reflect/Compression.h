@@ -1,16 +1,102 @@
 #pragma once
 
+#include <vector>
+
 #include "API.h" 
 #include "Stream.h" 
 
+//
+//  Block Compression Binary Format:
+//
+//  struct Block
+//  {
+//      i32 size;               // uncompressed size, -1 terminates the block list
+//      u32 compressed_size;    // size of the zlib data
+//      byte[] data;            // independent zlib stream
+//  };
+//
+//  Blocks hold at most COMPRESSION_BLOCK_SIZE uncompressed bytes, so writers never buffer
+//  more than a single block and readers can inflate the blocks in any order (or all at once)
+//
+
 namespace Helium
 {
     namespace Reflect
     {
+        const u32 COMPRESSION_BLOCK_SIZE = 128 * 1024; 
+
         // returns the size of the compressed data. 
         int CompressToStream(Reflect::CharStream& reflectStream, const char* data, u32 size);
 
         // returns number of bytes written to the output (after decompression)
         int DecompressFromStream(Reflect::CharStream& reflectStream, int inputBytes, char* output, int outputBytes);
+
+        // returns the size of the compressed blocks, including the terminator
+        int CompressBlocksToStream(Reflect::CharStream& reflectStream, const char* data, u32 size);
+
+        // returns number of bytes written to the output (after decompression), large inputs are inflated in parallel
+        int DecompressBlocksFromStream(Reflect::CharStream& reflectStream, int inputBytes, char* output, int outputBytes);
+
+        // shuts down the threads used for parallel decompression
+        void CleanupCompression();
+
+        //
+        // Stream buffer that compresses everything written to it into blocks in the target stream
+        //  Call Finish() once all the data has been written to flush the last block and terminate the list
+        //
+
+        class FOUNDATION_API CompressionStreamBuffer : public std::basic_streambuf< char >
+        {
+        public:
+            CompressionStreamBuffer( CharStream& stream );
+            ~CompressionStreamBuffer();
+
+            // returns the size of the compressed blocks, including the terminator
+            u32 Finish();
+
+            // uncompressed bytes written so far
+            u32 GetSize() const
+            {
+                return m_Size + (u32)( pptr() - pbase() );
+            }
+
+        protected:
+            virtual int_type overflow( int_type c ) HELIUM_OVERRIDE;
+
+        private:
+            void FlushBlock();
+
+            CharStream&         m_Stream;
+            std::vector< char > m_Block;
+            std::vector< char > m_Compressed;
+            u32                 m_Size;
+            u32                 m_CompressedSize;
+        };
+
+        //
+        // Stream buffer that reads blocks from the source stream and inflates them one at a time
+        //
+
+        class FOUNDATION_API DecompressionStreamBuffer : public std::basic_streambuf< char >
+        {
+        public:
+            DecompressionStreamBuffer( CharStream& stream );
+
+            // uncompressed bytes inflated so far
+            u32 GetSize() const
+            {
+                return m_Size;
+            }
+
+        protected:
+            virtual int_type underflow() HELIUM_OVERRIDE;
+
+        private:
+            CharStream&         m_Stream;
+            std::vector< char > m_Block;
+            std::vector< char > m_Compressed;
+            u32                 m_Size;
+            bool                m_Done;
+        };
     }
-}
\ No newline at end of file
+}
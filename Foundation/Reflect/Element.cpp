@@ -22,6 +22,15 @@ Element::Element()
 
 }
 
+Element::~Element()
+{
+    // a lazy read may have left some of our fields in a file
+    if ( g_LazyElementCount )
+    {
+        ArchiveBinary::DiscardLazyFields( this );
+    }
+}
+
 bool Element::ProcessComponent(ElementPtr element, const tstring& fieldName)
 {
     return false; // incurs data loss
@@ -70,6 +70,8 @@ namespace Helium
             Element ();
 
         public:
+            virtual ~Element();
+
             // Reflection prototypes
             static void EnumerateClass( Reflect::Compositor<Element>& comp );
 
@@ -158,11 +158,11 @@ void EnumerationSerializer::Deserialize(Archive& archive)
 
             if (index >= 0)
             {
-                const tstring& str (binary.GetStrings().Get(index));
+                const tchar* str = binary.GetStrings().Get(index);
 
                 if (m_Enumeration && !m_Enumeration->GetElementValue(str, m_Data.Ref()))
                 {
-                    binary.Debug( TXT( "Unable to deserialize %s::%s, discarding\n" ), m_Enumeration->m_ShortName.c_str(), str.c_str() );
+                    binary.Debug( TXT( "Unable to deserialize %s::%s, discarding\n" ), m_Enumeration->m_ShortName.c_str(), str );
                 }
                 else
                 {
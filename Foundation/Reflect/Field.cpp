@@ -14,6 +14,7 @@ Field::Field(const Composite* type)
 , m_SerializerID ( ReservedTypes::Invalid )
 , m_Offset ( -1 )
 , m_Create ( NULL )
+, m_PlainData ( false )
 {
 
 }
@@ -11,6 +11,22 @@
 
 namespace Helium
 {
+    class GUID;
+    class TUID;
+
+    namespace Math
+    {
+        class Vector2;
+        class Vector3;
+        class Vector4;
+        class Matrix3;
+        class Matrix4;
+        class Quaternion;
+        class Color3;
+        class Color4;
+        class HDRColor4;
+    }
+
     namespace Reflect
     {
         //
@@ -38,6 +54,49 @@ namespace Helium
         }
 
 
+        //
+        // PlainDataTraits marks field types that are trivially copyable and free of padding, these are
+        //  copied, compared, and binary serialized as raw memory instead of through a Serializer
+        //
+
+        template< class T >
+        struct PlainDataTraits
+        {
+            static const bool IsPlainData = false;
+        };
+
+#define REFLECT_SPECIALIZE_PLAIN_DATA(Type) \
+template<> struct PlainDataTraits< Type > \
+{ \
+    static const bool IsPlainData = true; \
+}
+
+        // these live with the primary template so every translation unit that registers a field sees the same answer
+        // HDRColor3 is left out since it has a padding byte between the color and the scale
+        REFLECT_SPECIALIZE_PLAIN_DATA( bool );
+        REFLECT_SPECIALIZE_PLAIN_DATA( u8 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( i8 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( u16 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( i16 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( u32 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( i32 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( u64 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( i64 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( f32 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( f64 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Helium::GUID );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Helium::TUID );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Vector2 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Vector3 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Vector4 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Matrix3 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Matrix4 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Quaternion );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Color3 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::Color4 );
+        REFLECT_SPECIALIZE_PLAIN_DATA( Math::HDRColor4 );
+
+
         //
         // Field, fully qualified field information
         //
@@ -57,6 +116,7 @@ namespace Helium
             i32                 m_SerializerID; // type id of the serializer to use
             SerializerPtr       m_Default;      // the value of the default
             CreateObjectFunc    m_Create;       // function to create a new instance for this field (optional)
+            bool                m_PlainData;    // the field is plain data (see PlainDataTraits)
 
         protected:
             Field(const Composite* type);
@@ -2,6 +2,7 @@
 #include "Registry.h"
 #include "Class.h"
 #include "Serializer.h"
+#include "ObjectPool.h"
 
 #include "Platform/Atomic.h"
 
@@ -32,6 +33,9 @@ Object::~Object()
     }
 }
 
+// padded to keep the alignment malloc gives us
+const u32 Object::ALLOCATION_HEADER_SIZE = 2 * sizeof(void*);
+
 void* Object::operator new(size_t bytes)
 {
     if (Reflect::MemoryPool().Valid())
@@ -39,7 +43,28 @@ void* Object::operator new(size_t bytes)
         Profile::Memory::Allocate( Reflect::MemoryPool(), (u32)bytes );
     }
 
-    return ::malloc( bytes );
+    // only the first allocation after arming (the object being created) comes from the pool
+    ObjectPool* pool = ObjectPool::Disarm();
+
+    void* block = NULL;
+    if ( pool && bytes + ALLOCATION_HEADER_SIZE <= pool->GetBlockSize() )
+    {
+        block = pool->Allocate();
+    }
+    else
+    {
+        pool = NULL;
+        block = ::malloc( bytes + ALLOCATION_HEADER_SIZE );
+
+        if ( !block )
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    *static_cast< ObjectPool** >( block ) = pool;
+
+    return static_cast< u8* >( block ) + ALLOCATION_HEADER_SIZE;
 }
 
 void Object::operator delete(void *ptr, size_t bytes)
@@ -49,7 +74,22 @@ void Object::operator delete(void *ptr, size_t bytes)
         Profile::Memory::Deallocate( Reflect::MemoryPool(), (u32)bytes );
     }
 
-    ::free(ptr);
+    if ( !ptr )
+    {
+        return;
+    }
+
+    void* block = static_cast< u8* >( ptr ) - ALLOCATION_HEADER_SIZE;
+
+    ObjectPool* pool = *static_cast< ObjectPool** >( block );
+    if ( pool )
+    {
+        pool->Free( block );
+    }
+    else
+    {
+        ::free( block );
+    }
 }
 
 i32 Object::GetType() const
@@ -37,6 +37,9 @@ namespace Helium
             // Memory
             //
 
+            // every allocation is prefixed with the pool it came from (NULL for the heap)
+            static const u32 ALLOCATION_HEADER_SIZE;
+
             void* operator new(size_t bytes);
             void operator delete(void *ptr, size_t bytes);
 
@@ -0,0 +1,271 @@
+#include "ObjectPool.h"
+
+#include "Platform/Assert.h"
+#include "Platform/Atomic.h"
+#include "Platform/Thread.h"
+#include "Foundation/Log.h"
+
+#include <malloc.h>
+
+using namespace Helium;
+using namespace Helium::Reflect;
+
+// uncomment to have every thread share the pool's free list
+//#define REFLECT_DISABLE_OBJECT_POOL_MAGAZINES
+
+// Slabs are at least this big, and hold at least a few blocks
+const u32 OBJECT_POOL_SLAB_SIZE = 64 * 1024;
+const u32 OBJECT_POOL_SLAB_MIN_BLOCKS = 8;
+
+// Blocks are aligned to this (the same alignment malloc gives us)
+const u32 OBJECT_POOL_ALIGNMENT = 2 * sizeof( void* );
+
+// Each magazine holds this many free blocks, and moves half of them at a time to or from the pool
+const u32 OBJECT_POOL_MAGAZINE_SIZE = 32;
+
+static Helium::Mutex g_PoolsMutex;
+static std::vector< ObjectPool* > g_Pools;
+
+// the pool armed for the next allocation on each thread
+static Helium::ThreadLocalPointer g_ArmedPool;
+
+#ifndef REFLECT_DISABLE_OBJECT_POOL_MAGAZINES
+// each thread's magazines, indexed by pool, emptied back into the pools when the thread exits
+static Helium::ThreadLocalPointer g_Magazines ( &ObjectPool::ReleaseMagazines );
+#endif
+
+ObjectPool* ObjectPool::Create( u32 size, const tstring& name )
+{
+    return new ObjectPool( size, name );
+}
+
+ObjectPool::ObjectPool( u32 size, const tstring& name )
+: m_Name (name)
+, m_BlockSize ((size + OBJECT_POOL_ALIGNMENT - 1) & ~(OBJECT_POOL_ALIGNMENT - 1))
+, m_Index (0)
+, m_Free (NULL)
+, m_Live (0)
+, m_Peak (0)
+{
+    // free blocks hold a link to the next one
+    if ( m_BlockSize < sizeof( FreeBlock ) )
+    {
+        m_BlockSize = OBJECT_POOL_ALIGNMENT;
+    }
+
+    Helium::TakeMutex mutex ( g_PoolsMutex );
+    m_Index = (u32)g_Pools.size();
+    g_Pools.push_back( this );
+}
+
+ObjectPool::ObjectPool( const ObjectPool& rhs )
+{
+    HELIUM_BREAK();
+}
+
+void* ObjectPool::Allocate()
+{
+    FreeBlock* block = NULL;
+
+#ifdef REFLECT_DISABLE_OBJECT_POOL_MAGAZINES
+    {
+        Helium::TakeMutex mutex ( m_Mutex );
+
+        if ( !m_Free )
+        {
+            AllocateSlab();
+        }
+
+        block = m_Free;
+        m_Free = block->m_Next;
+    }
+#else
+    Magazine* magazine = GetMagazine();
+    if ( !magazine->m_Head )
+    {
+        Refill( magazine );
+    }
+
+    block = magazine->m_Head;
+    magazine->m_Head = block->m_Next;
+    magazine->m_Count--;
+#endif
+
+    Helium::AtomicIncrement( &m_Live );
+
+    // this is only statistics, so a racy peak is fine
+    if ( m_Live > m_Peak )
+    {
+        m_Peak = m_Live;
+    }
+
+    return block;
+}
+
+void ObjectPool::Free( void* ptr )
+{
+    FreeBlock* block = static_cast< FreeBlock* >( ptr );
+
+    Helium::AtomicDecrement( &m_Live );
+
+#ifdef REFLECT_DISABLE_OBJECT_POOL_MAGAZINES
+    Helium::TakeMutex mutex ( m_Mutex );
+    block->m_Next = m_Free;
+    m_Free = block;
+#else
+    Magazine* magazine = GetMagazine();
+    block->m_Next = magazine->m_Head;
+    magazine->m_Head = block;
+
+    if ( ++magazine->m_Count >= OBJECT_POOL_MAGAZINE_SIZE )
+    {
+        Drain( magazine, OBJECT_POOL_MAGAZINE_SIZE / 2 );
+    }
+#endif
+}
+
+void ObjectPool::GetPools( std::vector< const ObjectPool* >& pools )
+{
+    Helium::TakeMutex mutex ( g_PoolsMutex );
+    pools.assign( g_Pools.begin(), g_Pools.end() );
+}
+
+void ObjectPool::PrintStatistics()
+{
+    std::vector< const ObjectPool* > pools;
+    GetPools( pools );
+
+    Log::Print( TXT( "Reflect Object Pools:\n" ) );
+
+    std::vector< const ObjectPool* >::const_iterator itr = pools.begin();
+    std::vector< const ObjectPool* >::const_iterator end = pools.end();
+    for ( ; itr != end; ++itr )
+    {
+        const ObjectPool* pool = *itr;
+        if ( pool->GetPeakCount() )
+        {
+            Log::Print( TXT( " %s: %d live, %d peak, %d bytes each\n" ), pool->GetName().c_str(), pool->GetLiveCount(), pool->GetPeakCount(), pool->GetBlockSize() );
+        }
+    }
+}
+
+void ObjectPool::Arm( ObjectPool* pool )
+{
+    g_ArmedPool.SetPointer( pool );
+}
+
+ObjectPool* ObjectPool::Disarm()
+{
+    ObjectPool* pool = static_cast< ObjectPool* >( g_ArmedPool.GetPointer() );
+
+    if ( pool )
+    {
+        g_ArmedPool.SetPointer( NULL );
+    }
+
+    return pool;
+}
+
+void ObjectPool::ReleaseMagazines( void* pointer )
+{
+#ifndef REFLECT_DISABLE_OBJECT_POOL_MAGAZINES
+    std::vector< Magazine >* magazines = static_cast< std::vector< Magazine >* >( pointer );
+
+    for ( u32 i=0; i<magazines->size(); ++i )
+    {
+        Magazine& magazine = (*magazines)[ i ];
+        if ( magazine.m_Count )
+        {
+            ObjectPool* pool = NULL;
+            {
+                Helium::TakeMutex mutex ( g_PoolsMutex );
+                pool = g_Pools[ i ];
+            }
+
+            pool->Drain( &magazine, 0 );
+        }
+    }
+
+    delete magazines;
+#endif
+}
+
+ObjectPool::Magazine* ObjectPool::GetMagazine()
+{
+#ifdef REFLECT_DISABLE_OBJECT_POOL_MAGAZINES
+    return NULL;
+#else
+    std::vector< Magazine >* magazines = static_cast< std::vector< Magazine >* >( g_Magazines.GetPointer() );
+    if ( !magazines )
+    {
+        magazines = new std::vector< Magazine >;
+        g_Magazines.SetPointer( magazines );
+    }
+
+    if ( m_Index >= magazines->size() )
+    {
+        Magazine empty;
+        empty.m_Head = NULL;
+        empty.m_Count = 0;
+        magazines->resize( m_Index + 1, empty );
+    }
+
+    return &(*magazines)[ m_Index ];
+#endif
+}
+
+void ObjectPool::Refill( Magazine* magazine )
+{
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    while ( magazine->m_Count < OBJECT_POOL_MAGAZINE_SIZE / 2 )
+    {
+        if ( !m_Free )
+        {
+            AllocateSlab();
+        }
+
+        FreeBlock* block = m_Free;
+        m_Free = block->m_Next;
+
+        block->m_Next = magazine->m_Head;
+        magazine->m_Head = block;
+        magazine->m_Count++;
+    }
+}
+
+void ObjectPool::Drain( Magazine* magazine, u32 keep )
+{
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    while ( magazine->m_Count > keep )
+    {
+        FreeBlock* block = magazine->m_Head;
+        magazine->m_Head = block->m_Next;
+        magazine->m_Count--;
+
+        block->m_Next = m_Free;
+        m_Free = block;
+    }
+}
+
+void ObjectPool::AllocateSlab()
+{
+    u32 count = std::max< u32 >( OBJECT_POOL_SLAB_SIZE / m_BlockSize, OBJECT_POOL_SLAB_MIN_BLOCKS );
+
+    u8* slab = static_cast< u8* >( ::malloc( count * m_BlockSize ) );
+    if ( !slab )
+    {
+        throw std::bad_alloc();
+    }
+
+    m_Slabs.push_back( slab );
+
+    // thread the new blocks onto the free list in address order
+    for ( u32 i=count; i>0; --i )
+    {
+        FreeBlock* block = reinterpret_cast< FreeBlock* >( slab + ( i - 1 ) * m_BlockSize );
+        block->m_Next = m_Free;
+        m_Free = block;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+
+#include "Platform/Types.h"
+#include "Platform/Mutex.h"
+
+#include "API.h"
+
+namespace Helium
+{
+    namespace Reflect
+    {
+        //
+        // ObjectPool hands out fixed size blocks for the instances of a single class
+        //  Blocks are carved out of large slabs and recycled through a free list, and each thread keeps
+        //  a small magazine of free blocks so most allocations and frees never touch the pool's lock,
+        //  the magazines go back to the pools when their thread exits
+        //  Pools (and their slabs) are never freed, objects may outlive the class registration
+        //
+
+        class FOUNDATION_API ObjectPool
+        {
+        public:
+            // protect external allocation to keep inlined code in this dll
+            static ObjectPool* Create( u32 size, const tstring& name );
+
+        private:
+            ObjectPool( u32 size, const tstring& name );
+            ObjectPool( const ObjectPool& rhs );
+
+        public:
+            const tstring& GetName() const
+            {
+                return m_Name;
+            }
+
+            // the size of the blocks, which is larger than the objects they hold
+            u32 GetBlockSize() const
+            {
+                return m_BlockSize;
+            }
+
+            i32 GetLiveCount() const
+            {
+                return m_Live;
+            }
+
+            i32 GetPeakCount() const
+            {
+                return m_Peak;
+            }
+
+            void* Allocate();
+            void Free( void* block );
+
+            // every pool created so far
+            static void GetPools( std::vector< const ObjectPool* >& pools );
+
+            // print live and peak counts for each pool
+            static void PrintStatistics();
+
+            // the next Object allocated on this thread comes from this pool
+            static void Arm( ObjectPool* pool );
+            static ObjectPool* Disarm();
+
+            // hands an exiting thread's free blocks back to their pools
+            static void ReleaseMagazines( void* magazines );
+
+        private:
+            struct FreeBlock
+            {
+                FreeBlock* m_Next;
+            };
+
+            struct Magazine
+            {
+                FreeBlock*  m_Head;
+                u32         m_Count;
+            };
+
+            Magazine* GetMagazine();
+            void Refill( Magazine* magazine );
+            void Drain( Magazine* magazine, u32 keep );
+            void AllocateSlab();
+
+            tstring                 m_Name;
+            u32                     m_BlockSize;
+            u32                     m_Index;        // index of this pool's magazine in each thread
+            Mutex                   m_Mutex;
+            FreeBlock*              m_Free;
+            std::vector< u8* >      m_Slabs;
+            volatile i32            m_Live;
+            i32                     m_Peak;
+        };
+    }
+}
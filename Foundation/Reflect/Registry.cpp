@@ -2,6 +2,9 @@
 #include "Version.h"
 #include "Serializers.h"
 #include "DOM.h"
+#include "Compression.h"
+#include "ArchiveBinary.h"
+#include "ObjectPool.h"
 
 #ifdef REFLECT_OBJECT_TRACKING
 # include "Platform/Mutex.h"
@@ -18,6 +21,9 @@
 // Prints the callstack for every init and cleanup call
 // #define REFLECT_DEBUG_INIT_AND_CLEANUP
 
+// uncomment to allocate objects created through the registry on the heap instead of their class' pool
+//#define REFLECT_DISABLE_OBJECT_POOLS
+
 using Helium::Insert; 
 
 using namespace Helium;
@@ -225,9 +231,18 @@ void Reflect::Cleanup()
 {
     if ( --g_InitCount == 0 )
     {
+        // finish any pending compaction of incremental saves
+        ArchiveBinary::CleanupCompaction();
+
+        // stop the threads that help with reading large archives
+        ArchiveBinary::CleanupParallelRead();
+
         // free our casting memory
         Serializer::Cleanup();
 
+        // stop our decompression threads
+        CleanupCompression();
+
         // delete registry
         delete g_Registry;
         g_Registry = NULL;
@@ -326,6 +341,11 @@ bool Registry::RegisterType(Type* type)
                     }
                 }
 
+                if ( classType->m_Create && !classType->m_Pool )
+                {
+                    classType->m_Pool = ObjectPool::Create( classType->m_Size + Object::ALLOCATION_HEADER_SIZE, classType->m_ShortName );
+                }
+
                 classType->Report();
             }
             else if (classType != idResult.first->second)
@@ -493,6 +513,22 @@ void Registry::AtomicGetType(const tstring& str, const Type** addr) const
     Helium::AtomicExchange( (intptr*)addr, (intptr)GetType(str) );
 }
 
+// creates an instance in its class' pool (when it has one)
+static Object* CreatePooledInstance(const Class* type)
+{
+#ifndef REFLECT_DISABLE_OBJECT_POOLS
+    ObjectPool::Arm( type->m_Pool );
+    Object* object = type->m_Create();
+
+    // the object's allocation normally disarms the pool, but creators are free to not allocate
+    ObjectPool::Disarm();
+
+    return object;
+#else
+    return type->m_Create();
+#endif
+}
+
 ObjectPtr Registry::CreateInstance(int id) const
 {
     M_IDToType::const_iterator type = m_TypesByID.find(id);
@@ -503,7 +539,7 @@ ObjectPtr Registry::CreateInstance(int id) const
         HELIUM_ASSERT( cls->m_Create );
         if ( cls->m_Create )
         {
-            return cls->m_Create();
+            return CreatePooledInstance(cls);
         }
         else
         {
@@ -520,7 +556,7 @@ ObjectPtr Registry::CreateInstance(const Class* type) const
 {
     if (type && type->m_Create)
     {
-        return type->m_Create();
+        return CreatePooledInstance(type);
     }
     else
     {
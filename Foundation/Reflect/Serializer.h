@@ -26,6 +26,12 @@ namespace Helium
 
         typedef SerializerFlags::SerializerFlag SerializerFlag;
 
+        // number of elements with fields left in the file by a lazy binary read (see ArchiveBinary::SetLazyThreshold)
+        FOUNDATION_API extern volatile i32 g_LazyElementCount;
+
+        // loads a field left in the file by a lazy binary read, if there is one
+        FOUNDATION_API void LoadLazyField(Element* element, const Field* field);
+
         struct TranslateEventArgs
         {
             // the serialier to read/write from
@@ -188,6 +194,12 @@ namespace Helium
             // connect to a field of an object
             virtual void ConnectField(Helium::HybridPtr<Element> instance, const Field* field, uintptr offsetInField = 0)
             {
+                // the data has to be in memory before anyone can look at it
+                if ( g_LazyElementCount )
+                {
+                    LoadLazyField( (Element*)instance.Address(), field );
+                }
+
                 ConnectData( Helium::HybridPtr<void>( instance.Address() + field->m_Offset + offsetInField, instance.State())); 
 
                 m_Instance = instance; 
@@ -352,6 +364,13 @@ namespace Helium
             // data deserialization (insert from archive)
             virtual void Deserialize(Archive& archive) = 0;
 
+            // xml text deserialization straight from the parser's null terminated buffer
+            //  returns false if the text needs the archive stream path instead
+            virtual bool DeserializeText(const tchar* text, size_t length)
+            {
+                return false;
+            }
+
             // text serialization (extract to text stream)
             virtual tostream& operator>> (tostream& stream) const
             { 
@@ -1,6 +1,7 @@
 #include "SimpleSerializer.h"
 #include "ArchiveBinary.h"
 #include "ArchiveXML.h"
+#include "TextParse.h"
 
 #include "Foundation/Memory/Endian.h"
 
@@ -125,6 +126,13 @@ void SimpleSerializer<T>::Deserialize(Archive& archive)
     }
 }
 
+template <class T>
+bool SimpleSerializer<T>::DeserializeText(const tchar* text, size_t length)
+{
+    const tchar* cursor = text;
+    return ParseText( cursor, m_Data.Ref() );
+}
+
 template <class T>
 tistream& SimpleSerializer<T>::operator<< (tistream& stream)
 {
@@ -198,6 +206,14 @@ void StringSerializer::Deserialize(Archive& archive)
     }
 }
 
+// strings take the whole text, like the stream path
+template <>
+bool StringSerializer::DeserializeText(const tchar* text, size_t length)
+{
+    m_Data->assign( text, length );
+    return true;
+}
+
 template<>
 tostream& StringSerializer::operator>> (tostream& stream) const
 {
@@ -4,6 +4,7 @@
 #include "Exceptions.h"
 
 #include "Platform/Assert.h"
+#include "Platform/MappedFile.h"
 
 #ifdef UNICODE
 
@@ -164,6 +165,12 @@ namespace Helium
                 return *this; 
             }
 
+            // direct access to the elements at the read cursor, only streams backed by memory support this
+            virtual const C* PeekBuffer(std::streamsize streamElementCount)
+            {
+                return NULL;
+            }
+
             template <typename T>
             inline Stream& Read(T* ptr)
             {
@@ -444,5 +451,152 @@ namespace Helium
             tstring     m_Filename; 
             bool        m_OpenForWrite; 
         };
+    
+        //
+        // MemoryStreamBuffer, a read-only stream buffer over a block of memory we don't own
+        //
+
+        template< class C >
+        class MemoryStreamBuffer : public std::basic_streambuf< C, std::char_traits< C > >
+        {
+        public:
+            typedef typename std::basic_streambuf< C, std::char_traits< C > >::pos_type pos_type;
+            typedef typename std::basic_streambuf< C, std::char_traits< C > >::off_type off_type;
+
+            MemoryStreamBuffer(const C* data, std::streamsize count)
+            {
+                C* begin = const_cast< C* >( data );
+                this->setg( begin, begin, begin + count );
+            }
+
+            // the data at the read cursor, if there is enough of it
+            const C* Peek(std::streamsize count) const
+            {
+                return ( this->egptr() - this->gptr() >= count ) ? this->gptr() : NULL;
+            }
+
+        protected:
+            virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) HELIUM_OVERRIDE
+            {
+                if ( which & std::ios_base::out )
+                {
+                    return pos_type( off_type( -1 ) );
+                }
+
+                C* target = NULL;
+                switch ( dir )
+                {
+                case std::ios_base::beg:
+                    target = this->eback() + offset;
+                    break;
+
+                case std::ios_base::cur:
+                    target = this->gptr() + offset;
+                    break;
+
+                default:
+                    target = this->egptr() + offset;
+                    break;
+                }
+
+                if ( target < this->eback() || target > this->egptr() )
+                {
+                    return pos_type( off_type( -1 ) );
+                }
+
+                this->setg( this->eback(), target, this->egptr() );
+                return pos_type( off_type( target - this->eback() ) );
+            }
+
+            virtual pos_type seekpos(pos_type position, std::ios_base::openmode which) HELIUM_OVERRIDE
+            {
+                return seekoff( off_type( position ), std::ios_base::beg, which );
+            }
+        };
+
+        //
+        // MemoryStream, a read-only stream object over a block of memory we don't own
+        //
+
+        template< class C >
+        class MemoryStream : public Stream< C >
+        {
+        public: 
+            MemoryStream(const C* data, std::streamsize count)
+                : m_Buffer(data, count)
+            {
+                this->m_Stream    = new std::basic_iostream< C, std::char_traits< C > >( &m_Buffer ); 
+                this->m_OwnStream = true; 
+            }
+
+            virtual const C* PeekBuffer(std::streamsize streamElementCount) HELIUM_OVERRIDE
+            {
+                return m_Buffer.Peek( streamElementCount );
+            }
+
+        protected: 
+            MemoryStreamBuffer< C > m_Buffer;
+        };
+
+        //
+        // MappedFileStream, a read-only stream object backed by a memory mapped file
+        //  Reads are serviced straight out of the mapped pages, and PeekBuffer() allows
+        //  callers to consume large payloads in place without copying them at all
+        //
+
+        template< class C >
+        class MappedFileStream : public Stream< C >
+        {
+        public: 
+            MappedFileStream(const tstring& filename)
+                : m_Filename(filename)
+                , m_Buffer(NULL)
+            {
+
+            }
+
+            ~MappedFileStream()
+            {
+                Close();
+            }
+
+            virtual void Open() HELIUM_OVERRIDE
+            {
+                if ( !m_File.Open( m_Filename.c_str() ) )
+                {
+                    throw Reflect::StreamException( TXT( "Unable to open '%s' for read" ), m_Filename.c_str() );
+                }
+
+                m_Buffer = new MemoryStreamBuffer< C >( (const C*)m_File.GetData(), (std::streamsize)( m_File.GetSize() / sizeof( C ) ) );
+
+                this->m_Stream    = new std::basic_iostream< C, std::char_traits< C > >( m_Buffer ); 
+                this->m_OwnStream = true; 
+            }
+
+            virtual void Close() HELIUM_OVERRIDE
+            {
+                if ( this->m_OwnStream )
+                {
+                    delete this->m_Stream;
+                    this->m_Stream    = NULL;
+                    this->m_OwnStream = false;
+                }
+
+                delete m_Buffer;
+                m_Buffer = NULL;
+
+                m_File.Close();
+            }
+
+            virtual const C* PeekBuffer(std::streamsize streamElementCount) HELIUM_OVERRIDE
+            {
+                return m_Buffer ? m_Buffer->Peek( streamElementCount ) : NULL;
+            }
+
+        protected: 
+            tstring                 m_Filename; 
+            Helium::MappedFile      m_File;
+            MemoryStreamBuffer< C >* m_Buffer;
+        };
     }
 }
\ No newline at end of file
@@ -5,12 +5,15 @@
 #include "Compression.h" 
 
 #include "Platform/Assert.h"
+#include "Platform/Atomic.h"
 #include "Platform/String.h"
+#include "Foundation/Checksum/MurmurHash2.h"
 #include "Foundation/Memory/ArrayPtr.h" 
 #include "Foundation/Log.h"
 
 using Helium::ArrayPtr; 
 
+#include <string.h>
 #include <strstream>
 #include <sstream>
 
@@ -25,33 +28,280 @@ Profile::Accumulator g_StringPoolDeserialize( "Reflect String Pool Deserialize")
 Profile::Accumulator g_StringPoolLookup( "Reflect String Pool Lookup"); 
 Profile::Accumulator g_StringPoolInsert( "Reflect String Pool Insert"); 
 
-int StringPool::Insert(const tstring& str)
+// Intern table sizing
+const u32 STRING_TABLE_INITIAL_BUCKETS = 1024;      // power of two
+const u32 STRING_TABLE_PAGE_SIZE = 16 * 1024;       // characters
+const u32 STRING_POOL_INITIAL_BUCKETS = 64;         // power of two
+
+StringTable::StringTable()
+: m_Buckets (CreateBuckets( STRING_TABLE_INITIAL_BUCKETS ))
+, m_Page (NULL)
+, m_PageUsed (0)
+, m_Count (0)
 {
-    PROFILE_SCOPE_ACCUM(g_StringPoolInsert); 
 
-    M_StringToIndex::iterator found = m_Indices.find( str );
-    if ( found != m_Indices.end() )
+}
+
+StringTable::~StringTable()
+{
+    DestroyBuckets( m_Buckets );
+
+    std::vector< Buckets* >::const_iterator retiredItr = m_Retired.begin();
+    std::vector< Buckets* >::const_iterator retiredEnd = m_Retired.end();
+    for ( ; retiredItr != retiredEnd; ++retiredItr )
+    {
+        DestroyBuckets( *retiredItr );
+    }
+
+    std::vector< tchar* >::const_iterator pageItr = m_Pages.begin();
+    std::vector< tchar* >::const_iterator pageEnd = m_Pages.end();
+    for ( ; pageItr != pageEnd; ++pageItr )
+    {
+        delete [] *pageItr;
+    }
+}
+
+u64 StringTable::Hash( const tchar* chars, u32 length )
+{
+    return MurmurHash64A( chars, (u64)length * sizeof( tchar ), 42 );
+}
+
+const StringTable::Entry* StringTable::Find( const tchar* chars, u32 length, u64 hash ) const
+{
+    // buckets are always less than half full, so we will always hit an empty slot
+    const Buckets* buckets = m_Buckets;
+    for ( u32 slot = (u32)hash & buckets->m_Mask; ; slot = ( slot + 1 ) & buckets->m_Mask )
+    {
+        const Entry* entry = buckets->m_Slots[ slot ];
+        if ( !entry )
+        {
+            return NULL;
+        }
+
+        if ( entry->m_Hash == hash && entry->m_Length == length && memcmp( entry->m_Chars, chars, length * sizeof( tchar ) ) == 0 )
+        {
+            return entry;
+        }
+    }
+}
+
+const StringTable::Entry* StringTable::Intern( const tchar* chars, u32 length, u64 hash )
+{
+    const Entry* entry = Find( chars, length, hash );
+    if ( entry )
+    {
+        return entry;
+    }
+
+    Helium::TakeMutex mutex ( m_Mutex );
+
+    // another thread may have inserted it while we were waiting
+    entry = Find( chars, length, hash );
+    if ( entry )
+    {
+        return entry;
+    }
+
+    if ( ( m_Count + 1 ) * 2 > m_Buckets->m_Mask + 1 )
+    {
+        Grow();
+    }
+
+    m_Entries.push_back( Entry () );
+    Entry& added = m_Entries.back();
+    added.m_Hash = hash;
+    added.m_Length = length;
+    added.m_Chars = Store( chars, length );
+
+    Buckets* buckets = m_Buckets;
+    u32 slot = (u32)hash & buckets->m_Mask;
+    while ( buckets->m_Slots[ slot ] )
+    {
+        slot = ( slot + 1 ) & buckets->m_Mask;
+    }
+
+    // publish the entry after it is completely written
+    Helium::AtomicExchangePointer( (void* volatile*)&buckets->m_Slots[ slot ], &added );
+    ++m_Count;
+
+    return &added;
+}
+
+StringTable::Buckets* StringTable::CreateBuckets( u32 capacity )
+{
+    Buckets* buckets = new Buckets;
+    buckets->m_Mask = capacity - 1;
+    buckets->m_Slots = new const Entry* volatile [ capacity ];
+    memset( (void*)buckets->m_Slots, 0, capacity * sizeof( Entry* ) );
+    return buckets;
+}
+
+void StringTable::DestroyBuckets( Buckets* buckets )
+{
+    delete [] buckets->m_Slots;
+    delete buckets;
+}
+
+const tchar* StringTable::Store( const tchar* chars, u32 length )
+{
+    tchar* result = NULL;
+
+    if ( length + 1 > STRING_TABLE_PAGE_SIZE )
+    {
+        // too big to share a page
+        result = new tchar[ length + 1 ];
+        m_Pages.push_back( result );
+    }
+    else
+    {
+        if ( !m_Page || m_PageUsed + length + 1 > STRING_TABLE_PAGE_SIZE )
+        {
+            m_Page = new tchar[ STRING_TABLE_PAGE_SIZE ];
+            m_PageUsed = 0;
+            m_Pages.push_back( m_Page );
+        }
+
+        result = m_Page + m_PageUsed;
+        m_PageUsed += length + 1;
+    }
+
+    memcpy( result, chars, length * sizeof( tchar ) );
+    result[ length ] = TXT( '\0' );
+
+    return result;
+}
+
+void StringTable::Grow()
+{
+    Buckets* current = m_Buckets;
+    Buckets* buckets = CreateBuckets( ( current->m_Mask + 1 ) * 2 );
+
+    for ( u32 i=0; i<=current->m_Mask; ++i )
+    {
+        const Entry* entry = current->m_Slots[ i ];
+        if ( entry )
+        {
+            u32 slot = (u32)entry->m_Hash & buckets->m_Mask;
+            while ( buckets->m_Slots[ slot ] )
+            {
+                slot = ( slot + 1 ) & buckets->m_Mask;
+            }
+
+            buckets->m_Slots[ slot ] = entry;
+        }
+    }
+
+    // readers that already hold the old buckets keep probing them safely, they just won't see newer strings
+    Helium::AtomicExchangePointer( (void* volatile*)&m_Buckets, buckets );
+    m_Retired.push_back( current );
+}
+
+StringPool::StringPool( StringTable* table )
+: m_Table (table)
+{
+
+}
+
+StringTable* StringPool::GetTable()
+{
+    if ( !m_Table.ReferencesObject() )
+    {
+        m_Table = new StringTable;
+    }
+
+    return m_Table;
+}
+
+u32 StringPool::FindSlot( const StringTable::Entry* entry ) const
+{
+    // entries are interned, so identity is equality
+    u32 mask = (u32)m_Indices.size() - 1;
+    u32 slot = (u32)entry->m_Hash & mask;
+    while ( m_Indices[ slot ] >= 0 && m_Strings[ m_Indices[ slot ] ] != entry )
     {
-        return found->second;
+        slot = ( slot + 1 ) & mask;
     }
 
-    int index = (int)m_Strings.size();
-    m_Indices.insert( M_StringToIndex::value_type(str, index));
-    m_Strings.push_back(str);
+    return slot;
+}
+
+i32 StringPool::Add( const StringTable::Entry* entry )
+{
+    if ( ( m_Strings.size() + 1 ) * 2 > m_Indices.size() )
+    {
+        Grow();
+    }
+
+    i32 index = (i32)m_Strings.size();
+    m_Strings.push_back( entry );
+
+    // if a stream holds duplicates the first index wins
+    u32 slot = FindSlot( entry );
+    if ( m_Indices[ slot ] < 0 )
+    {
+        m_Indices[ slot ] = index;
+    }
 
     return index;
 }
 
-const tstring& StringPool::Get(int index)
+void StringPool::Grow()
+{
+    m_Indices.assign( std::max< size_t >( STRING_POOL_INITIAL_BUCKETS, m_Indices.size() * 2 ), -1 );
+
+    for ( i32 i=0; i<(i32)m_Strings.size(); ++i )
+    {
+        u32 slot = FindSlot( m_Strings[ i ] );
+        if ( m_Indices[ slot ] < 0 )
+        {
+            m_Indices[ slot ] = i;
+        }
+    }
+}
+
+i32 StringPool::Insert(const tstring& str)
+{
+    PROFILE_SCOPE_ACCUM(g_StringPoolInsert); 
+
+    const tchar* chars = str.c_str();
+    u32 length = (u32)str.length();
+    const StringTable::Entry* entry = GetTable()->Intern( chars, length, StringTable::Hash( chars, length ) );
+
+    if ( !m_Indices.empty() )
+    {
+        i32 index = m_Indices[ FindSlot( entry ) ];
+        if ( index >= 0 )
+        {
+            return index;
+        }
+    }
+
+    return Add( entry );
+}
+
+const tchar* StringPool::Get(i32 index)
 {
     PROFILE_SCOPE_ACCUM(g_StringPoolLookup); 
 
-    if ( index < 0 || index >= (int)m_Strings.size() )
+    if ( index < 0 || index >= (i32)m_Strings.size() )
     {
         throw Reflect::LogisticException( TXT( "String index out of range in StringPool" ) );
     }
 
-    return m_Strings[ index ];
+    return m_Strings[ index ]->m_Chars;
+}
+
+void StringPool::Get(i32 index, tstring& str)
+{
+    PROFILE_SCOPE_ACCUM(g_StringPoolLookup); 
+
+    if ( index < 0 || index >= (i32)m_Strings.size() )
+    {
+        throw Reflect::LogisticException( TXT( "String index out of range in StringPool" ) );
+    }
+
+    const StringTable::Entry* entry = m_Strings[ index ];
+    str.assign( entry->m_Chars, entry->m_Length );
 }
 
 void StringPool::SerializeDirect(CharStream& stream)
@@ -63,19 +313,17 @@ void StringPool::SerializeDirect(CharStream& stream)
     i32 size = (i32)m_Strings.size();
     stream.Write(&size); 
 
-    std::vector<tstring>::iterator itr = m_Strings.begin();
-    std::vector<tstring>::iterator end = m_Strings.end();
-    for ( int index=0; itr != end; ++itr, ++index )
+    for ( i32 index=0; index < (i32)m_Strings.size(); ++index )
     {
-        size = (i32)itr->length();
-        const tstring& str (*itr);
+        const StringTable::Entry* entry = m_Strings[ index ];
+        size = (i32)entry->m_Length;
 
 #ifdef REFLECT_ARCHIVE_VERBOSE
-        Log::Debug(TXT(" [%d] : %s\n"), index, str.c_str());
+        Log::Debug(TXT(" [%d] : %s\n"), index, entry->m_Chars);
 #endif
 
         stream.Write(&size); 
-        stream.WriteBuffer(str.c_str(), size * sizeof(tstring::traits_type::char_type));
+        stream.WriteBuffer(entry->m_Chars, size * sizeof(tchar));
     }
 
     size = -1;
@@ -91,14 +339,20 @@ void StringPool::DeserializeDirect(CharStream& stream, CharacterEncoding encodin
     Log::Debug(TXT("Deserializing %d strings\n"), stringCount);
 #endif
 
-    m_Strings.resize(stringCount);
+    m_Strings.clear();
+    m_Strings.reserve(stringCount);
+    m_Indices.clear();
+
+    StringTable* table = GetTable();
+
+    // reused for every string so we only allocate when a longer string comes along
+    tstring outputString;
+
     for (i32 i=0; i<stringCount; ++i)
     {
         i32 stringLength = 0;
         stream.Read(&stringLength);
 
-        tstring& outputString = m_Strings[i]; 
-
         switch (encoding)
         {
         case CharacterEncodings::ASCII:
@@ -132,8 +386,10 @@ void StringPool::DeserializeDirect(CharStream& stream, CharacterEncoding encodin
             }
         }
 
-        // log the index
-        m_Indices[outputString] = i; 
+        // intern it and log the index
+        const tchar* chars = outputString.c_str();
+        u32 length = (u32)outputString.length();
+        Add( table->Intern( chars, length, StringTable::Hash( chars, length ) ) );
 
 #ifdef REFLECT_ARCHIVE_VERBOSE
         Log::Debug(TXT(" [%d] : %s\n"), i, outputString.c_str());
@@ -188,22 +444,75 @@ void StringPool::DeserializeCompressed(CharStream& stream, CharacterEncoding enc
         throw Reflect::StreamException( TXT( "StringPool failed to read compressed data" ) ); 
     }
 
-    std::stringstream memoryStream;
-    std::streamsize copied = memoryStream.rdbuf()->sputn( originalData, originalSize );
-    HELIUM_ASSERT( copied == originalSize );
+    // read the strings in place out of the inflated buffer
+    MemoryStreamBuffer<char> memoryBuffer (originalData, originalSize); 
+    std::iostream memoryStream (&memoryBuffer); 
 
     Reflect::CharStream tempStream(&memoryStream, false); 
     DeserializeDirect(tempStream, encoding); 
 }
 
+void StringPool::SerializeBlockCompressed(CharStream& stream)
+{
+    // in bytes... 
+    u32 originalSize = 0; 
+    u32 compressedSize = 0; 
+
+    // save a place for the originalSize and compressedSize
+    std::streamoff startOffset = stream.TellWrite(); 
+    stream.Write(&originalSize);
+    stream.Write(&compressedSize); 
+
+    // serialize the strings through the compressor, one block at a time
+    CompressionStreamBuffer compressionBuffer (stream); 
+    std::iostream compressionStream (&compressionBuffer); 
+
+    Reflect::CharStream tempStream(&compressionStream, false); 
+    SerializeDirect(tempStream); 
+
+    compressedSize = compressionBuffer.Finish(); 
+    originalSize   = compressionBuffer.GetSize(); 
+
+    // go back and record the size information in the stream. 
+    stream.SeekWrite(startOffset, std::ios_base::beg); 
+    stream.Write(&originalSize); 
+    stream.Write(&compressedSize); 
+    stream.SeekWrite(0, std::ios_base::end); 
+}
+
+void StringPool::DeserializeBlockCompressed(CharStream& stream, CharacterEncoding encoding)
+{
+    u32 originalSize = 0; 
+    u32 compressedSize = 0; 
+
+    stream.Read(&originalSize); 
+    stream.Read(&compressedSize); 
+
+    std::streamoff startOffset = stream.TellRead(); 
+
+    // read the strings through the decompressor, one block at a time
+    DecompressionStreamBuffer decompressionBuffer (stream); 
+    std::iostream decompressionStream (&decompressionBuffer); 
+
+    Reflect::CharStream tempStream(&decompressionStream, false); 
+    DeserializeDirect(tempStream, encoding); 
+
+    if (decompressionBuffer.GetSize() != originalSize)
+    {
+        throw Reflect::StreamException( TXT( "StringPool failed to read compressed data" ) ); 
+    }
+
+    // skip the block terminator
+    stream.SeekRead(startOffset + compressedSize, std::ios_base::beg); 
+}
+
 void StringPool::Serialize(ArchiveBinary* archive)
 {
     PROFILE_SCOPE_ACCUM(g_StringPoolSerialize); 
 
     Reflect::CharStream& stream = archive->GetStream(); 
 
-    HELIUM_ASSERT(m_Strings.size() == m_Indices.size());
-    return SerializeCompressed(stream); 
+    return SerializeBlockCompressed(stream); 
 }
 
 void StringPool::Deserialize(ArchiveBinary* archive, CharacterEncoding encoding)
@@ -212,7 +521,11 @@ void StringPool::Deserialize(ArchiveBinary* archive, CharacterEncoding encoding)
 
     Reflect::CharStream& stream = archive->GetStream(); 
 
-    if(archive->GetVersion() >= ArchiveBinary::FIRST_VERSION_WITH_STRINGPOOL_COMPRESSION)
+    if(archive->GetVersion() >= ArchiveBinary::FIRST_VERSION_WITH_BLOCK_COMPRESSION)
+    {
+        return DeserializeBlockCompressed(stream, encoding); 
+    }
+    else if(archive->GetVersion() >= ArchiveBinary::FIRST_VERSION_WITH_STRINGPOOL_COMPRESSION)
     {
         return DeserializeCompressed(stream, encoding); 
     }
@@ -220,6 +533,4 @@ void StringPool::Deserialize(ArchiveBinary* archive, CharacterEncoding encoding)
     {
         return DeserializeDirect(stream, encoding); 
     }
-
-    HELIUM_ASSERT(m_Strings.size() == m_Indices.size());
 }
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <deque>
 #include <vector>
-#include <hash_map>
 
 #include "Platform/Types.h"
+#include "Platform/Mutex.h"
+
+#include "Foundation/Atomic.h"
 
 #include "API.h"
 #include "Stream.h" 
@@ -43,16 +46,81 @@ namespace Helium
         }
         typedef CharacterEncodings::CharacterEncoding CharacterEncoding;
 
-        class FOUNDATION_API StringPool
+        //
+        // Intern table backing string pools, it may be shared by many archives (and threads)
+        //  Lookups are lock-free, insertions are serialized by a mutex
+        //  Strings are never removed, they live in the table's arena until the last pool using it lets go
+        //
+
+        class FOUNDATION_API StringTable : public Helium::AtomicRefCountBase
         {
         public:
-            typedef stdext::hash_map<tstring, int> M_StringToIndex;
+            struct Entry
+            {
+                u64             m_Hash;     // MurmurHash2 of the characters
+                u32             m_Length;   // length in characters
+                const tchar*    m_Chars;    // null terminated, stored in the arena
+            };
 
-            M_StringToIndex         m_Indices; 
-            std::vector< tstring >  m_Strings;
+            StringTable();
+            ~StringTable();
+
+            static u64 Hash( const tchar* chars, u32 length );
+
+            u32 GetCount() const
+            {
+                return m_Count;
+            }
+
+            // find an interned string without locking, NULL if it hasn't been interned
+            const Entry* Find( const tchar* chars, u32 length, u64 hash ) const;
+
+            // find or insert a string
+            const Entry* Intern( const tchar* chars, u32 length, u64 hash );
+
+        private:
+            StringTable( const StringTable& rhs )
+            {
+
+            }
+
+            struct Buckets
+            {
+                u32                     m_Mask;
+                const Entry* volatile*  m_Slots;
+            };
+
+            static Buckets* CreateBuckets( u32 capacity );
+            static void DestroyBuckets( Buckets* buckets );
+
+            const tchar* Store( const tchar* chars, u32 length );
+            void Grow();
+
+            Buckets* volatile       m_Buckets;  // never resized in place, replaced with a larger copy
+            std::vector< Buckets* > m_Retired;  // replaced buckets, readers may still be probing them
+            std::deque< Entry >     m_Entries;  // deque so entries never move
+            std::vector< tchar* >   m_Pages;    // character arena
+            tchar*                  m_Page;
+            u32                     m_PageUsed;
+            u32                     m_Count;
+            Mutex                   m_Mutex;
+        };
+        typedef Helium::SmartPtr< StringTable > StringTablePtr;
+
+        //
+        // String pool for serializing string data in binary
+        //  Maps archive string indices to strings interned in a StringTable
+        //
+
+        class FOUNDATION_API StringPool
+        {
+        public:
+            // a NULL table gives the pool a private table of its own, copies share the source's table
+            StringPool( StringTable* table = NULL );
 
             i32 Insert(const tstring& str);
-            const tstring& Get(i32 index);
+            const tchar* Get(i32 index);
+            void Get(i32 index, tstring& str);
 
             void SerializeDirect(CharStream& stream); 
             void DeserializeDirect(CharStream& stream, CharacterEncoding encoding); 
@@ -60,8 +128,21 @@ namespace Helium
             void SerializeCompressed(CharStream& stream); 
             void DeserializeCompressed(CharStream& stream, CharacterEncoding encoding); 
 
+            void SerializeBlockCompressed(CharStream& stream); 
+            void DeserializeBlockCompressed(CharStream& stream, CharacterEncoding encoding); 
+
             void Serialize(class ArchiveBinary* archive); 
             void Deserialize(class ArchiveBinary* archive, CharacterEncoding encoding); 
+
+        private:
+            StringTable* GetTable();
+            u32 FindSlot( const StringTable::Entry* entry ) const;
+            i32 Add( const StringTable::Entry* entry );
+            void Grow();
+
+            StringTablePtr                              m_Table;
+            std::vector< const StringTable::Entry* >    m_Strings;  // string index to interned string
+            std::vector< i32 >                          m_Indices;  // open addressed by hash, -1 is empty
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "API.h"
+
+#include "Foundation/Math/Vector2.h"
+#include "Foundation/Math/Vector3.h"
+#include "Foundation/Math/Vector4.h"
+
+#include <stdlib.h>
+
+//
+// Allocation free parsing of the text written by XML archives
+//  Each function advances the cursor past the value it read, and returns false
+//  (leaving the value undefined) when the text isn't in the expected form.
+//  The text must be null terminated.
+//
+
+namespace Helium
+{
+    namespace Reflect
+    {
+        inline bool IsTextSpace( tchar c )
+        {
+            return c == TXT(' ') || c == TXT('\t') || c == TXT('\n') || c == TXT('\r');
+        }
+
+        inline void SkipTextSpace( const tchar*& cursor )
+        {
+            while ( IsTextSpace( *cursor ) )
+            {
+                ++cursor;
+            }
+        }
+
+        // types without a fast parser fall back to the stream path
+        template< class T >
+        inline bool ParseText( const tchar*& cursor, T& value )
+        {
+            return false;
+        }
+
+        template< class T >
+        inline bool ParseUnsignedText( const tchar*& cursor, T& value )
+        {
+            SkipTextSpace( cursor );
+
+            if ( *cursor == TXT('+') )
+            {
+                ++cursor;
+            }
+
+            if ( *cursor < TXT('0') || *cursor > TXT('9') )
+            {
+                return false;
+            }
+
+            T result = 0;
+            while ( *cursor >= TXT('0') && *cursor <= TXT('9') )
+            {
+                result = result * 10 + (T)( *cursor - TXT('0') );
+                ++cursor;
+            }
+
+            value = result;
+            return true;
+        }
+
+        template< class T, class UnsignedT >
+        inline bool ParseSignedText( const tchar*& cursor, T& value )
+        {
+            SkipTextSpace( cursor );
+
+            bool negative = false;
+            if ( *cursor == TXT('-') )
+            {
+                negative = true;
+                ++cursor;
+            }
+
+            UnsignedT magnitude;
+            if ( !ParseUnsignedText( cursor, magnitude ) )
+            {
+                return false;
+            }
+
+            value = negative ? (T)( 0 - magnitude ) : (T)magnitude;
+            return true;
+        }
+
+        template< class T >
+        inline bool ParseFloatText( const tchar*& cursor, T& value )
+        {
+            tchar* end = NULL;
+            f64 result = _tcstod( cursor, &end );
+            if ( end == cursor )
+            {
+                return false;
+            }
+
+            cursor = end;
+            value = (T)result;
+            return true;
+        }
+
+        inline bool ParseText( const tchar*& cursor, bool& value )
+        {
+            u32 result;
+            if ( !ParseUnsignedText( cursor, result ) || result > 1 )
+            {
+                return false;
+            }
+
+            value = result != 0;
+            return true;
+        }
+
+        inline bool ParseText( const tchar*& cursor, u8& value )  { return ParseUnsignedText( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, u16& value ) { return ParseUnsignedText( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, u32& value ) { return ParseUnsignedText( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, u64& value ) { return ParseUnsignedText( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, i8& value )  { return ParseSignedText<i8, u8>( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, i16& value ) { return ParseSignedText<i16, u16>( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, i32& value ) { return ParseSignedText<i32, u32>( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, i64& value ) { return ParseSignedText<i64, u64>( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, f32& value ) { return ParseFloatText( cursor, value ); }
+        inline bool ParseText( const tchar*& cursor, f64& value ) { return ParseFloatText( cursor, value ); }
+
+        // vector components are written separated by ", "
+        inline bool ParseComponentsText( const tchar*& cursor, f32* components, u32 count )
+        {
+            for ( u32 i = 0; i < count; ++i )
+            {
+                if ( i > 0 )
+                {
+                    if ( *cursor != TXT(',') )
+                    {
+                        return false;
+                    }
+                    ++cursor;
+                }
+
+                if ( !ParseFloatText( cursor, components[ i ] ) )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        inline bool ParseText( const tchar*& cursor, Math::Vector2& value ) { return ParseComponentsText( cursor, &value.x, 2 ); }
+        inline bool ParseText( const tchar*& cursor, Math::Vector3& value ) { return ParseComponentsText( cursor, &value.x, 3 ); }
+        inline bool ParseText( const tchar*& cursor, Math::Vector4& value ) { return ParseComponentsText( cursor, &value.x, 4 ); }
+    }
+}
@@ -104,7 +104,7 @@ void TypeIDSerializer::Deserialize(Archive& archive)
 
             i32 index;
             binary.GetStream().Read(&index); 
-            str = binary.GetStrings().Get(index);
+            binary.GetStrings().Get(index, str);
             break;
         }
     }
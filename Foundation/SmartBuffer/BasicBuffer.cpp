@@ -384,6 +384,71 @@ u32 BasicBuffer::AddF64( f64 val, const tchar* dbgStr, ... )
     return AddU64( i );
 }
 
+u32 BasicBuffer::AddU16Array( const u16* values, u32 count, const tchar* dbgStr, ... )
+{
+    ADD_DEBUG_INFO_SKIP(BasicBufferDebugInfo::BLOCK_TYPE_BUFFER, count * sizeof( u16 ));
+
+    u32 offset = AddBuffer( (const u8*)values, count * sizeof( u16 ) );
+    ConvertEndianArray( (u16*)( m_Data + offset ), count, IsPlatformBigEndian() );
+    return offset;
+}
+
+u32 BasicBuffer::AddI16Array( const i16* values, u32 count, const tchar* dbgStr, ... )
+{
+    ADD_DEBUG_INFO_SKIP(BasicBufferDebugInfo::BLOCK_TYPE_BUFFER, count * sizeof( i16 ));
+
+    u32 offset = AddBuffer( (const u8*)values, count * sizeof( i16 ) );
+    ConvertEndianArray( (i16*)( m_Data + offset ), count, IsPlatformBigEndian() );
+    return offset;
+}
+
+u32 BasicBuffer::AddU32Array( const u32* values, u32 count, const tchar* dbgStr, ... )
+{
+    ADD_DEBUG_INFO_SKIP(BasicBufferDebugInfo::BLOCK_TYPE_BUFFER, count * sizeof( u32 ));
+
+    u32 offset = AddBuffer( (const u8*)values, count * sizeof( u32 ) );
+    ConvertEndianArray( (u32*)( m_Data + offset ), count, IsPlatformBigEndian() );
+    return offset;
+}
+
+u32 BasicBuffer::AddI32Array( const i32* values, u32 count, const tchar* dbgStr, ... )
+{
+    ADD_DEBUG_INFO_SKIP(BasicBufferDebugInfo::BLOCK_TYPE_BUFFER, count * sizeof( i32 ));
+
+    u32 offset = AddBuffer( (const u8*)values, count * sizeof( i32 ) );
+    ConvertEndianArray( (i32*)( m_Data + offset ), count, IsPlatformBigEndian() );
+    return offset;
+}
+
+u32 BasicBuffer::AddU64Array( const u64* values, u32 count, const tchar* dbgStr, ... )
+{
+    ADD_DEBUG_INFO_SKIP(BasicBufferDebugInfo::BLOCK_TYPE_BUFFER, count * sizeof( u64 ));
+
+    u32 offset = AddBuffer( (const u8*)values, count * sizeof( u64 ) );
+    ConvertEndianArray( (u64*)( m_Data + offset ), count, IsPlatformBigEndian() );
+    return offset;
+}
+
+u32 BasicBuffer::AddF32Array( const f32* values, u32 count, const tchar* dbgStr, ... )
+{
+    ADD_DEBUG_INFO_SKIP(BasicBufferDebugInfo::BLOCK_TYPE_BUFFER, count * sizeof( f32 ));
+
+    u32 offset = AddBuffer( (const u8*)values, count * sizeof( f32 ) );
+    u32* data = (u32*)( m_Data + offset );
+
+    // "negative" zero becomes zero, same as AddF32
+    for ( u32 i = 0; i < count; ++i )
+    {
+        if ( ( data[ i ] & 0x7FFFFFFF ) == 0x0 )
+        {
+            data[ i ] = 0x0;
+        }
+    }
+
+    ConvertEndianArray( data, count, IsPlatformBigEndian() );
+    return offset;
+}
+
 u32 BasicBuffer::AddVector3( const Math::Vector3& v, const tchar* debugStr )
 {
     u32 ret = AddF32(v.x, debugStr);
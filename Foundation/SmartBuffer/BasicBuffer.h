@@ -112,6 +112,14 @@ namespace Helium
         u32 AddF32(f32 val, const tchar* dbgStr = NULL, ...);
         u32 AddF64(f64 val, const tchar* dbgStr = NULL, ...);
 
+        // Add whole arrays, swapping them to the platform byte order in one pass
+        u32 AddU16Array(const u16* values, u32 count, const tchar* dbgStr = NULL, ...);
+        u32 AddI16Array(const i16* values, u32 count, const tchar* dbgStr = NULL, ...);
+        u32 AddU32Array(const u32* values, u32 count, const tchar* dbgStr = NULL, ...);
+        u32 AddI32Array(const i32* values, u32 count, const tchar* dbgStr = NULL, ...);
+        u32 AddU64Array(const u64* values, u32 count, const tchar* dbgStr = NULL, ...);
+        u32 AddF32Array(const f32* values, u32 count, const tchar* dbgStr = NULL, ...);
+
         u32 AddVector3( const Math::Vector3& v, const tchar* debugStr = NULL);
         u32 AddVector4( const Math::Vector4& v, const tchar* debugStr = NULL);
         u32 AddVector4( const Math::Vector3& v, f32 w, const tchar* debugStr = NULL);
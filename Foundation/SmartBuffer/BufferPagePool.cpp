@@ -0,0 +1,117 @@
+#include "BufferPagePool.h"
+
+#include "Platform/Mutex.h"
+#include "Platform/Assert.h"
+
+#include <vector>
+#include <stdlib.h>
+
+using namespace Helium;
+
+namespace
+{
+    // blocks run from a single page up to 64mb, bigger blocks aren't worth keeping around
+    const u32 PAGE_POOL_CLASS_COUNT = 15;
+
+    // how much free storage the pool holds on to before it starts giving blocks back to the heap
+    const u32 PAGE_POOL_CACHE_LIMIT = 128 * 1024 * 1024;
+
+    Helium::Mutex g_PagePoolMutex;
+    std::vector< u8* > g_PagePoolFree[ PAGE_POOL_CLASS_COUNT ];
+    u32 g_PagePoolCachedSize = 0;
+
+    u32 GetClassSize( u32 size_class )
+    {
+        return BufferPagePool::s_PageSize << size_class;
+    }
+
+    // returns PAGE_POOL_CLASS_COUNT if the size is bigger than any class
+    u32 GetSizeClass( u32 size )
+    {
+        u32 size_class = 0;
+        while ( size_class < PAGE_POOL_CLASS_COUNT && GetClassSize( size_class ) < size )
+        {
+            ++size_class;
+        }
+
+        return size_class;
+    }
+}
+
+u8* BufferPagePool::Allocate( u32& capacity )
+{
+    u32 size_class = GetSizeClass( capacity );
+    if ( size_class == PAGE_POOL_CLASS_COUNT )
+    {
+        // too big to pool, just round it to a whole page
+        capacity = ( capacity + s_PageSize - 1 ) & ~( s_PageSize - 1 );
+        return (u8*)::malloc( capacity );
+    }
+
+    capacity = GetClassSize( size_class );
+
+    {
+        Helium::TakeMutex lock ( g_PagePoolMutex );
+
+        std::vector< u8* >& free_blocks = g_PagePoolFree[ size_class ];
+        if ( !free_blocks.empty() )
+        {
+            u8* data = free_blocks.back();
+            free_blocks.pop_back();
+            g_PagePoolCachedSize -= capacity;
+            return data;
+        }
+    }
+
+    return (u8*)::malloc( capacity );
+}
+
+void BufferPagePool::Free( u8* data, u32 capacity )
+{
+    if ( data == NULL )
+    {
+        return;
+    }
+
+    u32 size_class = GetSizeClass( capacity );
+    if ( size_class < PAGE_POOL_CLASS_COUNT && GetClassSize( size_class ) == capacity )
+    {
+        Helium::TakeMutex lock ( g_PagePoolMutex );
+
+        if ( g_PagePoolCachedSize + capacity <= PAGE_POOL_CACHE_LIMIT )
+        {
+            g_PagePoolFree[ size_class ].push_back( data );
+            g_PagePoolCachedSize += capacity;
+            return;
+        }
+    }
+
+    ::free( data );
+}
+
+void BufferPagePool::Trim()
+{
+    Helium::TakeMutex lock ( g_PagePoolMutex );
+
+    for ( u32 size_class = 0; size_class < PAGE_POOL_CLASS_COUNT; ++size_class )
+    {
+        std::vector< u8* >& free_blocks = g_PagePoolFree[ size_class ];
+
+        std::vector< u8* >::const_iterator itr = free_blocks.begin();
+        std::vector< u8* >::const_iterator end = free_blocks.end();
+        for ( ; itr != end; ++itr )
+        {
+            ::free( *itr );
+        }
+
+        free_blocks.clear();
+    }
+
+    g_PagePoolCachedSize = 0;
+}
+
+u32 BufferPagePool::GetCachedSize()
+{
+    Helium::TakeMutex lock ( g_PagePoolMutex );
+    return g_PagePoolCachedSize;
+}
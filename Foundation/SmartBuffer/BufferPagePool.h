@@ -0,0 +1,32 @@
+#pragma once
+
+#include "API.h"
+#include "Platform/Types.h"
+
+namespace Helium
+{
+    //
+    // BufferPagePool recycles the storage of paged SmartBuffers
+    //  Blocks are runs of a power of two pages, so a buffer that doubles as it grows reuses the blocks
+    //  other buffers released instead of going back to the heap.  Blocks come from malloc, so data taken
+    //  out of a buffer with TakeData can still be released with free.
+    //
+
+    class FOUNDATION_API BufferPagePool
+    {
+    public:
+        static const u32 s_PageSize = 4 * 1024;
+
+        // Allocates a block of at least capacity bytes, and rounds capacity up to the size of the block
+        static u8* Allocate( u32& capacity );
+
+        // Returns a block to the pool, capacity must be the size Allocate returned
+        static void Free( u8* data, u32 capacity );
+
+        // Releases all the cached blocks back to the heap
+        static void Trim();
+
+        // The number of bytes currently cached in the pool
+        static u32 GetCachedSize();
+    };
+}
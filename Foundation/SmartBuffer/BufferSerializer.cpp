@@ -2,7 +2,9 @@
 #include "SmartBuffer.h"
 #include "ObjectBuffer.h"
 #include "BasicBuffer.h"
+#include "BufferPagePool.h"
 
+#include "Platform/Exception.h"
 #include "Foundation/Log.h"
 #include "Foundation/SmartBuffer/SmartLoader.h"
 
@@ -19,11 +21,13 @@ Profile::Accumulator BufferSerializer::s_WriteAccum ( "BufferSerializer Data Wri
 
 BufferSerializer::BufferSerializer()
 : m_ByteOrder( DEFAULT_BYTE_ORDER )
+, m_Paged( true )
 {
 }
 
 BufferSerializer::BufferSerializer( ByteOrder platform )
 : m_ByteOrder( platform )
+, m_Paged( true )
 {
 
 }
@@ -35,6 +39,11 @@ BasicBufferPtr BufferSerializer::CreateBasic( u32 type, bool track )
     return_val->SetType( type );
     return_val->SetByteOrder( m_ByteOrder );
 
+    if ( m_Paged )
+    {
+        return_val->SetPaged();
+    }
+
     // we don't track anonymous buffers because they could be empty or not pointed to from a non-anonymous buffer
     //  however, we do allow non-anonymous buffers to not be tracked in case they were allocated but not written to
     //  take, for instance some code that may or may not write data to a non-anonymous buffer, it could choose not
@@ -67,14 +76,107 @@ const u32 BF_ALIGN = 16;
 const u32 BF_ALIGN_MINUS_ONE = BF_ALIGN - 1;
 const tchar BF_PAD_STR[BF_ALIGN+1] = TXT( "PAD0PAD1PAD2PAD3" );
 
-struct P_Fixup
+BufferScatterList::BufferScatterList()
+: m_BlockUsed( 0 )
+, m_Size( 0 )
+{
+
+}
+
+BufferScatterList::~BufferScatterList()
+{
+    Clear();
+}
+
+void BufferScatterList::Clear()
+{
+    std::vector< std::pair< u8*, u32 > >::const_iterator itr = m_Blocks.begin();
+    std::vector< std::pair< u8*, u32 > >::const_iterator end = m_Blocks.end();
+    for ( ; itr != end; ++itr )
+    {
+        BufferPagePool::Free( (*itr).first, (*itr).second );
+    }
+
+    m_Blocks.clear();
+    m_Segments.clear();
+    m_BlockUsed = 0;
+    m_Size = 0;
+}
+
+void BufferScatterList::AddReference( const void* data, u32 size )
 {
-    u32             source_offset;
-    u32             target_offset;
+    if ( size == 0 )
+    {
+        return;
+    }
+
+    BufferSegment segment;
+    segment.m_Data = (const u8*)data;
+    segment.m_Size = size;
+    m_Segments.push_back( segment );
+
+    m_Size += size;
+}
+
+void BufferScatterList::AddCopy( const void* data, u32 size )
+{
+    if ( size == 0 )
+    {
+        return;
+    }
+
+    // start a new block if the copy doesn't fit in the current one
+    if ( m_Blocks.empty() || m_BlockUsed + size > m_Blocks.back().second )
+    {
+        u32 capacity = size > BufferPagePool::s_PageSize ? size : BufferPagePool::s_PageSize;
+        u8* block = BufferPagePool::Allocate( capacity );
+        if ( block == NULL )
+        {
+            throw Helium::Exception( TXT( "Could not allocate %d bytes for a scatter list." ), capacity );
+        }
+
+        m_Blocks.push_back( std::make_pair( block, capacity ) );
+        m_BlockUsed = 0;
+    }
+
+    u8* copy = m_Blocks.back().first + m_BlockUsed;
+    memcpy( copy, data, size );
+    m_BlockUsed += size;
+
+    // consecutive copies (headers, patched pointers that share a page) collapse into a single segment
+    if ( !m_Segments.empty() && m_Segments.back().m_Data + m_Segments.back().m_Size == copy )
+    {
+        m_Segments.back().m_Size += size;
+        m_Size += size;
+    }
+    else
+    {
+        AddReference( copy, size );
+    }
+}
+
+bool BufferScatterList::WriteToStream( tostream& strm ) const
+{
+    V_BufferSegment::const_iterator itr = m_Segments.begin();
+    V_BufferSegment::const_iterator end = m_Segments.end();
+    for ( ; itr != end; ++itr )
+    {
+        strm.write( (const tchar*)(*itr).m_Data, (*itr).m_Size );
+    }
 
-    u32             source_chunk_offset;
-    SmartBufferPtr target_chunk_buffer;
-};
+    return !strm.fail();
+}
+
+void BufferScatterList::CopyTo( u8* destination ) const
+{
+    V_BufferSegment::const_iterator itr = m_Segments.begin();
+    V_BufferSegment::const_iterator end = m_Segments.end();
+    for ( ; itr != end; ++itr )
+    {
+        memcpy( destination, (*itr).m_Data, (*itr).m_Size );
+        destination += (*itr).m_Size;
+    }
+}
 
 u32 BufferSerializer::ComputeSize() const
 {
@@ -198,18 +300,31 @@ bool BufferSerializer::WriteToFile( const tchar* filename ) const
 }
 
 bool BufferSerializer::WriteToStream( tostream& strm ) const
+{
+    BufferScatterList list;
+    if ( !WriteToScatterList( list ) )
+    {
+        return false;
+    }
+
+    return list.WriteToStream( strm );
+}
+
+bool BufferSerializer::WriteToScatterList( BufferScatterList& list ) const
 {
     bool swizzle = m_ByteOrder == ByteOrders::BigEndian;
     bool align   = m_ByteOrder == ByteOrders::BigEndian;
 
     // track data for when we need to fixup
     typedef std::map< SmartBufferPtr, u32 > M_BuffU32;
-    typedef std::vector< P_Fixup > V_Fixup;
 
     M_BuffU32 buffer_to_offset_map;
 
-    V_Fixup fixup_32;
-    V_Fixup fixup_64;
+    // the (swizzled) file offsets of the pointers we patched, for the fixup tables
+    std::vector< u32 > fixup_32;
+    std::vector< u32 > fixup_64;
+
+    list.Clear();
 
     // make a unique list of contained buffers
     S_SmartBufferPtr buffers;
@@ -232,7 +347,7 @@ bool BufferSerializer::WriteToStream( tostream& strm ) const
         file_header.m_Version    = ConvertEndian( CHUNK_VERSION_16_ALIGN, swizzle );
         file_header.m_ChunkCount = ConvertEndian( (u32)buffers.Size(), swizzle );
 
-        strm.write( (const tchar*)&file_header, sizeof( ChunkFileHeader ) );
+        list.AddCopy( &file_header, sizeof( ChunkFileHeader ) );
     }
 
     // how many chunks?
@@ -241,7 +356,7 @@ bool BufferSerializer::WriteToStream( tostream& strm ) const
     // write a header for each chunk
     if ( num_chunks == 0 )
     {
-        strm.write( (const tchar*)&num_chunks, sizeof( num_chunks ) );
+        list.AddCopy( &num_chunks, sizeof( num_chunks ) );
     }
     else
     {
@@ -276,7 +391,7 @@ bool BufferSerializer::WriteToStream( tostream& strm ) const
                 buffer_offset += BF_ALIGN - ( (*itr)->GetSize() & BF_ALIGN_MINUS_ONE );
             }
 
-            strm.write( (const tchar*)&chunk_header, sizeof( ChunkHeader ) );
+            list.AddCopy( &chunk_header, sizeof( ChunkHeader ) );
         }
     }
 
@@ -285,24 +400,14 @@ bool BufferSerializer::WriteToStream( tostream& strm ) const
         S_SmartBufferPtr::Iterator end = buffers.End();
         for ( u32 chunk_index = 0; itr != end; ++itr, ++chunk_index )
         {
-            // go back and write the offset
-            u32 chunk_start_loc = (u32)strm.tellp();
+            u32 chunk_start_loc = buffer_to_offset_map[ *itr ];
 
-            // write the buffer
             u32 buffer_size = (*itr)->GetSize();
             const u8* buffer_data = (*itr)->GetData();
-            strm.write( (const tchar*)buffer_data, buffer_size );
 
-            //  align to boundary...
-            if ( align && (buffer_size & BF_ALIGN_MINUS_ONE) != 0 )
-            {
-                u32 pad = BF_ALIGN - (buffer_size & BF_ALIGN_MINUS_ONE);
-                strm.write( BF_PAD_STR, pad );
-            }
-
-            // store all the outgoing fixups and process them at the end..
-            P_Fixup fix;
-            fix.source_chunk_offset = chunk_start_loc;
+            // the buffer data is referenced in place, except for the pointers, which are
+            //  replaced by the file offsets they point to (the outgoing fixups are sorted by offset)
+            u32 cursor = 0;
 
             BufferLocation destination;
 
@@ -315,90 +420,72 @@ bool BufferSerializer::WriteToStream( tostream& strm ) const
                     PointerFixup* fixup = static_cast<PointerFixup*>( (*of_itr).second.Ptr() );
                     fixup->GetDestination( destination );
 
-                    fix.source_offset       = (*of_itr).first;
-                    fix.target_offset       = destination.first;
-                    fix.target_chunk_buffer = destination.second;
+                    M_BuffU32::const_iterator target_chunk_offset = buffer_to_offset_map.find( destination.second );
+                    HELIUM_ASSERT( target_chunk_offset != buffer_to_offset_map.end() );
+
+                    u32 target_offset = ( (*target_chunk_offset).second + destination.first );
+                    u32 source_offset = (*of_itr).first;
+                    HELIUM_ASSERT( source_offset >= cursor );
+
+                    list.AddReference( buffer_data + cursor, source_offset - cursor );
+
                     if (fixup->GetSize() == 4)
                     {
-                        fixup_32.push_back( fix );
+                        u32 target_offset_swizzled = ConvertEndian( target_offset, swizzle );
+                        list.AddCopy( &target_offset_swizzled, sizeof( target_offset_swizzled ) );
+                        cursor = source_offset + sizeof( target_offset_swizzled );
+
+                        fixup_32.push_back( ConvertEndian( chunk_start_loc + source_offset, swizzle ) );
                     }
                     else
                     {
-                        fixup_64.push_back( fix );
+                        // an 8 byte pointer, but still uses a 4-byte pointer fixup runtime
+                        u32 pointer[ 2 ] = { 0x0, ConvertEndian( target_offset, swizzle ) };
+                        list.AddCopy( pointer, sizeof( pointer ) );
+                        cursor = source_offset + sizeof( pointer );
+
+                        fixup_64.push_back( ConvertEndian( chunk_start_loc + source_offset + 4, swizzle ) );
                     }
                 }
             }
+
+            HELIUM_ASSERT( cursor <= buffer_size );
+            list.AddReference( buffer_data + cursor, buffer_size - cursor );
+
+            //  align to boundary...
+            if ( align && (buffer_size & BF_ALIGN_MINUS_ONE) != 0 )
+            {
+                u32 pad = BF_ALIGN - (buffer_size & BF_ALIGN_MINUS_ONE);
+                list.AddReference( BF_PAD_STR, pad );
+            }
         }
     }
 
-    u32 test = (u32)strm.tellp();
-
-    // write the number fixups
+    // write the number fixups, and the fixups themselves
     u32 num_fixups_32 = (u32)fixup_32.size();
     u32 num_fixups_32_swizzled = ConvertEndian( num_fixups_32, swizzle );
-    strm.write( (const tchar*)&num_fixups_32_swizzled, sizeof( num_fixups_32_swizzled ) );
+    list.AddCopy( &num_fixups_32_swizzled, sizeof( num_fixups_32_swizzled ) );
 
-    // now the fixups themselvs
     if ( num_fixups_32 == 0 )
     {
-        strm.write( (const tchar*)&num_fixups_32, sizeof( num_fixups_32 ) );
+        list.AddCopy( &num_fixups_32, sizeof( num_fixups_32 ) );
     }
     else
     {
-        V_Fixup::const_iterator itr = fixup_32.begin();
-        V_Fixup::const_iterator end  = fixup_32.end();
-        for( ; itr != end; ++itr )
-        {
-            M_BuffU32::const_iterator target_chunk_offset = buffer_to_offset_map.find( (*itr).target_chunk_buffer );
-            HELIUM_ASSERT( target_chunk_offset != buffer_to_offset_map.end() );
-
-            u32 curr_offset   = (u32)strm.tellp();
-            u32 target_offset = ( (*target_chunk_offset).second + (*itr).target_offset );
-            u32 source_offset = ( (*itr).source_chunk_offset + (*itr).source_offset );
-
-            u32 target_offset_swizzled = ConvertEndian( target_offset, swizzle );
-            u32 source_offset_swizzled = ConvertEndian( source_offset, swizzle );
-
-            strm.seekp( source_offset );
-            strm.write( (const tchar*)&target_offset_swizzled, sizeof( target_offset_swizzled ) );
-            strm.seekp( curr_offset );
-            strm.write( (const tchar*)&source_offset_swizzled, sizeof( source_offset_swizzled ) );
-        }
+        list.AddCopy( &fixup_32.front(), num_fixups_32 * sizeof( u32 ) );
     }
 
-    // write the number fixups
     u32 num_fixups_64 = (u32)fixup_64.size();
     u32 num_fixups_64_swizzled = ConvertEndian( num_fixups_64, swizzle );
-    strm.write( (const tchar*)&num_fixups_64_swizzled, sizeof( num_fixups_64_swizzled ) );
+    list.AddCopy( &num_fixups_64_swizzled, sizeof( num_fixups_64_swizzled ) );
 
     if ( num_fixups_64 == 0 )
     {
-        strm.write( (const tchar*)&num_fixups_64, sizeof( num_fixups_64 ) );
+        list.AddCopy( &num_fixups_64, sizeof( num_fixups_64 ) );
     }
     else
     {
-        V_Fixup::const_iterator itr = fixup_64.begin();
-        V_Fixup::const_iterator end  = fixup_64.end();
-        for( ; itr != end; ++itr )
-        {
-            M_BuffU32::const_iterator target_chunk_offset = buffer_to_offset_map.find( (*itr).target_chunk_buffer );
-            HELIUM_ASSERT( target_chunk_offset != buffer_to_offset_map.end() );
-
-            u32 curr_offset   = (u32)strm.tellp();
-            u32 target_offset = ( (*target_chunk_offset).second + (*itr).target_offset );
-            u32 source_offset = ( (*itr).source_chunk_offset + (*itr).source_offset );
-
-            u32 target_offset_swizzled = ConvertEndian( target_offset, swizzle );
-            u32 source_offset_swizzled = ConvertEndian( source_offset+4, swizzle );
-            u32 pad = 0x0;
-
-            // an 8 byte pointer, but still uses a 4-byte pointer fixup runtime
-            strm.seekp( source_offset );
-            strm.write( (const tchar*)&pad, sizeof(pad) );
-            strm.write( (const tchar*)&target_offset_swizzled, sizeof( target_offset_swizzled ) );
-            strm.seekp( curr_offset );
-            strm.write( (const tchar*)&source_offset_swizzled, sizeof( source_offset_swizzled ) );
-        }
+        list.AddCopy( &fixup_64.front(), num_fixups_64 * sizeof( u32 ) );
     }
 
     return true;
@@ -7,6 +7,68 @@ namespace Helium
     template< typename T > class ObjectBuffer;
     template< typename T > class ObjectArrayBuffer;
 
+    //
+    // A span of bytes in the serialized output
+    //
+
+    struct BufferSegment
+    {
+        const u8*   m_Data;
+        u32         m_Size;
+    };
+    typedef std::vector< BufferSegment > V_BufferSegment;
+
+    //
+    // BufferScatterList describes serialized output as a list of segments, ready for a gather write or a
+    //  copy into a mapped view.  Buffer data is referenced in place (so the buffers must outlive the list),
+    //  only headers and patched pointers are copied, into pages from the BufferPagePool.
+    //
+
+    class FOUNDATION_API BufferScatterList
+    {
+    private:
+        V_BufferSegment                     m_Segments;
+        std::vector< std::pair< u8*, u32 > > m_Blocks;
+        u32                                 m_BlockUsed;
+        u32                                 m_Size;
+
+    public:
+        BufferScatterList();
+        ~BufferScatterList();
+
+    private:
+        BufferScatterList( const BufferScatterList& rhs )
+        {
+
+        }
+
+    public:
+        void Clear();
+
+        // Appends bytes the list points to
+        void AddReference( const void* data, u32 size );
+
+        // Appends a copy of the bytes
+        void AddCopy( const void* data, u32 size );
+
+        const V_BufferSegment& GetSegments() const
+        {
+            return m_Segments;
+        }
+
+        // The total number of bytes described by the list
+        u32 GetSize() const
+        {
+            return m_Size;
+        }
+
+        // Writes each segment in order
+        bool WriteToStream( tostream& strm ) const;
+
+        // Gathers the segments into GetSize() bytes at the destination
+        void CopyTo( u8* destination ) const;
+    };
+
     class FOUNDATION_API BufferSerializer
     {
         // Profile interface
@@ -18,6 +80,7 @@ namespace Helium
     protected:
         ByteOrder m_ByteOrder;
         S_SmartBufferPtr m_Buffers;
+        bool m_Paged;
 
     public:
         BufferSerializer();
@@ -33,6 +96,13 @@ namespace Helium
             m_ByteOrder = platform;
         }
 
+        // Basic buffers grow in pages from the BufferPagePool (see SmartBuffer::SetPaged) unless this is turned off,
+        //  only buffers created after the call are affected
+        void SetPaged(bool paged)
+        {
+            m_Paged = paged;
+        }
+
         S_SmartBufferPtr::Iterator begin() const
         {
             return m_Buffers.Begin();
@@ -88,6 +158,7 @@ namespace Helium
 
     public:
         u32 ComputeSize() const;
+        bool WriteToScatterList( BufferScatterList& list ) const;
         bool WriteToFile( const tchar* filename ) const;
         bool WriteToStream( tostream& strm ) const;
         bool ReadFromFile( const tchar* filename );
@@ -1,10 +1,13 @@
 #include "SmartBuffer.h"
+#include "BufferPagePool.h"
 
 #include "Platform/Assert.h"
 #include "Platform/Exception.h"
 #include "Foundation/Log.h"
 #include "Platform/Windows/Windows.h"
 
+#include <algorithm>
+
 using namespace Helium;
 
 // These are project specific, and in the order of PC, PS3
@@ -270,6 +273,7 @@ SmartBuffer::SmartBuffer()
 , m_OwnsData( true )
 , m_ByteOrder( DEFAULT_BYTE_ORDER )
 , m_Virtual( false )
+, m_Paged( false )
 , m_Data ( NULL )
 {
     HELIUM_ASSERT( m_ByteOrder >= 0 && m_ByteOrder < ByteOrders::Count );
@@ -280,17 +284,7 @@ SmartBuffer::~SmartBuffer()
     HELIUM_ASSERT( m_RefCount == 0 );
     if ( m_OwnsData && m_Data != NULL )
     {
-        if (m_Virtual)
-        {
-            ::VirtualFree(m_Data,m_Capacity,MEM_DECOMMIT);
-            ::VirtualFree(m_Data,0,MEM_RELEASE);
-        }
-        else
-        {
-            ::free( m_Data );
-        }
-
-        Profile::Memory::Deallocate( s_DataPool, m_Capacity );
+        FreeData();
     }
 
     if ( m_OwnsData )
@@ -349,18 +343,7 @@ void SmartBuffer::Reset()
 
     if (m_Data)
     {
-        if (m_Virtual)
-        {
-            // release memory pages but not the address space
-            ::VirtualFree(m_Data,m_Capacity,MEM_DECOMMIT);
-            ::VirtualFree(m_Data,0,MEM_RELEASE);
-        }
-        else
-        {
-            ::free(m_Data);
-        }
-
-        Profile::Memory::Deallocate( s_DataPool, m_Capacity );
+        FreeData();
     }
 
     m_Data = 0;
@@ -425,6 +408,17 @@ void SmartBuffer::SetVirtual(u32 size)
     SetMaxSize(size);
 }
 
+void SmartBuffer::SetPaged()
+{
+    // cannot page a buffer which is not owned or has been used
+    HELIUM_ASSERT( m_OwnsData );
+    HELIUM_ASSERT( m_Size == 0 );
+    HELIUM_ASSERT( m_Capacity == 0 );
+    HELIUM_ASSERT( m_Virtual == false );
+
+    m_Paged = true;
+}
+
 void SmartBuffer::GrowBy(u32 size)
 {
     HELIUM_ASSERT( m_OwnsData );
@@ -460,11 +454,37 @@ void SmartBuffer::GrowBy(u32 size)
 
             u32 difference = m_Size + size - m_Capacity;
 
+            void *ptr = NULL;
+            if ( m_Paged )
+            {
+                // double the capacity so a stream of small adds only moves the data a handful of times
+                u32 capacity = std::max( m_Size + size, m_Capacity * 2 );
+                if ( m_MaxSize && capacity > m_MaxSize )
+                {
+                    capacity = m_MaxSize;
+                }
+                ptr = BufferPagePool::Allocate( capacity );
+                if ( ptr != NULL )
+                {
+                    difference = capacity - m_Capacity;
+
+                    if ( m_Data != NULL )
+                    {
+                        memcpy( ptr, m_Data, m_Size );
+                        BufferPagePool::Free( m_Data, m_Capacity );
+                    }
+                }
+            }
+
             // profiler keeps the allocation count so deallocate our old size and allocate our new total
             Profile::Memory::Deallocate( s_DataPool, m_Capacity );
             Profile::Memory::Allocate( s_DataPool, m_Capacity + difference );
 
-            void *ptr = ::realloc( m_Data, m_Capacity + difference );
+            if ( !m_Paged )
+            {
+                ptr = ::realloc( m_Data, m_Capacity + difference );
+            }
+
             if (ptr == NULL)
             {
                 if (!m_Name.empty())
@@ -490,23 +510,52 @@ void SmartBuffer::GrowBy(u32 size)
                 m_Data = (u8*)ptr;
 
                 // Fix incoming pointers
-                if ( !m_IncomingFixups.Empty() )
-                {
-                    S_DumbBufferLocation::Iterator itr = m_IncomingFixups.Begin();
-                    S_DumbBufferLocation::Iterator end = m_IncomingFixups.End();
-                    for ( ; itr != end; ++itr )
-                    {
-                        DumbBufferLocation& source = (*itr);
+                RelinkIncomingFixups();
+            }
+        }
+    }
+}
 
-                        // get the target location from the source buffer
-                        M_OffsetToFixup::iterator found = source.second->m_OutgoingFixups.find( source.first );
-                        HELIUM_ASSERT( found != source.second->m_OutgoingFixups.end() );
+void SmartBuffer::FreeData()
+{
+    HELIUM_ASSERT( m_OwnsData && m_Data != NULL );
 
-                        // "do" fixup
-                        (*found).second->DoFixup( source );
-                    }
-                }
-            }
+    if (m_Virtual)
+    {
+        // release memory pages but not the address space
+        ::VirtualFree(m_Data,m_Capacity,MEM_DECOMMIT);
+        ::VirtualFree(m_Data,0,MEM_RELEASE);
+    }
+    else if (m_Paged)
+    {
+        BufferPagePool::Free( m_Data, m_Capacity );
+    }
+    else
+    {
+        ::free( m_Data );
+    }
+
+    Profile::Memory::Deallocate( s_DataPool, m_Capacity );
+}
+
+void SmartBuffer::RelinkIncomingFixups()
+{
+    // the incoming set and the references are still right, and offsets are relative to the buffers they are in,
+    //  so only the pointers need to be rewritten, there's no need to go through DoFixup for each of them
+    S_DumbBufferLocation::Iterator itr = m_IncomingFixups.Begin();
+    S_DumbBufferLocation::Iterator end = m_IncomingFixups.End();
+    for ( ; itr != end; ++itr )
+    {
+        const DumbBufferLocation& source = (*itr);
+
+        // get the target location from the source buffer
+        M_OffsetToFixup::const_iterator found = source.second->m_OutgoingFixups.find( source.first );
+        HELIUM_ASSERT( found != source.second->m_OutgoingFixups.end() );
+
+        if ( (*found).second->GetType() == FixupTypes::Pointer )
+        {
+            const PointerFixup* fixup = static_cast< const PointerFixup* >( (*found).second.Ptr() );
+            *(void**)( source.second->m_Data + source.first ) = m_Data + fixup->GetDestinationOffset();
         }
     }
 }
@@ -549,9 +598,7 @@ bool SmartBuffer::AdoptBuffer( const SmartBufferPtr& buffer )
         // be sure not to leak memory
         if ( m_Capacity > 0 )
         {
-            ::free( m_Data );
-
-            Profile::Memory::Deallocate( s_DataPool, m_Capacity );
+            FreeData();
 
             m_Data = NULL;
             m_Capacity = 0;
@@ -561,6 +608,7 @@ bool SmartBuffer::AdoptBuffer( const SmartBufferPtr& buffer )
         m_Data = buffer->m_Data;
         m_Size = buffer->m_Size;
         m_Capacity = buffer->m_Capacity;
+        m_Paged = buffer->m_Paged;
 
         // we need to take all the fixups and inherit them into this new buffer
         InheritFixups( buffer, 0 );
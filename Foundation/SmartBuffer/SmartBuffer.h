@@ -112,6 +112,11 @@ namespace Helium
             return m_Size;
         }
 
+        u32 GetDestinationOffset() const
+        {
+            return m_Destination.first;
+        }
+
         virtual FixupType GetType() const
         {
             return FixupTypes::Pointer;
@@ -197,6 +202,7 @@ namespace Helium
         bool                    m_OwnsData;
         ByteOrder               m_ByteOrder;
         bool                    m_Virtual;
+        bool                    m_Paged;
         M_OffsetToFixup         m_OutgoingFixups;
         S_DumbBufferLocation    m_IncomingFixups;
 
@@ -312,6 +318,15 @@ namespace Helium
         //  This must be called when the buffer is empty
         void SetVirtual(u32 size);
 
+        // Switch the smart buffer to grow in whole pages taken from the BufferPagePool, doubling its capacity
+        //  when it runs out instead of reallocating for each add.  This must be called when the buffer is empty
+        void SetPaged();
+
+        bool IsPaged() const
+        {
+            return m_Paged;
+        }
+
         // Grow the buffer to at least the specified size
         void GrowBy(u32 size);
 
@@ -368,5 +383,12 @@ namespace Helium
         static void WriteU64(const BufferLocation& pointer,u64 val);
         static void WriteF32(const BufferLocation& pointer,f32 val);
         static void WriteF64(const BufferLocation& pointer,f64 val);
+
+    private:
+        // Releases the data we own back to where it came from
+        void FreeData();
+
+        // Re-points the incoming pointers after our data has moved
+        void RelinkIncomingFixups();
     };
 }
\ No newline at end of file
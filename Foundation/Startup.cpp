@@ -32,9 +32,11 @@ const tchar* StartupArgs::Script = TXT( "script" );
 const tchar* StartupArgs::Attach = TXT( "attach" );
 const tchar* StartupArgs::Profile = TXT( "profile" );
 const tchar* StartupArgs::Memory = TXT( "memory" );
+const tchar* StartupArgs::Trace = TXT( "trace" );
 const tchar* StartupArgs::Verbose = TXT( "verbose" );
 const tchar* StartupArgs::Extreme = TXT( "extreme" );
 const tchar* StartupArgs::Debug = TXT( "debug" );
+const tchar* StartupArgs::SyncLog = TXT( "sync_log" );
 
 #ifdef _DEBUG
 const tchar* StartupArgs::DisableDebugHeap = TXT( "no_debug_heap" );
@@ -195,6 +197,12 @@ void Helium::Startup( int argc, const tchar** argv )
         Log::EnableStream( Log::Streams::Debug, Helium::GetCmdLineFlag( StartupArgs::Debug ) );
         Log::EnableStream( Log::Streams::Profile, Helium::GetCmdLineFlag( StartupArgs::Profile ) );
 
+        // write output from the log thread, unless we want it written by the thread that prints it (handy in the debugger)
+        if ( !Helium::GetCmdLineFlag( StartupArgs::SyncLog ) )
+        {
+            Log::InitializeAsyncOutput();
+        }
+
         if( Helium::GetCmdLineFlag( StartupArgs::Debug ) )
         {
             // add the debug stream to the trace
@@ -244,6 +252,12 @@ void Helium::Startup( int argc, const tchar** argv )
             {
                 Profile::Memory::Initialize();
             }
+
+            // record every profiled scope to the trace file
+            if ( Helium::GetCmdLineFlag( StartupArgs::Trace ) )
+            {
+                Profile::StartTrace();
+            }
         }
 
 
@@ -419,6 +433,9 @@ int Helium::Shutdown( int code )
             Profile::Cleanup(); 
         }
 
+        // everything printed has to make it out before the trace files close
+        Log::CleanupAsyncOutput();
+
         CleanupStandardTraceFiles();
 
         Helium::ReleaseCmdLine();
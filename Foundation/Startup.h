@@ -23,9 +23,11 @@ namespace Helium
         static const tchar* Attach;
         static const tchar* Profile;
         static const tchar* Memory;
+        static const tchar* Trace;
         static const tchar* Verbose;
         static const tchar* Extreme;
         static const tchar* Debug;
+        static const tchar* SyncLog;
 
 #ifdef _DEBUG
         static const tchar* DisableDebugHeap;
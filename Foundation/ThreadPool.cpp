@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+#include "Platform/Platform.h"
+#include "Platform/Assert.h"
+
+using namespace Helium;
+
+ThreadPool::ThreadPool( u32 threadCount, const char* name )
+: m_Pending (0)
+, m_Terminate (false)
+{
+    if ( threadCount == 0 )
+    {
+        threadCount = Helium::GetProcessorCount();
+    }
+
+    // nothing is queued, so we start out idle
+    m_Idle.Signal();
+
+    for ( u32 i=0; i<threadCount; ++i )
+    {
+        Thread* thread = new Thread ();
+        if ( !thread->Create( &Thread::EntryHelper< ThreadPool, &ThreadPool::WorkerThread >, this, name ) )
+        {
+            delete thread;
+            break;
+        }
+
+        m_Threads.push_back( thread );
+    }
+
+    HELIUM_ASSERT( !m_Threads.empty() );
+}
+
+ThreadPool::~ThreadPool()
+{
+    Wait();
+
+    {
+        TakeMutex mutex ( m_TasksMutex );
+        m_Terminate = true;
+    }
+
+    // wake everyone up so they see the terminate flag
+    std::vector< Thread* >::const_iterator itr = m_Threads.begin();
+    std::vector< Thread* >::const_iterator end = m_Threads.end();
+    for ( ; itr != end; ++itr )
+    {
+        m_TasksAvailable.Increment();
+    }
+
+    for ( itr = m_Threads.begin(); itr != end; ++itr )
+    {
+        (*itr)->Wait();
+        delete *itr;
+    }
+
+    m_Threads.clear();
+}
+
+void ThreadPool::Queue( TaskFunction function, void* param )
+{
+    HELIUM_ASSERT( function );
+
+    Task task;
+    task.m_Function = function;
+    task.m_Param = param;
+
+    {
+        TakeMutex mutex ( m_TasksMutex );
+
+        if ( m_Pending++ == 0 )
+        {
+            m_Idle.Reset();
+        }
+
+        m_Tasks.push_back( task );
+    }
+
+    m_TasksAvailable.Increment();
+}
+
+void ThreadPool::Wait()
+{
+    m_Idle.Wait();
+}
+
+void ThreadPool::WorkerThread()
+{
+    while ( true )
+    {
+        m_TasksAvailable.Decrement();
+
+        Task task;
+
+        {
+            TakeMutex mutex ( m_TasksMutex );
+
+            if ( m_Tasks.empty() )
+            {
+                if ( m_Terminate )
+                {
+                    return;
+                }
+
+                continue;
+            }
+
+            task = m_Tasks.front();
+            m_Tasks.pop_front();
+        }
+
+        task.m_Function( task.m_Param );
+
+        {
+            TakeMutex mutex ( m_TasksMutex );
+
+            if ( --m_Pending == 0 )
+            {
+                m_Idle.Signal();
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "API.h"
+
+#include "Platform/Types.h"
+#include "Platform/Thread.h"
+#include "Platform/Mutex.h"
+#include "Platform/Condition.h"
+#include "Platform/Semaphore.h"
+
+namespace Helium
+{
+    //
+    // ThreadPool - a fixed set of worker threads that service a queue of tasks
+    //  Tasks must not throw, catch and marshal your exceptions back to the caller of Wait()
+    //
+
+    class FOUNDATION_API ThreadPool
+    {
+    public:
+        typedef void (*TaskFunction)( void* param );
+
+        // a thread count of zero will create one thread per processor
+        ThreadPool( u32 threadCount = 0, const char* name = "Thread Pool" );
+        ~ThreadPool();
+
+        u32 GetThreadCount() const
+        {
+            return (u32)m_Threads.size();
+        }
+
+        // add a task to the queue, it may begin executing immediately
+        void Queue( TaskFunction function, void* param );
+
+        // block until all queued tasks have completed
+        void Wait();
+
+    private:
+        ThreadPool( const ThreadPool& rhs )
+        {
+
+        }
+
+        void WorkerThread();
+
+        struct Task
+        {
+            TaskFunction    m_Function;
+            void*           m_Param;
+        };
+
+        std::vector< Thread* >  m_Threads;
+        std::deque< Task >      m_Tasks;
+        Mutex                   m_TasksMutex;
+        Semaphore               m_TasksAvailable;
+        Condition               m_Idle;
+        u32                     m_Pending;
+        bool                    m_Terminate;
+    };
+}
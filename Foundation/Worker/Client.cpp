@@ -4,7 +4,7 @@
 #include "Platform/Exception.h"
 #include "Platform/Windows/Windows.h"
 #include "Foundation/CommandLine/Utilities.h"
-#include "Foundation/IPC/Pipe.h"
+#include "Foundation/IPC/SharedMemory.h"
 
 #include "Foundation/Startup.h"
 #include "Foundation/Exception.h"
@@ -56,9 +56,9 @@ static void TerminateListener(const Debug::TerminateArgs& args)
 
 bool Client::Initialize( bool debug, bool wait )
 {
-    IPC::PipeConnection* connection = new IPC::PipeConnection ();
+    IPC::SharedMemoryConnection* connection = new IPC::SharedMemoryConnection ();
 
-    // init pipe connection with this process' process id (hex)
+    // init shared memory connection with this process' process id (hex)
     tostringstream stream;
 
     if ( debug )
@@ -142,6 +142,9 @@ IPC::Message* Client::Receive(bool wait)
 
 bool Client::Send(u32 id, u32 size, const u8* data)
 {
+    // the printed listener forwards our output from the log thread, get it to the manager ahead of this message
+    Log::Flush();
+
     if (g_Connection && g_Connection->GetState() == IPC::ConnectionStates::Active)
     {
         IPC::Message* msg = g_Connection->CreateMessage(id, data ? size : 0);
@@ -0,0 +1,522 @@
+#include "Pool.h"
+
+#include "Platform/Atomic.h"
+#include "Platform/Assert.h"
+#include "Platform/Exception.h"
+#include "Platform/Platform.h"
+#include "Platform/Profile.h"
+#include "Platform/Thread.h"
+
+#include "Foundation/Log.h"
+#include "Foundation/IPC/Message.h"
+
+#include <string.h>
+
+using namespace Helium;
+using namespace Helium::Worker;
+
+struct Pool::Slot
+{
+    u32                             m_Index;
+    u32                             m_Launches;     // processes this slot has started
+    Helium::SmartPtr< Process >     m_Process;
+    Helium::Thread                  m_Thread;
+
+    Helium::Mutex                   m_Mutex;        // guards the queue, the owner and thieves both take from it
+    std::deque< JobPtr >            m_Jobs;
+
+    Slot( u32 index )
+        : m_Index (index)
+        , m_Launches (0)
+    {
+
+    }
+};
+
+Job::Job( u32 id, u32 size, const u8* data )
+: m_ID (id)
+, m_Complete (false)
+, m_Succeeded (false)
+, m_Attempts (0)
+, m_Queued (0)
+, m_Started (0)
+, m_Finished (0)
+{
+    if ( data && size )
+    {
+        m_Data.assign( data, data + size );
+    }
+}
+
+f32 Job::GetWaitMillis() const
+{
+    return m_Started ? Helium::CyclesToMillis( m_Started - m_Queued ) : 0.f;
+}
+
+f32 Job::GetRunMillis() const
+{
+    return m_Started && m_Finished > m_Started ? Helium::CyclesToMillis( m_Finished - m_Started ) : 0.f;
+}
+
+bool Job::Wait()
+{
+    while ( !m_Complete )
+    {
+        m_Done.Wait();
+    }
+
+    return m_Succeeded;
+}
+
+Pool::Pool()
+: m_Debug (false)
+, m_Wait (false)
+, m_Timeout (DefaultWorkerTimeout)
+, m_MaxAttempts (DefaultJobAttempts)
+, m_JobTimeout (DefaultJobTimeout)
+, m_Stopping (0)
+, m_Next (0)
+, m_Workers (0)
+, m_Queued (0)
+, m_Running (0)
+, m_Steals (0)
+, m_Outstanding (0)
+, m_Completed (0)
+, m_Failed (0)
+, m_Restarts (0)
+, m_WaitCycles (0)
+, m_RunCycles (0)
+, m_MaxLatencyCycles (0)
+{
+
+}
+
+Pool::~Pool()
+{
+    Stop();
+}
+
+bool Pool::Start( const tstring& executable, u32 count, bool debug, bool wait, int timeout )
+{
+    HELIUM_ASSERT( m_Slots.empty() );
+
+    m_Executable = executable;
+    m_Debug = debug;
+    m_Wait = wait;
+    m_Timeout = timeout;
+    m_Stopping = 0;
+
+    if ( count == 0 )
+    {
+        count = Helium::GetProcessorCount();
+    }
+
+    // there is only one debug connection to attach to
+    if ( debug )
+    {
+        count = 1;
+    }
+
+    for ( u32 i = 0; i < count; ++i )
+    {
+        m_Slots.push_back( new Slot ( i ) );
+    }
+
+    bool result = true;
+
+    for ( u32 i = 0; i < count; ++i )
+    {
+        // each thread starts its own worker, so they all come up at once
+        result &= m_Slots[ i ]->m_Thread.CreateWithArgs( &Helium::Thread::EntryHelperWithArgs< Pool, u32, &Pool::DispatchThread >, this, new u32 ( i ), "Worker Pool Dispatch" );
+    }
+
+    if ( !result )
+    {
+        Stop();
+    }
+
+    return result;
+}
+
+void Pool::Stop()
+{
+    if ( m_Slots.empty() )
+    {
+        return;
+    }
+
+    Helium::AtomicExchange( &m_Stopping, 1 );
+
+    // every thread wakes up, sees we're stopping, and lets its worker go
+    for ( u32 i = 0; i < m_Slots.size(); ++i )
+    {
+        m_Work.Increment();
+    }
+
+    for ( u32 i = 0; i < m_Slots.size(); ++i )
+    {
+        if ( m_Slots[ i ]->m_Thread.Valid() )
+        {
+            m_Slots[ i ]->m_Thread.Wait();
+            m_Slots[ i ]->m_Thread.Close();
+        }
+    }
+
+    // nobody is left to run what's still queued
+    for ( u32 i = 0; i < m_Slots.size(); ++i )
+    {
+        Slot* slot = m_Slots[ i ];
+
+        while ( !slot->m_Jobs.empty() )
+        {
+            JobPtr job = slot->m_Jobs.front();
+            slot->m_Jobs.pop_front();
+            Helium::AtomicDecrement( &m_Queued );
+
+            Finish( job, false );
+        }
+
+        delete slot;
+    }
+
+    m_Slots.clear();
+    m_Work.Reset();
+}
+
+void Pool::Submit( Job* job )
+{
+    HELIUM_ASSERT( !m_Slots.empty() );
+
+    job->m_Result.clear();
+    job->m_Complete = false;
+    job->m_Succeeded = false;
+    job->m_Attempts = 0;
+    job->m_Queued = Helium::TimerGetClock();
+    job->m_Started = 0;
+    job->m_Finished = 0;
+    job->m_Done.Reset();
+
+    {
+        Helium::TakeMutex mutex ( m_StatsMutex );
+
+        if ( m_Outstanding++ == 0 )
+        {
+            m_Idle.Reset();
+        }
+    }
+
+    Enqueue( job );
+}
+
+void Pool::WaitAll()
+{
+    while ( true )
+    {
+        {
+            Helium::TakeMutex mutex ( m_StatsMutex );
+
+            if ( m_Outstanding == 0 )
+            {
+                return;
+            }
+        }
+
+        m_Idle.Wait();
+    }
+}
+
+void Pool::GetStats( PoolStats& stats )
+{
+    stats.m_Workers = m_Workers;
+    stats.m_Queued = m_Queued;
+    stats.m_Running = m_Running;
+    stats.m_Steals = m_Steals;
+
+    Helium::TakeMutex mutex ( m_StatsMutex );
+
+    u32 finished = m_Completed + m_Failed;
+
+    stats.m_Completed = m_Completed;
+    stats.m_Failed = m_Failed;
+    stats.m_Restarts = m_Restarts;
+    stats.m_AverageWaitMillis = finished ? Helium::CyclesToMillis( m_WaitCycles ) / finished : 0.f;
+    stats.m_AverageRunMillis = finished ? Helium::CyclesToMillis( m_RunCycles ) / finished : 0.f;
+    stats.m_MaxLatencyMillis = Helium::CyclesToMillis( m_MaxLatencyCycles );
+}
+
+void Pool::ResetStats()
+{
+    Helium::AtomicExchange( &m_Steals, 0 );
+
+    Helium::TakeMutex mutex ( m_StatsMutex );
+
+    m_Completed = 0;
+    m_Failed = 0;
+    m_Restarts = 0;
+    m_WaitCycles = 0;
+    m_RunCycles = 0;
+    m_MaxLatencyCycles = 0;
+}
+
+void Pool::Enqueue( Job* job )
+{
+    Slot* slot = m_Slots[ (u32)Helium::AtomicIncrement( &m_Next ) % m_Slots.size() ];
+
+    {
+        Helium::TakeMutex mutex ( slot->m_Mutex );
+        slot->m_Jobs.push_back( job );
+    }
+
+    Helium::AtomicIncrement( &m_Queued );
+
+    // one count per queued job, whichever thread takes it is guaranteed to find one
+    m_Work.Increment();
+}
+
+JobPtr Pool::Dequeue( u32 index )
+{
+    u32 count = (u32)m_Slots.size();
+
+    for ( u32 i = 0; i < count; ++i )
+    {
+        Slot* slot = m_Slots[ ( index + i ) % count ];
+
+        Helium::TakeMutex mutex ( slot->m_Mutex );
+
+        if ( slot->m_Jobs.empty() )
+        {
+            continue;
+        }
+
+        JobPtr job;
+
+        if ( i == 0 )
+        {
+            // our own queue, oldest first
+            job = slot->m_Jobs.front();
+            slot->m_Jobs.pop_front();
+        }
+        else
+        {
+            // someone else's, take from the end they aren't working on
+            job = slot->m_Jobs.back();
+            slot->m_Jobs.pop_back();
+            Helium::AtomicIncrement( &m_Steals );
+        }
+
+        Helium::AtomicDecrement( &m_Queued );
+
+        return job;
+    }
+
+    return NULL;
+}
+
+void Pool::DispatchThread( u32& index )
+{
+    Slot& slot = *m_Slots[ index ];
+
+    // get the worker warmed up before the first job shows up
+    StartProcess( slot );
+
+    while ( true )
+    {
+        m_Work.Decrement();
+
+        if ( m_Stopping )
+        {
+            break;
+        }
+
+        JobPtr job = Dequeue( index );
+        HELIUM_ASSERT( job.ReferencesObject() );
+
+        if ( job.ReferencesObject() )
+        {
+            Run( slot, job );
+        }
+    }
+
+    StopProcess( slot );
+}
+
+void Pool::Run( Slot& slot, Job* job )
+{
+    ++job->m_Attempts;
+
+    if ( !slot.m_Process.ReferencesObject() && !StartProcess( slot ) )
+    {
+        Retry( job );
+        return;
+    }
+
+    Helium::AtomicIncrement( &m_Running );
+
+    job->m_Started = Helium::TimerGetClock();
+
+    bool answered = false;
+    bool succeeded = false;
+    bool expired = false;
+
+    if ( slot.m_Process->Send( job->m_ID, (u32)job->m_Data.size(), job->m_Data.empty() ? NULL : &job->m_Data.front() ) )
+    {
+        while ( true )
+        {
+            u32 timeout = 0xffffffff;
+
+            if ( m_JobTimeout )
+            {
+                // console output doesn't buy the worker more time
+                u32 elapsed = (u32)Helium::CyclesToMillis( Helium::TimerGetClock() - job->m_Started );
+                timeout = elapsed < m_JobTimeout ? m_JobTimeout - elapsed : 0;
+            }
+
+            IPC::Message* msg = timeout ? slot.m_Process->Receive( true, timeout ) : slot.m_Process->Receive( false );
+            if ( !msg )
+            {
+                expired = m_JobTimeout && slot.m_Process->Running() && Helium::CyclesToMillis( Helium::TimerGetClock() - job->m_Started ) >= m_JobTimeout;
+                break;
+            }
+
+            if ( msg->GetID() == ConsoleOutputMessage )
+            {
+                // pass the worker's output along as if we printed it
+                ConsoleOutput* output = (ConsoleOutput*)msg->GetData();
+                Log::PrintStatement( Log::Statement ( output->m_String, output->m_Stream, output->m_Level, output->m_Indent ) );
+                delete msg;
+                continue;
+            }
+
+            job->m_Result.assign( msg->GetData(), msg->GetData() + msg->GetSize() );
+            succeeded = msg->GetID() == JobCompleteMessage;
+            answered = true;
+
+            delete msg;
+            break;
+        }
+    }
+
+    Helium::AtomicDecrement( &m_Running );
+
+    if ( answered )
+    {
+        Finish( job, succeeded );
+    }
+    else
+    {
+        if ( expired )
+        {
+            Log::Warning( TXT( "Worker process %d took longer than %dms on a job, restarting it\n" ), slot.m_Index, m_JobTimeout );
+        }
+        else
+        {
+            Log::Warning( TXT( "Worker process %d went away while running a job, restarting it\n" ), slot.m_Index );
+        }
+
+        // releasing the process kills it if it's still going
+        StopProcess( slot );
+        Retry( job );
+    }
+}
+
+void Pool::Retry( Job* job )
+{
+    if ( job->m_Attempts < m_MaxAttempts && !m_Stopping )
+    {
+        Enqueue( job );
+    }
+    else
+    {
+        Finish( job, false );
+    }
+}
+
+void Pool::Finish( Job* job, bool succeeded )
+{
+    job->m_Finished = Helium::TimerGetClock();
+    job->m_Succeeded = succeeded;
+
+    {
+        Helium::TakeMutex mutex ( m_StatsMutex );
+
+        if ( succeeded )
+        {
+            ++m_Completed;
+        }
+        else
+        {
+            ++m_Failed;
+        }
+
+        if ( job->m_Started )
+        {
+            m_WaitCycles += job->m_Started - job->m_Queued;
+            m_RunCycles += job->m_Finished - job->m_Started;
+        }
+
+        if ( job->m_Finished - job->m_Queued > m_MaxLatencyCycles )
+        {
+            m_MaxLatencyCycles = job->m_Finished - job->m_Queued;
+        }
+
+        if ( --m_Outstanding == 0 )
+        {
+            m_Idle.Signal();
+        }
+    }
+
+    job->m_Complete = true;
+    job->m_Done.Signal();
+}
+
+bool Pool::StartProcess( Slot& slot )
+{
+    Process* process = Process::Create( m_Executable, m_Debug, m_Wait );
+
+    bool started = false;
+
+    try
+    {
+        started = process->Start( m_Timeout );
+    }
+    catch ( const Helium::Exception& ex )
+    {
+        Log::Error( TXT( "%s" ), ex.What() );
+    }
+
+    if ( !started )
+    {
+        Log::Warning( TXT( "Worker process %d failed to start\n" ), slot.m_Index );
+        Process::Release( process );
+        return false;
+    }
+
+    if ( slot.m_Launches++ )
+    {
+        Helium::TakeMutex mutex ( m_StatsMutex );
+        ++m_Restarts;
+    }
+
+    // the pool keeps its own reference, the process list might let go of it during shutdown
+    slot.m_Process = process;
+
+    Helium::AtomicIncrement( &m_Workers );
+
+    return true;
+}
+
+void Pool::StopProcess( Slot& slot )
+{
+    if ( !slot.m_Process.ReferencesObject() )
+    {
+        return;
+    }
+
+    Process* process = slot.m_Process;
+    Process::Release( process );
+
+    // this kills the process if it's still going
+    slot.m_Process = NULL;
+
+    Helium::AtomicDecrement( &m_Workers );
+}
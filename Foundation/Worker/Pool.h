@@ -0,0 +1,207 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "Platform/Types.h"
+#include "Platform/Mutex.h"
+#include "Platform/Semaphore.h"
+#include "Platform/Condition.h"
+
+#include "Foundation/API.h"
+#include "Foundation/Atomic.h"
+#include "Foundation/Worker/Process.h"
+
+namespace Helium
+{
+    namespace Worker
+    {
+        // number of times a job is run before we give up on it, a worker dying under it counts as a run
+        const static u32 DefaultJobAttempts = 3;
+
+        // millis a worker gets to answer a job before it's killed and restarted, the attempt counts as a run
+        const static u32 DefaultJobTimeout = 5 * 60 * 1000;
+
+        //
+        // Job is a single request for a worker process
+        //  The id and data are sent to the worker as a message, and the worker answers with
+        //  JobCompleteMessage or JobFailedMessage, carrying back any result data
+        //
+
+        class FOUNDATION_API Job : public Helium::AtomicRefCountBase
+        {
+        private:
+            u32                 m_ID;
+            std::vector< u8 >   m_Data;
+            std::vector< u8 >   m_Result;
+
+            volatile bool       m_Complete;
+            bool                m_Succeeded;
+            u32                 m_Attempts;
+
+            u64                 m_Queued;       // clock when the job was submitted
+            u64                 m_Started;      // clock when the job was last sent to a worker
+            u64                 m_Finished;     // clock when the job completed or failed
+
+            Helium::Condition   m_Done;
+
+            friend class Pool;
+
+        public:
+            Job( u32 id, u32 size = 0, const u8* data = NULL );
+
+            u32 GetID() const
+            {
+                return m_ID;
+            }
+
+            const std::vector< u8 >& GetData() const
+            {
+                return m_Data;
+            }
+
+            // data the worker sent back with its answer
+            const std::vector< u8 >& GetResult() const
+            {
+                return m_Result;
+            }
+
+            bool IsComplete() const
+            {
+                return m_Complete;
+            }
+
+            bool Succeeded() const
+            {
+                return m_Complete && m_Succeeded;
+            }
+
+            u32 GetAttempts() const
+            {
+                return m_Attempts;
+            }
+
+            // time spent queued before a worker took the job
+            f32 GetWaitMillis() const;
+
+            // time spent from being sent to the worker until the answer came back
+            f32 GetRunMillis() const;
+
+            // block until the pool is done with the job, returns Succeeded()
+            bool Wait();
+        };
+        typedef Helium::SmartPtr< Job > JobPtr;
+
+        struct PoolStats
+        {
+            u32 m_Workers;              // worker processes that are up and connected
+            u32 m_Queued;               // jobs waiting for a worker
+            u32 m_Running;              // jobs sent to a worker that haven't been answered
+            u32 m_Completed;            // jobs the workers finished successfully
+            u32 m_Failed;               // jobs the workers failed, or that ran out of attempts
+            u32 m_Restarts;             // worker processes started to replace ones that died
+            u32 m_Steals;               // jobs a worker took from another worker's queue
+            f32 m_AverageWaitMillis;    // average time from submission until a worker took the job
+            f32 m_AverageRunMillis;     // average time a worker spent on a job
+            f32 m_MaxLatencyMillis;     // longest time from submission to completion
+        };
+
+        //
+        // Pool keeps a set of worker processes running and feeds jobs to them over their IPC connections
+        //  Each worker has its own queue, a worker that runs dry takes jobs from the back of the others,
+        //  and a worker that dies is restarted and its job handed back out, so callers with lots of small
+        //  jobs only pay for process startup and the connection handshake once per worker
+        //
+
+        class FOUNDATION_API Pool
+        {
+        private:
+            struct Slot;
+
+            tstring                 m_Executable;
+            bool                    m_Debug;
+            bool                    m_Wait;
+            int                     m_Timeout;
+            u32                     m_MaxAttempts;
+            u32                     m_JobTimeout;
+
+            std::vector< Slot* >    m_Slots;
+            Helium::Semaphore       m_Work;             // counts jobs sitting in the queues
+            volatile i32            m_Stopping;
+            volatile i32            m_Next;             // round robin for submission
+
+            volatile i32            m_Workers;
+            volatile i32            m_Queued;
+            volatile i32            m_Running;
+            volatile i32            m_Steals;
+
+            Helium::Mutex           m_StatsMutex;       // guards the totals below
+            u32                     m_Outstanding;      // submitted jobs that haven't completed
+            u32                     m_Completed;
+            u32                     m_Failed;
+            u32                     m_Restarts;
+            u64                     m_WaitCycles;
+            u64                     m_RunCycles;
+            u64                     m_MaxLatencyCycles;
+            Helium::Condition       m_Idle;             // signaled when nothing is outstanding
+
+        public:
+            Pool();
+            ~Pool();
+
+            // launch the workers, count of zero runs one per processor
+            bool Start( const tstring& executable, u32 count = 0, bool debug = false, bool wait = false, int timeout = DefaultWorkerTimeout );
+
+            // wait for running jobs (no longer than the job timeout), fail anything still queued, and shut the workers down
+            void Stop();
+
+            bool IsRunning() const
+            {
+                return !m_Slots.empty();
+            }
+
+            void SetMaxAttempts( u32 attempts )
+            {
+                m_MaxAttempts = attempts ? attempts : 1;
+            }
+
+            // zero lets a job run as long as it likes, which means Stop can wait that long too
+            void SetJobTimeout( u32 millis )
+            {
+                m_JobTimeout = millis;
+            }
+
+            // queue a job for the next available worker
+            void Submit( Job* job );
+
+            // block until every submitted job has completed
+            void WaitAll();
+
+            // jobs waiting for a worker
+            u32 GetQueueDepth() const
+            {
+                return (u32)m_Queued;
+            }
+
+            void GetStats( PoolStats& stats );
+            void ResetStats();
+
+        private:
+            void Enqueue( Job* job );
+            JobPtr Dequeue( u32 index );
+
+            // worker thread entry, one per slot
+            void DispatchThread( u32& index );
+
+            // send the job to the slot's worker and wait for the answer
+            void Run( Slot& slot, Job* job );
+
+            // hand the job out again, or fail it if it's out of attempts
+            void Retry( Job* job );
+            void Finish( Job* job, bool succeeded );
+
+            bool StartProcess( Slot& slot );
+            void StopProcess( Slot& slot );
+        };
+    }
+}
@@ -1,16 +1,18 @@
 #include "Process.h"
 
 #include "Platform/Exception.h"
+#include "Platform/Profile.h"
 #include "Platform/Windows/Windows.h"
 
 #include "Foundation/Log.h"
-#include "Foundation/IPC/Pipe.h"
+#include "Foundation/IPC/SharedMemory.h"
 #include "Foundation/CommandLine/Utilities.h"
 
 #include "Foundation/Startup.h"
 #include "Foundation/Exception.h"
 
 #include <sstream>
+#include <algorithm>
 
 using namespace Helium;
 using namespace Helium::Worker;
@@ -22,6 +24,9 @@ const tchar* Worker::Args::Wait    = TXT( "worker_wait" );
 // the worker processes for a master application
 std::set< Helium::SmartPtr< Worker::Process > > g_Workers;
 
+// worker pools create and release processes from their own threads
+Helium::Mutex g_WorkersMutex;
+
 // Called from Debug if an exception occurs
 static void TerminateListener(const Debug::TerminateArgs& args)
 {
@@ -51,17 +56,23 @@ Process* Process::Create( const tstring& executable, bool debug, bool wait )
         Debug::g_Terminating.Add( &TerminateListener );
     }
 
+    Helium::TakeMutex mutex ( g_WorkersMutex );
+
     return g_Workers.insert( new Process ( executable, debug, wait ) ).first->Ptr();
 }
 
 void Process::Release( Process*& worker )
 {
+    Helium::TakeMutex mutex ( g_WorkersMutex );
+
     g_Workers.erase( worker );
     worker = NULL;
 }
 
 void Process::ReleaseAll()
 {
+    Helium::TakeMutex mutex ( g_WorkersMutex );
+
     g_Workers.clear();
 }
 
@@ -122,10 +133,10 @@ bool Process::Start( int timeout )
         // save this for query later
         m_Handle = procInfo.hProcess;
 
-        // create the server side of the connection
-        IPC::PipeConnection* connection = new IPC::PipeConnection ();
+        // create the server side of the connection, workers always run on this machine so they talk through shared memory
+        IPC::SharedMemoryConnection* connection = new IPC::SharedMemoryConnection ();
 
-        // init pipe connection with background process' process id (hex)
+        // init shared memory connection with background process' process id (hex)
         tostringstream stream;
 
         if ( m_Debug )
@@ -184,7 +195,7 @@ bool Process::Start( int timeout )
     }
 }
 
-IPC::Message* Process::Receive(bool wait)
+IPC::Message* Process::Receive(bool wait, u32 timeout)
 {
     IPC::Message* msg = NULL;
 
@@ -194,11 +205,29 @@ IPC::Message* Process::Receive(bool wait)
 
         if (!msg && wait)
         {
-            while (m_Connection->GetState() == IPC::ConnectionStates::Active && !msg)
+            u64 start = Helium::TimerGetClock();
+
+            // wait in slices, a worker that dies or hangs doesn't always take the connection down with it
+            while (!msg && m_Connection->GetState() == IPC::ConnectionStates::Active && Running())
             {
-                Sleep(1);
+                u32 slice = ReceivePollMillis;
 
-                m_Connection->Receive(&msg);
+                if (timeout != 0xffffffff)
+                {
+                    u32 elapsed = (u32)Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+                    if (elapsed >= timeout)
+                    {
+                        break;
+                    }
+
+                    slice = std::min( slice, timeout - elapsed );
+                }
+
+                if (m_Connection->Wait(slice))
+                {
+                    // there is a message or a wakeup waiting, so this won't block (and takes the wakeup if that's all it is)
+                    m_Connection->Receive(&msg, true);
+                }
             }
         }
     }
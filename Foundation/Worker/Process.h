@@ -23,6 +23,9 @@ namespace Helium
         //  - Worker's Worker::Initialize function will wait for a connection with the Manager process
         const static int DefaultWorkerTimeout = 10000;
 
+        // how often (in millis) a waiting Receive wakes to check the connection and the process are still up
+        const static u32 ReceivePollMillis = 100;
+
         struct FOUNDATION_API Args
         {
             static const tchar* Worker;
@@ -40,6 +43,10 @@ namespace Helium
         };
 
         const static u32 ConsoleOutputMessage = 0;
+
+        // a worker's answer to a job handed out by a Worker::Pool, with any result as the message data
+        const static u32 JobCompleteMessage = 1;
+        const static u32 JobFailedMessage = 2;
 #pragma warning ( default: 4200 )
 
         class FOUNDATION_API Process : public Helium::RefCountBase<Process>
@@ -79,8 +86,8 @@ namespace Helium
             // create process
             bool Start( int timeout = DefaultWorkerTimeout );
 
-            // you must delete the object this returns, if non-null
-            IPC::Message* Receive( bool wait = true );
+            // you must delete the object this returns, if non-null, a wait gives up after timeout millis
+            IPC::Message* Receive( bool wait = true, u32 timeout = 0xffffffff );
 
             // a copy is made into the IPC connection system
             bool Send(u32 id, u32 size = -1, const u8* data = NULL);
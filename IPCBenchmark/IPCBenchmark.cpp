@@ -0,0 +1,270 @@
+#include "Platform/Types.h"
+#include "Platform/Platform.h"
+#include "Platform/Profile.h"
+#include "Platform/Thread.h"
+
+#include "Foundation/Log.h"
+#include "Foundation/IPC/Message.h"
+#include "Foundation/CommandLine/Command.h"
+#include "Foundation/CommandLine/Option.h"
+
+#include <algorithm>
+#include <sstream>
+
+#ifdef WIN32
+# include "Foundation/Startup.h"
+#endif
+
+using namespace Helium;
+using namespace Helium::CommandLine;
+
+namespace Helium
+{
+    namespace IPCBenchmark
+    {
+        //
+        // Measures IPC message queue throughput with a growing number of sender threads
+        //
+
+        class IPCBenchmarkCommand : public Helium::CommandLine::Command
+        {
+        private:
+            bool m_HelpFlag;
+            u32 m_Threads;
+            u32 m_Count;
+            u32 m_Size;
+            u32 m_Backlog;
+            u32 m_Iterations;
+
+            IPC::MessageQueue m_Queue;
+
+        public:
+            IPCBenchmarkCommand();
+            virtual ~IPCBenchmarkCommand();
+
+            virtual bool Initialize( tstring& error ) HELIUM_OVERRIDE;
+            virtual void Cleanup() HELIUM_OVERRIDE;
+
+            virtual bool Process( std::vector< tstring >::const_iterator& argsBegin, const std::vector< tstring >::const_iterator& argsEnd, tstring& error ) HELIUM_OVERRIDE;
+
+        private:
+            // times the given number of sender threads pushing messages through the queue to this thread
+            bool BenchmarkQueue( u32 threads, tstring& error );
+
+            // sender thread entry, creates and queues m_Count messages
+            void SendThread( u32& index );
+        };
+    }
+}
+
+using namespace Helium::IPCBenchmark;
+
+IPCBenchmarkCommand::IPCBenchmarkCommand()
+: Command( TXT( "ipc-benchmark" ), TXT( "" ), TXT( "Measure IPC message queue throughput with many sender threads" ) )
+, m_HelpFlag( false )
+, m_Threads( 8 )
+, m_Count( 100000 )
+, m_Size( 128 )
+, m_Backlog( 4096 )
+, m_Iterations( 3 )
+{
+}
+
+IPCBenchmarkCommand::~IPCBenchmarkCommand()
+{
+}
+
+bool IPCBenchmarkCommand::Initialize( tstring& error )
+{
+    bool result = true;
+
+    result &= AddOption( new SimpleOption<u32>( &m_Threads, TXT( "threads" ), TXT( "<NUM>" ), TXT( "most sender threads to run, doubling from one (default 8)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_Count, TXT( "count" ), TXT( "<NUM>" ), TXT( "number of messages each sender queues (default 100000)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_Size, TXT( "size" ), TXT( "<NUM>" ), TXT( "payload bytes per message (default 128)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_Backlog, TXT( "backlog" ), TXT( "<NUM>" ), TXT( "senders back off when this many messages are queued, 0 for no limit (default 4096)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_Iterations, TXT( "iterations" ), TXT( "<NUM>" ), TXT( "number of times to run each test (default 3)" ) ), error );
+    result &= AddOption( new FlagOption( &m_HelpFlag, TXT( "h|help" ), TXT( "print command usage" ) ), error );
+
+    return result;
+}
+
+void IPCBenchmarkCommand::Cleanup()
+{
+    m_Queue.Clear();
+    IPC::MessagePool::Trim();
+}
+
+bool IPCBenchmarkCommand::Process( std::vector< tstring >::const_iterator& argsBegin, const std::vector< tstring >::const_iterator& argsEnd, tstring& error )
+{
+    if ( !ParseOptions( argsBegin, argsEnd, error ) )
+    {
+        return false;
+    }
+
+    if ( m_HelpFlag )
+    {
+        Log::Print( Help().c_str() );
+        return true;
+    }
+
+    if ( m_Threads == 0 )
+    {
+        m_Threads = 1;
+    }
+
+    if ( m_Iterations == 0 )
+    {
+        m_Iterations = 1;
+    }
+
+    Log::Print( TXT( "IPC Benchmark: %d messages per sender, %d byte payloads, backlog %d, %d processors\n" ), m_Count, m_Size, m_Backlog, Helium::GetProcessorCount() );
+
+    bool result = true;
+
+    for ( u32 threads = 1; result; threads *= 2 )
+    {
+        if ( threads > m_Threads )
+        {
+            threads = m_Threads;
+        }
+
+        result &= BenchmarkQueue( threads, error );
+
+        if ( threads == m_Threads )
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+bool IPCBenchmarkCommand::BenchmarkQueue( u32 threads, tstring& error )
+{
+    u64 total = (u64)threads * m_Count;
+    f32 millis = 0.f;
+
+    std::vector< u32 > sequence ( threads );
+    std::vector< Helium::Thread* > senders ( threads );
+
+    for ( u32 iteration = 0; iteration < m_Iterations; ++iteration )
+    {
+        std::fill( sequence.begin(), sequence.end(), 0 );
+
+        u64 start = Helium::TimerGetClock();
+
+        for ( u32 i = 0; i < threads; ++i )
+        {
+            senders[ i ] = new Helium::Thread;
+            senders[ i ]->CreateWithArgs( &Helium::Thread::EntryHelperWithArgs< IPCBenchmarkCommand, u32, &IPCBenchmarkCommand::SendThread >, this, new u32 ( i ), "IPC Benchmark Sender" );
+        }
+
+        u32 outOfOrder = 0;
+        for ( u64 received = 0; received < total; )
+        {
+            IPC::Message* msg = m_Queue.Remove();
+            if ( msg == NULL )
+            {
+                continue;
+            }
+
+            // each sender's messages must come out in the order it queued them
+            u32& expected = sequence[ msg->GetID() ];
+            if ( (u32)msg->GetTransaction() != expected )
+            {
+                ++outOfOrder;
+            }
+            expected = msg->GetTransaction() + 1;
+
+            delete msg;
+            ++received;
+        }
+
+        millis += Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+
+        for ( u32 i = 0; i < threads; ++i )
+        {
+            senders[ i ]->Wait();
+            senders[ i ]->Close();
+            delete senders[ i ];
+        }
+
+        if ( outOfOrder )
+        {
+            tstringstream str;
+            str << outOfOrder << TXT( " messages came out of the queue out of order with " ) << threads << TXT( " senders" );
+            error = str.str();
+            return false;
+        }
+    }
+
+    millis /= m_Iterations;
+
+    f32 seconds = millis / 1000.f;
+    if ( seconds <= 0.f )
+    {
+        seconds = 0.001f;
+    }
+
+    Log::Print( TXT( " %3d senders %10.2f ms %12.0f messages/s %10.2f MB/s\n" ), threads, millis, (f32)total / seconds, ( (f32)total * m_Size / ( 1024.f * 1024.f ) ) / seconds );
+
+    return true;
+}
+
+void IPCBenchmarkCommand::SendThread( u32& index )
+{
+    for ( u32 i = 0; i < m_Count; ++i )
+    {
+        IPC::Message* msg = IPC::Message::Create( index, i, m_Size, 0 );
+        if ( m_Size )
+        {
+            memset( msg->GetData(), (int)i, m_Size );
+        }
+
+        m_Queue.Add( msg );
+
+        // stand in for a writer that keeps up, otherwise we're just measuring how fast the heap grows
+        while ( m_Backlog && m_Queue.Count() > m_Backlog )
+        {
+            Helium::Sleep( 0 );
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Runs headless, with nothing but Foundation and Platform linked in
+//
+int Main( int argc, const tchar** argv )
+{
+    std::vector< tstring > options;
+    for ( int i = 1; i < argc; ++i )
+    {
+        options.push_back( argv[ i ] );
+    }
+    std::vector< tstring >::const_iterator argsBegin = options.begin(), argsEnd = options.end();
+
+    tstring error;
+
+    IPCBenchmarkCommand benchmark;
+    bool success = benchmark.Initialize( error ) && benchmark.Process( argsBegin, argsEnd, error );
+    benchmark.Cleanup();
+
+    if ( !success && !error.empty() )
+    {
+        Log::Error( TXT( "%s\n" ), error.c_str() );
+    }
+
+    return success ? 0 : 1;
+}
+
+#ifdef WIN32
+int _tmain( int argc, const tchar** argv )
+{
+    return Helium::StandardMain( &Main, argc, argv );
+}
+#else
+int main( int argc, const char** argv )
+{
+    return Main( argc, argv );
+}
+#endif
@@ -1,6 +1,7 @@
 #include "Image.h"
 
 #include "Platform/Exception.h"
+#include "Platform/Mutex.h"
 #include "Platform/Windows/Windows.h"
 
 #include "Foundation/Profile.h"
@@ -21,6 +22,9 @@
 
 using namespace Helium;
 
+// the jpeg decoder keeps its state in globals, so only one image can be decoded at a time
+static Helium::Mutex g_JPGMutex;
+
 //-----------------------------------------------------------------------------
 tchar* Image::p_volume_identifier_strings[VOLUME_NUM_IDENTIFIERS] =
 {
@@ -475,12 +479,7 @@ Image* Image::LoadFile( const tchar* p_path, bool convert_to_linear, LoadRAWInfo
 
     //
     // The selected texture is a proxy for an animated sequence to make into a volume texture
-
-    tchar old_dir[MAX_PATH];
-    if(GetCurrentDirectory(MAX_PATH, old_dir) == 0)
-    {
-        return NULL;
-    }
+    //  Frames are found by their full path, the current directory is shared by every thread that might be loading
 
     tchar anim_folder[MAX_PATH];
     Image* p_anim_texture = NULL;
@@ -495,8 +494,6 @@ Image* Image::LoadFile( const tchar* p_path, bool convert_to_linear, LoadRAWInfo
     }
     p_ext_start[0] = 0;
 
-    SetCurrentDirectory(anim_folder);
-
     HANDLE h_folder_search;
     WIN32_FIND_DATA folder_search_info;
     WIN32_FIND_DATA folder_files[VOLUME_MAX_DEPTH];
@@ -509,8 +506,10 @@ Image* Image::LoadFile( const tchar* p_path, bool convert_to_linear, LoadRAWInfo
     }
     p_ext[0] = '*';
 
+    tstring search = tstring (anim_folder) + TXT( "\\" ) + p_ext;
+
     u32 num_files_found = 0;
-    h_folder_search = FindFirstFile(p_ext, &folder_search_info);
+    h_folder_search = FindFirstFile(search.c_str(), &folder_search_info);
     if(h_folder_search != INVALID_HANDLE_VALUE)
     {
         do
@@ -536,7 +535,9 @@ Image* Image::LoadFile( const tchar* p_path, bool convert_to_linear, LoadRAWInfo
     {
         WIN32_FIND_DATA* p_curr_file = &folder_files[file_index];
 
-        Image* p_frame_texture = LoadSingleFile(p_curr_file->cFileName, convert_to_linear, info);
+        tstring frame_path = tstring (anim_folder) + TXT( "\\" ) + p_curr_file->cFileName;
+
+        Image* p_frame_texture = LoadSingleFile(frame_path.c_str(), convert_to_linear, info);
         if(p_frame_texture)
         {
             if(p_frame_texture->m_Depth != TWO_D_DEPTH) // Frames need to be 2D textures
@@ -573,8 +574,6 @@ Image* Image::LoadFile( const tchar* p_path, bool convert_to_linear, LoadRAWInfo
         }
     }
 
-    SetCurrentDirectory(old_dir);
-
     // We only support volume texture with a power of two depth due to swizzling and DXT compression limitations
     // TODO: Impement depth scaling?
     if( !curr_depth || (curr_depth != ::Math::NextPowerOfTwo(curr_depth)) )
@@ -628,6 +627,7 @@ Image* Image::LoadSingleFile(const tchar* filename, bool convert_to_linear, Load
     }
     else if ((_tcsicmp(ext,TXT(".jpg"))==0) || (_tcsicmp(ext,TXT(".jpeg"))==0))
     {
+        Helium::TakeMutex mutex (g_JPGMutex);
         result =  LoadJPG(data, convert_to_linear);
     }
     else if ((_tcsicmp(ext,TXT(".tif"))==0) || (_tcsicmp(ext,TXT(".tiff"))==0))
@@ -1,8 +1,13 @@
 #include "ImageProcess.h"
 
 #include "Platform/Types.h"
+#include "Platform/Atomic.h"
 #include "Platform/Exception.h"
+#include "Platform/Platform.h"
+#include "Platform/Semaphore.h"
+#include "Platform/String.h"
 
+#include "Foundation/ThreadPool.h"
 #include "Foundation/Checksum/CRC32.h"
 #include "Foundation/String/Utilities.h"
 
@@ -11,6 +16,7 @@
 #include "Pipeline/Image/Image.h"
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <assert.h>
 #include <string>
 #include <vector>
@@ -26,33 +32,178 @@ Helium::OutputColorFormat ImageProcess::g_DefaultOutputFormat   = Helium::OUTPUT
 Helium::PostMipImageFilter ImageProcess::g_DefaultPostMipFilter  = Helium::IMAGE_FILTER_NONE;
 
 
-////////////////////////////////////////////////////////////////////////////////////////////////
-//
-//  LoadImages
-//
-//  Loads the source textures and fills in the remainder of the process class
-//
-////////////////////////////////////////////////////////////////////////////////////////////////
-bool ImageProcess::Bank::LoadImages()
+namespace
 {
-  Log::Bullet bullet( TXT( "Loading...\n" ) );
+  //
+  // What one texture had to say while it was worked on, held until it's done so the log comes out in bank order
+  //
+
+  struct StepResult
+  {
+    bool                        m_done;
+    bool                        m_succeeded;
+    tstring                     m_error;      // the exception that stopped it, if any
+    Log::V_Statement            m_statements;
+
+    StepResult()
+      : m_done (false)
+      , m_succeeded (false)
+    {
+
+    }
+  };
+
+  // one piece of work on one texture, returns false or throws if the bank can't be built
+  typedef bool (*StepFunction)( u32 index, Definition* def );
+
+  struct StepRun
+  {
+    V_Definition*               m_textures;
+    std::vector< StepFunction > m_steps;
+    std::vector< StepResult >   m_results;
+    Helium::Semaphore           m_slots;      // one count per texture that may be in flight
+    volatile i32                m_next;       // next texture to hand out
+    volatile i32                m_failed;     // once set nobody starts on another texture
+  };
+
+  void StepTask( void* param )
+  {
+    StepRun* run = (StepRun*)param;
+
+    // textures are handed out in order, so everything ahead of one that fails has already been claimed and will finish
+    while ( !run->m_failed )
+    {
+      i32 index = Helium::AtomicIncrement( &run->m_next ) - 1;
+      if ( index >= (i32)run->m_textures->size() )
+      {
+        break;
+      }
+
+      // wait for a texture ahead of us to finish before holding another one in memory
+      run->m_slots.Decrement();
+
+      StepResult& result = run->m_results[ index ];
+      result.m_succeeded = true;
 
-  u32 c=0;
-  for (V_Definition::iterator i=m_textures.begin();i!=m_textures.end();++i)
+      {
+        // everything printed on this thread while the texture is worked on, loaders included, gets held for the report
+        Log::Listener listener ( Log::Streams::All, NULL, NULL, &result.m_statements );
+
+        try
+        {
+          for ( std::vector< StepFunction >::const_iterator step = run->m_steps.begin(); result.m_succeeded && step != run->m_steps.end(); ++step )
+          {
+            result.m_succeeded = (*step)( (u32)index, (*run->m_textures)[ index ] );
+          }
+        }
+        catch ( const Helium::Exception& ex )
+        {
+          result.m_error = ex.What();
+          result.m_succeeded = false;
+        }
+        catch ( const std::exception& ex )
+        {
+          Helium::ConvertString( ex.what(), result.m_error );
+          result.m_succeeded = false;
+        }
+        catch ( ... )
+        {
+          result.m_error = TXT( "Unknown exception" );
+          result.m_succeeded = false;
+        }
+      }
+
+      result.m_done = true;
+
+      if ( !result.m_succeeded )
+      {
+        Helium::AtomicExchange( &run->m_failed, 1 );
+      }
+
+      run->m_slots.Increment();
+    }
+  }
+
+  bool RunSteps( V_Definition& textures, u32 threadCount, u32 maxInFlight, const std::vector< StepFunction >& steps )
   {
-    tstring filename = (*i)->m_texture_file;
+    StepRun run;
+    run.m_textures = &textures;
+    run.m_steps = steps;
+    run.m_results.resize( textures.size() );
+    run.m_next = 0;
+    run.m_failed = 0;
+
+    // the in flight limit bounds memory, the thread count bounds cpu, extra threads just wait for a texture to finish
+    u32 slots = maxInFlight ? maxInFlight : 1;
+    for ( u32 i = 0; i < slots; ++i )
+    {
+      run.m_slots.Increment();
+    }
+
+    if ( threadCount == 0 )
+    {
+      threadCount = Helium::GetProcessorCount();
+    }
+
+    u32 workers = threadCount;
+    if ( workers > textures.size() )
+    {
+      workers = (u32)textures.size();
+    }
+
+    if ( workers <= 1 )
+    {
+      StepTask( &run );
+    }
+    else
+    {
+      Helium::ThreadPool pool ( workers, "Image Process" );
+
+      for ( u32 i = 0; i < workers; ++i )
+      {
+        pool.Queue( &StepTask, &run );
+      }
+
+      pool.Wait();
+    }
+
+    // report the way a single thread would have, stopping at the first texture that failed
+    for ( std::vector< StepResult >::const_iterator result = run.m_results.begin(); result != run.m_results.end() && result->m_done; ++result )
+    {
+      Log::PrintStatements( result->m_statements );
+
+      if ( !result->m_error.empty() )
+      {
+        throw Helium::Exception( TXT( "%s" ), result->m_error.c_str() );
+      }
+
+      if ( !result->m_succeeded )
+      {
+        return false;
+      }
+    }
+
+    return !run.m_failed;
+  }
+
+  bool RunSteps( V_Definition& textures, u32 threadCount, u32 maxInFlight, StepFunction step )
+  {
+    return RunSteps( textures, threadCount, maxInFlight, std::vector< StepFunction > ( 1, step ) );
+  }
+
+  bool LoadStep( u32 index, Definition* def )
+  {
+    tstring filename = def->m_texture_file;
     size_t pos = filename.find_last_of( TXT( "\\/" ) );
     if (pos != tstring::npos)
       filename = filename.substr(pos+1);
 
-    Log::Print( Log::Levels::Verbose, TXT( "[%d] : %s" ), c, filename.c_str());
-
-    bool convert_to_linear = (*i)->m_is_normal_map ? false : true;
-    Helium::Image* tex = Helium::Image::LoadFile((*i)->m_texture_file.c_str(), convert_to_linear, NULL);
+    bool convert_to_linear = def->m_is_normal_map ? false : true;
+    Helium::Image* tex = Helium::Image::LoadFile(def->m_texture_file.c_str(), convert_to_linear, NULL);
     if (tex)
     {
       // convert all input images to either RGBA 8 bit or RGBA floating point
-      if (ColorFormatHDR( (*i)->m_output_format))
+      if (ColorFormatHDR( def->m_output_format))
       {
         tex->m_NativeFormat = Helium::CF_RGBAFLOATMAP;
       }
@@ -64,138 +215,102 @@ bool ImageProcess::Bank::LoadImages()
       tchar* type[] = { TXT( "2D TEXTURE" ), TXT( "CUBE MAP") , TXT( "VOLUME TEXTURE" ) };
       if (tex->Type()==Helium::Image::VOLUME)
       {
-        Log::Print( Log::Levels::Verbose, TXT( "%s %d x %d x %d\n" ),type[tex->Type()],tex->m_Width,tex->m_Height,tex->m_Depth);
+        Log::Print( Log::Levels::Verbose, TXT( "[%d] : %s%s %d x %d x %d\n" ),index,filename.c_str(),type[tex->Type()],tex->m_Width,tex->m_Height,tex->m_Depth);
       }
       else
       {
-        Log::Print( Log::Levels::Verbose, TXT( "%s %d x %d\n" ),type[tex->Type()],tex->m_Width,tex->m_Height);
+        Log::Print( Log::Levels::Verbose, TXT( "[%d] : %s%s %d x %d\n" ),index,filename.c_str(),type[tex->Type()],tex->m_Width,tex->m_Height);
       }
 
-      (*i)->m_texture = tex;
+      def->m_texture = tex;
     }
     else
     {
-      Log::Warning( TXT( "Failed to load '%s'\n" ),(*i)->m_texture_file.c_str());
+      Log::Print( Log::Levels::Verbose, TXT( "[%d] : %s" ),index,filename.c_str());
+      Log::Warning( TXT( "Failed to load '%s'\n" ),def->m_texture_file.c_str());
       return false;
     }
-    c++;
-  }
-
-  return true;
-}
-
 
-////////////////////////////////////////////////////////////////////////////////////////////////
-//
-//  AdjustImages
-//
-//  Adjust the source image for being non power of 2 or if it requires prescaling
-//
-////////////////////////////////////////////////////////////////////////////////////////////////
+    return true;
+  }
 
-inline bool IsOne(float v)
-{
+  inline bool IsOne(float v)
+  {
     const float diff = fabsf(1.f - v);
     return diff <= 0.001f;
-}
-
-bool ImageProcess::Bank::AdjustImages()
-{
-  Log::Bullet bullet( TXT( "Adjusting...\n" ) );
+  }
 
-  // relative scale should be done before the power of 2 restriction...
-  for (V_Definition::iterator i=m_textures.begin();i!=m_textures.end();i++)
+  bool AdjustStep( u32 index, Definition* def )
   {
-    if ((*i)->m_texture)
+    // relative scale should be done before the power of 2 restriction...
+    if (def->m_texture)
     {
       // now if there is a relative scale set in the input then scale
-
-
-      if ( !IsOne( (*i)->m_relscale_x ) || !IsOne( (*i)->m_relscale_y ) )
+      if ( !IsOne( def->m_relscale_x ) || !IsOne( def->m_relscale_y ) )
       {
-        Helium::Image* new_tex = (*i)->m_texture->RelativeScaleImage((*i)->m_relscale_x, (*i)->m_relscale_y, (*i)->m_texture->m_NativeFormat, Helium::MIP_FILTER_CUBIC);
-        if (new_tex)
+        Helium::Image* new_tex = def->m_texture->RelativeScaleImage(def->m_relscale_x, def->m_relscale_y, def->m_texture->m_NativeFormat, Helium::MIP_FILTER_CUBIC);
+        if (!new_tex)
         {
           throw Helium::Exception( TXT( "Failed to rescale, aborting" ) );
         }
-        delete (*i)->m_texture;
-        (*i)->m_texture = new_tex;
+        delete def->m_texture;
+        def->m_texture = new_tex;
       }
     }
-  }
 
-
-  for (V_Definition::iterator i=m_textures.begin();i!=m_textures.end();i++)
-  {
-    if ((*i)->m_texture && (*i)->m_force_power_of_2)
+    if (def->m_texture && def->m_force_power_of_2)
     {
       // first process for being a power of 2
-      if ( !Math::IsPowerOfTwo((*i)->m_texture->m_Width) || !Math::IsPowerOfTwo((*i)->m_texture->m_Height) )
+      if ( !Math::IsPowerOfTwo(def->m_texture->m_Width) || !Math::IsPowerOfTwo(def->m_texture->m_Height) )
       {
         // this texture is not a power of 2 so rescale it to fix it
-        Log::Warning( TXT( "Rescaling texture '%s', it is not a power of 2 (%d x %d)\n" ),(*i)->m_texture_file.c_str(),(*i)->m_texture->m_Width,(*i)->m_texture->m_Height);
+        Log::Warning( TXT( "Rescaling texture '%s', it is not a power of 2 (%d x %d)\n" ),def->m_texture_file.c_str(),def->m_texture->m_Width,def->m_texture->m_Height);
 
-        Helium::Image* new_tex = (*i)->m_texture->ScaleUpNextPowerOfTwo((*i)->m_texture->m_NativeFormat,Helium::MIP_FILTER_CUBIC);
+        Helium::Image* new_tex = def->m_texture->ScaleUpNextPowerOfTwo(def->m_texture->m_NativeFormat,Helium::MIP_FILTER_CUBIC);
         if (!new_tex)
         {
           throw Helium::Exception( TXT( "Failed to rescale, aborting" ) );
         }
-        delete (*i)->m_texture;
-        (*i)->m_texture = new_tex;
+        delete def->m_texture;
+        def->m_texture = new_tex;
       }
     }
 
-    if ((*i)->m_texture == NULL)
+    if (def->m_texture == NULL)
     {
-      tchar buf[120];
-      _stprintf(buf, TXT( "Image %s has no pixel data, file may be missing or corrupted" ), (*i)->m_texture_file.c_str());
-      throw Helium::Exception(buf);
+      throw Helium::Exception( TXT( "Image %s has no pixel data, file may be missing or corrupted" ), def->m_texture_file.c_str() );
     }
-  }
 
-  return true;
-}
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////
-//
-//  CompressImages
-//
-//  Compress and generate the output data along with all the associated mip maps
-//
-////////////////////////////////////////////////////////////////////////////////////////////////
-bool ImageProcess::Bank::CompressImages()
-{
-  Log::Bullet bullet( TXT( "Compressing...\n" ) );
+    return true;
+  }
 
-  u32 count=0;
-  for (V_Definition::iterator i=m_textures.begin();i!=m_textures.end();i++)
+  bool CompressStep( u32 index, Definition* def )
   {
-    if ((*i)->m_texture)
+    if (def->m_texture)
     {
       Helium::MipGenOptions m;
-      if ( (*i)->m_force_single_mip_level || !Math::IsPowerOfTwo((*i)->m_texture->m_Width) || !Math::IsPowerOfTwo((*i)->m_texture->m_Height) )
+      if ( def->m_force_single_mip_level || !Math::IsPowerOfTwo(def->m_texture->m_Width) || !Math::IsPowerOfTwo(def->m_texture->m_Height) )
       {
         // NP2 textures get only 1 mip level
         m.m_Levels  = 1;
       }
 
       // set the output format
-      m.m_OutputFormat  = (*i)->m_output_format;
-      m.m_PostFilter    = (*i)->m_post_filter;
+      m.m_OutputFormat  = def->m_output_format;
+      m.m_PostFilter    = def->m_post_filter;
 
       // generate mipset
       Helium::MipSet* mips = NULL;
-      if ( (*i)->m_is_normal_map )
+      if ( def->m_is_normal_map )
       {
         // does a clone if sizes are the same
-        Helium::Image* nt = (*i)->m_texture->ScaleImage((*i)->m_texture->m_Width, (*i)->m_texture->m_Height, (*i)->m_texture->m_NativeFormat, m.m_Filter);
+        Helium::Image* nt = def->m_texture->ScaleImage(def->m_texture->m_Width, def->m_texture->m_Height, def->m_texture->m_NativeFormat, m.m_Filter);
 
-        nt->PrepareFor2ChannelNormalMap((*i)->m_is_detail_normal_map, (*i)->m_is_detail_map_only);
+        nt->PrepareFor2ChannelNormalMap(def->m_is_detail_normal_map, def->m_is_detail_map_only);
 
         //Don't convert to sRGB
         m.m_ConvertToSrgb = false;
-        mips              = nt->GenerateMipSet(m, (*i)->m_runtime);
+        mips              = nt->GenerateMipSet(m, def->m_runtime);
 
         delete nt;
       }
@@ -203,7 +318,7 @@ bool ImageProcess::Bank::CompressImages()
       {
         //Convert to sRGB
         m.m_ConvertToSrgb = true;
-        mips              = (*i)->m_texture->GenerateMipSet(m, (*i)->m_runtime);
+        mips              = def->m_texture->GenerateMipSet(m, def->m_runtime);
       }
 
       if (!mips)
@@ -215,15 +330,66 @@ bool ImageProcess::Bank::CompressImages()
       for (u32 level=0; level<mips->m_levels_used; level++)
         size += mips->m_datasize[level];
 
-      Log::Print( Log::Levels::Verbose, TXT( "%8.02f kb used by '%s'\n" ), (float)(size) / 1024.f, (*i)->m_texture_file.c_str() );
+      Log::Print( Log::Levels::Verbose, TXT( "%8.02f kb used by '%s'\n" ), (float)(size) / 1024.f, def->m_texture_file.c_str() );
 
-      (*i)->m_mips = mips;
+      def->m_mips = mips;
     }
 
-    count++;
+    return true;
   }
 
-  return true;
+  bool ReleaseStep( u32 index, Definition* def )
+  {
+    // the mips are all the bank needs from here on, the source image is the bulk of what a texture holds
+    delete def->m_texture;
+    def->m_texture = NULL;
+
+    return true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  LoadImages
+//
+//  Loads the source textures and fills in the remainder of the process class
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+bool ImageProcess::Bank::LoadImages()
+{
+  Log::Bullet bullet( TXT( "Loading...\n" ) );
+
+  return RunSteps( m_textures, m_thread_count, m_max_in_flight, &LoadStep );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  AdjustImages
+//
+//  Adjust the source image for being non power of 2 or if it requires prescaling
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+bool ImageProcess::Bank::AdjustImages()
+{
+  Log::Bullet bullet( TXT( "Adjusting...\n" ) );
+
+  return RunSteps( m_textures, m_thread_count, m_max_in_flight, &AdjustStep );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  CompressImages
+//
+//  Compress and generate the output data along with all the associated mip maps
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+bool ImageProcess::Bank::CompressImages()
+{
+  Log::Bullet bullet( TXT( "Compressing...\n" ) );
+
+  return RunSteps( m_textures, m_thread_count, m_max_in_flight, &CompressStep );
 }
 
 
@@ -236,37 +402,44 @@ bool ImageProcess::Bank::CompressImages()
 ////////////////////////////////////////////////////////////////////////////////////////////////
 bool ImageProcess::Bank::Pack()
 {
-  // load the images, missing textures are written as default textures but
-  // textures ommited for a given level are written as NULL entries in the
-  // contents of the pack file.
-  if (!ImageProcess::Bank::LoadImages())
-  {
-    return false;
-  }
+  std::vector< StepFunction > steps;
 
-  // Give our definition processors a chance to modify the defintions if they need to
-  V_Definition::iterator it = m_textures.begin();
-  V_Definition::iterator end = m_textures.end();
-  for ( ; it != end; ++it )
+  // definition processors and post load listeners expect the whole bank loaded before they run,
+  //  so only then do we have to hold every source image at once
+  if ( m_ProcessDefinition.Valid() || m_PostLoad.Valid() )
   {
-    m_ProcessDefinition.Raise( *it );
-  }
+    // load the images, missing textures are written as default textures but
+    // textures ommited for a given level are written as NULL entries in the
+    // contents of the pack file.
+    if (!ImageProcess::Bank::LoadImages())
+    {
+      return false;
+    }
 
-  m_PostLoad.Raise( PostLoadArgs() );
+    // Give our definition processors a chance to modify the defintions if they need to
+    V_Definition::iterator it = m_textures.begin();
+    V_Definition::iterator end = m_textures.end();
+    for ( ; it != end; ++it )
+    {
+      m_ProcessDefinition.Raise( *it );
+    }
 
-  // resize if not a power of two or if we are rescaling the input
-  if (!ImageProcess::Bank::AdjustImages())
-  {
-    return false;
+    m_PostLoad.Raise( PostLoadArgs() );
   }
-
-  // compress and generate mip levels
-  if (!ImageProcess::Bank::CompressImages())
+  else
   {
-    return false;
+    steps.push_back( &LoadStep );
   }
 
-  return true;
+  // resize if not a power of two or if we are rescaling the input, then compress and generate mip levels,
+  //  each texture goes straight through and lets go of its source image so only m_max_in_flight are held at once
+  steps.push_back( &AdjustStep );
+  steps.push_back( &CompressStep );
+  steps.push_back( &ReleaseStep );
+
+  Log::Bullet bullet( steps.front() == &LoadStep ? TXT( "Loading, adjusting and compressing...\n" ) : TXT( "Adjusting and compressing...\n" ) );
+
+  return RunSteps( m_textures, m_thread_count, m_max_in_flight, steps );
 }
 
 bool Bank::WriteDebugFile( const tstring& debug_file )
@@ -291,7 +464,7 @@ bool Bank::WriteDebugFile( const tstring& debug_file )
   {
     const DefinitionPtr& def = *it;
 
-    fprintf( f,"%s [%s,%s,%dx%dx%d][%s]\n",def->m_texture_file.c_str(),type[def->m_texture->Type()],ColorFormatName(def->m_output_format),def->m_mips->m_width,def->m_mips->m_height,def->m_mips->m_depth,def->m_enum.c_str());
+    fprintf( f,"%s [%s,%s,%dx%dx%d][%s]\n",def->m_texture_file.c_str(),type[def->m_mips->m_texture_type],ColorFormatName(def->m_output_format),def->m_mips->m_width,def->m_mips->m_height,def->m_mips->m_depth,def->m_enum.c_str());
   }
 
   fclose( f );
@@ -97,8 +97,14 @@ namespace Helium
         };
         typedef Helium::Signature< const PostLoadArgs&> PostLoadSignature;
 
+        // each texture being worked on holds its source image plus scratch copies while it's scaled and compressed,
+        //  Pack lets go of the source once the mips are built
+        const static u32 DefaultMaxInFlight = 16;
+
         //
         // The Bank class builds Defs into a packed bank of textures
+        //  Textures are loaded, adjusted and compressed on a pool of threads, but everything they
+        //  produce and everything they log (loaders included) comes out in the order of m_textures
         //
 
         class Bank
@@ -112,6 +118,19 @@ namespace Helium
             // The list of textures to work with
             V_Definition m_textures;
 
+            // threads to work on textures with, zero for one per processor
+            u32 m_thread_count;
+
+            // most textures to work on at once, this is what bounds memory use, threads past it wait their turn
+            u32 m_max_in_flight;
+
+            Bank()
+                : m_thread_count (0)
+                , m_max_in_flight (DefaultMaxInFlight)
+            {
+
+            }
+
             // Events
             void AddDefinitionProcessor( const DefinitionSignature::Delegate& listener )
             {
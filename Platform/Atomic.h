@@ -6,13 +6,20 @@
 
 namespace Helium
 {
-    PLATFORM_API void AtomicIncrement( volatile i32* value );
-    PLATFORM_API void AtomicDecrement( volatile i32* value );
-    PLATFORM_API void AtomicExchange( volatile i32* addr, i32 value );
+    // increment and decrement return the new value, exchange returns the old one
+    PLATFORM_API i32 AtomicIncrement( volatile i32* value );
+    PLATFORM_API i32 AtomicDecrement( volatile i32* value );
+    PLATFORM_API i32 AtomicExchange( volatile i32* addr, i32 value );
+
+    // stores value if addr holds comparand, returns what addr held (so success is a return of comparand)
+    PLATFORM_API i32 AtomicCompareExchange( volatile i32* addr, i32 value, i32 comparand );
 
 #ifdef X64
-    PLATFORM_API void AtomicIncrement( volatile i64* value );
-    PLATFORM_API void AtomicDecrement( volatile i64* value );
-    PLATFORM_API void AtomicExchange( volatile i64* addr, i64 value );
+    PLATFORM_API i64 AtomicIncrement( volatile i64* value );
+    PLATFORM_API i64 AtomicDecrement( volatile i64* value );
+    PLATFORM_API i64 AtomicExchange( volatile i64* addr, i64 value );
 #endif
+
+    // full barrier, anything written before this call is visible to readers of the new pointer
+    PLATFORM_API void* AtomicExchangePointer( void* volatile* addr, void* value );
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "API.h"
+#include "Types.h"
+
+namespace Helium
+{
+    //
+    // MappedFile - a read-only view of an entire file mapped into our address space
+    //  The OS pages the data in on demand, so reading it costs no syscalls and no copies
+    //
+
+    class PLATFORM_API MappedFile
+    {
+    public:
+#ifdef WIN32
+        typedef void* Handle;
+#else
+        typedef int Handle;
+#endif
+
+    private:
+        Handle      m_File;
+        Handle      m_Mapping;
+        const u8*   m_Data;
+        u64         m_Size;
+
+    public:
+        MappedFile();
+        ~MappedFile();
+
+    private:
+        MappedFile( const MappedFile& rhs )
+        {
+
+        }
+
+    public:
+        // map the whole file for reading, an empty file opens successfully with no data
+        bool Open( const tchar* path );
+
+        // unmap the view and close the file
+        void Close();
+
+        bool IsOpen() const;
+
+        const u8* GetData() const
+        {
+            return m_Data;
+        }
+
+        u64 GetSize() const
+        {
+            return m_Size;
+        }
+    };
+}
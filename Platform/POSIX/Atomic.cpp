@@ -1,35 +1,50 @@
 #include "Platform/Atomic.h"
 
-void Helium::AtomicIncrement( volatile i32* value )
+i32 Helium::AtomicIncrement( volatile i32* value )
 {
-    HELIUM_ASSERT( false );
+    return __sync_add_and_fetch( value, 1 );
 }
 
-void Helium::AtomicDecrement( volatile i32* value )
+i32 Helium::AtomicDecrement( volatile i32* value )
 {
-    HELIUM_ASSERT( false );
+    return __sync_sub_and_fetch( value, 1 );
 }
 
-void Helium::AtomicExchange( volatile i32* addr, i32 value )
+i32 Helium::AtomicExchange( volatile i32* addr, i32 value )
 {
-    HELIUM_ASSERT( false );
+    // test and set is only an acquire barrier, make it a full one like InterlockedExchange
+    __sync_synchronize();
+    return __sync_lock_test_and_set( addr, value );
+}
+
+i32 Helium::AtomicCompareExchange( volatile i32* addr, i32 value, i32 comparand )
+{
+    return __sync_val_compare_and_swap( addr, comparand, value );
 }
 
 #ifdef X64
 
-void Helium::AtomicIncrement( volatile i64* value )
+i64 Helium::AtomicIncrement( volatile i64* value )
 {
-    HELIUM_ASSERT( false );
+    return __sync_add_and_fetch( value, 1 );
 }
 
-void Helium::AtomicDecrement( volatile i64* value )
+i64 Helium::AtomicDecrement( volatile i64* value )
 {
-    HELIUM_ASSERT( false );
+    return __sync_sub_and_fetch( value, 1 );
 }
 
-void Helium::AtomicExchange( volatile i64* addr, i64 value )
+i64 Helium::AtomicExchange( volatile i64* addr, i64 value )
 {
-    HELIUM_ASSERT( false );
+    // test and set is only an acquire barrier, make it a full one like InterlockedExchange
+    __sync_synchronize();
+    return __sync_lock_test_and_set( addr, value );
 }
 
 #endif
+
+void* Helium::AtomicExchangePointer( void* volatile* addr, void* value )
+{
+    __sync_synchronize();
+    return __sync_lock_test_and_set( addr, value );
+}
@@ -0,0 +1,84 @@
+#include "Platform/MappedFile.h"
+#include "Platform/Assert.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Helium;
+
+MappedFile::MappedFile()
+: m_File (-1)
+, m_Mapping (-1)
+, m_Data (NULL)
+, m_Size (0)
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open( const tchar* path )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    m_File = open( path, O_RDONLY );
+    if ( m_File < 0 )
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if ( fstat( m_File, &fileStat ) != 0 )
+    {
+        Close();
+        return false;
+    }
+
+    m_Size = fileStat.st_size;
+
+    // mapping a zero length file is an error, but opening one is not
+    if ( m_Size == 0 )
+    {
+        return true;
+    }
+
+    void* data = mmap( NULL, (size_t)m_Size, PROT_READ, MAP_SHARED, m_File, 0 );
+    if ( data == MAP_FAILED )
+    {
+        Close();
+        return false;
+    }
+
+    // we read front to back, let the kernel read ahead aggressively
+    madvise( data, (size_t)m_Size, MADV_SEQUENTIAL );
+
+    m_Data = (const u8*)data;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if ( m_Data )
+    {
+        munmap( (void*)m_Data, (size_t)m_Size );
+        m_Data = NULL;
+    }
+
+    if ( m_File >= 0 )
+    {
+        close( m_File );
+        m_File = -1;
+    }
+
+    m_Size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return m_File >= 0;
+}
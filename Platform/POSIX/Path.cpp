@@ -1,5 +1,7 @@
 #include "Platform/Path.h"
 
+#include <stdio.h>
+
 const tchar Helium::PathSeparator = '/';
 
 bool Helium::GetFullPath( const tchar* path, tstring& fullPath )
@@ -27,6 +29,11 @@ bool Helium::Move( const tchar* source, const tchar* dest )
     return false;
 }
 
+bool Helium::Replace( const tchar* source, const tchar* dest )
+{
+    return rename( source, dest ) == 0;
+}
+
 bool Helium::Delete( const tchar* path )
 {
     return false;
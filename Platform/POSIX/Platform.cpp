@@ -23,3 +23,9 @@ void Helium::Sleep(int millis)
 {
     usleep( millis * 1000 );
 }
+
+u32 Helium::GetProcessorCount()
+{
+    long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return count > 0 ? (u32)count : 1;
+}
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "Platform/Process.h"
 
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
 int Helium::Execute( const tstring& command, bool showWindow, bool block )
 {
     return -1;
@@ -14,3 +18,14 @@ tstring Helium::GetProcessString()
 {
     return "";
 }
+
+u32 Helium::GetProcessID()
+{
+    return (u32)getpid();
+}
+
+bool Helium::IsProcessRunning( u32 processID )
+{
+    // signal 0 just checks the process exists, EPERM means it does but belongs to someone else
+    return kill( (pid_t)processID, 0 ) == 0 || errno == EPERM;
+}
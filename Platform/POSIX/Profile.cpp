@@ -4,9 +4,9 @@
 #include <pthread.h>
 #include <assert.h>
 
-void Helium::TraceFile::Open(const tchar* file)
+bool Helium::TraceFile::Open(const tchar* file)
 {
-
+    return false;
 }
 
 void Helium::TraceFile::Close()
@@ -14,7 +14,7 @@ void Helium::TraceFile::Close()
 
 }
 
-void Helium::TraceFile::Write(const tchar* data, int size)
+void Helium::TraceFile::Write(const void* data, u32 size)
 {
 
 }
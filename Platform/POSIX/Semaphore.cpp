@@ -3,6 +3,9 @@
 
 #include "Platform/Assert.h"
 
+#include <errno.h>
+#include <time.h>
+
 using namespace Helium;
 
 Semaphore::Semaphore()
@@ -23,10 +26,35 @@ void Semaphore::Increment()
     HELIUM_ASSERT( result == 0 );
 }
 
-void Semaphore::Decrement()
+bool Semaphore::Decrement(u32 timeout)
 {
-    int result = sem_wait(&m_Handle);
-    HELIUM_ASSERT( result == 0 );
+    if ( timeout == 0xffffffff )
+    {
+        int result = sem_wait(&m_Handle);
+        HELIUM_ASSERT( result == 0 );
+        return true;
+    }
+
+    // sem_timedwait takes an absolute time against the realtime clock
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += ( timeout % 1000 ) * 1000000;
+    if ( deadline.tv_nsec >= 1000000000 )
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    int result;
+    do
+    {
+        result = sem_timedwait(&m_Handle, &deadline);
+    }
+    while ( result != 0 && errno == EINTR );
+
+    HELIUM_ASSERT( result == 0 || errno == ETIMEDOUT );
+    return result == 0;
 }
 
 void Semaphore::Reset()
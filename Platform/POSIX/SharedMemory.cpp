@@ -0,0 +1,237 @@
+#include "Platform/SharedMemory.h"
+#include "Platform/Assert.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Helium;
+
+// shm_open and sem_open want a name with a single leading slash
+static void MakeObjectName( const tchar* name, tchar* result, size_t size )
+{
+    result[0] = '/';
+    strncpy( result + 1, name[0] == '/' ? name + 1 : name, size - 2 );
+    result[ size - 1 ] = '\0';
+
+    for ( tchar* c = result + 1; *c; ++c )
+    {
+        if ( *c == '/' )
+        {
+            *c = '_';
+        }
+    }
+}
+
+SharedMemory::SharedMemory()
+: m_Mapping (-1)
+, m_Data (NULL)
+, m_Size (0)
+, m_Creator (false)
+{
+    m_Name[0] = '\0';
+}
+
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+bool SharedMemory::Create( const tchar* name, u32 size )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    MakeObjectName( name, m_Name, sizeof( m_Name ) );
+
+    // start from nothing, a stale block from a crashed owner would otherwise keep its contents
+    shm_unlink( m_Name );
+
+    m_Mapping = shm_open( m_Name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR );
+    if ( m_Mapping < 0 )
+    {
+        Close();
+        return false;
+    }
+
+    m_Creator = true;
+
+    if ( ftruncate( m_Mapping, size ) != 0 )
+    {
+        Close();
+        return false;
+    }
+
+    void* data = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_Mapping, 0 );
+    if ( data == MAP_FAILED )
+    {
+        Close();
+        return false;
+    }
+
+    m_Data = data;
+    m_Size = size;
+
+    return true;
+}
+
+bool SharedMemory::Open( const tchar* name, u32 size )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    MakeObjectName( name, m_Name, sizeof( m_Name ) );
+
+    m_Mapping = shm_open( m_Name, O_RDWR, 0 );
+    if ( m_Mapping < 0 )
+    {
+        Close();
+        return false;
+    }
+
+    struct stat info;
+    if ( fstat( m_Mapping, &info ) != 0 || info.st_size < (off_t)size )
+    {
+        Close();
+        return false;
+    }
+
+    void* data = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_Mapping, 0 );
+    if ( data == MAP_FAILED )
+    {
+        Close();
+        return false;
+    }
+
+    m_Data = data;
+    m_Size = size;
+    m_Creator = false;
+
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    if ( m_Data )
+    {
+        munmap( m_Data, m_Size );
+        m_Data = NULL;
+    }
+
+    if ( m_Mapping >= 0 )
+    {
+        close( m_Mapping );
+        m_Mapping = -1;
+    }
+
+    if ( m_Creator )
+    {
+        shm_unlink( m_Name );
+        m_Creator = false;
+    }
+
+    m_Size = 0;
+    m_Name[0] = '\0';
+}
+
+SharedSignal::SharedSignal()
+: m_Handle (NULL)
+, m_Creator (false)
+{
+    m_Name[0] = '\0';
+}
+
+SharedSignal::~SharedSignal()
+{
+    Close();
+}
+
+bool SharedSignal::Create( const tchar* name )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    MakeObjectName( name, m_Name, sizeof( m_Name ) );
+
+    // a semaphore left by a crashed owner may still hold a count
+    sem_unlink( m_Name );
+
+    sem_t* semaphore = sem_open( m_Name, O_CREAT | O_EXCL, S_IRUSR | S_IWUSR, 0 );
+    if ( semaphore == SEM_FAILED )
+    {
+        return false;
+    }
+
+    m_Handle = semaphore;
+    m_Creator = true;
+
+    return true;
+}
+
+bool SharedSignal::Open( const tchar* name )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    MakeObjectName( name, m_Name, sizeof( m_Name ) );
+
+    sem_t* semaphore = sem_open( m_Name, 0 );
+    if ( semaphore == SEM_FAILED )
+    {
+        return false;
+    }
+
+    m_Handle = semaphore;
+    m_Creator = false;
+
+    return true;
+}
+
+void SharedSignal::Close()
+{
+    if ( m_Handle )
+    {
+        sem_close( (sem_t*)m_Handle );
+        m_Handle = NULL;
+    }
+
+    if ( m_Creator )
+    {
+        sem_unlink( m_Name );
+        m_Creator = false;
+    }
+
+    m_Name[0] = '\0';
+}
+
+void SharedSignal::Signal()
+{
+    HELIUM_ASSERT( IsOpen() );
+    sem_post( (sem_t*)m_Handle );
+}
+
+bool SharedSignal::Wait( u32 timeout )
+{
+    HELIUM_ASSERT( IsOpen() );
+
+    struct timespec deadline;
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += ( timeout % 1000 ) * 1000000;
+    if ( deadline.tv_nsec >= 1000000000 )
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while ( sem_timedwait( (sem_t*)m_Handle, &deadline ) != 0 )
+    {
+        if ( errno != EINTR )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
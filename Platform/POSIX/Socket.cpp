@@ -3,6 +3,9 @@
 #include "Platform/Platform.h"
 #include "Platform/Assert.h"
 
+#include <string.h>
+#include <sys/uio.h>
+
 using namespace Helium;
 
 bool Helium::InitializeSockets()
@@ -203,3 +206,36 @@ bool Helium::WriteSocket(Socket& socket, void* buffer, u32 bytes, u32& wrote, Co
     HELIUM_BREAK();
     return false;
 }
+
+bool Helium::WriteSocketGather(Socket& socket, SocketBuffer* buffers, u32 count, u32& wrote, Condition& terminate)
+{
+#ifdef PS3_POSIX
+    struct iovec vecs[ SOCKET_GATHER_MAX ];
+
+    count = count < SOCKET_GATHER_MAX ? count : SOCKET_GATHER_MAX;
+    for ( u32 i = 0; i < count; ++i )
+    {
+        vecs[ i ].iov_base = buffers[ i ].m_Data;
+        vecs[ i ].iov_len = buffers[ i ].m_Size;
+    }
+
+    struct msghdr header;
+    memset( &header, 0, sizeof( header ) );
+    header.msg_iov = vecs;
+    header.msg_iovlen = count;
+
+    i32 local_wrote = ::sendmsg( socket, &header, 0 );
+
+    if (local_wrote < 0)
+    {
+        return false;
+    }
+
+    wrote = local_wrote;
+
+    return true;
+#endif
+
+    HELIUM_BREAK();
+    return false;
+}
@@ -50,10 +50,11 @@ bool Thread::Valid()
     return m_Handle != 0;
 }
 
-ThreadLocalPointer::ThreadLocalPointer()
+ThreadLocalPointer::ThreadLocalPointer(Destructor destructor)
+: m_Destructor (destructor)
 {
 #ifdef PS3_POSIX
-    int status = pthread_key_create(&m_Key, NULL);
+    int status = pthread_key_create(&m_Key, destructor);
     HELIUM_ASSERT( status == 0 && "Could not create pthread_key");
 #endif
 
@@ -20,6 +20,7 @@ namespace Helium
     PLATFORM_API bool MakePath( const tchar* path );
     PLATFORM_API bool Copy( const tchar* source, const tchar* dest, bool overwrite );
     PLATFORM_API bool Move( const tchar* source, const tchar* dest );
+    PLATFORM_API bool Replace( const tchar* source, const tchar* dest );    // move over an existing file in one step, dest is never missing
     PLATFORM_API bool Delete( const tchar* path );
     PLATFORM_API bool GetVersionInfo( const tchar* path, tstring& versionInfo );
 }
\ No newline at end of file
@@ -47,4 +47,7 @@ namespace Helium
 
     PLATFORM_API void Print(const tchar* fmt, ...);
     PLATFORM_API void Sleep(int millis);
+
+    // number of logical processors available to the process
+    PLATFORM_API u32 GetProcessorCount();
 }
@@ -36,4 +36,16 @@ namespace Helium
   //
 
   PLATFORM_API tstring GetProcessName();
+
+  //
+  // Get the id of this process
+  //
+
+  PLATFORM_API u32 GetProcessID();
+
+  //
+  // Check if the process with the given id is still running
+  //
+
+  PLATFORM_API bool IsProcessRunning( u32 processID );
 }
\ No newline at end of file
@@ -32,11 +32,11 @@ namespace Helium
 
         }
 
-        void Open(const tchar* file);
+        bool Open(const tchar* file);
 
         void Close();
 
-        void Write(const tchar* data, int size);
+        void Write(const void* data, u32 size);
 
         static const tchar* GetFilePath();
     };
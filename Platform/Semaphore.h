@@ -35,7 +35,7 @@ namespace Helium
         }
 
         void Increment();
-        void Decrement();
+        bool Decrement(u32 timeout = 0xffffffff);
         void Reset();
     };
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "API.h"
+#include "Types.h"
+
+namespace Helium
+{
+    //
+    // SharedMemory - a named block of memory mapped into every process that opens it
+    //  The creator's block starts zeroed, and its name goes away when the creator closes it
+    //
+
+    class PLATFORM_API SharedMemory
+    {
+    public:
+#ifdef WIN32
+        typedef void* Handle;
+#else
+        typedef int Handle;
+#endif
+
+    private:
+        Handle      m_Mapping;
+        void*       m_Data;
+        u32         m_Size;
+        bool        m_Creator;
+        tchar       m_Name[256];
+
+    public:
+        SharedMemory();
+        ~SharedMemory();
+
+    private:
+        SharedMemory( const SharedMemory& rhs )
+        {
+
+        }
+
+    public:
+        // create the named block, fails if it can't be made the requested size
+        bool Create( const tchar* name, u32 size );
+
+        // open a block someone else created
+        bool Open( const tchar* name, u32 size );
+
+        // unmap the block (and remove the name if we created it)
+        void Close();
+
+        bool IsOpen() const
+        {
+            return m_Data != NULL;
+        }
+
+        void* GetData() const
+        {
+            return m_Data;
+        }
+
+        u32 GetSize() const
+        {
+            return m_Size;
+        }
+    };
+
+    //
+    // SharedSignal - a named wakeup that works across processes
+    //  Signals sent while nobody is waiting are not lost, but a waiter may wake with nothing to do,
+    //  so always re-check whatever state the signal is guarding after Wait returns
+    //
+
+    class PLATFORM_API SharedSignal
+    {
+    public:
+        typedef void* Handle;
+
+    private:
+        Handle      m_Handle;
+        bool        m_Creator;
+        tchar       m_Name[256];
+
+    public:
+        SharedSignal();
+        ~SharedSignal();
+
+    private:
+        SharedSignal( const SharedSignal& rhs )
+        {
+
+        }
+
+    public:
+        bool Create( const tchar* name );
+        bool Open( const tchar* name );
+        void Close();
+
+        bool IsOpen() const
+        {
+            return m_Handle != NULL;
+        }
+
+        void Signal();
+
+        // returns true if signaled, false if the timeout (in millis) expired
+        bool Wait( u32 timeout );
+    };
+}
@@ -10,6 +10,16 @@
 
 namespace Helium
 {
+    // one piece of a gathered write
+    struct SocketBuffer
+    {
+        void*   m_Data;
+        u32     m_Size;
+    };
+
+    // most buffers a single gathered write will take, WriteSocketGather sends at most this many
+    const static u32 SOCKET_GATHER_MAX = 64;
+
     PLATFORM_API bool InitializeSockets();
     PLATFORM_API void CleanupSockets();
     PLATFORM_API void CleanupSocketThread();
@@ -28,4 +38,7 @@ namespace Helium
 
     PLATFORM_API bool ReadSocket(Socket& socket, void* buffer, u32 bytes, u32& read, Condition& terminate);
     PLATFORM_API bool WriteSocket(Socket& socket, void* buffer, u32 bytes, u32& wrote, Condition& terminate);
+
+    // sends a list of buffers with one call, wrote may come back short of the total like WriteSocket
+    PLATFORM_API bool WriteSocketGather(Socket& socket, SocketBuffer* buffers, u32 count, u32& wrote, Condition& terminate);
 }
@@ -103,14 +103,18 @@ namespace Helium
     class PLATFORM_API ThreadLocalPointer
     {
     public:
-        ThreadLocalPointer();
+        // called on a thread as it exits with the last non-NULL value it set, so per thread data can be handed back
+        typedef void (*Destructor)(void* value);
+
+        ThreadLocalPointer(Destructor destructor = NULL);
         ~ThreadLocalPointer();
 
         void* GetPointer();
         void SetPointer(void* value);
 
     private:
-        u32 m_Key;
+        u32         m_Key;
+        Destructor  m_Destructor;
     };
 
     PLATFORM_API u32 GetMainThreadID();
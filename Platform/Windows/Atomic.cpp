@@ -6,41 +6,53 @@
 
 using namespace Helium;
 
-void Helium::AtomicIncrement( volatile i32* value )
+i32 Helium::AtomicIncrement( volatile i32* value )
 {
     HELIUM_ASSERT( HELIUM_ALIGN_4( value ) == (uintptr)value );
-    ::InterlockedIncrement( (volatile LONG*)value );
+    return ::InterlockedIncrement( (volatile LONG*)value );
 }
 
-void Helium::AtomicDecrement( volatile i32* value )
+i32 Helium::AtomicDecrement( volatile i32* value )
 {
     HELIUM_ASSERT( HELIUM_ALIGN_4( value ) == (uintptr)value );
-    ::InterlockedDecrement( (volatile LONG*)value );
+    return ::InterlockedDecrement( (volatile LONG*)value );
 }
 
-void Helium::AtomicExchange( volatile i32* addr, i32 value )
+i32 Helium::AtomicExchange( volatile i32* addr, i32 value )
 {
     HELIUM_ASSERT( HELIUM_ALIGN_4( addr ) == (uintptr)addr );
-    ::InterlockedExchange( (volatile LONG*)addr, value );
+    return ::InterlockedExchange( (volatile LONG*)addr, value );
+}
+
+i32 Helium::AtomicCompareExchange( volatile i32* addr, i32 value, i32 comparand )
+{
+    HELIUM_ASSERT( HELIUM_ALIGN_4( addr ) == (uintptr)addr );
+    return ::InterlockedCompareExchange( (volatile LONG*)addr, value, comparand );
 }
 
 #ifdef X64
 
-void Helium::AtomicIncrement( volatile i64* value )
+i64 Helium::AtomicIncrement( volatile i64* value )
 {
     HELIUM_ASSERT( HELIUM_ALIGN_4( value ) == (uintptr)value );
-    ::InterlockedIncrement64( (volatile LONGLONG*)value );
+    return ::InterlockedIncrement64( (volatile LONGLONG*)value );
 }
-void Helium::AtomicDecrement( volatile i64* value )
+i64 Helium::AtomicDecrement( volatile i64* value )
 {
     HELIUM_ASSERT( HELIUM_ALIGN_4( value ) == (uintptr)value );
-    ::InterlockedDecrement64( (volatile LONGLONG*)value );
+    return ::InterlockedDecrement64( (volatile LONGLONG*)value );
 }
 
-void Helium::AtomicExchange( volatile i64* addr, i64 value )
+i64 Helium::AtomicExchange( volatile i64* addr, i64 value )
 {
     HELIUM_ASSERT( HELIUM_ALIGN_4( addr ) == (uintptr)addr );
-    ::InterlockedExchange64( (volatile LONGLONG*)addr, value );
+    return ::InterlockedExchange64( (volatile LONGLONG*)addr, value );
 }
 
-#endif
\ No newline at end of file
+#endif
+
+void* Helium::AtomicExchangePointer( void* volatile* addr, void* value )
+{
+    HELIUM_ASSERT( HELIUM_ALIGN_4( addr ) == (uintptr)addr );
+    return ::InterlockedExchangePointer( addr, value );
+}
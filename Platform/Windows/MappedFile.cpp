@@ -0,0 +1,90 @@
+#include "Platform/Windows/Windows.h"
+#include "Platform/MappedFile.h"
+#include "Platform/Assert.h"
+
+using namespace Helium;
+
+MappedFile::MappedFile()
+: m_File (INVALID_HANDLE_VALUE)
+, m_Mapping (NULL)
+, m_Data (NULL)
+, m_Size (0)
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open( const tchar* path )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    // share everything like a plain read would, readers notice a rewrite on their own and saves must not fail while we're mapped
+    m_File = ::CreateFile( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( m_File == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if ( !::GetFileSizeEx( m_File, &size ) )
+    {
+        Close();
+        return false;
+    }
+
+    m_Size = size.QuadPart;
+
+    // mapping a zero length file is an error, but opening one is not
+    if ( m_Size == 0 )
+    {
+        return true;
+    }
+
+    m_Mapping = ::CreateFileMapping( m_File, NULL, PAGE_READONLY, 0, 0, NULL );
+    if ( m_Mapping == NULL )
+    {
+        Close();
+        return false;
+    }
+
+    m_Data = (const u8*)::MapViewOfFile( m_Mapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( m_Data == NULL )
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if ( m_Data )
+    {
+        ::UnmapViewOfFile( m_Data );
+        m_Data = NULL;
+    }
+
+    if ( m_Mapping )
+    {
+        ::CloseHandle( m_Mapping );
+        m_Mapping = NULL;
+    }
+
+    if ( m_File != INVALID_HANDLE_VALUE )
+    {
+        ::CloseHandle( m_File );
+        m_File = INVALID_HANDLE_VALUE;
+    }
+
+    m_Size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return m_File != INVALID_HANDLE_VALUE;
+}
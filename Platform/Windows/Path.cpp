@@ -93,6 +93,11 @@ bool Helium::Move( const tchar* source, const tchar* dest )
     return ( TRUE == ::MoveFile( source, dest ) );
 }
 
+bool Helium::Replace( const tchar* source, const tchar* dest )
+{
+    return ( TRUE == ::MoveFileEx( source, dest, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) );
+}
+
 bool Helium::Delete( const tchar* path )
 {
     return ( TRUE == ::DeleteFile( path ) );
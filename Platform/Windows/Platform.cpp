@@ -106,3 +106,10 @@ void Helium::Sleep(int millis)
 {
     ::Sleep(millis);
 }
+
+u32 Helium::GetProcessorCount()
+{
+    SYSTEM_INFO info;
+    ::GetSystemInfo( &info );
+    return info.dwNumberOfProcessors;
+}
\ No newline at end of file
@@ -164,4 +164,23 @@ tstring Helium::GetProcessName()
     _tsplitpath( module, NULL, NULL, file, NULL );
 
     return file;
-}
\ No newline at end of file
+}
+
+u32 Helium::GetProcessID()
+{
+    return ::GetCurrentProcessId();
+}
+
+bool Helium::IsProcessRunning( u32 processID )
+{
+    HANDLE process = ::OpenProcess( SYNCHRONIZE, FALSE, processID );
+    if ( process == NULL )
+    {
+        return false;
+    }
+
+    bool running = ::WaitForSingleObject( process, 0 ) == WAIT_TIMEOUT;
+    ::CloseHandle( process );
+
+    return running;
+}
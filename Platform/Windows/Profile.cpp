@@ -13,9 +13,10 @@
 using namespace Helium;
 using namespace Helium::Profile;
 
-void Helium::TraceFile::Open(const tchar* file)
+bool Helium::TraceFile::Open(const tchar* file)
 {
     m_FileHandle = _tfopen(file, TXT("wb"));
+    return m_FileHandle != NULL;
 }
 
 void Helium::TraceFile::Close()
@@ -23,14 +24,15 @@ void Helium::TraceFile::Close()
     if (m_FileHandle)
     {
         fclose(m_FileHandle);
+        m_FileHandle = NULL;
     }
 }
 
-void Helium::TraceFile::Write(const tchar* data, int size)
+void Helium::TraceFile::Write(const void* data, u32 size)
 {
-    if (m_FileHandle)
+    if (m_FileHandle && size)
     {
-        fwrite(data, sizeof(tchar), size, m_FileHandle);
+        fwrite(data, 1, size, m_FileHandle);
     }
 }
 
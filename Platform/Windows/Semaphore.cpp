@@ -37,14 +37,16 @@ void Semaphore::Increment()
     }
 }
 
-void Semaphore::Decrement()
+bool Semaphore::Decrement(u32 timeout)
 {
-    DWORD result = ::WaitForSingleObject(m_Handle, INFINITE);
-    if ( result != WAIT_OBJECT_0 )
+    DWORD result = ::WaitForSingleObject(m_Handle, timeout);
+    if ( result != WAIT_OBJECT_0 && result != WAIT_TIMEOUT )
     {
         Helium::Print(TXT("Failed to decrement semaphore (%s)\n"), Helium::GetErrorString().c_str());
         HELIUM_BREAK();
     }
+
+    return result == WAIT_OBJECT_0;
 }
 
 void Semaphore::Reset()
@@ -0,0 +1,171 @@
+#include "Platform/Windows/Windows.h"
+#include "Platform/SharedMemory.h"
+#include "Platform/Assert.h"
+
+using namespace Helium;
+
+SharedMemory::SharedMemory()
+: m_Mapping (NULL)
+, m_Data (NULL)
+, m_Size (0)
+, m_Creator (false)
+{
+    m_Name[0] = '\0';
+}
+
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+bool SharedMemory::Create( const tchar* name, u32 size )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    m_Mapping = ::CreateFileMapping( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name );
+    if ( m_Mapping == NULL )
+    {
+        return false;
+    }
+
+    // someone is still holding a block by this name, it may be the wrong size and it isn't zeroed
+    bool existed = ::GetLastError() == ERROR_ALREADY_EXISTS;
+
+    m_Data = ::MapViewOfFile( m_Mapping, FILE_MAP_ALL_ACCESS, 0, 0, size );
+    if ( m_Data == NULL )
+    {
+        Close();
+        return false;
+    }
+
+    if ( existed )
+    {
+        MEMORY_BASIC_INFORMATION info;
+        if ( !::VirtualQuery( m_Data, &info, sizeof( info ) ) || info.RegionSize < size )
+        {
+            Close();
+            return false;
+        }
+
+        memset( m_Data, 0, size );
+    }
+
+    m_Size = size;
+    m_Creator = true;
+    _tcsncpy( m_Name, name, sizeof( m_Name ) / sizeof( tchar ) - 1 );
+    m_Name[ sizeof( m_Name ) / sizeof( tchar ) - 1 ] = '\0';
+
+    return true;
+}
+
+bool SharedMemory::Open( const tchar* name, u32 size )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    m_Mapping = ::OpenFileMapping( FILE_MAP_ALL_ACCESS, FALSE, name );
+    if ( m_Mapping == NULL )
+    {
+        return false;
+    }
+
+    m_Data = ::MapViewOfFile( m_Mapping, FILE_MAP_ALL_ACCESS, 0, 0, size );
+    if ( m_Data == NULL )
+    {
+        Close();
+        return false;
+    }
+
+    m_Size = size;
+    m_Creator = false;
+    _tcsncpy( m_Name, name, sizeof( m_Name ) / sizeof( tchar ) - 1 );
+    m_Name[ sizeof( m_Name ) / sizeof( tchar ) - 1 ] = '\0';
+
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    // the name goes away with the last handle, so there is nothing extra for the creator to do
+    if ( m_Data )
+    {
+        ::UnmapViewOfFile( m_Data );
+        m_Data = NULL;
+    }
+
+    if ( m_Mapping )
+    {
+        ::CloseHandle( m_Mapping );
+        m_Mapping = NULL;
+    }
+
+    m_Size = 0;
+    m_Creator = false;
+    m_Name[0] = '\0';
+}
+
+SharedSignal::SharedSignal()
+: m_Handle (NULL)
+, m_Creator (false)
+{
+    m_Name[0] = '\0';
+}
+
+SharedSignal::~SharedSignal()
+{
+    Close();
+}
+
+bool SharedSignal::Create( const tchar* name )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    // auto reset, so one wakeup is consumed by one wait
+    m_Handle = ::CreateEvent( NULL, FALSE, FALSE, name );
+    if ( m_Handle == NULL )
+    {
+        return false;
+    }
+
+    // clear any stale wakeup left by an earlier owner
+    ::ResetEvent( m_Handle );
+
+    m_Creator = true;
+    return true;
+}
+
+bool SharedSignal::Open( const tchar* name )
+{
+    HELIUM_ASSERT( !IsOpen() );
+
+    m_Handle = ::OpenEvent( EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name );
+    if ( m_Handle == NULL )
+    {
+        return false;
+    }
+
+    m_Creator = false;
+    return true;
+}
+
+void SharedSignal::Close()
+{
+    if ( m_Handle )
+    {
+        ::CloseHandle( m_Handle );
+        m_Handle = NULL;
+    }
+
+    m_Creator = false;
+}
+
+void SharedSignal::Signal()
+{
+    HELIUM_ASSERT( IsOpen() );
+    ::SetEvent( m_Handle );
+}
+
+bool SharedSignal::Wait( u32 timeout )
+{
+    HELIUM_ASSERT( IsOpen() );
+    return ::WaitForSingleObject( m_Handle, timeout ) == WAIT_OBJECT_0;
+}
@@ -259,4 +259,66 @@ bool Helium::WriteSocket(Socket& socket, void* buffer, u32 bytes, u32& wrote, Co
     wrote = (u32)wrote_local;
 
     return true;
-}
\ No newline at end of file
+}
+
+bool Helium::WriteSocketGather(Socket& socket, SocketBuffer* buffers, u32 count, u32& wrote, Condition& terminate)
+{
+    if (count == 0)
+    {
+        return true;
+    }
+
+    WSABUF bufs[ SOCKET_GATHER_MAX ];
+
+    count = count < SOCKET_GATHER_MAX ? count : SOCKET_GATHER_MAX;
+    for ( u32 i = 0; i < count; ++i )
+    {
+        bufs[ i ].buf = (CHAR*)buffers[ i ].m_Data;
+        bufs[ i ].len = buffers[ i ].m_Size;
+    }
+
+    DWORD flags = 0;
+    DWORD wrote_local = 0;
+    if ( ::WSASend(socket.m_Handle, bufs, count, &wrote_local, 0, (OVERLAPPED*)&socket.m_Overlapped, NULL) != 0 )
+    {
+        if ( WSAGetLastError() != WSA_IO_PENDING )
+        {
+#ifdef IPC_TCP_DEBUG_SOCKETS
+            Helium::Print("TCP Support: Failed to initiate overlapped gathered write (%s)\n", Helium::GetErrorString().c_str());
+#endif
+            return false;
+        }
+        else
+        {
+            HANDLE events[] = { terminate.GetHandle(), socket.m_Overlapped.hEvent };
+            DWORD result = ::WSAWaitForMultipleEvents(2, events, FALSE, INFINITE, FALSE);
+
+            HELIUM_ASSERT( result != WAIT_FAILED );
+
+            if ( (result - WAIT_OBJECT_0) == 0 )
+            {
+#ifdef IPC_TCP_DEBUG_SOCKETS
+                Helium::Print("TCP Support: Terminating gathered write\n");
+#endif
+                return false;
+            }
+
+            if ( !::WSAGetOverlappedResult(socket.m_Handle, (OVERLAPPED*)&socket.m_Overlapped, &wrote_local, false, &flags) )
+            {
+#ifdef IPC_TCP_DEBUG_SOCKETS
+                Helium::Print("TCP Support: Failed gathered write (%s)\n", Helium::GetErrorString().c_str());
+#endif
+                return false;
+            }
+        }
+    }
+
+    if (wrote_local == 0)
+    {
+        return false;
+    }
+
+    wrote = (u32)wrote_local;
+
+    return true;
+}
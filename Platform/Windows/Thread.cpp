@@ -131,26 +131,87 @@ bool Thread::Valid()
     return m_Handle != 0;
 }
 
-ThreadLocalPointer::ThreadLocalPointer()
+// fiber local storage only hands its callback the stored value, so values with a destructor are boxed with it
+struct ThreadLocalValue
 {
-    m_Key = TlsAlloc(); 
-    HELIUM_ASSERT(m_Key != TLS_OUT_OF_INDEXES);
-    SetPointer(NULL); 
+    ThreadLocalPointer::Destructor  m_Destructor;
+    void*                           m_Value;
+};
+
+static VOID WINAPI DestroyThreadLocalValue(PVOID data)
+{
+    ThreadLocalValue* value = (ThreadLocalValue*)data;
+
+    if (value->m_Value)
+    {
+        value->m_Destructor(value->m_Value);
+    }
+
+    delete value;
+}
+
+ThreadLocalPointer::ThreadLocalPointer(Destructor destructor)
+: m_Destructor (destructor)
+{
+    if (m_Destructor)
+    {
+        m_Key = FlsAlloc(&DestroyThreadLocalValue);
+        HELIUM_ASSERT(m_Key != FLS_OUT_OF_INDEXES);
+    }
+    else
+    {
+        m_Key = TlsAlloc(); 
+        HELIUM_ASSERT(m_Key != TLS_OUT_OF_INDEXES);
+        SetPointer(NULL); 
+    }
 }
 
 ThreadLocalPointer::~ThreadLocalPointer()
 {
-    TlsFree(m_Key); 
+    if (m_Destructor)
+    {
+        FlsFree(m_Key);
+    }
+    else
+    {
+        TlsFree(m_Key); 
+    }
 }
 
 void* ThreadLocalPointer::GetPointer()
 {
+    if (m_Destructor)
+    {
+        ThreadLocalValue* value = (ThreadLocalValue*)FlsGetValue(m_Key);
+        return value ? value->m_Value : NULL;
+    }
+
     void* value = TlsGetValue(m_Key);
     return value;
 }
 
 void ThreadLocalPointer::SetPointer(void* pointer)
 {
+    if (m_Destructor)
+    {
+        ThreadLocalValue* value = (ThreadLocalValue*)FlsGetValue(m_Key);
+
+        if (value == NULL)
+        {
+            if (pointer == NULL)
+            {
+                return;
+            }
+
+            value = new ThreadLocalValue;
+            value->m_Destructor = m_Destructor;
+            FlsSetValue(m_Key, value);
+        }
+
+        value->m_Value = pointer;
+        return;
+    }
+
     TlsSetValue(m_Key, pointer); 
 }
 
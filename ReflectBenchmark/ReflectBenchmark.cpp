@@ -0,0 +1,547 @@
+#include "Platform/Types.h"
+#include "Platform/Exception.h"
+#include "Platform/Platform.h"
+#include "Platform/Profile.h"
+#include "Platform/Thread.h"
+
+#include "Foundation/Log.h"
+#include "Foundation/InitializerStack.h"
+#include "Foundation/File/Path.h"
+#include "Foundation/Reflect/Archive.h"
+#include "Foundation/Reflect/Element.h"
+#include "Foundation/Reflect/Registry.h"
+#include "Foundation/Reflect/Serializers.h"
+#include "Foundation/CommandLine/Command.h"
+#include "Foundation/CommandLine/Option.h"
+
+#include <algorithm>
+
+#ifdef WIN32
+# include "Foundation/Startup.h"
+# include "Platform/Windows/Windows.h"
+# include <psapi.h>
+#else
+# include <stdio.h>
+# include <string.h>
+#endif
+
+using namespace Helium;
+using namespace Helium::CommandLine;
+using namespace Helium::Reflect;
+
+namespace Helium
+{
+    namespace ReflectBenchmark
+    {
+        //
+        // Synthetic corpus types, sized by the command options
+        //
+
+        class BenchmarkLeaf : public Reflect::Element
+        {
+        public:
+            u32             m_Index;
+            f32             m_Weight;
+            Math::Vector3   m_Position;
+            Math::Matrix4   m_Transform;
+            tstring         m_Name;
+
+            BenchmarkLeaf()
+                : m_Index( 0 )
+                , m_Weight( 0.f )
+            {
+            }
+
+            REFLECT_DECLARE_CLASS( BenchmarkLeaf, Reflect::Element );
+
+            static void EnumerateClass( Reflect::Compositor<BenchmarkLeaf>& comp );
+        };
+        typedef Helium::SmartPtr<BenchmarkLeaf> BenchmarkLeafPtr;
+
+        class BenchmarkNode : public BenchmarkLeaf
+        {
+        public:
+            std::vector< f32 >                              m_Samples;
+            std::map< tstring, u32 >                        m_Lookup;
+            std::set< u32 >                                 m_Tags;
+            BenchmarkLeafPtr                                m_Leaf;
+            std::vector< Helium::SmartPtr<BenchmarkNode> >  m_Children;
+
+            REFLECT_DECLARE_CLASS( BenchmarkNode, BenchmarkLeaf );
+
+            static void EnumerateClass( Reflect::Compositor<BenchmarkNode>& comp );
+        };
+        typedef Helium::SmartPtr<BenchmarkNode> BenchmarkNodePtr;
+
+        //
+        // Measures Reflect archive, clone and compare throughput over a synthetic corpus
+        //
+
+        class ReflectBenchmarkCommand : public Helium::CommandLine::Command
+        {
+        private:
+            Helium::InitializerStack m_InitializerStack;
+
+            bool m_HelpFlag;
+            bool m_XML;
+            bool m_Binary;
+            u32 m_Count;
+            u32 m_Depth;
+            u32 m_ArraySize;
+            u32 m_Iterations;
+
+        public:
+            ReflectBenchmarkCommand();
+            virtual ~ReflectBenchmarkCommand();
+
+            virtual bool Initialize( tstring& error ) HELIUM_OVERRIDE;
+            virtual void Cleanup() HELIUM_OVERRIDE;
+
+            virtual bool Process( std::vector< tstring >::const_iterator& argsBegin, const std::vector< tstring >::const_iterator& argsEnd, tstring& error ) HELIUM_OVERRIDE;
+
+        private:
+            // builds the synthetic corpus, returns the total number of objects in it
+            u32 BuildCorpus( Reflect::V_Element& elements );
+
+            // times a save/load round trip of the corpus through the given archive type
+            bool BenchmarkArchive( const Reflect::V_Element& elements, u32 objects, Reflect::ArchiveType type, tstring& error );
+
+            // times deep copy and comparison of the corpus
+            void BenchmarkCloneEquals( const Reflect::V_Element& elements, u32 objects );
+        };
+    }
+}
+
+using namespace Helium::ReflectBenchmark;
+
+REFLECT_DEFINE_CLASS( BenchmarkLeaf );
+
+void BenchmarkLeaf::EnumerateClass( Reflect::Compositor<BenchmarkLeaf>& comp )
+{
+    comp.AddField( &BenchmarkLeaf::m_Index, "m_Index" );
+    comp.AddField( &BenchmarkLeaf::m_Weight, "m_Weight" );
+    comp.AddField( &BenchmarkLeaf::m_Position, "m_Position" );
+    comp.AddField( &BenchmarkLeaf::m_Transform, "m_Transform" );
+    comp.AddField( &BenchmarkLeaf::m_Name, "m_Name" );
+}
+
+REFLECT_DEFINE_CLASS( BenchmarkNode );
+
+void BenchmarkNode::EnumerateClass( Reflect::Compositor<BenchmarkNode>& comp )
+{
+    comp.AddField( &BenchmarkNode::m_Samples, "m_Samples" );
+    comp.AddField( &BenchmarkNode::m_Lookup, "m_Lookup" );
+    comp.AddField( &BenchmarkNode::m_Tags, "m_Tags" );
+    comp.AddField( &BenchmarkNode::m_Leaf, "m_Leaf" );
+    comp.AddField( &BenchmarkNode::m_Children, "m_Children" );
+}
+
+//
+// Peak memory over one phase of the benchmark
+//  Linux lets us reset the process high water mark and read it back afterwards, windows has no way
+//  to reset its peak working set so a thread samples the working set for as long as the phase runs
+//
+
+class PhaseMemory
+{
+public:
+    PhaseMemory()
+        : m_Peak( 0 )
+    {
+#ifdef WIN32
+        m_Stop = false;
+        m_Peak = GetCurrentMemory();
+        m_Sampler.Create( &Thread::EntryHelper< PhaseMemory, &PhaseMemory::Sample >, this, "Memory Sampler" );
+#else
+        // 5 resets VmHWM to the current resident size (linux 4.0 and up)
+        FILE* f = fopen( "/proc/self/clear_refs", "w" );
+        if ( f )
+        {
+            fputs( "5", f );
+            fclose( f );
+        }
+#endif
+    }
+
+    // the most memory the process had resident since we were constructed
+    u64 Stop()
+    {
+#ifdef WIN32
+        if ( !m_Stop )
+        {
+            m_Stop = true;
+            m_Sampler.Wait();
+            m_Sampler.Close();
+        }
+
+        u64 current = GetCurrentMemory();
+        if ( current > m_Peak )
+        {
+            m_Peak = current;
+        }
+#else
+        FILE* f = fopen( "/proc/self/status", "r" );
+        if ( f )
+        {
+            char line[ 256 ];
+            while ( fgets( line, sizeof( line ), f ) )
+            {
+                unsigned long long kb = 0;
+                if ( sscanf( line, "VmHWM: %llu kB", &kb ) == 1 )
+                {
+                    m_Peak = (u64)kb * 1024;
+                    break;
+                }
+            }
+
+            fclose( f );
+        }
+#endif
+
+        return m_Peak;
+    }
+
+private:
+#ifdef WIN32
+    static u64 GetCurrentMemory()
+    {
+        PROCESS_MEMORY_COUNTERS counters;
+        if ( ::GetProcessMemoryInfo( ::GetCurrentProcess(), &counters, sizeof( counters ) ) )
+        {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+    }
+
+    void Sample()
+    {
+        while ( !m_Stop )
+        {
+            u64 current = GetCurrentMemory();
+            if ( current > m_Peak )
+            {
+                m_Peak = current;
+            }
+
+            Helium::Sleep( 1 );
+        }
+    }
+
+    Thread          m_Sampler;
+    volatile bool   m_Stop;
+#endif
+
+    u64             m_Peak;
+};
+
+static void PrintResult( const tchar* name, f32 millis, u32 objects, i64 bytes, u64 peak )
+{
+    f32 seconds = millis / 1000.f;
+    if ( seconds <= 0.f )
+    {
+        seconds = 0.001f;
+    }
+
+    f32 peakMegabytes = (f32)peak / ( 1024.f * 1024.f );
+
+    if ( bytes > 0 )
+    {
+        Log::Print( TXT( " %-16s %10.2f ms %10.2f MB/s %12.0f objects/s %10.2f MB peak\n" ), name, millis, ( (f32)bytes / ( 1024.f * 1024.f ) ) / seconds, (f32)objects / seconds, peakMegabytes );
+    }
+    else
+    {
+        Log::Print( TXT( " %-16s %10.2f ms %12.0f objects/s %10.2f MB peak\n" ), name, millis, (f32)objects / seconds, peakMegabytes );
+    }
+}
+
+static BenchmarkNodePtr BuildNode( u32 index, u32 depth, u32 arraySize, u32& objects )
+{
+    BenchmarkNodePtr node = new BenchmarkNode;
+    ++objects;
+
+    tstringstream name;
+    name << TXT( "node_" ) << index << TXT( "_" ) << depth;
+
+    node->m_Index = index;
+    node->m_Weight = (f32)index * 0.5f;
+    node->m_Position = Math::Vector3( (f32)index, (f32)depth, (f32)arraySize );
+    node->m_Name = name.str();
+
+    node->m_Samples.resize( arraySize );
+    for ( u32 i = 0; i < arraySize; ++i )
+    {
+        node->m_Samples[ i ] = (f32)( i * depth );
+    }
+
+    u32 entries = arraySize / 16 + 1;
+    for ( u32 i = 0; i < entries; ++i )
+    {
+        tstringstream key;
+        key << TXT( "key_" ) << i;
+        node->m_Lookup[ key.str() ] = i * index;
+        node->m_Tags.insert( i + index );
+    }
+
+    node->m_Leaf = new BenchmarkLeaf;
+    node->m_Leaf->m_Index = index;
+    node->m_Leaf->m_Name = node->m_Name;
+    ++objects;
+
+    if ( depth > 0 )
+    {
+        // two children per level keeps the corpus bushy as well as deep
+        node->m_Children.push_back( BuildNode( index, depth - 1, arraySize, objects ) );
+        node->m_Children.push_back( BuildNode( index, depth - 1, arraySize, objects ) );
+    }
+
+    return node;
+}
+
+ReflectBenchmarkCommand::ReflectBenchmarkCommand()
+: Command( TXT( "reflect-benchmark" ), TXT( "" ), TXT( "Measure Reflect archive, clone and compare throughput over a synthetic corpus" ) )
+, m_HelpFlag( false )
+, m_XML( false )
+, m_Binary( false )
+, m_Count( 1000 )
+, m_Depth( 3 )
+, m_ArraySize( 256 )
+, m_Iterations( 3 )
+{
+}
+
+ReflectBenchmarkCommand::~ReflectBenchmarkCommand()
+{
+}
+
+bool ReflectBenchmarkCommand::Initialize( tstring& error )
+{
+    bool result = true;
+
+    result &= AddOption( new SimpleOption<u32>( &m_Count, TXT( "count" ), TXT( "<NUM>" ), TXT( "number of top level elements (default 1000)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_Depth, TXT( "depth" ), TXT( "<NUM>" ), TXT( "depth of each element's child tree (default 3)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_ArraySize, TXT( "array" ), TXT( "<NUM>" ), TXT( "number of samples per node (default 256)" ) ), error );
+    result &= AddOption( new SimpleOption<u32>( &m_Iterations, TXT( "iterations" ), TXT( "<NUM>" ), TXT( "number of times to run each test (default 3)" ) ), error );
+    result &= AddOption( new FlagOption( &m_XML, TXT( "xml" ), TXT( "only benchmark xml archives" ) ), error );
+    result &= AddOption( new FlagOption( &m_Binary, TXT( "binary" ), TXT( "only benchmark binary archives" ) ), error );
+    result &= AddOption( new FlagOption( &m_HelpFlag, TXT( "h|help" ), TXT( "print command usage" ) ), error );
+
+    return result;
+}
+
+void ReflectBenchmarkCommand::Cleanup()
+{
+    m_InitializerStack.Cleanup();
+}
+
+bool ReflectBenchmarkCommand::Process( std::vector< tstring >::const_iterator& argsBegin, const std::vector< tstring >::const_iterator& argsEnd, tstring& error )
+{
+    if ( !ParseOptions( argsBegin, argsEnd, error ) )
+    {
+        return false;
+    }
+
+    if ( m_HelpFlag )
+    {
+        Log::Print( Help().c_str() );
+        return true;
+    }
+
+    if ( m_Iterations == 0 )
+    {
+        m_Iterations = 1;
+    }
+
+    // neither flag means both
+    if ( !m_XML && !m_Binary )
+    {
+        m_XML = m_Binary = true;
+    }
+
+    m_InitializerStack.Push( Reflect::Initialize, Reflect::Cleanup );
+    m_InitializerStack.Push( Reflect::RegisterClassType<BenchmarkLeaf>( TXT( "BenchmarkLeaf" ) ) );
+    m_InitializerStack.Push( Reflect::RegisterClassType<BenchmarkNode>( TXT( "BenchmarkNode" ) ) );
+
+    V_Element elements;
+    PhaseMemory memory;
+    u64 start = Helium::TimerGetClock();
+    u32 objects = BuildCorpus( elements );
+
+    Log::Print( TXT( "Reflect Benchmark: %d elements, depth %d, %d samples, %d objects (built in %.2f ms, %.2f MB peak)\n" ), m_Count, m_Depth, m_ArraySize, objects, Helium::CyclesToMillis( Helium::TimerGetClock() - start ), (f32)memory.Stop() / ( 1024.f * 1024.f ) );
+
+    bool result = true;
+
+    if ( m_Binary )
+    {
+        result &= BenchmarkArchive( elements, objects, ArchiveTypes::Binary, error );
+    }
+
+    if ( m_XML && result )
+    {
+        result &= BenchmarkArchive( elements, objects, ArchiveTypes::XML, error );
+    }
+
+    if ( result )
+    {
+        BenchmarkCloneEquals( elements, objects );
+    }
+
+    return result;
+}
+
+u32 ReflectBenchmarkCommand::BuildCorpus( V_Element& elements )
+{
+    u32 objects = 0;
+
+    elements.reserve( m_Count );
+    for ( u32 i = 0; i < m_Count; ++i )
+    {
+        elements.push_back( BuildNode( i, m_Depth, m_ArraySize, objects ) );
+    }
+
+    return objects;
+}
+
+bool ReflectBenchmarkCommand::BenchmarkArchive( const V_Element& elements, u32 objects, ArchiveType type, tstring& error )
+{
+    Helium::Path path( tstring( TXT( "reflect_benchmark." ) ) + Archive::GetExtension( type ) );
+
+    f32 saveMillis = 0.f;
+    f32 loadMillis = 0.f;
+    u64 savePeak = 0;
+    u64 loadPeak = 0;
+    i64 bytes = 0;
+
+    for ( u32 i = 0; i < m_Iterations; ++i )
+    {
+        V_Element loaded;
+
+        try
+        {
+            {
+                PhaseMemory memory;
+                u64 start = Helium::TimerGetClock();
+                Archive::ToFile( elements, path.Get() );
+                saveMillis += Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+                savePeak = std::max( savePeak, memory.Stop() );
+            }
+
+            bytes = path.Size();
+
+            {
+                PhaseMemory memory;
+                u64 start = Helium::TimerGetClock();
+                Archive::FromFile( path.Get(), loaded );
+                loadMillis += Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+                loadPeak = std::max( loadPeak, memory.Stop() );
+            }
+        }
+        catch ( Helium::Exception& ex )
+        {
+            path.Delete();
+            error = tstring( TXT( "Benchmark failed for " ) ) + path.Get() + TXT( ": " ) + ex.What();
+            return false;
+        }
+
+        if ( loaded.size() != elements.size() )
+        {
+            path.Delete();
+            error = tstring( TXT( "Benchmark round trip lost elements in " ) ) + path.Get();
+            return false;
+        }
+    }
+
+    path.Delete();
+
+    tstring saveName = tstring( Archive::GetExtension( type ) ) + TXT( " save" );
+    tstring loadName = tstring( Archive::GetExtension( type ) ) + TXT( " load" );
+    PrintResult( saveName.c_str(), saveMillis / m_Iterations, objects, bytes, savePeak );
+    PrintResult( loadName.c_str(), loadMillis / m_Iterations, objects, bytes, loadPeak );
+
+    return true;
+}
+
+void ReflectBenchmarkCommand::BenchmarkCloneEquals( const V_Element& elements, u32 objects )
+{
+    f32 cloneMillis = 0.f;
+    f32 equalsMillis = 0.f;
+    u64 clonePeak = 0;
+    u64 equalsPeak = 0;
+
+    for ( u32 i = 0; i < m_Iterations; ++i )
+    {
+        V_Element clones;
+        clones.reserve( elements.size() );
+
+        {
+            PhaseMemory memory;
+            u64 start = Helium::TimerGetClock();
+            for ( V_Element::const_iterator itr = elements.begin(), end = elements.end(); itr != end; ++itr )
+            {
+                clones.push_back( (*itr)->Clone() );
+            }
+            cloneMillis += Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+            clonePeak = std::max( clonePeak, memory.Stop() );
+        }
+
+        u32 mismatches = 0;
+        {
+            PhaseMemory memory;
+            u64 start = Helium::TimerGetClock();
+            for ( size_t index = 0; index < elements.size(); ++index )
+            {
+                if ( !elements[ index ]->Equals( clones[ index ] ) )
+                {
+                    ++mismatches;
+                }
+            }
+            equalsMillis += Helium::CyclesToMillis( Helium::TimerGetClock() - start );
+            equalsPeak = std::max( equalsPeak, memory.Stop() );
+        }
+
+        if ( mismatches )
+        {
+            Log::Warning( TXT( "%d cloned elements did not compare equal to their source\n" ), mismatches );
+        }
+    }
+
+    PrintResult( TXT( "clone" ), cloneMillis / m_Iterations, objects, 0, clonePeak );
+    PrintResult( TXT( "equals" ), equalsMillis / m_Iterations, objects, 0, equalsPeak );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Runs headless, with nothing but Foundation and Platform linked in
+//
+int Main( int argc, const tchar** argv )
+{
+    std::vector< tstring > options;
+    for ( int i = 1; i < argc; ++i )
+    {
+        options.push_back( argv[ i ] );
+    }
+    std::vector< tstring >::const_iterator argsBegin = options.begin(), argsEnd = options.end();
+
+    tstring error;
+
+    ReflectBenchmarkCommand benchmark;
+    bool success = benchmark.Initialize( error ) && benchmark.Process( argsBegin, argsEnd, error );
+    benchmark.Cleanup();
+
+    if ( !success && !error.empty() )
+    {
+        Log::Error( TXT( "%s\n" ), error.c_str() );
+    }
+
+    return success ? 0 : 1;
+}
+
+#ifdef WIN32
+int _tmain( int argc, const tchar** argv )
+{
+    return Helium::StandardMain( &Main, argc, argv );
+}
+#else
+int main( int argc, const char** argv )
+{
+    return Main( argc, argv );
+}
+#endif